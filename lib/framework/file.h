@@ -35,6 +35,23 @@ extern bool loadFile(const char *pFileName,		// The filename
 /** Save the data in the buffer into the given file */
 extern bool saveFile(const char *pFileName, const char *pFileData, UDWORD fileSize);
 
+/** Until saveFileDeferEnd, saveFile and files written through the wz:: Qt file engine are kept in memory instead of written. */
+extern void saveFileDeferBegin(void);
+
+typedef bool (*SAVEFILE_DEFER_FUNC)(void *data, bool ok);
+
+/** Has func(data, ok) write a file after the kept files, with ok false if any of them could not be written. func must free data either way. */
+extern void saveFileDeferLast(SAVEFILE_DEFER_FUNC func, void *data);
+
+/** Writes the files kept since saveFileDeferBegin. If background, they are written by a separate thread, and this returns immediately. */
+extern bool saveFileDeferEnd(bool background);
+
+/** Waits for files being written in the background. Returns false if any of them could not be written. */
+extern bool saveFileDeferWait(void);
+
+/** Returns true between saveFileDeferBegin and saveFileDeferEnd. */
+extern bool saveFileDeferring(void);
+
 /** Load a file from disk into a fixed memory buffer. */
 extern bool loadFileToBuffer(const char *pFileName, char *pFileBuffer, UDWORD bufferSize, UDWORD *pSize);
 
@@ -38,6 +38,12 @@
 #include "physfs_ext.h"
 
 #include "cursors.h"
+#include "wztime.h"
+#include "wzprofile.h"
+#include "wzjobs.h"
+
+#include <string>
+#include <vector>
 
 /* Linux specific stuff */
 
@@ -110,6 +116,9 @@ bool frameInitialise()
 		return false;
 	}
 
+	// Start the threads that share the work of preparing each frame
+	wzJobsInitialise();
+
 	return true;
 }
 
@@ -137,12 +146,17 @@ void frameUpdate(void)
  */
 void frameShutDown(void)
 {
+	// Finish writing any savegame still being written
+	saveFileDeferWait();
+
 	debug(LOG_NEVER, "Screen shutdown!");
 	screenShutDown();
 
 	// Shutdown the resource stuff
 	debug(LOG_NEVER, "No more resources!");
 	resShutDown();
+
+	wzJobsShutdown();
 }
 
 void setMouseWarp(bool value)
@@ -235,6 +249,7 @@ static bool loadFile2(const char *pFileName, char **ppFileData, UDWORD *pFileSiz
 		assert(false);
 		return false;
 	}
+	wzProfileFileRead(filesize);
 
 	if (!PHYSFS_close(pfile))
 	{
@@ -278,10 +293,118 @@ PHYSFS_file* openSaveFile(const char* fileName)
 	return fileHandle;
 }
 
+static bool saveFileNow(const char *pFileName, const char *pFileData, UDWORD fileSize);
+
+struct DeferredFile
+{
+	DeferredFile(const char *name_, const char *data_, size_t size) : name(name_), data(data_, data_ + size) {}
+
+	std::string name;
+	std::vector<char> data;
+};
+
+/// Files kept in memory since saveFileDeferBegin, and what to write after them.
+struct DeferredWrite
+{
+	DeferredWrite() : last(NULL), lastData(NULL) {}
+
+	std::vector<DeferredFile> files;
+	SAVEFILE_DEFER_FUNC last;
+	void *lastData;
+};
+
+static DeferredWrite *deferredFiles = NULL;    ///< Files kept in memory since saveFileDeferBegin, or NULL if not deferring.
+static WZ_THREAD *deferredWriteThread = NULL;  ///< Thread writing the previous deferred files, if any.
+
+static bool writeDeferredFiles(DeferredWrite *write)
+{
+	uint64_t startTime = wzGetMicroTicks();
+	size_t bytes = 0;
+	bool ok = true;
+
+	for (std::vector<DeferredFile>::const_iterator i = write->files.begin(); i != write->files.end(); ++i)
+	{
+		ok = saveFileNow(i->name.c_str(), i->data.empty() ? NULL : &i->data[0], i->data.size()) && ok;
+		bytes += i->data.size();
+	}
+	if (write->last != NULL)
+	{
+		// Only once everything else is written, and not at all if something failed
+		ok = write->last(write->lastData, ok) && ok;
+	}
+	debug(LOG_SAVE, "Wrote %u files, %u bytes, in %u ms", (unsigned)write->files.size(), (unsigned)bytes, (unsigned)((wzGetMicroTicks() - startTime)/1000));
+	delete write;
+	return ok;
+}
+
+static int deferredWriteThreadFunc(void *data)
+{
+	return writeDeferredFiles((DeferredWrite *)data);
+}
+
+void saveFileDeferBegin()
+{
+	ASSERT_OR_RETURN(, deferredFiles == NULL, "Already deferring file writes");
+	deferredFiles = new DeferredWrite;
+}
+
+void saveFileDeferLast(SAVEFILE_DEFER_FUNC func, void *data)
+{
+	ASSERT_OR_RETURN(, deferredFiles != NULL, "Not deferring file writes");
+	ASSERT_OR_RETURN(, deferredFiles->last == NULL, "Already have a file to write last");
+	deferredFiles->last = func;
+	deferredFiles->lastData = data;
+}
+
+bool saveFileDeferEnd(bool background)
+{
+	DeferredWrite *files = deferredFiles;
+
+	ASSERT_OR_RETURN(false, files != NULL, "Not deferring file writes");
+	deferredFiles = NULL;
+	if (!saveFileDeferWait())
+	{
+		debug(LOG_ERROR, "Failed to write previous files");
+	}
+	if (!background)
+	{
+		return writeDeferredFiles(files);
+	}
+	deferredWriteThread = wzThreadCreate(deferredWriteThreadFunc, files);
+	wzThreadStart(deferredWriteThread);
+	return true;
+}
+
+bool saveFileDeferWait()
+{
+	if (deferredWriteThread == NULL)
+	{
+		return true;
+	}
+	bool ok = wzThreadJoin(deferredWriteThread);
+	deferredWriteThread = NULL;
+	return ok;
+}
+
+bool saveFileDeferring()
+{
+	return deferredFiles != NULL;
+}
+
 /***************************************************************************
 	Save the data in the buffer into the given file.
 ***************************************************************************/
 bool saveFile(const char *pFileName, const char *pFileData, UDWORD fileSize)
+{
+	if (deferredFiles != NULL)
+	{
+		deferredFiles->files.push_back(DeferredFile(pFileName, pFileData, fileSize));
+		return true;
+	}
+	return saveFileNow(pFileName, pFileData, fileSize);
+}
+
+static bool saveFileNow(const char *pFileName, const char *pFileData, UDWORD fileSize)
 {
 	PHYSFS_file *pfile;
 	PHYSFS_uint32 size = fileSize;
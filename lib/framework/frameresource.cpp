@@ -30,9 +30,24 @@
 
 #include "file.h"
 #include "resly.h"
+#include "wzapp.h"
+#include "wztime.h"
+#include "wzprofile.h"
+
+#include <vector>
+
+/// Number of threads reading and decoding the files of a res file
+#define RES_LOAD_THREADS	3
+/// Maximum number of files read ahead of the one being registered, bounds the memory held by decoded files
+#define RES_LOAD_WINDOW		64
+/// Number of slots of the resource type table, a power of two well above the number of types
+#define RES_TYPE_SLOTS		128
+/// Initial number of slots of the resource tables of a type, a power of two
+#define RES_TABLE_MIN_SLOTS	16
 
 // Local prototypes
 static RES_TYPE *psResTypes=NULL;
+static RES_TYPE *apResTypeTable[RES_TYPE_SLOTS];	///< psResTypes by HashedType, open addressing with linear probing
 
 /* The initial resource directory and the current resource directory */
 char aResDir[PATH_MAX];
@@ -41,8 +56,23 @@ char aCurrResDir[PATH_MAX];
 // the current resource block ID
 static SDWORD resBlockID;
 
+/// A file listed in a res file, read and decoded by a loader thread before resFinishFile registers it
+struct RES_PENDING
+{
+	RES_TYPE	*psT;
+	char		*aFileName;		///< Path the file is read from
+	char		*aID;			///< Name the resource is registered under
+	void		*pDecoded;		///< Decoded data, or the file contents for buffer load types
+	UDWORD		size;			///< Size of the file contents for buffer load types
+	bool		done;			///< Set once the loader thread is done with the file
+	bool		ok;			///< Whether reading and decoding succeeded
+	uint64_t	readTime;		///< Microseconds spent reading and decoding
+};
+
+static std::vector<RES_PENDING> *resPendingFiles = NULL;	///< Files collected while parsing a res file, NULL when loading files immediately
+
 // prototypes
-static void ResetResourceFile(void);
+static bool resLoadPendingFiles(const char *pResFile, std::vector<RES_PENDING> &files);
 
 // callback to resload screen.
 static RESLOAD_CALLBACK resLoadCallback=NULL;
@@ -73,8 +103,6 @@ bool resInitialise(void)
 	resBlockID = 0;
 	resLoadCallback = NULL;
 
-	ResetResourceFile();
-
 	return true;
 }
 
@@ -104,8 +132,10 @@ void resSetBaseDir(const char* pResDir)
 /* Parse the res file */
 bool resLoad(const char *pResFile, SDWORD blockID)
 {
+	WzProfilePhase profile(pResFile);
 	bool retval = true;
 	lexerinput_t input;
+	std::vector<RES_PENDING> files;
 
 	sstrcpy(aCurrResDir, aResDir);
 
@@ -123,21 +153,66 @@ bool resLoad(const char *pResFile, SDWORD blockID)
 		return false;
 	}
 
-	// and parse it
+	// and parse it, collecting the files to load
+	resPendingFiles = &files;
 	res_set_extra(&input);
 	if (res_parse() != 0)
 	{
 		debug(LOG_FATAL, "Failed to parse %s", pResFile);
 		retval = false;
 	}
+	resPendingFiles = NULL;
 
 	res_lex_destroy();
 	PHYSFS_close(input.input.physfsfile);
 
+	// Load the files listed before any parse error, like they would have been when loading while parsing
+	if (!resLoadPendingFiles(pResFile, files))
+	{
+		retval = false;
+	}
+
 	return retval;
 }
 
 
+/// Slot at which the search for key starts in a table with the given mask
+static inline unsigned resTableSlot(unsigned mask, uintptr_t key)
+{
+	// Fibonacci hashing, so that keys differing only in their high or low bits still spread out
+	return (unsigned)(((uint64_t)key * 0x9E3779B97F4A7C15ULL) >> 32) & mask;
+}
+
+/// Find the resource type with the given HashedType
+static RES_TYPE *resFindType(UDWORD HashedType)
+{
+	unsigned i;
+
+	for (i = resTableSlot(RES_TYPE_SLOTS - 1, HashedType); apResTypeTable[i] != NULL; i = (i + 1) % RES_TYPE_SLOTS)
+	{
+		if (apResTypeTable[i]->HashedType == HashedType)
+		{
+			return apResTypeTable[i];
+		}
+	}
+	return NULL;
+}
+
+/// Add a resource type to psResTypes and the type table
+static void resAddType(RES_TYPE *psT)
+{
+	unsigned i, count = 0;
+
+	for (i = resTableSlot(RES_TYPE_SLOTS - 1, psT->HashedType); apResTypeTable[i] != NULL; i = (i + 1) % RES_TYPE_SLOTS)
+	{
+		ASSERT_OR_RETURN(, ++count < RES_TYPE_SLOTS / 2, "Too many resource types, increase RES_TYPE_SLOTS");
+	}
+	apResTypeTable[i] = psT;
+
+	psT->psNext = psResTypes;
+	psResTypes = psT;
+}
+
 /* Allocate a RES_TYPE structure */
 static RES_TYPE* resAlloc(const char *pType)
 {
@@ -145,11 +220,7 @@ static RES_TYPE* resAlloc(const char *pType)
 
 #ifdef DEBUG
 	// Check for a duplicate type
-	for(psT = psResTypes; psT; psT = psT->psNext)
-	{
-		ASSERT( strcmp(psT->aType, pType) != 0,
-			"resAlloc: Duplicate function for type: %s", pType );
-	}
+	ASSERT(resFindType(HashString(pType)) == NULL, "resAlloc: Duplicate function for type: %s", pType);
 #endif
 
 	// Allocate the memory
@@ -166,7 +237,16 @@ static RES_TYPE* resAlloc(const char *pType)
 
 	psT->HashedType = HashString(psT->aType); // store a hased version for super speed !
 
-	psT->psRes = NULL;
+	memset(&psT->byID, 0, sizeof(psT->byID));
+	memset(&psT->byData, 0, sizeof(psT->byData));
+	psT->psBlocks = NULL;
+
+	psT->buffLoad = NULL;
+	psT->fileLoad = NULL;
+	psT->decode = NULL;
+	psT->decodedLoad = NULL;
+	psT->decodedRelease = NULL;
+	psT->release = NULL;
 
 	return psT;
 }
@@ -185,11 +265,9 @@ bool resAddBufferLoad(const char *pType, RES_BUFFERLOAD buffLoad,
 	}
 
 	psT->buffLoad = buffLoad;
-	psT->fileLoad = NULL;
 	psT->release = release;
 
-	psT->psNext = psResTypes;
-	psResTypes = psT;
+	resAddType(psT);
 
 	return true;
 }
@@ -206,12 +284,32 @@ bool resAddFileLoad(const char *pType, RES_FILELOAD fileLoad,
 		return false;
 	}
 
-	psT->buffLoad = NULL;
 	psT->fileLoad = fileLoad;
 	psT->release = release;
 
-	psT->psNext = psResTypes;
-	psResTypes = psT;
+	resAddType(psT);
+
+	return true;
+}
+
+
+/* Add a decode function and a load function for the decoded data for a file type */
+bool resAddDecodeLoad(const char *pType, RES_FILEDECODE decode, RES_DECODEDLOAD decodedLoad,
+                      RES_FREE decodedRelease, RES_FREE release)
+{
+	RES_TYPE	*psT = resAlloc(pType);
+
+	if (!psT)
+	{
+		return false;
+	}
+
+	psT->decode = decode;
+	psT->decodedLoad = decodedLoad;
+	psT->decodedRelease = decodedRelease;
+	psT->release = release;
+
+	resAddType(psT);
 
 	return true;
 }
@@ -250,123 +348,192 @@ void SetLastResourceFilename(const char *pName)
 }
 
 
-// Structure for each file currently in use in the resource  ... probably only going to be one ... but we will handle upto MAXLOADEDRESOURCE
-struct RESOURCEFILE
+static inline RES_DATA* resDataInit(const char *DebugName, UDWORD DataIDHash, void *pData, UDWORD BlockID)
 {
-  	char *pBuffer;	// a pointer to the data
-	UDWORD size;	// number of bytes
-	UBYTE	type;	// what type of resource is it
-};
-
-#define RESFILETYPE_EMPTY (0)			// empty entry
-#define RESFILETYPE_PC_SBL (1)			// Johns SBL stuff
-#define RESFILETYPE_LOADED (2)			// Loaded from a file (!)
-#define RESFILETYPE_WDGPTR (3)			// A pointer from the WDG cache
+	char* resID;
 
+	// Allocate memory to hold the RES_DATA structure plus the identifying string
+	RES_DATA *psRes = (RES_DATA *)malloc(sizeof(RES_DATA) + strlen(DebugName) + 1);
+	if (!psRes)
+	{
+		debug(LOG_ERROR, "resDataInit: Out of memory");
+		return NULL;
+	}
 
-#define MAXLOADEDRESOURCES (6)
-static RESOURCEFILE LoadedResourceFiles[MAXLOADEDRESOURCES];
+	// Initialize the pointer for our ID string
+	resID = (char*)(psRes + 1);
 
+	// Copy over the identifying string
+	strcpy(resID, DebugName);
+	psRes->aID = resID;
 
+	psRes->pData = pData;
+	psRes->blockID = BlockID;
+	psRes->HashedID = DataIDHash;
 
-// Clear out the resource list ... needs to be called during init.
-static void ResetResourceFile(void)
-{
-	UWORD i;
+	psRes->usage = 0;
 
-	for (i=0;i<MAXLOADEDRESOURCES;i++)
-	{
-		LoadedResourceFiles[i].type=RESFILETYPE_EMPTY;
-	}
+	return psRes;
 }
 
-// Returns an empty resource entry or -1 if none exsist
-static SDWORD FindEmptyResourceFile(void)
+
+/// Key of a resource in a RES_TABLE
+typedef uintptr_t (*RES_TABLE_KEY)(const RES_DATA *psRes);
+
+static uintptr_t resKeyID(const RES_DATA *psRes)
 {
-	UWORD i;
-	for (i=0;i<MAXLOADEDRESOURCES ;i++ )
-	  {
-		if (LoadedResourceFiles[i].type==RESFILETYPE_EMPTY)
-			return(i);
+	return psRes->HashedID;
+}
 
-	  }
-	return(-1);			// ERROR
+static uintptr_t resKeyData(const RES_DATA *psRes)
+{
+	return (uintptr_t)psRes->pData;
 }
 
+static void resTableInsert(RES_TABLE *psTable, RES_TABLE_KEY key, RES_DATA *psRes);
 
-// Get a resource data file ... either loads it or just returns a pointer
-static bool RetreiveResourceFile(char *ResourceName, RESOURCEFILE **NewResource)
+/// Double the number of slots of a table, or allocate the initial ones
+static void resTableGrow(RES_TABLE *psTable, RES_TABLE_KEY key)
 {
-	SDWORD ResID;
-	RESOURCEFILE *ResData;
-	UDWORD size;
-	char *pBuffer;
+	RES_TABLE old = *psTable;
+	unsigned size = old.apRes == NULL ? RES_TABLE_MIN_SLOTS : (old.mask + 1) * 2;
+	unsigned i;
+
+	psTable->apRes = (RES_DATA **)calloc(size, sizeof(*psTable->apRes));
+	if (psTable->apRes == NULL)
+	{
+		debug(LOG_FATAL, "resTableGrow: Out of memory");
+		abort();
+	}
+	psTable->mask = size - 1;
+	psTable->count = 0;
 
-	ResID=FindEmptyResourceFile();
-	if (ResID==-1) return(false);		// all resource files are full
+	for (i = 0; old.apRes != NULL && i <= old.mask; ++i)
+	{
+		if (old.apRes[i] != NULL)
+		{
+			resTableInsert(psTable, key, old.apRes[i]);
+		}
+	}
+	free(old.apRes);
+}
 
-	ResData= &LoadedResourceFiles[ResID];
-	*NewResource=ResData;
+static void resTableInsert(RES_TABLE *psTable, RES_TABLE_KEY key, RES_DATA *psRes)
+{
+	unsigned i;
 
-	// This is needed for files that do not fit in the WDG cache ... (VAB file for example)
-	if (!loadFile(ResourceName, &pBuffer, &size))
+	// Keep the table at most half full, so that probe sequences stay short
+	if (psTable->apRes == NULL || (psTable->count + 1) * 2 > psTable->mask + 1)
 	{
-		return false;
+		resTableGrow(psTable, key);
 	}
 
-	ResData->type=RESFILETYPE_LOADED;
-	ResData->size=size;
-	ResData->pBuffer=pBuffer;
-	return(true);
+	for (i = resTableSlot(psTable->mask, key(psRes)); psTable->apRes[i] != NULL; i = (i + 1) & psTable->mask) {}
+	psTable->apRes[i] = psRes;
+	++psTable->count;
 }
 
-
-// Free up the file depending on what type it is
-static void FreeResourceFile(RESOURCEFILE *OldResource)
+/// Find the first resource whose key is value
+static RES_DATA *resTableFind(const RES_TABLE *psTable, RES_TABLE_KEY key, uintptr_t value)
 {
-	switch (OldResource->type)
+	unsigned i;
+
+	if (psTable->apRes == NULL)
 	{
-		case RESFILETYPE_LOADED:
-			free(OldResource->pBuffer);
-			OldResource->pBuffer = NULL;
-			break;
+		return NULL;
+	}
 
-		default:
-			debug(LOG_WARNING, "resource not freed");
+	for (i = resTableSlot(psTable->mask, value); psTable->apRes[i] != NULL; i = (i + 1) & psTable->mask)
+	{
+		if (key(psTable->apRes[i]) == value)
+		{
+			return psTable->apRes[i];
+		}
 	}
+	return NULL;
+}
 
+static void resTableRemove(RES_TABLE *psTable, RES_TABLE_KEY key, const RES_DATA *psRes)
+{
+	unsigned i, j;
 
-	// Remove from the list
-	OldResource->type=RESFILETYPE_EMPTY;
+	ASSERT_OR_RETURN(, psTable->apRes != NULL, "Resource %s not in table", psRes->aID);
+	for (i = resTableSlot(psTable->mask, key(psRes)); psTable->apRes[i] != psRes; i = (i + 1) & psTable->mask)
+	{
+		ASSERT_OR_RETURN(, psTable->apRes[i] != NULL, "Resource %s not in table", psRes->aID);
+	}
+
+	// Move later entries of the probe sequence into the hole, unless that would put them before their first slot
+	for (j = (i + 1) & psTable->mask; psTable->apRes[j] != NULL; j = (j + 1) & psTable->mask)
+	{
+		unsigned home = resTableSlot(psTable->mask, key(psTable->apRes[j]));
+
+		if (((j - home) & psTable->mask) >= ((j - i) & psTable->mask))
+		{
+			psTable->apRes[i] = psTable->apRes[j];
+			i = j;
+		}
+	}
+	psTable->apRes[i] = NULL;
+	--psTable->count;
 }
 
+static void resTableClear(RES_TABLE *psTable)
+{
+	free(psTable->apRes);
+	memset(psTable, 0, sizeof(*psTable));
+}
 
-static inline RES_DATA* resDataInit(const char *DebugName, UDWORD DataIDHash, void *pData, UDWORD BlockID)
+/// Add a loaded resource to the tables and the block list of its type
+static void resAddData(RES_TYPE *psT, RES_DATA *psRes)
 {
-	char* resID;
+	RES_BLOCK *psBlock;
 
-	// Allocate memory to hold the RES_DATA structure plus the identifying string
-	RES_DATA *psRes = (RES_DATA *)malloc(sizeof(RES_DATA) + strlen(DebugName) + 1);
-	if (!psRes)
+	for (psBlock = psT->psBlocks; psBlock != NULL && psBlock->blockID != psRes->blockID; psBlock = psBlock->psNext) {}
+	if (psBlock == NULL)
 	{
-		debug(LOG_ERROR, "resDataInit: Out of memory");
-		return NULL;
+		psBlock = (RES_BLOCK *)malloc(sizeof(*psBlock));
+		if (psBlock == NULL)
+		{
+			debug(LOG_FATAL, "resAddData: Out of memory");
+			abort();
+		}
+		psBlock->blockID = psRes->blockID;
+		psBlock->psRes = NULL;
+		psBlock->psNext = psT->psBlocks;
+		psT->psBlocks = psBlock;
 	}
 
-	// Initialize the pointer for our ID string
-	resID = (char*)(psRes + 1);
+	psRes->psNext = psBlock->psRes;
+	psBlock->psRes = psRes;
+	resTableInsert(&psT->byID, resKeyID, psRes);
+	resTableInsert(&psT->byData, resKeyData, psRes);
+}
 
-	// Copy over the identifying string
-	strcpy(resID, DebugName);
-	psRes->aID = resID;
+/// Release all resources of a type loaded in a block, and the block itself
+static void resReleaseBlock(RES_TYPE *psT, RES_BLOCK *psBlock)
+{
+	RES_DATA *psRes, *psNRes;
 
-	psRes->pData = pData;
-	psRes->blockID = BlockID;
-	psRes->HashedID = DataIDHash;
+	for (psRes = psBlock->psRes; psRes != NULL; psRes = psNRes)
+	{
+		if (psRes->usage == 0)
+		{
+			debug(LOG_NEVER, "%s resource: %s(%04x) not used", psT->aType, psRes->aID, psRes->HashedID);
+		}
 
-	psRes->usage = 0;
+		if (psT->release != NULL)
+		{
+			psT->release(psRes->pData);
+		}
 
-	return psRes;
+		resTableRemove(&psT->byID, resKeyID, psRes);
+		resTableRemove(&psT->byData, resKeyData, psRes);
+
+		psNRes = psRes->psNext;
+		free(psRes);
+	}
+	free(psBlock);
 }
 
 
@@ -402,104 +569,131 @@ static void makeLocaleFile(char* fileName, size_t maxlen)  // given string must
 }
 
 
-/*!
- * Call the load function (registered in data.c)
- * for this filetype
- */
-bool resLoadFile(const char *pType, const char *pFile)
+/// Shared state of the loader threads of a res file
+struct RES_LOADER
+{
+	std::vector<RES_PENDING> *files;
+	size_t		next;			///< Next file to be read by a loader thread
+	bool		abort;			///< Stops the loader threads
+	WZ_MUTEX	*mutex;			///< Protects next, abort and the done and ok flags of the files
+	WZ_SEMAPHORE	*readSem;		///< Posted whenever a file is done
+	WZ_SEMAPHORE	*windowSem;		///< Number of files which may still be read ahead
+};
+
+/// Time spent on the files of one type in a res file
+struct RES_TIMING
 {
 	RES_TYPE	*psT;
-	void		*pData;
-	RES_DATA	*psRes;
-	char		aFileName[PATH_MAX];
-	UDWORD HashedName, HashedType = HashString(pType);
+	unsigned	files;
+	uint64_t	readTime;		///< Reading and decoding, summed over the loader threads
+	uint64_t	finishTime;		///< Loading and registering on the main thread
+};
+
+/// Read the file and decode it if the type supports it, may run on a loader thread
+static bool resReadFile(RES_PENDING *psFile)
+{
+	RES_TYPE *psT = psFile->psT;
 
-	// Find the resource-type
-	for(psT = psResTypes; psT != NULL; psT = psT->psNext )
+	if (psT->decode)
 	{
-		if (psT->HashedType == HashedType)
+		return psT->decode(psFile->aFileName, &psFile->pDecoded);
+	}
+	else if (psT->buffLoad)
+	{
+		char *pBuffer;
+
+		// Load the file in a buffer
+		if (!loadFile(psFile->aFileName, &pBuffer, &psFile->size))
 		{
-			break;
+			debug(LOG_ERROR, "Unable to retreive resource - %s", psFile->aFileName);
+			return false;
 		}
+		psFile->pDecoded = pBuffer;
 	}
 
-	if (psT == NULL)
-	{
-		debug(LOG_WZ, "resLoadFile: Unknown type: %s", pType);
-		return false;
-	}
+	// File load functions read the file themselves
+	return true;
+}
 
-	// Check for duplicates
-	HashedName = HashStringIgnoreCase(pFile);
-	for (psRes = psT->psRes; psRes; psRes = psRes->psNext)
+/// Release whatever resReadFile left behind for a file
+static void resFreePendingFile(RES_PENDING *psFile)
+{
+	if (psFile->pDecoded != NULL)
 	{
-		if(psRes->HashedID == HashedName)
+		if (psFile->psT->decode == NULL)
+		{
+			free(psFile->pDecoded);
+		}
+		else if (psFile->psT->decodedRelease != NULL)
 		{
-			debug(LOG_WZ, "resLoadFile: Duplicate file name: %s (hash %x) for type %s",
-			      pFile, HashedName, psT->aType);
-			// assume that they are actually both the same and silently fail
-			// lovely little hack to allow some files to be loaded from disk (believe it or not!).
-			return true;
+			psFile->psT->decodedRelease(psFile->pDecoded);
 		}
+		psFile->pDecoded = NULL;
 	}
+	free(psFile->aFileName);
+	free(psFile->aID);
+	psFile->aFileName = NULL;
+	psFile->aID = NULL;
+}
 
-	// Create the file name
-	if (strlen(aCurrResDir) + strlen(pFile) + 1 >= PATH_MAX)
+/// Turn a read file into a resource and register it, runs on the main thread
+static bool resFinishFile(RES_PENDING *psFile)
+{
+	RES_TYPE	*psT = psFile->psT;
+	RES_DATA	*psRes;
+	void		*pData = NULL;
+	UDWORD		HashedName = HashStringIgnoreCase(psFile->aID);
+	bool		ok = psFile->ok;
+
+	// A res file may list the same file twice, the first one wins
+	if (resTableFind(&psT->byID, resKeyID, HashedName) != NULL)
 	{
-		debug(LOG_ERROR, "resLoadFile: Filename too long!! %s%s", aCurrResDir, pFile);
-		return false;
+		debug(LOG_WZ, "Duplicate file name: %s (hash %x) for type %s", psFile->aID, HashedName, psT->aType);
+		resFreePendingFile(psFile);
+		return true;
 	}
-	sstrcpy(aFileName, aCurrResDir);
-	sstrcat(aFileName, pFile);
-
-	makeLocaleFile(aFileName, sizeof(aFileName));  // check for translated file
 
-	SetLastResourceFilename(pFile); // Save the filename in case any routines need it
+	SetLastResourceFilename(psFile->aID); // Save the filename in case any routines need it
 
 	// load the resource
-	if (psT->buffLoad)
+	if (!ok)
+	{
+		// Reading or decoding failed already
+	}
+	else if (psT->decodedLoad)
+	{
+		// The load function takes ownership of the decoded data
+		ok = psT->decodedLoad(psFile->aFileName, psFile->pDecoded, &pData);
+		psFile->pDecoded = NULL;
+	}
+	else if (psT->buffLoad)
 	{
-		RESOURCEFILE *Resource;
-
-		// Load the file in a buffer
-		if (!RetreiveResourceFile(aFileName, &Resource))
-		{
-			debug(LOG_ERROR, "resLoadFile: Unable to retreive resource - %s", aFileName);
-			return false;
-		}
-
 		// Now process the buffer data
-		if (!psT->buffLoad(Resource->pBuffer, Resource->size, &pData))
-		{
-			ASSERT(false, "The load function for resource type \"%s\" failed for file \"%s\"", pType, pFile);
-			FreeResourceFile(Resource);
-			if (psT->release != NULL)
-			{
-				psT->release(pData);
-			}
-			return false;
-		}
-
-		FreeResourceFile(Resource);
+		ok = psT->buffLoad((const char *)psFile->pDecoded, psFile->size, &pData);
 	}
-	else if(psT->fileLoad)
+	else if (psT->fileLoad)
 	{
 		// Process data directly from file
-		if (!psT->fileLoad(aFileName, &pData))
-		{
-			ASSERT(false, "The load function for resource type \"%s\" failed for file \"%s\"", pType, pFile);
-			if (psT->release != NULL)
-			{
-				psT->release(pData);
-			}
-			return false;
-		}
+		ok = psT->fileLoad(psFile->aFileName, &pData);
 	}
 	else
 	{
-		ASSERT(false, "No load functions for this type (%s)", pType);
+		ASSERT(false, "No load functions for this type (%s)", psT->aType);
+		resFreePendingFile(psFile);
+		return false;
+	}
+
+	if (!ok)
+	{
+		ASSERT(false, "The load function for resource type \"%s\" failed for file \"%s\"", psT->aType, psFile->aID);
+		if (psT->release != NULL && pData != NULL)
+		{
+			psT->release(pData);
+		}
+		resFreePendingFile(psFile);
 		return false;
 	}
+	resFreePendingFile(psFile);
 
 	resDoResLoadCallback();		// do callback.
 
@@ -517,45 +711,207 @@ bool resLoadFile(const char *pType, const char *pFile)
 			return false;
 		}
 
-		// Add the resource to the list
-		psRes->psNext = psT->psRes;
-		psT->psRes = psRes;
+		resAddData(psT, psRes);
 	}
 	return true;
 }
 
-/* Return the resource for a type and hashedname */
-void *resGetDataFromHash(const char *pType, UDWORD HashedID)
+static int resLoaderThreadFunc(void *data)
 {
-	RES_TYPE	*psT = NULL;
-	RES_DATA	*psRes = NULL;
-	// Find the correct type
-	UDWORD HashedType = HashString(pType);
+	RES_LOADER *psLoader = (RES_LOADER *)data;
 
-	for(psT = psResTypes; psT != NULL; psT = psT->psNext )
+	for (;;)
 	{
-		if (psT->HashedType==HashedType)
+		RES_PENDING *psFile;
+		uint64_t startTime;
+		bool ok;
+
+		// Don't read too far ahead of the main thread
+		wzSemaphoreWait(psLoader->windowSem);
+
+		wzMutexLock(psLoader->mutex);
+		if (psLoader->abort || psLoader->next >= psLoader->files->size())
 		{
-			/* We found it */
-			break;
+			wzMutexUnlock(psLoader->mutex);
+			return 0;
 		}
+		psFile = &(*psLoader->files)[psLoader->next++];
+		wzMutexUnlock(psLoader->mutex);
+
+		startTime = wzGetMicroTicks();
+		ok = resReadFile(psFile);
+		psFile->readTime = wzGetMicroTicks() - startTime;
+
+		wzMutexLock(psLoader->mutex);
+		psFile->ok = ok;
+		psFile->done = true;
+		wzMutexUnlock(psLoader->mutex);
+		wzSemaphorePost(psLoader->readSem);
 	}
+}
 
-	ASSERT( psT != NULL, "resGetDataFromHash: Unknown type: %s", pType );
-	if (psT == NULL)
+/*!
+ * Load the files collected while parsing a res file.
+ * Loader threads read and decode the files in order while the main thread
+ * loads and registers them, in the same order as listed in the res file.
+ */
+static bool resLoadPendingFiles(const char *pResFile, std::vector<RES_PENDING> &files)
+{
+	RES_LOADER loader;
+	WZ_THREAD *threads[RES_LOAD_THREADS];
+	std::vector<RES_TIMING> timings;
+	unsigned numThreads = MIN(files.size(), RES_LOAD_THREADS);
+	uint64_t startTime = wzGetMicroTicks(), waitTime = 0;
+	bool ok = true;
+	size_t i;
+	unsigned t;
+
+	if (files.empty())
 	{
-		return NULL;
+		return true;
+	}
+
+	loader.files = &files;
+	loader.next = 0;
+	loader.abort = false;
+	loader.mutex = wzMutexCreate();
+	loader.readSem = wzSemaphoreCreate(0);
+	loader.windowSem = wzSemaphoreCreate(RES_LOAD_WINDOW);
+	for (t = 0; t < numThreads; ++t)
+	{
+		threads[t] = wzThreadCreate(resLoaderThreadFunc, &loader);
+		wzThreadStart(threads[t]);
 	}
 
-	for(psRes = psT->psRes; psRes != NULL; psRes = psRes->psNext)
+	for (i = 0; i < files.size() && ok; ++i)
 	{
-		if (psRes->HashedID == HashedID)
+		RES_PENDING *psFile = &files[i];
+		uint64_t waitStart = wzGetMicroTicks(), finishStart;
+		std::vector<RES_TIMING>::iterator timing;
+
+		wzMutexLock(loader.mutex);
+		while (!psFile->done)
 		{
-			/* We found it */
-			break;
+			wzMutexUnlock(loader.mutex);
+			wzSemaphoreWait(loader.readSem);
+			wzMutexLock(loader.mutex);
 		}
+		wzMutexUnlock(loader.mutex);
+
+		finishStart = wzGetMicroTicks();
+		waitTime += finishStart - waitStart;
+
+		ok = resFinishFile(psFile);
+		wzSemaphorePost(loader.windowSem);
+
+		for (timing = timings.begin(); timing != timings.end() && timing->psT != psFile->psT; ++timing) {}
+		if (timing == timings.end())
+		{
+			RES_TIMING newTiming = {psFile->psT, 0, 0, 0};
+			timing = timings.insert(timings.end(), newTiming);
+		}
+		++timing->files;
+		timing->readTime += psFile->readTime;
+		timing->finishTime += wzGetMicroTicks() - finishStart;
 	}
 
+	// Stop the loader threads, they are still reading ahead if a file failed to load
+	wzMutexLock(loader.mutex);
+	loader.abort = true;
+	wzMutexUnlock(loader.mutex);
+	for (t = 0; t < numThreads; ++t)
+	{
+		wzSemaphorePost(loader.windowSem);
+	}
+	for (t = 0; t < numThreads; ++t)
+	{
+		wzThreadJoin(threads[t]);
+	}
+	for (; i < files.size(); ++i)
+	{
+		resFreePendingFile(&files[i]);
+	}
+	wzSemaphoreDestroy(loader.windowSem);
+	wzSemaphoreDestroy(loader.readSem);
+	wzMutexDestroy(loader.mutex);
+
+	debug(LOG_WZ, "%s: %u files in %u ms, main thread waited %u ms for the loader threads", pResFile,
+	      (unsigned)files.size(), (unsigned)((wzGetMicroTicks() - startTime) / 1000), (unsigned)(waitTime / 1000));
+	for (std::vector<RES_TIMING>::const_iterator timing = timings.begin(); timing != timings.end(); ++timing)
+	{
+		debug(LOG_WZ, "  %s: %u files, read and decode %u ms, load %u ms", timing->psT->aType, timing->files,
+		      (unsigned)(timing->readTime / 1000), (unsigned)(timing->finishTime / 1000));
+	}
+
+	return ok;
+}
+
+
+/*!
+ * Call the load function (registered in data.c)
+ * for this filetype
+ */
+bool resLoadFile(const char *pType, const char *pFile)
+{
+	RES_TYPE	*psT = resFindType(HashString(pType));
+	char		aFileName[PATH_MAX];
+	UDWORD HashedName;
+
+	if (psT == NULL)
+	{
+		debug(LOG_WZ, "resLoadFile: Unknown type: %s", pType);
+		return false;
+	}
+
+	// Check for duplicates
+	HashedName = HashStringIgnoreCase(pFile);
+	if (resTableFind(&psT->byID, resKeyID, HashedName) != NULL)
+	{
+		debug(LOG_WZ, "resLoadFile: Duplicate file name: %s (hash %x) for type %s",
+		      pFile, HashedName, psT->aType);
+		// assume that they are actually both the same and silently fail
+		// lovely little hack to allow some files to be loaded from disk (believe it or not!).
+		return true;
+	}
+
+	// Create the file name
+	if (strlen(aCurrResDir) + strlen(pFile) + 1 >= PATH_MAX)
+	{
+		debug(LOG_ERROR, "resLoadFile: Filename too long!! %s%s", aCurrResDir, pFile);
+		return false;
+	}
+	sstrcpy(aFileName, aCurrResDir);
+	sstrcat(aFileName, pFile);
+
+	makeLocaleFile(aFileName, sizeof(aFileName));  // check for translated file
+
+	RES_PENDING file = {psT, strdup(aFileName), strdup(pFile), NULL, 0, false, false, 0};
+
+	if (resPendingFiles != NULL)
+	{
+		// resLoad hands it to the loader threads once the whole res file is parsed
+		resPendingFiles->push_back(file);
+		return true;
+	}
+
+	file.ok = resReadFile(&file);
+	return resFinishFile(&file);
+}
+
+/* Return the resource for a type and hashedname */
+void *resGetDataFromHash(const char *pType, UDWORD HashedID)
+{
+	RES_TYPE	*psT = resFindType(HashString(pType));
+	RES_DATA	*psRes;
+
+	ASSERT( psT != NULL, "resGetDataFromHash: Unknown type: %s", pType );
+	if (psT == NULL)
+	{
+		return NULL;
+	}
+
+	psRes = resTableFind(&psT->byID, resKeyID, HashedID);
+
 	ASSERT( psRes != NULL, "resGetDataFromHash: Unknown ID: %0x Type: %s", HashedID, pType );
 	if (psRes == NULL)
 	{
@@ -579,19 +935,11 @@ void *resGetData(const char *pType, const char *pID)
 
 bool resGetHashfromData(const char *pType, const void *pData, UDWORD *pHash)
 {
-	RES_TYPE	*psT;
 	RES_DATA	*psRes;
 
 	// Find the correct type
 	UDWORD	HashedType=HashString(pType);
-
-	for(psT = psResTypes; psT != NULL; psT = psT->psNext )
-	{
-		if (psT->HashedType==HashedType)
-		{
-			break;
-		}
-	}
+	RES_TYPE	*psT = resFindType(HashedType);
 
 	if (psT == NULL)
 	{
@@ -600,14 +948,7 @@ bool resGetHashfromData(const char *pType, const void *pData, UDWORD *pHash)
 	}
 
 	// Find the resource
-	for(psRes = psT->psRes; psRes; psRes = psRes->psNext)
-	{
-
-		if (psRes->pData == pData)
-		{
-			break;
-		}
-	}
+	psRes = resTableFind(&psT->byData, resKeyData, (uintptr_t)pData);
 
 	if (psRes == NULL)
 	{
@@ -635,13 +976,7 @@ const char* resGetNamefromData(const char* type, const void *data)
 	HashedType = HashString(type);
 
 	// Find the resource table for the given type
-	for (psT = psResTypes; psT != NULL; psT = psT->psNext)
-	{
-		if (psT->HashedType == HashedType)
-		{
-			break;
-		}
-	}
+	psT = resFindType(HashedType);
 
 	if (psT == NULL)
 	{
@@ -650,13 +985,7 @@ const char* resGetNamefromData(const char* type, const void *data)
 	}
 
 	// Find the resource in the resource table
-	for(psRes = psT->psRes; psRes; psRes = psRes->psNext)
-	{
-		if (psRes->pData == data)
-		{
-			break;
-		}
-	}
+	psRes = resTableFind(&psT->byData, resKeyData, (uintptr_t)data);
 
 	if (psRes == NULL)
 	{
@@ -670,19 +999,7 @@ const char* resGetNamefromData(const char* type, const void *data)
 /* Simply returns true if a resource is present */
 bool resPresent(const char *pType, const char *pID)
 {
-	RES_TYPE	*psT;
-	RES_DATA	*psRes;
-
-	// Find the correct type
-	UDWORD HashedType=HashString(pType);
-
-	for(psT = psResTypes; psT != NULL; psT = psT->psNext )
-	{
-		if (psT->HashedType==HashedType)
-		{
-			break;
-		}
-	}
+	RES_TYPE	*psT = resFindType(HashString(pType));
 
 	/* Bow out if unrecognised type */
 	ASSERT(psT != NULL, "resPresent: Unknown type");
@@ -691,26 +1008,7 @@ bool resPresent(const char *pType, const char *pID)
 		return false;
 	}
 
-	{
-		UDWORD HashedID=HashStringIgnoreCase(pID);
-
-		for(psRes = psT->psRes; psRes; psRes = psRes->psNext)
-		{
-			if (psRes->HashedID==HashedID)
-			{
-				/* We found it */
-				break;
-			}
-		}
-	}
-
-	/* Did we find it? */
-	if (psRes != NULL)
-	{
-		return (true);
-	}
-
-	return (false);
+	return resTableFind(&psT->byID, resKeyID, HashStringIgnoreCase(pID)) != NULL;
 }
 
 
@@ -728,6 +1026,7 @@ void resReleaseAll(void)
 	}
 
 	psResTypes = NULL;
+	memset(apResTypeTable, 0, sizeof(apResTypeTable));
 }
 
 
@@ -735,27 +1034,19 @@ void resReleaseAll(void)
 void resReleaseAllData(void)
 {
 	RES_TYPE *psT;
-	RES_DATA *psRes, *psNRes;
+	RES_BLOCK *psBlock, *psNBlock;
 
 	for (psT = psResTypes; psT != NULL; psT = psT->psNext)
 	{
-		for(psRes = psT->psRes; psRes != NULL; psRes = psNRes)
+		for (psBlock = psT->psBlocks; psBlock != NULL; psBlock = psNBlock)
 		{
-			if (psRes->usage == 0)
-			{
-				debug(LOG_NEVER, "resReleaseAllData: %s resource: %s(%04x) not used", psT->aType, psRes->aID, psRes->HashedID);
-			}
-
-			if (psT->release != NULL)
-			{
-				psT->release(psRes->pData);
-			}
-
-			psNRes = psRes->psNext;
-			free(psRes);
+			psNBlock = psBlock->psNext;
+			resReleaseBlock(psT, psBlock);
 		}
 
-		psT->psRes = NULL;
+		psT->psBlocks = NULL;
+		resTableClear(&psT->byID);
+		resTableClear(&psT->byData);
 	}
 }
 
@@ -763,47 +1054,21 @@ void resReleaseAllData(void)
 // release the data for a particular block ID
 void resReleaseBlockData(SDWORD blockID)
 {
-	RES_TYPE	*psT, *psNT;
-	RES_DATA	*psPRes, *psRes, *psNRes;
+	RES_TYPE	*psT;
+	RES_BLOCK	**ppsBlock;
 
-	for(psT = psResTypes; psT != NULL; psT = psNT)
+	for (psT = psResTypes; psT != NULL; psT = psT->psNext)
 	{
-		psPRes = NULL;
-		for(psRes = psT->psRes; psRes; psRes = psNRes)
+		for (ppsBlock = &psT->psBlocks; *ppsBlock != NULL; ppsBlock = &(*ppsBlock)->psNext)
 		{
-			ASSERT(psRes != NULL, "resReleaseBlockData: null pointer passed into loop");
-
-			if (psRes->blockID == blockID)
+			if ((*ppsBlock)->blockID == blockID)
 			{
-				if (psRes->usage == 0)
-				{
-					debug(LOG_NEVER, "resReleaseBlockData: %s resource: %s(%04x) not used", psT->aType, psRes->aID,
-					      psRes->HashedID);
-				}
-				if(psT->release != NULL)
-				{
-					psT->release( psRes->pData );
-				}
-
-				psNRes = psRes->psNext;
-				free(psRes);
-
-				if (psPRes == NULL)
-				{
-					psT->psRes = psNRes;
-				}
-				else
-				{
-					psPRes->psNext = psNRes;
-				}
-			}
-			else
-			{
-				psPRes = psRes;
-				psNRes = psRes->psNext;
+				RES_BLOCK *psBlock = *ppsBlock;
+
+				*ppsBlock = psBlock->psNext;
+				resReleaseBlock(psT, psBlock);
+				break;
 			}
 		}
-
-		psNT = psT->psNext;
 	}
 }
@@ -38,6 +38,14 @@ typedef bool (*RES_BUFFERLOAD)(const char *pBuffer, UDWORD size, void **pData);
 /** Function pointer for a function that loads from a filename. */
 typedef bool (*RES_FILELOAD)(const char *pFile, void **pData);
 
+/** Function pointer for a function that reads and decodes a file on a loader thread.
+ *  It must not touch GL, OpenAL or any other main thread state. */
+typedef bool (*RES_FILEDECODE)(const char *pFile, void **pDecoded);
+
+/** Function pointer for a function that turns decoded data into the resource on the main thread.
+ *  It takes ownership of \c pDecoded. */
+typedef bool (*RES_DECODEDLOAD)(const char *pFile, void *pDecoded, void **pData);
+
 /** Function pointer for releasing a resource loaded by the above functions. */
 typedef void (*RES_FREE)(void *pData);
 
@@ -50,7 +58,7 @@ struct RES_DATA
 	SDWORD		blockID;			// which of the blocks is it in (so we can clear some of them...)
 
 	UDWORD	HashedID;				// hashed version of the name of the id
-	RES_DATA *      psNext;                         // next entry - most likely to be following on!
+	RES_DATA *      psNext;                         // next entry of the same type and block, most recently loaded first
 	UDWORD		usage; // Reference count
 
 	// ID of the resource - filename from the .wrf - e.g. "TRON.PIE"
@@ -58,6 +66,22 @@ struct RES_DATA
 };
 
 
+/// Open addressing hash table of the resources of one type, with linear probing
+struct RES_TABLE
+{
+	RES_DATA	**apRes;			///< Slots, NULL if unused
+	unsigned	mask;				///< Number of slots minus one, the number of slots is a power of two
+	unsigned	count;				///< Number of used slots
+};
+
+/// The resources of one type loaded in the same block
+struct RES_BLOCK
+{
+	SDWORD		blockID;
+	RES_DATA	*psRes;				///< Most recently loaded first
+	RES_BLOCK	*psNext;
+};
+
 // New reduced resource type ... specially for PSX
 // These types  are statically defined in data.c
 struct RES_TYPE
@@ -69,10 +93,16 @@ struct RES_TYPE
 	RES_FREE release;			// routine to release the data (NULL indicates none)
 
 	// we must have a pointer to the data here so that we can do a resGetData();
-	RES_DATA		*psRes;		// Linked list of data items of this type
+	RES_TABLE		byID;		///< Data items of this type by HashedID
+	RES_TABLE		byData;		///< Data items of this type by pData, for resGetHashfromData and resGetNamefromData
+	RES_BLOCK		*psBlocks;	///< Data items of this type by block, for resReleaseBlockData
 	UDWORD	HashedType;				// hashed version of the name of the id - // a null hashedtype indicates end of list
 
 	RES_FILELOAD	fileLoad;		// This isn't really used any more ?
+
+	RES_FILEDECODE	decode;			///< Reads and decodes the file on a loader thread
+	RES_DECODEDLOAD	decodedLoad;		///< Finishes loading the decoded data on the main thread
+	RES_FREE	decodedRelease;		///< Frees decoded data that was never passed to decodedLoad
 	RES_TYPE *      psNext;
 };
 
@@ -110,6 +140,12 @@ extern bool	resAddBufferLoad(const char *pType, RES_BUFFERLOAD buffLoad,
 extern bool	resAddFileLoad(const char *pType, RES_FILELOAD fileLoad,
 						   RES_FREE release);
 
+/** Add a decode, load and release function for a file type.
+ *  Files of this type listed in a res file are decoded on loader threads while earlier files
+ *  are still being registered, only \c decodedLoad runs on the main thread. */
+extern bool resAddDecodeLoad(const char *pType, RES_FILEDECODE decode, RES_DECODEDLOAD decodedLoad,
+                             RES_FREE decodedRelease, RES_FREE release);
+
 /** Call the load function for a file. */
 extern bool resLoadFile(const char *pType, const char *pFile);
 
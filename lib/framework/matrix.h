@@ -0,0 +1,126 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2011  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  4x4 float matrices, for transforms computed on the CPU.
+ *
+ *  All operations right-multiply, like the OpenGL matrix functions, so matrixTranslate(&m, ...) gives
+ *  m . translationMatrix(...). They work a whole column of 4 floats at a time, which the compiler can
+ *  turn into vector instructions.
+ */
+
+#ifndef __INCLUDED_LIB_FRAMEWORK_MATRIX_H__
+#define __INCLUDED_LIB_FRAMEWORK_MATRIX_H__
+
+#include "vector.h"
+
+struct Matrix4f
+{
+	float m[16];  ///< Column-major, m[4*column + row], so it can be passed to glLoadMatrixf() as is
+};
+
+static const float MATRIX_ANGLE_TO_RAD = 2.f * (float)M_PI / 65536.f;  ///< Converts 0..64k game angles
+
+static inline void matrixIdentity(Matrix4f *mat)
+{
+	for (int i = 0; i < 16; ++i)
+	{
+		mat->m[i] = i % 5 == 0 ? 1.f : 0.f;
+	}
+}
+
+/// mat = mat . translationMatrix(x, y, z)
+static inline void matrixTranslate(Matrix4f *mat, float x, float y, float z)
+{
+	for (int row = 0; row < 4; ++row)
+	{
+		mat->m[12 + row] += x * mat->m[row] + y * mat->m[4 + row] + z * mat->m[8 + row];
+	}
+}
+
+/// mat = mat . scaleMatrix(x, y, z)
+static inline void matrixScale(Matrix4f *mat, float x, float y, float z)
+{
+	for (int row = 0; row < 4; ++row)
+	{
+		mat->m[row] *= x;
+		mat->m[4 + row] *= y;
+		mat->m[8 + row] *= z;
+	}
+}
+
+/// Rotates columns i and j of mat into each other: col i = c*col i + s*col j, col j = c*col j - s*col i
+static inline void matrixRotateColumns(Matrix4f *mat, int i, int j, float c, float s)
+{
+	for (int row = 0; row < 4; ++row)
+	{
+		const float a = mat->m[4*i + row], b = mat->m[4*j + row];
+		mat->m[4*i + row] = c*a + s*b;
+		mat->m[4*j + row] = c*b - s*a;
+	}
+}
+
+/// mat = mat . rotationMatrix(angle, 1, 0, 0)
+static inline void matrixRotX(Matrix4f *mat, uint16_t angle)
+{
+	matrixRotateColumns(mat, 1, 2, cosf(angle * MATRIX_ANGLE_TO_RAD), sinf(angle * MATRIX_ANGLE_TO_RAD));
+}
+
+/// mat = mat . rotationMatrix(angle, 0, 1, 0)
+static inline void matrixRotY(Matrix4f *mat, uint16_t angle)
+{
+	matrixRotateColumns(mat, 0, 2, cosf(angle * MATRIX_ANGLE_TO_RAD), -sinf(angle * MATRIX_ANGLE_TO_RAD));
+}
+
+/// mat = mat . rotationMatrix(angle, 0, 0, 1)
+static inline void matrixRotZ(Matrix4f *mat, uint16_t angle)
+{
+	matrixRotateColumns(mat, 0, 1, cosf(angle * MATRIX_ANGLE_TO_RAD), sinf(angle * MATRIX_ANGLE_TO_RAD));
+}
+
+/// Returns a . b
+static inline WZ_DECL_PURE Matrix4f matrixMultiply(Matrix4f const &a, Matrix4f const &b)
+{
+	Matrix4f r;
+	for (int col = 0; col < 4; ++col)
+	{
+		for (int row = 0; row < 4; ++row)
+		{
+			r.m[4*col + row] = a.m[row] * b.m[4*col] + a.m[4 + row] * b.m[4*col + 1] + a.m[8 + row] * b.m[4*col + 2] + a.m[12 + row] * b.m[4*col + 3];
+		}
+	}
+	return r;
+}
+
+/// Returns mat . (v, 1), for matrices without projection
+static inline WZ_DECL_PURE Vector3f matrixTransform(Matrix4f const &mat, Vector3f const &v)
+{
+	return Vector3f(mat.m[0] * v.x + mat.m[4] * v.y + mat.m[8]  * v.z + mat.m[12],
+	                mat.m[1] * v.x + mat.m[5] * v.y + mat.m[9]  * v.z + mat.m[13],
+	                mat.m[2] * v.x + mat.m[6] * v.y + mat.m[10] * v.z + mat.m[14]);
+}
+
+/// Returns mat . (v, 0), which only rotates and scales v
+static inline WZ_DECL_PURE Vector3f matrixTransformDirection(Matrix4f const &mat, Vector3f const &v)
+{
+	return Vector3f(mat.m[0] * v.x + mat.m[4] * v.y + mat.m[8]  * v.z,
+	                mat.m[1] * v.x + mat.m[5] * v.y + mat.m[9]  * v.z,
+	                mat.m[2] * v.x + mat.m[6] * v.y + mat.m[10] * v.z);
+}
+
+#endif // __INCLUDED_LIB_FRAMEWORK_MATRIX_H__
@@ -22,12 +22,18 @@
 #include <QtCore/QString>
 #include <QtCore/QDateTime>
 #include <QtCore/QAbstractFileEngine>
+#include <QtCore/QByteArray>
 #include <physfs.h>
 
+#include "lib/framework/frame.h"
+#include "lib/framework/file.h"
+
 class PhysicsFileSystem : public QAbstractFileEngine
 {
 private:
 	PHYSFS_file	*fp;
+	QByteArray	*deferred;	///< Data to write with saveFile when closed, if the file was opened while saveFileDeferring().
+	qint64		deferredPos;
 	FileFlags	flags;
 	QString		name;
 	QDateTime	lastMod;
@@ -47,30 +53,61 @@ private:
 
 
 public:
-	PhysicsFileSystem(QString filename) : fp(NULL), flags(0), name(filename) { realSetFileName(filename); }
-	virtual ~PhysicsFileSystem() { if (fp) PHYSFS_close(fp); }
-	bool atEnd() const { return PHYSFS_eof(fp) != 0; }
+	PhysicsFileSystem(QString filename) : fp(NULL), deferred(NULL), deferredPos(0), flags(0), name(filename) { realSetFileName(filename); }
+	virtual ~PhysicsFileSystem() { close(); }
+	bool atEnd() const { return deferred ? deferredPos >= deferred->size() : PHYSFS_eof(fp) != 0; }
 	virtual bool caseSensitive() const { return true; }
-	virtual bool close() { if (fp) { int retval = PHYSFS_close(fp); fp = NULL; return retval != 0; } else return true; }
+	virtual bool close()
+	{
+		if (deferred)
+		{
+			bool retval = saveFile(name.toUtf8().constData(), deferred->constData(), deferred->size());
+			delete deferred;
+			deferred = NULL;
+			return retval;
+		}
+		if (fp) { int retval = PHYSFS_close(fp); fp = NULL; return retval != 0; } else return true;
+	}
 	QFile::FileError error() const { return QFile::UnspecifiedError; }
 	QString errorString() const { return QString(PHYSFS_getLastError()); }
 	virtual bool extension(Extension extension, const ExtensionOption * option = 0, ExtensionReturn * output = 0) { return extension == QAbstractFileEngine::AtEndExtension; }
 	virtual FileFlags fileFlags(FileFlags type = FileInfoAll) const { return type & flags; }
 	virtual QDateTime fileTime(FileTime time) const { if (time == QAbstractFileEngine::ModificationTime) return lastMod; else return QDateTime(); }
-	virtual bool flush() { return PHYSFS_flush(fp) != 0; }
+	virtual bool flush() { return deferred || PHYSFS_flush(fp) != 0; }
 	virtual bool isRelativePath() const { return true; }	// in physfs, all paths are relative
 	virtual bool isSequential() const { return true; }
 	virtual bool mkdir(const QString & dirName, bool createParentDirectories) const { Q_UNUSED(createParentDirectories); return PHYSFS_mkdir(dirName.toUtf8().constData()) != 0; }
-	virtual qint64 pos() const { return PHYSFS_tell(fp); }
-	virtual qint64 read(char *data, qint64 maxlen) { return PHYSFS_read(fp, data, 1, maxlen); }
+	virtual qint64 pos() const { return deferred ? deferredPos : PHYSFS_tell(fp); }
+	virtual qint64 read(char *data, qint64 maxlen) { return deferred ? 0 : PHYSFS_read(fp, data, 1, maxlen); }
 	virtual bool remove() { return PHYSFS_delete(name.toUtf8().constData()) != 0; }
 	virtual bool rmdir(const QString & dirName, bool recurseParentDirectories) const { Q_UNUSED(recurseParentDirectories); return PHYSFS_delete(name.toUtf8().constData()) != 0; }
-	virtual bool seek(qint64 offset) { return PHYSFS_seek(fp, offset) != 0; }
+	virtual bool seek(qint64 offset)
+	{
+		if (deferred)
+		{
+			deferredPos = qMin<qint64>(offset, deferred->size());
+			return deferredPos == offset;
+		}
+		return PHYSFS_seek(fp, offset) != 0;
+	}
 	virtual bool supportsExtension(Extension extension) const { return extension == QAbstractFileEngine::AtEndExtension; }
-	virtual qint64 write(const char *data, qint64 len) { return PHYSFS_write(fp, data, 1, len); }
+	virtual qint64 write(const char *data, qint64 len)
+	{
+		if (deferred)
+		{
+			deferred->replace(deferredPos, len, data, len);
+			deferredPos += len;
+			return len;
+		}
+		return PHYSFS_write(fp, data, 1, len);
+	}
 
 	virtual qint64 size() const
 	{
+		if (deferred)
+		{
+			return deferred->size();
+		}
 		if (!fp)
 		{
 			if (!PHYSFS_exists(name.toUtf8().constData())) return 0;
@@ -96,7 +133,15 @@ public:
 	virtual bool open(QIODevice::OpenMode mode)
 	{
 		close();
-		if (mode & QIODevice::WriteOnly)
+		if (mode & QIODevice::WriteOnly && saveFileDeferring())
+		{
+			// Keep the data in memory, and pass it to saveFile when closed.
+			flags = QAbstractFileEngine::WriteOwnerPerm | QAbstractFileEngine::WriteUserPerm | QAbstractFileEngine::FileType | QAbstractFileEngine::ExistsFlag;
+			deferred = new QByteArray;
+			deferredPos = 0;
+			return true;
+		}
+		else if (mode & QIODevice::WriteOnly)
 		{
 			flags = QAbstractFileEngine::WriteOwnerPerm | QAbstractFileEngine::WriteUserPerm | QAbstractFileEngine::FileType;
 			fp = PHYSFS_openWrite(name.toUtf8().constData());	// will truncate
@@ -0,0 +1,178 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2011  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "frame.h"
+#include "wzjobs.h"
+#include "wzapp.h"
+
+#if defined(WZ_OS_WIN)
+# include <windows.h>
+#else
+# include <unistd.h>
+#endif
+
+#include <algorithm>
+#include <vector>
+
+#define JOB_MAX_THREADS   7   ///< Worker threads at most, besides the calling thread
+#define JOB_CHUNKS        4   ///< Chunks each thread takes on average, so that uneven jobs still balance
+
+static std::vector<WZ_THREAD *> jobThreads;
+static WZ_SEMAPHORE *jobStartSem = NULL;   ///< Posted once per worker to start it on the current job
+static WZ_SEMAPHORE *jobDoneSem = NULL;    ///< Posted by each worker when it has finished the current job
+static WZ_MUTEX *jobMutex = NULL;          ///< Protects jobNext
+static bool jobsQuit = false;
+
+static void (*jobFunc)(void *data, unsigned i) = NULL;
+static void *jobData = NULL;
+static unsigned jobCount = 0, jobChunk = 1;
+static unsigned jobNext = 0;               ///< First index not yet taken by a thread
+
+/// Runs chunks of the current job until none are left.
+static void jobRun(void)
+{
+	for (;;)
+	{
+		wzMutexLock(jobMutex);
+		const unsigned first = jobNext;
+		const unsigned last = std::min(first + jobChunk, jobCount);
+		jobNext = last;
+		wzMutexUnlock(jobMutex);
+
+		if (first >= last)
+		{
+			return;
+		}
+		for (unsigned i = first; i < last; ++i)
+		{
+			jobFunc(jobData, i);
+		}
+	}
+}
+
+static int jobThreadFunc(void *)
+{
+	for (;;)
+	{
+		wzSemaphoreWait(jobStartSem);
+		if (jobsQuit)
+		{
+			return 0;
+		}
+		jobRun();
+		wzSemaphorePost(jobDoneSem);
+	}
+}
+
+static unsigned jobProcessorCount(void)
+{
+#if defined(WZ_OS_WIN)
+	SYSTEM_INFO info;
+	GetSystemInfo(&info);
+	return info.dwNumberOfProcessors;
+#elif defined(_SC_NPROCESSORS_ONLN)
+	long count = sysconf(_SC_NPROCESSORS_ONLN);
+	return count > 0 ? count : 1;
+#else
+	return 1;
+#endif
+}
+
+void wzJobsInitialise(void)
+{
+	ASSERT_OR_RETURN(, jobThreads.empty(), "Job threads already running");
+
+	const unsigned numThreads = std::min<unsigned>(jobProcessorCount() - 1, JOB_MAX_THREADS);
+	if (numThreads == 0)
+	{
+		return;
+	}
+
+	jobsQuit = false;
+	jobStartSem = wzSemaphoreCreate(0);
+	jobDoneSem = wzSemaphoreCreate(0);
+	jobMutex = wzMutexCreate();
+	for (unsigned i = 0; i < numThreads; ++i)
+	{
+		WZ_THREAD *thread = wzThreadCreate(jobThreadFunc, NULL);
+		wzThreadStart(thread);
+		jobThreads.push_back(thread);
+	}
+	debug(LOG_WZ, "Started %u job threads", numThreads);
+}
+
+void wzJobsShutdown(void)
+{
+	if (jobThreads.empty())
+	{
+		return;
+	}
+
+	jobsQuit = true;
+	for (unsigned i = 0; i < jobThreads.size(); ++i)
+	{
+		wzSemaphorePost(jobStartSem);
+	}
+	for (unsigned i = 0; i < jobThreads.size(); ++i)
+	{
+		wzThreadJoin(jobThreads[i]);
+	}
+	jobThreads.clear();
+
+	wzSemaphoreDestroy(jobStartSem);
+	wzSemaphoreDestroy(jobDoneSem);
+	wzMutexDestroy(jobMutex);
+	jobStartSem = NULL;
+	jobDoneSem = NULL;
+	jobMutex = NULL;
+}
+
+unsigned wzJobsThreadCount(void)
+{
+	return jobThreads.size() + 1;
+}
+
+void wzParallelFor(unsigned count, void (*job)(void *data, unsigned i), void *data)
+{
+	if (jobThreads.empty() || count < 2)
+	{
+		for (unsigned i = 0; i < count; ++i)
+		{
+			job(data, i);
+		}
+		return;
+	}
+
+	// The workers are all waiting on jobStartSem, so nothing else touches these until it is posted.
+	jobFunc = job;
+	jobData = data;
+	jobCount = count;
+	jobChunk = std::max(count / (wzJobsThreadCount() * JOB_CHUNKS), 1u);
+	jobNext = 0;
+
+	for (unsigned i = 0; i < jobThreads.size(); ++i)
+	{
+		wzSemaphorePost(jobStartSem);
+	}
+	jobRun();
+	for (unsigned i = 0; i < jobThreads.size(); ++i)
+	{
+		wzSemaphoreWait(jobDoneSem);
+	}
+}
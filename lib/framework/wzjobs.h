@@ -0,0 +1,41 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2011  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  A pool of worker threads, one per extra processor core, for splitting up the CPU work of a frame.
+ */
+
+#ifndef __INCLUDED_LIB_FRAMEWORK_WZJOBS_H__
+#define __INCLUDED_LIB_FRAMEWORK_WZJOBS_H__
+
+/// Starts the worker threads. Without them, wzParallelFor() runs everything on the calling thread.
+void wzJobsInitialise(void);
+
+/// Stops the worker threads.
+void wzJobsShutdown(void);
+
+/// Returns the number of threads wzParallelFor() runs jobs on, including the calling thread.
+unsigned wzJobsThreadCount(void);
+
+/// Calls job(data, i) for each i from 0 to count - 1, spread over the worker threads and the calling
+/// thread, and returns when all have finished. The calls may happen in any order and at the same time,
+/// so each must only write what belongs to its own i, and must not call OpenGL.
+/// Must be called from the main thread.
+void wzParallelFor(unsigned count, void (*job)(void *data, unsigned i), void *data);
+
+#endif // __INCLUDED_LIB_FRAMEWORK_WZJOBS_H__
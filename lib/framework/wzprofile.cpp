@@ -0,0 +1,154 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2011  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "frame.h"
+#include "wzprofile.h"
+#include "wzapp.h"
+#include "wztime.h"
+
+#include <physfs.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+
+struct PROFILE_PHASE
+{
+	std::string name;
+	const char *reportName;      ///< Write a report when this phase ends, if not NULL
+	unsigned    depth;           ///< Number of phases this one is nested in
+	uint64_t    start, end;      ///< wzGetMicroTicks()
+	uint64_t    files, bytes;    ///< Read during the phase, the totals at the start until it ends
+};
+
+static std::vector<PROFILE_PHASE> phases;      ///< Phases since the last report, in the order they started
+static std::vector<size_t> openPhases;         ///< Indices in phases of the phases that have not ended, -1 for ones not recorded
+static unsigned recordedOpenPhases = 0;        ///< Number of openPhases that are recorded
+static WZ_MUTEX *fileCountMutex = NULL;        ///< Protects filesRead and bytesRead, which are counted by loader threads too
+static uint64_t filesRead = 0, bytesRead = 0;
+
+static void wzProfileFileTotals(uint64_t *pFiles, uint64_t *pBytes)
+{
+	wzMutexLock(fileCountMutex);
+	*pFiles = filesRead;
+	*pBytes = bytesRead;
+	wzMutexUnlock(fileCountMutex);
+}
+
+/// Writes the phases since the last report to logs/<reportName>-<time>.csv, for loading into a spreadsheet.
+static bool wzProfileWriteReport(const char *reportName)
+{
+	time_t aclock;
+	struct tm *newtime;
+	char filename[256];
+	char buf[512];
+
+	time(&aclock);
+	newtime = localtime(&aclock);
+	snprintf(filename, sizeof(filename), "logs/%s-%04d%02d%02d_%02d%02d%02d.csv", reportName, newtime->tm_year + 1900, newtime->tm_mon + 1,
+	         newtime->tm_mday, newtime->tm_hour, newtime->tm_min, newtime->tm_sec);
+	PHYSFS_file *fileHandle = PHYSFS_openWrite(filename);
+	if (!fileHandle)
+	{
+		debug(LOG_ERROR, "Could not create profile report %s: %s", filename, PHYSFS_getLastError());
+		return false;
+	}
+
+	snprintf(buf, sizeof(buf), "phase,depth,start (ms),duration (ms),files,bytes\n");
+	PHYSFS_write(fileHandle, buf, strlen(buf), 1);
+	for (std::vector<PROFILE_PHASE>::const_iterator phase = phases.begin(); phase != phases.end(); ++phase)
+	{
+		snprintf(buf, sizeof(buf), "%s,%u,%.3f,%.3f,%u,%u\n", phase->name.c_str(), phase->depth, (phase->start - phases[0].start) / 1000.,
+		         (phase->end - phase->start) / 1000., (unsigned)phase->files, (unsigned)phase->bytes);
+		PHYSFS_write(fileHandle, buf, strlen(buf), 1);
+	}
+
+	if (!PHYSFS_close(fileHandle))
+	{
+		debug(LOG_ERROR, "Could not close profile report: %s", PHYSFS_getLastError());
+		return false;
+	}
+	debug(LOG_WZ, "Wrote %s", filename);
+	return true;
+}
+
+void wzProfileBegin(const char *name, const char *reportName)
+{
+	if (recordedOpenPhases == 0 && reportName == NULL)
+	{
+		openPhases.push_back(-1);  // Not recorded, since there is no report to write it to.
+		return;
+	}
+	if (fileCountMutex == NULL)
+	{
+		// Created here on the main thread, before any loader thread can count files.
+		fileCountMutex = wzMutexCreate();
+	}
+
+	PROFILE_PHASE phase;
+	phase.name = name;
+	phase.reportName = reportName;
+	phase.depth = recordedOpenPhases++;
+	wzProfileFileTotals(&phase.files, &phase.bytes);
+	phase.start = phase.end = wzGetMicroTicks();
+	openPhases.push_back(phases.size());
+	phases.push_back(phase);
+}
+
+void wzProfileEnd(void)
+{
+	ASSERT_OR_RETURN(, !openPhases.empty(), "wzProfileEnd without wzProfileBegin");
+
+	size_t index = openPhases.back();
+	openPhases.pop_back();
+	if (index == (size_t)-1)
+	{
+		return;
+	}
+
+	--recordedOpenPhases;
+
+	PROFILE_PHASE &phase = phases[index];
+	uint64_t files, bytes;
+	phase.end = wzGetMicroTicks();
+	wzProfileFileTotals(&files, &bytes);
+	phase.files = files - phase.files;
+	phase.bytes = bytes - phase.bytes;
+
+	if (phase.reportName != NULL)
+	{
+		wzProfileWriteReport(phase.reportName);
+		if (recordedOpenPhases == 0)
+		{
+			phases.clear();
+		}
+	}
+}
+
+void wzProfileFileRead(size_t bytes)
+{
+	if (fileCountMutex == NULL)
+	{
+		return;  // No phase has been timed yet.
+	}
+	wzMutexLock(fileCountMutex);
+	++filesRead;
+	bytesRead += bytes;
+	wzMutexUnlock(fileCountMutex);
+}
@@ -0,0 +1,48 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2011  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Timings of the phases of startup and level loading, written to logs/ as a report.
+ */
+
+#ifndef __INCLUDED_LIB_FRAMEWORK_WZPROFILE_H__
+#define __INCLUDED_LIB_FRAMEWORK_WZPROFILE_H__
+
+#include "types.h"
+
+/// Starts timing a phase, which lasts until the matching wzProfileEnd(). Phases nest.
+/// Phases are only recorded inside a phase with a reportName. When that phase ends, all the phases
+/// recorded since the last report are written to logs/<reportName>-<time>.csv.
+/// Must be called from the main thread.
+void wzProfileBegin(const char *name, const char *reportName = NULL);
+
+/// Ends the phase started by the last unmatched wzProfileBegin().
+void wzProfileEnd(void);
+
+/// Counts a file read, for the phases that are running. May be called from any thread.
+void wzProfileFileRead(size_t bytes);
+
+/// Times the enclosing scope as a phase.
+class WzProfilePhase
+{
+public:
+	WzProfilePhase(const char *name, const char *reportName = NULL) { wzProfileBegin(name, reportName); }
+	~WzProfilePhase() { wzProfileEnd(); }
+};
+
+#endif // __INCLUDED_LIB_FRAMEWORK_WZPROFILE_H__
@@ -0,0 +1,44 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2011  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+#include "wztime.h"
+
+#if defined(WZ_OS_WIN)
+# include <windows.h>
+#else
+# include <sys/time.h>
+#endif
+
+uint64_t wzGetMicroTicks()
+{
+#if defined(WZ_OS_WIN)
+	static LARGE_INTEGER frequency = {{0, 0}};
+	if (frequency.QuadPart == 0)
+	{
+		QueryPerformanceFrequency(&frequency);
+	}
+	LARGE_INTEGER count;
+	QueryPerformanceCounter(&count);
+	return uint64_t(count.QuadPart / frequency.QuadPart)*1000000 + uint64_t(count.QuadPart % frequency.QuadPart)*1000000/frequency.QuadPart;
+#else
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return uint64_t(tv.tv_sec)*1000000 + tv.tv_usec;
+#endif
+}
@@ -0,0 +1,32 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2011  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  High resolution timer, for measuring how long things take.
+ */
+
+#ifndef __INCLUDED_LIB_FRAMEWORK_WZTIME_H__
+#define __INCLUDED_LIB_FRAMEWORK_WZTIME_H__
+
+#include "types.h"
+
+/// Returns microseconds since some arbitrary point in time. Unlike wzGetTicks(), has sub-millisecond resolution and may be called from any thread.
+/// Only useful for measuring time differences, never for anything which affects the game state.
+uint64_t wzGetMicroTicks(void);
+
+#endif // __INCLUDED_LIB_FRAMEWORK_WZTIME_H__
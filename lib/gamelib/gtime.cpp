@@ -36,6 +36,14 @@
 // If not reaching the goal, force graphics updates, even if we aren't doing enough game state updates to maintain game speed.
 #define MAXIMUM_SPF 1/4
 
+// Time lost waiting for other players is made up afterwards, running at most 1 + 1/CATCHUP_DIVISOR times faster, so that we don't stay behind the others.
+#define CATCHUP_DIVISOR 2
+// Don't try to make up more than this much time. If it took longer, everyone had to wait anyway.
+#define MAXIMUM_CATCHUP (GAME_TICKS_PER_SEC/2)
+
+// Number of updates to remember how late the GAME_GAME_TIME messages were, when choosing the latency.
+#define LATENCY_HISTORY (2*GAME_UPDATES_PER_SEC)
+
 /* See header file for documentation */
 UDWORD gameTime = 0, deltaGameTime = 0, graphicsTime = 0, deltaGraphicsTime = 0, realTime = 0, deltaRealTime = 0;
 float graphicsTimeFraction = 0.0, realTimeFraction = 0.0;
@@ -69,6 +77,9 @@ static uint16_t chosenLatency = GAME_TICKS_PER_UPDATE;
 static uint16_t discreteChosenLatency = GAME_TICKS_PER_UPDATE;
 static uint16_t wantedLatency = GAME_TICKS_PER_UPDATE;
 static uint16_t wantedLatencies[MAX_PLAYERS];
+static int16_t  updateDelays[LATENCY_HISTORY];   ///< How long we had to wait for others in the last updates, negative if we didn't have to wait.
+static unsigned updateDelayIndex = 0;
+static uint32_t catchUpTime = 0;                 ///< Game time lost waiting for other players, not yet made up.
 
 static void updateLatency(void);
 
@@ -116,6 +127,10 @@ void gameTimeInit(void)
 	{
 		wantedLatencies[player] = 0;
 	}
+	for (unsigned i = 0; i != LATENCY_HISTORY; ++i)
+	{
+		updateDelays[i] = 0;
+	}
 
 	// Don't let syncDebug from previous games cause a desynch dump at gameTime 102.
 	resetSyncDebug();
@@ -134,6 +149,7 @@ extern void setGameTime(uint32_t newGameTime)
 	graphicsTimeFraction = 0.f;
 	timeOffset = graphicsTime;
 	baseTime = wzGetTicks();
+	catchUpTime = 0;
 
 	// Not setting real time.
 }
@@ -183,6 +199,15 @@ void gameTimeUpdate()
 			timeOffset = graphicsTime;
 		}
 
+		if (catchUpTime != 0 && scaledCurrTime > graphicsTime)
+		{
+			// We were waiting for other players earlier, run a bit faster until we have caught up again.
+			uint32_t catchUp = MIN(catchUpTime, (scaledCurrTime - graphicsTime)/CATCHUP_DIVISOR);
+			scaledCurrTime += catchUp;
+			timeOffset += catchUp;
+			catchUpTime -= catchUp;
+		}
+
 		if (updateWantedTime == 0 && scaledCurrTime >= gameTime)
 		{
 			updateWantedTime = currTime;  // This is the time that we wanted to tick.
@@ -193,6 +218,8 @@ void gameTimeUpdate()
 			unsigned player;
 
 			// Pause time at current game time, since we are waiting GAME_GAME_TIME from other players.
+			// Remember how long we waited, so that we can catch up when the messages arrive.
+			catchUpTime = MIN(catchUpTime + (scaledCurrTime - gameTime), MAXIMUM_CATCHUP);
 			scaledCurrTime = gameTime;
 			baseTime = currTime;
 			timeOffset = gameTime;
@@ -286,6 +313,7 @@ void gameTimeResetMod(void)
 {
 	timeOffset = graphicsTime;
 	baseTime = wzGetTicks();
+	catchUpTime = 0;
 
 	modifier = 1.0f;
 }
@@ -368,6 +396,7 @@ void	getTimeComponents(UDWORD time, UDWORD *hours, UDWORD *minutes, UDWORD *seco
 static void updateLatency()
 {
 	uint16_t maxWantedLatency = 0;
+	int16_t maxUpdateDelay = INT16_MIN;
 	unsigned player;
 	uint16_t prevDiscreteChosenLatency = discreteChosenLatency;
 
@@ -389,9 +418,20 @@ static void updateLatency()
 		debug(LOG_SYNC, "Adjusting latency %d -> %d", prevDiscreteChosenLatency, discreteChosenLatency);
 	}
 
-	// We want the chosen latency to increase by how much our update was delayed waiting for others, or to decrease by how long after we got the messages from others that it was time to tick. Plus a tiny 10ms buffer.
+	// Remember how much our update was delayed waiting for others, or how long after we got the messages from others that it was time to tick.
+	// If updateReadyTime is 0, we had the messages before the previous update.
+	int updateDelay = updateReadyTime != 0 ? (int)(updateReadyTime - updateWantedTime) : -GAME_TICKS_PER_SEC;
+	updateDelays[updateDelayIndex] = clip(updateDelay, -GAME_TICKS_PER_SEC, GAME_TICKS_PER_SEC);
+	updateDelayIndex = (updateDelayIndex + 1) % LATENCY_HISTORY;
+	for (unsigned i = 0; i != LATENCY_HISTORY; ++i)
+	{
+		maxUpdateDelay = MAX(maxUpdateDelay, updateDelays[i]);
+	}
+
+	// We want the chosen latency to increase by the worst delay in the last few updates, or to decrease if the messages were always early. Plus a tiny 10ms buffer.
+	// Using the worst recent delay instead of just the last one keeps the latency high enough to absorb jitter, instead of stalling on every spike.
 	// We will send this number to others.
-	wantedLatency = clip((int)(discreteChosenLatency + updateReadyTime - updateWantedTime + 10), 0, UINT16_MAX);
+	wantedLatency = clip(discreteChosenLatency + maxUpdateDelay + 10, 0, UINT16_MAX);
 
 	// Reset the times, ready to be set again.
 	updateReadyTime = 0;
@@ -21,6 +21,7 @@
 #include "ivisdef.h"
 #include "tex.h"
 #include "pietypes.h"
+#include "piedef.h"
 
 //*************************************************************************
 //*** free IMD shape memory
@@ -56,11 +57,7 @@ void iV_IMDRelease(iIMDShape *s)
 			}
 			free(s->polys);
 		}
-		if (s->shadowEdgeList)
-		{
-			free(s->shadowEdgeList);
-			s->shadowEdgeList = NULL;
-		}
+		pie_FreeShadowVolumes(s);
 		d = s->next;
 		free(s);
 		iV_IMDRelease(d);
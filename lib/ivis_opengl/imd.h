@@ -41,8 +41,23 @@
 
 //*************************************************************************
 
+/// A parsed IMD whose texture pages have not been looked up yet
+struct iIMDDecoded
+{
+	iIMDShape *shape;
+	uint32_t flags;
+	char *texfile;		///< Texture page, NULL if untextured
+	char *normalfile;	///< Normal map, NULL if none
+};
+
 extern iIMDShape *iV_ProcessIMD(const char **ppFileData, const char *FileDataEnd );
 
+/// Parse an IMD without touching GL or any other global state, so it can run on a loader thread
+extern iIMDDecoded *iV_DecodeIMD(const char **ppFileData, const char *FileDataEnd, const char *pFileName);
+/// Look up the texture pages of a decoded IMD on the main thread, frees psDecoded
+extern iIMDShape *iV_FinishIMD(iIMDDecoded *psDecoded, const char *pFileName);
+extern void iV_FreeDecodedIMD(iIMDDecoded *psDecoded);
+
 extern bool iV_IMDSave(char *filename, iIMDShape *s, bool PieIMD);
 extern void iV_IMDRelease(iIMDShape *s);
 
@@ -32,8 +32,12 @@
 
 #include "ivisdef.h" // for imd structures
 #include "imd.h" // for imd structures
+#include "piebinary.h" // compiled imds
 #include "tex.h" // texture page loading
 
+#include <physfs.h>
+#include <vector>
+
 static bool AtEndOfFile(const char *CurPos, const char *EndOfFile)
 {
 	while ( *CurPos == 0x00 || *CurPos == 0x09 || *CurPos == 0x0a || *CurPos == 0x0d || *CurPos == 0x20 )
@@ -53,6 +57,39 @@ static bool AtEndOfFile(const char *CurPos, const char *EndOfFile)
 }
 
 
+/*!
+ * Set up the texture coordinates of every animation frame of a polygon
+ * \param poly Polygon, with texAnim set
+ * \param numFrames Number of animation frames of the shape level so far
+ * \param uv Texture coordinates of the first frame, one for each point of the polygon
+ * \return false on memory allocation failure
+ */
+static bool _imd_expand_texcoords(iIMDPoly *poly, int numFrames, const Vector2f *uv)
+{
+	int nFrames, framesPerLine, frame;
+	unsigned int j;
+
+	nFrames = MAX(1, numFrames);
+	poly->texCoord = (Vector2f *)malloc(sizeof(*poly->texCoord) * nFrames * poly->npnts);
+	ASSERT_OR_RETURN(false, poly->texCoord, "Out of memory allocating texture coordinates");
+	framesPerLine = OLD_TEXTURE_SIZE_FIX / (poly->texAnim.x * OLD_TEXTURE_SIZE_FIX);
+	for (j = 0; j < poly->npnts; j++)
+	{
+		for (frame = 0; frame < nFrames; frame++)
+		{
+			const int uFrame = (frame % framesPerLine) * (poly->texAnim.x * OLD_TEXTURE_SIZE_FIX);
+			const int vFrame = (frame / framesPerLine) * (poly->texAnim.y * OLD_TEXTURE_SIZE_FIX);
+			Vector2f *c = &poly->texCoord[frame * poly->npnts + j];
+
+			c->x = uv[j].x + uFrame / OLD_TEXTURE_SIZE_FIX;
+			c->y = uv[j].y + vFrame / OLD_TEXTURE_SIZE_FIX;
+		}
+	}
+
+	return true;
+}
+
+
 /*!
  * Load shape level polygons
  * \param ppFileData Pointer to the data (usualy read from a file)
@@ -152,17 +189,11 @@ static bool _imd_load_polys( const char **ppFileData, iIMDShape *s, int pieVersi
 		// PC texture coord routine
 		if (poly->flags & iV_IMD_TEX)
 		{
-			int nFrames, framesPerLine, frame;
+			Vector2f uv[3];
 
-			nFrames = MAX(1, s->numFrames);
-			poly->texCoord = (Vector2f *)malloc(sizeof(*poly->texCoord) * nFrames * poly->npnts);
-			ASSERT_OR_RETURN(false, poly->texCoord, "Out of memory allocating texture coordinates");
-			framesPerLine = OLD_TEXTURE_SIZE_FIX / (poly->texAnim.x * OLD_TEXTURE_SIZE_FIX);
 			for (j = 0; j < poly->npnts; j++)
 			{
-				float VertexU, VertexV;
-
-				if (sscanf(pFileData, "%f %f%n", &VertexU, &VertexV, &cnt) != 2)
+				if (sscanf(pFileData, "%f %f%n", &uv[j].x, &uv[j].y, &cnt) != 2)
 				{
 					debug(LOG_ERROR, "(_load_polys) [poly %u] error reading tex outline", i);
 					return false;
@@ -171,19 +202,14 @@ static bool _imd_load_polys( const char **ppFileData, iIMDShape *s, int pieVersi
 
 				if (pieVersion != PIE_FLOAT_VER)
 				{
-					VertexU /= OLD_TEXTURE_SIZE_FIX;
-					VertexV /= OLD_TEXTURE_SIZE_FIX;
+					uv[j].x /= OLD_TEXTURE_SIZE_FIX;
+					uv[j].y /= OLD_TEXTURE_SIZE_FIX;
 				}
+			}
 
-				for (frame = 0; frame < nFrames; frame++)
-				{
-					const int uFrame = (frame % framesPerLine) * (poly->texAnim.x * OLD_TEXTURE_SIZE_FIX);
-					const int vFrame = (frame / framesPerLine) * (poly->texAnim.y * OLD_TEXTURE_SIZE_FIX);
-					Vector2f *c = &poly->texCoord[frame * poly->npnts + j];
-
-					c->x = VertexU + uFrame / OLD_TEXTURE_SIZE_FIX;
-					c->y = VertexV + vFrame / OLD_TEXTURE_SIZE_FIX;
-				}
+			if (!_imd_expand_texcoords(poly, s->numFrames, uv))
+			{
+				return false;
 			}
 		}
 		else
@@ -221,7 +247,10 @@ static bool ReadPoints( const char **ppFileData, iIMDShape *s )
 }
 
 
-static bool _imd_load_points( const char **ppFileData, iIMDShape *s )
+/*!
+ * Set up the bounding box and spheres of a shape level from its points
+ */
+static void _imd_calc_bounds(iIMDShape *s)
 {
 	Vector3f *p = NULL;
 	int32_t xmax, ymax, zmax;
@@ -231,21 +260,6 @@ static bool _imd_load_points( const char **ppFileData, iIMDShape *s )
 	Vector3f vxmin(0, 0, 0), vymin(0, 0, 0), vzmin(0, 0, 0),
 	         vxmax(0, 0, 0), vymax(0, 0, 0), vzmax(0, 0, 0);
 
-	//load the points then pass through a second time to setup bounding datavalues
-	s->points = (Vector3f*)malloc(sizeof(Vector3f) * s->npoints);
-	if (s->points == NULL)
-	{
-		return false;
-	}
-
-	// Read in points and remove duplicates (!)
-	if ( ReadPoints( ppFileData, s ) == false )
-	{
-		free(s->points);
-		s->points = NULL;
-		return false;
-	}
-
 	s->max.x = s->max.y = s->max.z = -FP12_MULTIPLIER;
 	s->min.x = s->min.y = s->min.z = FP12_MULTIPLIER;
 
@@ -414,6 +428,27 @@ static bool _imd_load_points( const char **ppFileData, iIMDShape *s )
 	s->ocen = cen;
 
 // END: tight bounding sphere
+}
+
+
+static bool _imd_load_points( const char **ppFileData, iIMDShape *s )
+{
+	//load the points then pass through a second time to setup bounding datavalues
+	s->points = (Vector3f*)malloc(sizeof(Vector3f) * s->npoints);
+	if (s->points == NULL)
+	{
+		return false;
+	}
+
+	// Read in points and remove duplicates (!)
+	if ( ReadPoints( ppFileData, s ) == false )
+	{
+		free(s->points);
+		s->points = NULL;
+		return false;
+	}
+
+	_imd_calc_bounds(s);
 
 	return true;
 }
@@ -460,6 +495,42 @@ static bool _imd_load_connectors(const char **ppFileData, iIMDShape *s)
 }
 
 
+/*!
+ * Allocate an empty shape level
+ * \return the level, or NULL if out of memory
+ */
+static iIMDShape *_imd_new_level(void)
+{
+	iIMDShape *s = (iIMDShape*)malloc(sizeof(iIMDShape));
+
+	if (s == NULL)
+	{
+		/* Failed to allocate memory for s */
+		debug(LOG_ERROR, "_imd_load_level: Memory allocation error");
+		return NULL;
+	}
+	s->flags = 0;
+	s->nconnectors = 0; // Default number of connectors must be 0
+	s->npoints = 0;
+	s->npolys = 0;
+	s->points = NULL;
+	s->polys = NULL;
+	s->connectors = NULL;
+	s->next = NULL;
+	s->numFrames = 0;
+	s->animInterval = 0;
+	s->texpage = iV_TEX_INVALID;
+	s->tcmaskpage = iV_TEX_INVALID;
+	s->normalpage = iV_TEX_INVALID;
+	memset(s->material, 0, sizeof(s->material));
+	s->material[LIGHT_AMBIENT][3] = 1.0f;
+	s->material[LIGHT_DIFFUSE][3] = 1.0f;
+	s->material[LIGHT_SPECULAR][3] = 1.0f;
+
+	return s;
+}
+
+
 /*!
  * Load shape levels recursively
  * \param ppFileData Pointer to the data (usualy read from a file)
@@ -486,30 +557,11 @@ static iIMDShape *_imd_load_level(const char **ppFileData, const char *FileDataE
 	i = sscanf(pFileData, "%255s %n", buffer, &cnt);
 	ASSERT_OR_RETURN(NULL, i == 1, "Bad directive following LEVEL");
 
-	s = (iIMDShape*)malloc(sizeof(iIMDShape));
+	s = _imd_new_level();
 	if (s == NULL)
 	{
-		/* Failed to allocate memory for s */
-		debug(LOG_ERROR, "_imd_load_level: Memory allocation error");
 		return NULL;
 	}
-	s->flags = 0;
-	s->nconnectors = 0; // Default number of connectors must be 0
-	s->npoints = 0;
-	s->npolys = 0;
-	s->points = NULL;
-	s->polys = NULL;
-	s->connectors = NULL;
-	s->next = NULL;
-	s->shadowEdgeList = NULL;
-	s->nShadowEdges = 0;
-	s->texpage = iV_TEX_INVALID;
-	s->tcmaskpage = iV_TEX_INVALID;
-	s->normalpage = iV_TEX_INVALID;
-	memset(s->material, 0, sizeof(s->material));
-	s->material[LIGHT_AMBIENT][3] = 1.0f;
-	s->material[LIGHT_DIFFUSE][3] = 1.0f;
-	s->material[LIGHT_SPECULAR][3] = 1.0f;
 	if (strcmp(buffer, "MATERIALS") == 0)
 	{
 		i = sscanf(pFileData, "%255s %f %f %f %f %f %f %f %f %f %f%n", buffer,
@@ -598,24 +650,236 @@ static iIMDShape *_imd_load_level(const char **ppFileData, const char *FileDataE
 
 
 /*!
- * Load ppFileData into a shape
+ * Copy size bytes of a compiled IMD to dest, converting every 32-bit word from little-endian
+ * \return false if the data ends too soon
+ */
+static bool _imd_read_binary(const char **ppFileData, const char *FileDataEnd, void *dest, size_t size)
+{
+	uint32_t *words = (uint32_t *)dest;
+	size_t i;
+
+	if ((size_t)(FileDataEnd - *ppFileData) < size)
+	{
+		return false;
+	}
+	memcpy(dest, *ppFileData, size);
+	*ppFileData += size;
+	for (i = 0; i < size / sizeof(*words); i++)
+	{
+		words[i] = PHYSFS_swapULE32(words[i]);
+	}
+	return true;
+}
+
+/*!
+ * Load compiled shape levels recursively
+ * \param ppFileData Pointer to the data, after the PIEB_HEADER or the previous level
+ * \param FileDataEnd End of the data
+ * \param nlevels Number of levels to load
+ * \param pFileName Name of the IMD, for error messages
+ * \return the shape, or NULL on error
+ */
+static iIMDShape *_imd_load_level_binary(const char **ppFileData, const char *FileDataEnd, unsigned nlevels, const char *pFileName)
+{
+	PIEB_LEVEL level;
+	std::vector<PIEB_POINT> points;
+	std::vector<PIEB_POLY> polys;
+	std::vector<PIEB_TEXCOORD> texcoords;
+	std::vector<PIEB_CONNECTOR> connectors;
+	iIMDShape *s;
+	unsigned i, j;
+
+	STATIC_ASSERT(PIEB_LIGHTS == LIGHT_MAX);
+
+	if (!_imd_read_binary(ppFileData, FileDataEnd, &level, sizeof(level))
+	    || level.npoints > (size_t)(FileDataEnd - *ppFileData) / sizeof(PIEB_POINT)
+	    || level.npolys > (size_t)(FileDataEnd - *ppFileData) / sizeof(PIEB_POLY)
+	    || level.ntexcoords > (size_t)(FileDataEnd - *ppFileData) / sizeof(PIEB_TEXCOORD)
+	    || level.nconnectors > (size_t)(FileDataEnd - *ppFileData) / sizeof(PIEB_CONNECTOR))
+	{
+		debug(LOG_ERROR, "%s: compiled model truncated", pFileName);
+		return NULL;
+	}
+	points.resize(level.npoints);
+	polys.resize(level.npolys);
+	texcoords.resize(level.ntexcoords);
+	connectors.resize(level.nconnectors);
+	if ((level.npoints != 0 && !_imd_read_binary(ppFileData, FileDataEnd, &points[0], points.size() * sizeof(points[0])))
+	    || (level.npolys != 0 && !_imd_read_binary(ppFileData, FileDataEnd, &polys[0], polys.size() * sizeof(polys[0])))
+	    || (level.ntexcoords != 0 && !_imd_read_binary(ppFileData, FileDataEnd, &texcoords[0], texcoords.size() * sizeof(texcoords[0])))
+	    || (level.nconnectors != 0 && !_imd_read_binary(ppFileData, FileDataEnd, &connectors[0], connectors.size() * sizeof(connectors[0]))))
+	{
+		debug(LOG_ERROR, "%s: compiled model truncated", pFileName);
+		return NULL;
+	}
+
+	s = _imd_new_level();
+	if (s == NULL)
+	{
+		return NULL;
+	}
+	memcpy(s->material, level.material, sizeof(s->material));
+	s->shininess = level.shininess;
+	s->numFrames = level.numFrames;
+	s->animInterval = level.animInterval;
+
+	s->npoints = level.npoints;
+	s->points = (Vector3f *)malloc(sizeof(*s->points) * s->npoints);
+	s->npolys = level.npolys;
+	s->polys = (iIMDPoly *)calloc(s->npolys, sizeof(*s->polys));
+	s->nconnectors = level.nconnectors;
+	s->connectors = (Vector3i *)malloc(sizeof(*s->connectors) * s->nconnectors);
+	if ((s->npoints != 0 && s->points == NULL) || (s->npolys != 0 && s->polys == NULL) || (s->nconnectors != 0 && s->connectors == NULL))
+	{
+		debug(LOG_ERROR, "_imd_load_level_binary: Memory allocation error");
+		iV_IMDRelease(s);
+		return NULL;
+	}
+
+	for (i = 0; i < s->npoints; i++)
+	{
+		s->points[i] = Vector3f(points[i].x, points[i].y, points[i].z);
+	}
+	for (i = 0; i < s->nconnectors; i++)
+	{
+		s->connectors[i] = Vector3i(connectors[i].x, connectors[i].y, connectors[i].z);
+	}
+	_imd_calc_bounds(s);
+
+	for (i = 0; i < s->npolys; i++)
+	{
+		const PIEB_POLY *psIn = &polys[i];
+		iIMDPoly *poly = &s->polys[i];
+
+		poly->flags = psIn->flags;
+		poly->npnts = 3;
+		for (j = 0; j < 3; j++)
+		{
+			if (psIn->pindex[j] < 0 || (unsigned)psIn->pindex[j] >= s->npoints)
+			{
+				debug(LOG_ERROR, "%s: polygon %u uses point %d of %u", pFileName, i, psIn->pindex[j], s->npoints);
+				iV_IMDRelease(s);
+				return NULL;
+			}
+			poly->pindex[j] = psIn->pindex[j];
+		}
+		poly->normal = Vector3f(psIn->normal[0], psIn->normal[1], psIn->normal[2]);
+		poly->texAnim = Vector2f(psIn->texAnim[0], psIn->texAnim[1]);
+		poly->texCoord = NULL;
+
+		if (poly->flags & iV_IMD_TEX)
+		{
+			Vector2f uv[3];
+
+			if (texcoords.size() < 3 || psIn->firstTexCoord > texcoords.size() - 3)
+			{
+				debug(LOG_ERROR, "%s: polygon %u has no texture coordinates", pFileName, i);
+				iV_IMDRelease(s);
+				return NULL;
+			}
+			for (j = 0; j < 3; j++)
+			{
+				uv[j] = Vector2f(texcoords[psIn->firstTexCoord + j].u, texcoords[psIn->firstTexCoord + j].v);
+			}
+			// To the frames the PIE parser would have given this polygon, as recorded by pie2bin
+			if (!_imd_expand_texcoords(poly, psIn->numFrames, uv))
+			{
+				iV_IMDRelease(s);
+				return NULL;
+			}
+		}
+	}
+
+	if (nlevels > 1)
+	{
+		s->next = _imd_load_level_binary(ppFileData, FileDataEnd, nlevels - 1, pFileName);
+		if (s->next == NULL)
+		{
+			iV_IMDRelease(s);
+			return NULL;
+		}
+	}
+
+	return s;
+}
+
+/*!
+ * Read a compiled IMD, see piebinary.h
+ * \param ppFileData Data from the file, incremented to the end of the model on exit
+ * \param FileDataEnd Endpointer
+ * \param pFileName Name of the IMD, for error messages
+ * \return The shape and the texture pages it uses, to be passed to iV_FinishIMD
+ */
+static iIMDDecoded *iV_DecodeIMDBinary(const char **ppFileData, const char *FileDataEnd, const char *pFileName)
+{
+	const char *pFileData = *ppFileData;
+	PIEB_HEADER header;
+	iIMDShape *shape;
+	iIMDDecoded *psDecoded;
+
+	if ((size_t)(FileDataEnd - pFileData) < sizeof(header))
+	{
+		debug(LOG_ERROR, "%s: compiled model truncated", pFileName);
+		return NULL;
+	}
+	memcpy(&header, pFileData, sizeof(header));
+	pFileData += sizeof(header);
+	header.version = PHYSFS_swapULE32(header.version);
+	header.flags = PHYSFS_swapULE32(header.flags);
+	header.nlevels = PHYSFS_swapULE32(header.nlevels);
+	header.texfile[PIEB_NAME_MAX - 1] = '\0';
+	header.normalfile[PIEB_NAME_MAX - 1] = '\0';
+
+	if (header.version != PIEB_VERSION)
+	{
+		debug(LOG_ERROR, "%s: compiled model version %u not supported, recompile it with pie2bin", pFileName, header.version);
+		return NULL;
+	}
+	ASSERT_OR_RETURN(NULL, header.nlevels > 0, "%s: compiled model has no levels", pFileName);
+
+	shape = _imd_load_level_binary(&pFileData, FileDataEnd, header.nlevels, pFileName);
+	if (shape == NULL)
+	{
+		debug(LOG_ERROR, "iV_ProcessIMD %s unsuccessful", pFileName);
+		return NULL;
+	}
+
+	psDecoded = (iIMDDecoded *)malloc(sizeof(*psDecoded));
+	psDecoded->shape = shape;
+	psDecoded->flags = header.flags;
+	psDecoded->texfile = header.texfile[0] != '\0' ? strdup(header.texfile) : NULL;
+	psDecoded->normalfile = header.normalfile[0] != '\0' ? strdup(header.normalfile) : NULL;
+
+	*ppFileData = pFileData;
+	return psDecoded;
+}
+
+/*!
+ * Parse ppFileData into a shape without looking up its texture pages
  * \param ppFileData Data from the IMD file
  * \param FileDataEnd Endpointer
- * \return The shape, constructed from the data read
+ * \param pFileName Name of the IMD, for error messages
+ * \return The shape and the texture pages it uses, to be passed to iV_FinishIMD
  */
 // ppFileData is incremented to the end of the file on exit!
-iIMDShape *iV_ProcessIMD( const char **ppFileData, const char *FileDataEnd )
+iIMDDecoded *iV_DecodeIMD(const char **ppFileData, const char *FileDataEnd, const char *pFileName)
 {
-	const char *pFileName = GetLastResourceFilename(); // Last loaded texture page filename
 	const char *pFileData = *ppFileData;
 	char buffer[PATH_MAX], texfile[PATH_MAX], normalfile[PATH_MAX];
 	int cnt, nlevels;
-	iIMDShape *shape, *psShape;
+	iIMDShape *shape;
+	iIMDDecoded *psDecoded;
 	UDWORD level;
 	int32_t imd_version;
 	uint32_t imd_flags;
 	bool bTextured = false;
 
+	if ((size_t)(FileDataEnd - pFileData) >= strlen(PIEB_MAGIC) && strncmp(pFileData, PIEB_MAGIC, strlen(PIEB_MAGIC)) == 0)
+	{
+		return iV_DecodeIMDBinary(ppFileData, FileDataEnd, pFileName);
+	}
+
+	memset(texfile, 0, sizeof(texfile));
 	memset(normalfile, 0, sizeof(normalfile));
 
 	if (sscanf(pFileData, "%255s %d%n", buffer, &imd_version, &cnt) != 2)
@@ -770,6 +1034,34 @@ iIMDShape *iV_ProcessIMD( const char **ppFileData, const char *FileDataEnd )
 		return NULL;
 	}
 
+	psDecoded = (iIMDDecoded *)malloc(sizeof(*psDecoded));
+	psDecoded->shape = shape;
+	psDecoded->flags = imd_flags;
+	psDecoded->texfile = bTextured ? strdup(texfile) : NULL;
+	psDecoded->normalfile = normalfile[0] != '\0' ? strdup(normalfile) : NULL;
+
+	*ppFileData = pFileData;
+	return psDecoded;
+}
+
+/*!
+ * Look up the texture pages of a decoded shape, loading them if needed
+ * \param psDecoded Result of iV_DecodeIMD, freed by this function
+ * \param pFileName Name of the IMD, for error messages
+ * \return The shape
+ */
+iIMDShape *iV_FinishIMD(iIMDDecoded *psDecoded, const char *pFileName)
+{
+	iIMDShape *shape = psDecoded->shape, *psShape;
+	char texfile[PATH_MAX], normalfile[PATH_MAX];
+	uint32_t imd_flags = psDecoded->flags;
+	bool bTextured = psDecoded->texfile != NULL;
+
+	sstrcpy(texfile, bTextured ? psDecoded->texfile : "");
+	sstrcpy(normalfile, psDecoded->normalfile != NULL ? psDecoded->normalfile : "");
+	psDecoded->shape = NULL;
+	iV_FreeDecodedIMD(psDecoded);
+
 	// load texture page if specified
 	if (bTextured)
 	{
@@ -811,6 +1103,38 @@ iIMDShape *iV_ProcessIMD( const char **ppFileData, const char *FileDataEnd )
 		}
 	}
 
-	*ppFileData = pFileData;
 	return shape;
 }
+
+/*!
+ * Free a decoded shape, including the shape itself unless passed to iV_FinishIMD
+ */
+void iV_FreeDecodedIMD(iIMDDecoded *psDecoded)
+{
+	if (psDecoded->shape != NULL)
+	{
+		iV_IMDRelease(psDecoded->shape);
+	}
+	free(psDecoded->texfile);
+	free(psDecoded->normalfile);
+	free(psDecoded);
+}
+
+/*!
+ * Load ppFileData into a shape
+ * \param ppFileData Data from the IMD file
+ * \param FileDataEnd Endpointer
+ * \return The shape, constructed from the data read
+ */
+// ppFileData is incremented to the end of the file on exit!
+iIMDShape *iV_ProcessIMD( const char **ppFileData, const char *FileDataEnd )
+{
+	const char *pFileName = GetLastResourceFilename(); // Last loaded texture page filename
+	iIMDDecoded *psDecoded = iV_DecodeIMD(ppFileData, FileDataEnd, pFileName);
+
+	if (psDecoded == NULL)
+	{
+		return NULL;
+	}
+	return iV_FinishIMD(psDecoded, pFileName);
+}
@@ -97,8 +97,6 @@ struct iIMDShape
 	unsigned int nconnectors;
 	Vector3i *connectors;
 
-	unsigned int nShadowEdges;
-	EDGE *shadowEdgeList;
 	float material[LIGHT_MAX][4];
 	float shininess;
 
@@ -0,0 +1,86 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2011  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/** @file
+ *  Compiled PIE models, as written by tools/pie/pie2bin and read by iV_DecodeIMD.
+ *
+ *  A compiled model holds the arrays that parsing a PIE file produces, so that it loads without
+ *  any text parsing. It may be used in place of the PIE file, under the same name.
+ *
+ *  Layout: a PIEB_HEADER, then for each level a PIEB_LEVEL followed by its npoints PIEB_POINTs,
+ *  npolys PIEB_POLYs, ntexcoords PIEB_TEXCOORDs and nconnectors PIEB_CONNECTORs.
+ *  Apart from the strings, every field is a 32-bit little-endian word.
+ *
+ *  This header is shared with the converter, so it may only depend on the standard library.
+ */
+
+#ifndef __INCLUDED_LIB_IVIS_OPENGL_PIEBINARY_H__
+#define __INCLUDED_LIB_IVIS_OPENGL_PIEBINARY_H__
+
+#include <stdint.h>
+
+#define PIEB_MAGIC     "PIEB"
+#define PIEB_VERSION   2
+#define PIEB_NAME_MAX  64   ///< Including the terminating zero
+#define PIEB_LIGHTS    4    ///< Emissive, ambient, diffuse and specular, as in LIGHTING_TYPE
+
+struct PIEB_HEADER
+{
+	char     magic[4];                    ///< PIEB_MAGIC, without the terminating zero
+	uint32_t version;                     ///< PIEB_VERSION
+	uint32_t flags;                       ///< Model flags, as in the PIE file
+	uint32_t nlevels;
+	char     texfile[PIEB_NAME_MAX];      ///< Texture page, empty if untextured
+	char     normalfile[PIEB_NAME_MAX];   ///< Normal map, empty if none
+};
+
+struct PIEB_LEVEL
+{
+	float    material[PIEB_LIGHTS][4];
+	float    shininess;
+	uint32_t numFrames, animInterval;     ///< Texture animation, of the last animated polygon
+	uint32_t npoints, npolys, ntexcoords, nconnectors;
+};
+
+struct PIEB_POINT
+{
+	float x, y, z;
+};
+
+/// A triangle
+struct PIEB_POLY
+{
+	uint32_t flags;
+	int32_t  pindex[3];
+	float    normal[3];       ///< Surface normal
+	float    texAnim[2];      ///< Size of an animation frame in the texture page, 0 if not animated
+	uint32_t firstTexCoord;   ///< Index in the level's texture coordinates of the first frame's 3 coordinates, if textured
+	uint32_t numFrames;       ///< Animation frames to expand the texture coordinates to, if textured
+};
+
+struct PIEB_TEXCOORD
+{
+	float u, v;               ///< In the texture page, 0 to 1
+};
+
+struct PIEB_CONNECTOR
+{
+	int32_t x, y, z;
+};
+
+#endif // __INCLUDED_LIB_IVIS_OPENGL_PIEBINARY_H__
@@ -56,6 +56,16 @@ static GLuint radarTexture;
 static GLuint radarSizeX, radarSizeY;
 static GLfloat radarTexX, radarTexY;
 
+struct PIE_SURFACE
+{
+	GLuint   framebuffer, texture, depthbuffer;
+	int      width, height;
+	GLfloat  texX, texY;     ///< Part of the power of two texture that is used
+};
+
+static PIE_SURFACE *currentSurface = NULL;  ///< Being drawn into
+static GLfloat screenClearColour[4];        ///< Clear colour to restore after drawing into a surface
+
 /***************************************************************************/
 /*
  *	Source
@@ -349,6 +359,13 @@ void pie_DownLoadRadar(UDWORD *buffer, int width, int height, bool filter)
 	radarTexY = ((GLfloat)height / (GLfloat)h);
 }
 
+/** Replace rows of the radar texture stored by pie_DownLoadRadar, from the same buffer of width pixels per row. */
+void pie_UpdateRadar(UDWORD *buffer, int width, int firstRow, int rows)
+{
+	pie_SetTexturePage(radarTexture);
+	glTexSubImage2D(GL_TEXTURE_2D, 0, 0, firstRow, width, rows, GL_RGBA, GL_UNSIGNED_BYTE, buffer + firstRow * width);
+}
+
 /** Display radar texture using the given height and width, depending on zoom level. */
 void pie_RenderRadar(int x, int y, int width, int height)
 {
@@ -364,6 +381,145 @@ void pie_RenderRadar(int x, int y, int width, int height)
 	glEnd();
 }
 
+PIE_SURFACE *pie_CreateSurface(int width, int height)
+{
+	int w = 1, h = 1;
+
+	if (!GLEW_EXT_framebuffer_object || !GLEW_VERSION_1_4 || width <= 0 || height <= 0)
+	{
+		return NULL;
+	}
+
+	/* Find power of two size */
+	while (width > w) { w *= 2; }
+	while (height > h) { h *= 2; }
+
+	PIE_SURFACE *surface = new PIE_SURFACE;
+	surface->width = width;
+	surface->height = height;
+	surface->texX = (GLfloat)width / w;
+	surface->texY = (GLfloat)height / h;
+
+	pie_SetTexturePage(TEXPAGE_NONE);
+	glGenTextures(1, &surface->texture);
+	glBindTexture(GL_TEXTURE_2D, surface->texture);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, w, h, 0, GL_RGBA, GL_UNSIGNED_BYTE, NULL);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	glGenRenderbuffersEXT(1, &surface->depthbuffer);
+	glBindRenderbufferEXT(GL_RENDERBUFFER_EXT, surface->depthbuffer);
+	glRenderbufferStorageEXT(GL_RENDERBUFFER_EXT, GL_DEPTH_COMPONENT, w, h);
+	glBindRenderbufferEXT(GL_RENDERBUFFER_EXT, 0);
+
+	glGenFramebuffersEXT(1, &surface->framebuffer);
+	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, surface->framebuffer);
+	glFramebufferTexture2DEXT(GL_FRAMEBUFFER_EXT, GL_COLOR_ATTACHMENT0_EXT, GL_TEXTURE_2D, surface->texture, 0);
+	glFramebufferRenderbufferEXT(GL_FRAMEBUFFER_EXT, GL_DEPTH_ATTACHMENT_EXT, GL_RENDERBUFFER_EXT, surface->depthbuffer);
+	GLenum status = glCheckFramebufferStatusEXT(GL_FRAMEBUFFER_EXT);
+	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0);
+
+	if (status != GL_FRAMEBUFFER_COMPLETE_EXT)
+	{
+		debug(LOG_3D, "Can't draw into a %dx%d surface, framebuffer status 0x%x", w, h, status);
+		pie_DeleteSurface(surface);
+		return NULL;
+	}
+	return surface;
+}
+
+void pie_DeleteSurface(PIE_SURFACE *surface)
+{
+	if (surface == NULL)
+	{
+		return;
+	}
+	ASSERT(surface != currentSurface, "Deleting a surface while drawing into it");
+
+	glDeleteFramebuffersEXT(1, &surface->framebuffer);
+	glDeleteRenderbuffersEXT(1, &surface->depthbuffer);
+	glDeleteTextures(1, &surface->texture);
+	delete surface;
+}
+
+bool pie_BeginSurface(PIE_SURFACE *surface, int x, int y)
+{
+	ASSERT_OR_RETURN(false, surface != NULL, "No surface");
+	if (currentSurface != NULL)
+	{
+		return false;
+	}
+	currentSurface = surface;
+
+	// Only what is changed here is saved, the blend and alpha test states are left to pie_SetRendMode()
+	// and pie_SetAlphaTest(), so that what they remember stays what GL has
+	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, surface->framebuffer);
+	glPushAttrib(GL_VIEWPORT_BIT | GL_DEPTH_BUFFER_BIT);
+	glGetFloatv(GL_COLOR_CLEAR_VALUE, screenClearColour);
+	glViewport(0, 0, surface->width, surface->height);
+	glClearColor(0.f, 0.f, 0.f, 0.f);
+	glClearDepth(1.f);
+	glDepthMask(GL_TRUE);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+	// Map the screen rectangle onto the surface, so drawing code needn't know it's there
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	glOrtho(x, x + surface->width, y + surface->height, y, 1.0f, -1.0f);
+	glMatrixMode(GL_MODELVIEW);
+
+	pie_SetSurfaceBlending(true);
+	return true;
+}
+
+void pie_EndSurface(void)
+{
+	ASSERT_OR_RETURN(, currentSurface != NULL, "Not drawing into a surface");
+	currentSurface = NULL;
+
+	pie_SetSurfaceBlending(false);
+
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+
+	// Restores the viewport, and the clear values and depth mask changed to clear the surface
+	glPopAttrib();
+	glClearColor(screenClearColour[0], screenClearColour[1], screenClearColour[2], screenClearColour[3]);
+	glBindFramebufferEXT(GL_FRAMEBUFFER_EXT, 0);
+}
+
+void pie_DrawSurface(PIE_SURFACE *surface, int x, int y)
+{
+	ASSERT_OR_RETURN(, surface != NULL, "No surface");
+
+	pie_SetTexturePage(TEXPAGE_NONE);
+	pie_SetRendMode(REND_ALPHA);
+	pie_SetAlphaTest(false);
+
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, surface->texture);
+	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);  // The surface is premultiplied
+
+	// The bottom row of the surface is at the bottom of the texture
+	glColor4ubv(WZCOL_WHITE.vector);
+	glBegin(GL_TRIANGLE_STRIP);
+		glTexCoord2f(0, surface->texY);			glVertex2f(x, y);
+		glTexCoord2f(surface->texX, surface->texY);	glVertex2f(x + surface->width, y);
+		glTexCoord2f(0, 0);				glVertex2f(x, y + surface->height);
+		glTexCoord2f(surface->texX, 0);			glVertex2f(x + surface->width, y + surface->height);
+	glEnd();
+
+	// Back to what pie_SetRendMode(REND_ALPHA) and pie_SetTexturePage(TEXPAGE_NONE) set
+	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	glBindTexture(GL_TEXTURE_2D, 0);
+	glDisable(GL_TEXTURE_2D);
+}
+
 void pie_LoadBackDrop(SCREENTYPE screenType)
 {
 	char backd[128];
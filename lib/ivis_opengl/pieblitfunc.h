@@ -74,10 +74,25 @@ extern void pie_UniTransBoxFill(float x0, float y0, float x1, float y1, PIELIGHT
 extern bool pie_InitRadar(void);
 extern bool pie_ShutdownRadar(void);
 extern void pie_DownLoadRadar(UDWORD *buffer, int width, int height, bool filter);
+extern void pie_UpdateRadar(UDWORD *buffer, int width, int firstRow, int rows);
 extern void pie_RenderRadar(int x, int y, int width, int height);
 
 extern void pie_UploadDisplayBuffer(void);
 
+/** An offscreen image of part of the screen, for 2D drawing that is redrawn only when it changes.
+ *  Drawing between pie_BeginSurface and pie_EndSurface goes into the surface instead of the screen, in
+ *  screen coordinates; pie_DrawSurface then blends it onto the screen as if it had been drawn there.
+ */
+struct PIE_SURFACE;
+
+/// Returns NULL if the driver can't draw offscreen.
+PIE_SURFACE *pie_CreateSurface(int width, int height);
+void pie_DeleteSurface(PIE_SURFACE *surface);
+/// Starts drawing the screen rectangle at x, y, of the surface's size, into the surface. Surfaces can't be nested; returns false if one is being drawn already.
+bool pie_BeginSurface(PIE_SURFACE *surface, int x, int y);
+void pie_EndSurface(void);
+void pie_DrawSurface(PIE_SURFACE *surface, int x, int y);
+
 enum SCREENTYPE
 {
 	SCREEN_RANDOMBDROP,
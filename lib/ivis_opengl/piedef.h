@@ -74,7 +74,21 @@ extern void pie_Draw3DShape(iIMDShape *shape, int frame, int team, PIELIGHT colo
 extern void pie_DrawImage(const PIEIMAGE *image, const PIERECT *dest);
 void pie_DrawImage(const PIEIMAGE *image, const PIERECT *dest, PIELIGHT colour);
 
-extern void pie_GetResetCounts(unsigned int* pPieCount, unsigned int* pPolyCount, unsigned int* pStateCount);
+extern void pie_GetResetCounts(unsigned int* pPieCount, unsigned int* pPolyCount, unsigned int* pStateCount, unsigned int* pBatchCount);
+
+/** Get the number of shadow volumes reused from the cache, and the number built for it, since the last call. */
+void pie_GetResetShadowCacheCounts(unsigned int *pHits, unsigned int *pMisses);
+
+/** Forget the cached shadow volumes of a shape, before it is freed. */
+void pie_FreeShadowVolumes(iIMDShape *shape);
+
+/** Start collecting opaque 3D shapes instead of drawing them, until pie_EndShapeBatch().
+ *  The shapes are then drawn sorted by shape and state, so the state is set once for all instances of a shape.
+ *  Blended shapes are deferred to pie_RemainingPasses() meanwhile, and nothing else may be drawn in between. */
+void pie_BeginShapeBatch(void);
+
+/** Draw the shapes collected since pie_BeginShapeBatch(). */
+void pie_EndShapeBatch(void);
 
 /** Setup stencil shadows and OpenGL lighting. */
 void pie_BeginLighting(const Vector3f * light, bool drawshadows);
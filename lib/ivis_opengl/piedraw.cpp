@@ -39,6 +39,7 @@
 
 #include <string.h>
 #include <vector>
+#include <map>
 #include <algorithm>
 
 
@@ -60,8 +61,34 @@ extern bool drawing_interface;
 static unsigned int pieCount = 0;
 static unsigned int polyCount = 0;
 static bool shadows = false;
+static Vector3f lightEye(0.0f, 0.0f, 0.0f);	///< Direction of the light in eye coordinates, as OpenGL keeps it
 static GLfloat lighting0[LIGHT_MAX][4] = {{0.0f, 0.0f, 0.0f, 1.0f},  {0.5f, 0.5f, 0.5f, 1.0f},  {0.8f, 0.8f, 0.8f, 1.0f},  {1.0f, 1.0f, 1.0f, 1.0f}};
 
+#define SHADOW_LIGHT_STEPS	256	///< Steps per unit the light direction is rounded to, when looking up cached shadow volumes
+#define SHADOW_CACHE_MAX	4096	///< Most shadow volumes cached; the cache is emptied when it would get bigger
+
+/// Identifies a cached shadow volume: the shape, how its heights are scaled, and the light relative to it
+struct shadow_key_t
+{
+	iIMDShape*	shape;
+	int		flag;		///< Only the flags that change the shape's heights
+	int		flag_data;
+	int		light[4];	///< Direction of the light in SHADOW_LIGHT_STEPS, and its rounded length
+};
+
+static inline bool operator <(shadow_key_t const &a, shadow_key_t const &b)
+{
+	if (a.shape != b.shape) return a.shape < b.shape;  // First, so that all volumes of a shape are next to each other
+	if (a.flag != b.flag) return a.flag < b.flag;
+	if (a.flag_data != b.flag_data) return a.flag_data < b.flag_data;
+	return std::lexicographical_compare(a.light, a.light + 4, b.light, b.light + 4);
+}
+
+/// Shadow volumes of statically shadowed shapes, as quads, kept until the sun moves
+static std::map<shadow_key_t, std::vector<Vector3f> > shadowCache;
+static Vector3f shadowCacheSun(0.0f, 0.0f, 0.0f);	///< The sun that the cached volumes were built for
+static unsigned int shadowCacheHits = 0, shadowCacheMisses = 0;
+
 /*
  *	Source
  */
@@ -81,11 +108,19 @@ void pie_BeginLighting(const Vector3f *light, bool drawshadows)
 	glLightModelfv(GL_LIGHT_MODEL_AMBIENT, lighting0[LIGHT_EMISSIVE]);
 	glLightModeli(GL_LIGHT_MODEL_LOCAL_VIEWER, GL_FALSE);
 	glLightfv(GL_LIGHT0, GL_POSITION, pos);
+	lightEye = matrixTransformDirection(pie_GetMatrix(), *light);
 	glLightfv(GL_LIGHT0, GL_AMBIENT, lighting0[LIGHT_AMBIENT]);
 	glLightfv(GL_LIGHT0, GL_DIFFUSE, lighting0[LIGHT_DIFFUSE]);
 	glLightfv(GL_LIGHT0, GL_SPECULAR, lighting0[LIGHT_SPECULAR]);
 	glEnable(GL_LIGHT0);
 
+	// The cached shadow volumes are only right for the sun they were built for
+	if (*light != shadowCacheSun)
+	{
+		shadowCache.clear();
+		shadowCacheSun = *light;
+	}
+
 	if (drawshadows)
 	{
 		shadows = true;
@@ -112,7 +147,7 @@ void pie_EndLighting(void)
 
 struct shadowcasting_shape_t
 {
-	float		matrix[16];
+	Matrix4f	matrix;
 	iIMDShape*	shape;
 	int		flag;
 	int		flag_data;
@@ -121,10 +156,11 @@ struct shadowcasting_shape_t
 
 struct transluscent_shape_t
 {
-	float		matrix[16];
+	Matrix4f	matrix;
 	iIMDShape*	shape;
 	int		frame;
 	PIELIGHT	colour;
+	PIELIGHT	teamcolour;
 	int		flag;
 	int		flag_data;
 };
@@ -136,9 +172,92 @@ static transluscent_shape_t* tshapes = NULL;
 static unsigned int tshapes_size = 0;
 static unsigned int nb_tshapes = 0;
 
-static void pie_Draw3DShape2(iIMDShape *shape, int frame, PIELIGHT colour, PIELIGHT teamcolour, int pieFlag, int pieFlagData)
+/// An opaque shape waiting in the batch, see pie_BeginShapeBatch()
+struct batched_shape_t
+{
+	Matrix4f	matrix;
+	iIMDShape*	shape;
+	int		frame;
+	PIELIGHT	colour;
+	PIELIGHT	teamcolour;
+	int		flag;
+	int		flag_data;
+	float		stretch;	///< Shader stretch depth when the shape was queued
+};
+
+static std::vector<batched_shape_t> bshapes;
+static bool batching = false;
+static unsigned int batchCount = 0;	///< Groups of batched shapes drawn, for pie_GetResetCounts
+
+static void pie_SetShapeMaterial(iIMDShape *shape)
+{
+	glMaterialfv(GL_FRONT, GL_AMBIENT, shape->material[LIGHT_AMBIENT]);
+	glMaterialfv(GL_FRONT, GL_DIFFUSE, shape->material[LIGHT_DIFFUSE]);
+	glMaterialfv(GL_FRONT, GL_SPECULAR, shape->material[LIGHT_SPECULAR]);
+	glMaterialf(GL_FRONT, GL_SHININESS, shape->shininess);
+	glMaterialfv(GL_FRONT, GL_EMISSION, shape->material[LIGHT_EMISSIVE]);
+}
+
+/// Applies the construction and collapse effects to the current matrix
+static void pie_ScaleShape(iIMDShape *shape, int pieFlag, int pieFlagData)
+{
+	if (pieFlag & pie_HEIGHT_SCALED)	// construct
+	{
+		glScalef(1.0f, (float)pieFlagData / (float)pie_RAISE_SCALE, 1.0f);
+	}
+	if (pieFlag & pie_RAISE)		// collapse
+	{
+		glTranslatef(1.0f, (-shape->max.y * (pie_RAISE_SCALE - pieFlagData)) * (1.0f / pie_RAISE_SCALE), 1.0f);
+	}
+}
+
+/// Submits the polygons of a shape, with the state already set up
+static void pie_DrawShapePolys(iIMDShape *shape, int frame, bool shaders)
 {
 	iIMDPoly *pPolys;
+
+	frame %= MAX(1, shape->numFrames);
+
+	glBegin(GL_TRIANGLES);
+	for (pPolys = shape->polys; pPolys < shape->polys + shape->npolys; pPolys++)
+	{
+		Vector3f	vertexCoords[3];
+		unsigned int	n, frameidx = frame;
+		int	*index;
+
+		if (!(pPolys->flags & iV_IMD_TEXANIM))
+		{
+			frameidx = 0;
+		}
+
+		for (n = 0, index = pPolys->pindex;
+				n < pPolys->npnts;
+				n++, index++)
+		{
+			vertexCoords[n].x = shape->points[*index].x;
+			vertexCoords[n].y = shape->points[*index].y;
+			vertexCoords[n].z = shape->points[*index].z;
+		}
+
+		polyCount++;
+
+		glNormal3fv((GLfloat*)&pPolys->normal);
+		for (n = 0; n < pPolys->npnts; n++)
+		{
+			GLfloat* texCoord = (GLfloat*)&pPolys->texCoord[frameidx * pPolys->npnts + n];
+			glTexCoord2fv(texCoord);
+			if (!shaders)
+			{
+				glMultiTexCoord2fv(GL_TEXTURE1, texCoord);
+			}
+			glVertex3fv((GLfloat*)&vertexCoords[n]);
+		}
+	}
+	glEnd();
+}
+
+static void pie_Draw3DShape2(iIMDShape *shape, int frame, PIELIGHT colour, PIELIGHT teamcolour, int pieFlag, int pieFlagData)
+{
 	bool light = true;
 	bool shaders = pie_GetShaderAvailability();
 
@@ -194,11 +313,7 @@ static void pie_Draw3DShape2(iIMDShape *shape, int frame, PIELIGHT colour, PIELI
 
 	if (light)
 	{
-		glMaterialfv(GL_FRONT, GL_AMBIENT, shape->material[LIGHT_AMBIENT]);
-		glMaterialfv(GL_FRONT, GL_DIFFUSE, shape->material[LIGHT_DIFFUSE]);
-		glMaterialfv(GL_FRONT, GL_SPECULAR, shape->material[LIGHT_SPECULAR]);
-		glMaterialf(GL_FRONT, GL_SHININESS, shape->shininess);
-		glMaterialfv(GL_FRONT, GL_EMISSION, shape->material[LIGHT_EMISSIVE]);
+		pie_SetShapeMaterial(shape);
 		if (shaders)
 		{
 			pie_ActivateShader(SHADER_COMPONENT, shape, teamcolour, colour);
@@ -209,56 +324,12 @@ static void pie_Draw3DShape2(iIMDShape *shape, int frame, PIELIGHT colour, PIELI
 		}
 	}
 
-	if (pieFlag & pie_HEIGHT_SCALED)	// construct
-	{
-		glScalef(1.0f, (float)pieFlagData / (float)pie_RAISE_SCALE, 1.0f);
-	}
-	if (pieFlag & pie_RAISE)		// collapse
-	{
-		glTranslatef(1.0f, (-shape->max.y * (pie_RAISE_SCALE - pieFlagData)) * (1.0f / pie_RAISE_SCALE), 1.0f);
-	}
+	pie_ScaleShape(shape, pieFlag, pieFlagData);
 
 	glColor4ubv(colour.vector);     // Only need to set once for entire model
 	pie_SetTexturePage(shape->texpage);
 
-	frame %= MAX(1, shape->numFrames);
-
-	glBegin(GL_TRIANGLES);
-	for (pPolys = shape->polys; pPolys < shape->polys + shape->npolys; pPolys++)
-	{
-		Vector3f	vertexCoords[3];
-		unsigned int	n, frameidx = frame;
-		int	*index;
-
-		if (!(pPolys->flags & iV_IMD_TEXANIM))
-		{
-			frameidx = 0;
-		}
-
-		for (n = 0, index = pPolys->pindex;
-				n < pPolys->npnts;
-				n++, index++)
-		{
-			vertexCoords[n].x = shape->points[*index].x;
-			vertexCoords[n].y = shape->points[*index].y;
-			vertexCoords[n].z = shape->points[*index].z;
-		}
-
-		polyCount++;
-
-		glNormal3fv((GLfloat*)&pPolys->normal);
-		for (n = 0; n < pPolys->npnts; n++)
-		{
-			GLfloat* texCoord = (GLfloat*)&pPolys->texCoord[frameidx * pPolys->npnts + n];
-			glTexCoord2fv(texCoord);
-			if (!shaders)
-			{
-				glMultiTexCoord2fv(GL_TEXTURE1, texCoord);
-			}
-			glVertex3fv((GLfloat*)&vertexCoords[n]);
-		}
-	}
-	glEnd();
+	pie_DrawShapePolys(shape, frame, shaders);
 
 	if (light || (pieFlag & pie_BUTTON))
 	{
@@ -279,6 +350,121 @@ static void pie_Draw3DShape2(iIMDShape *shape, int frame, PIELIGHT colour, PIELI
 	}
 }
 
+/// Orders batched shapes so that shapes sharing a texture page, shape and colours are drawn together
+static inline bool batchedShapeLessThan(batched_shape_t const &a, batched_shape_t const &b)
+{
+	if (a.shape->texpage != b.shape->texpage) return a.shape->texpage < b.shape->texpage;
+	if (a.shape != b.shape) return a.shape < b.shape;
+	if (a.teamcolour.rgba != b.teamcolour.rgba) return a.teamcolour.rgba < b.teamcolour.rgba;
+	if (a.colour.rgba != b.colour.rgba) return a.colour.rgba < b.colour.rgba;
+	return a.stretch < b.stretch;
+}
+
+/// Whether the shader inputs of two batched shapes differ
+static inline bool batchedShapeColoursDiffer(batched_shape_t const &a, batched_shape_t const &b)
+{
+	return a.teamcolour.rgba != b.teamcolour.rgba || a.colour.rgba != b.colour.rgba || a.stretch != b.stretch;
+}
+
+static void pie_BatchShape(iIMDShape *shape, int frame, PIELIGHT colour, PIELIGHT teamcolour, int pieFlag, int pieFlagData)
+{
+	batched_shape_t bshape;
+
+	bshape.matrix = pie_GetMatrix();
+	bshape.shape = shape;
+	bshape.frame = frame;
+	bshape.colour = colour;
+	bshape.teamcolour = teamcolour;
+	bshape.flag = pieFlag;
+	bshape.flag_data = pieFlagData;
+	bshape.stretch = pie_GetShaderStretchDepth();
+	bshapes.push_back(bshape);
+}
+
+static void pie_DeactivateShapeShader(bool shaders)
+{
+	if (shaders)
+	{
+		pie_DeactivateShader();
+	}
+	else
+	{
+		pie_DeactivateFallback();
+	}
+}
+
+/// Draws the batched shapes. The material, texture and shader are set up once for each shape,
+/// and the shader inputs again only when the colours of the next instance differ.
+static void pie_DrawBatchedShapes(void)
+{
+	const bool shaders = pie_GetShaderAvailability();
+	const float stretch = pie_GetShaderStretchDepth();
+	std::vector<batched_shape_t>::const_iterator prev = bshapes.end();
+
+	if (bshapes.empty())
+	{
+		return;
+	}
+
+	std::sort(bshapes.begin(), bshapes.end(), batchedShapeLessThan);
+
+	pie_SetAlphaTest(true);
+	pie_SetFogStatus(true);
+	pie_SetRendMode(REND_OPAQUE);
+
+	glPushMatrix();
+	for (std::vector<batched_shape_t>::const_iterator i = bshapes.begin(); i != bshapes.end(); prev = i++)
+	{
+		const bool newShape = prev == bshapes.end() || prev->shape != i->shape;
+
+		if (newShape)
+		{
+			if (prev != bshapes.end())
+			{
+				pie_DeactivateShapeShader(shaders);
+			}
+			pie_SetShapeMaterial(i->shape);
+			batchCount++;
+		}
+		if (newShape || batchedShapeColoursDiffer(*prev, *i))
+		{
+			pie_SetShaderStretchDepth(i->stretch);
+			if (shaders)
+			{
+				pie_ActivateShader(SHADER_COMPONENT, i->shape, i->teamcolour, i->colour);
+			}
+			else
+			{
+				pie_ActivateFallback(SHADER_COMPONENT, i->shape, i->teamcolour, i->colour);
+			}
+			glColor4ubv(i->colour.vector);
+			pie_SetTexturePage(i->shape->texpage);
+		}
+
+		glLoadMatrixf(i->matrix.m);
+		pie_ScaleShape(i->shape, i->flag, i->flag_data);
+		pie_DrawShapePolys(i->shape, i->frame, shaders);
+	}
+	pie_DeactivateShapeShader(shaders);
+	glPopMatrix();
+
+	pie_SetShaderStretchDepth(stretch);
+	bshapes.clear();
+}
+
+void pie_BeginShapeBatch(void)
+{
+	ASSERT(!batching, "Shape batch already begun");
+	batching = true;
+}
+
+void pie_EndShapeBatch(void)
+{
+	ASSERT(batching, "Shape batch not begun");
+	batching = false;
+	pie_DrawBatchedShapes();
+}
+
 static inline bool edgeLessThan(EDGE const &e1, EDGE const &e2)
 {
 	if (e1.from != e2.from) return e1.from < e2.from;
@@ -318,8 +504,8 @@ static inline float scale_y(float y, int flag, int flag_data)
 	return tempY;
 }
 
-/// Draw the shadow for a shape
-static void pie_DrawShadow(iIMDShape *shape, int flag, int flag_data, Vector3f* light)
+/// Build the shadow volume of a shape, as a quad for each silhouette edge
+static void pie_BuildShadowVolume(iIMDShape *shape, int flag, int flag_data, Vector3f const *light, std::vector<Vector3f> &volume)
 {
 	unsigned int i, j, n;
 	Vector3f *pVertices;
@@ -327,74 +513,103 @@ static void pie_DrawShadow(iIMDShape *shape, int flag, int flag_data, Vector3f*
 	static std::vector<EDGE> edgelist;  // Static, to save allocations.
 	static std::vector<EDGE> edgelistFlipped;  // Static, to save allocations.
 	static std::vector<EDGE> edgelistFiltered;  // Static, to save allocations.
-	EDGE *drawlist = NULL;
 
-	unsigned edge_count;
 	pVertices = shape->points;
-	if( flag & pie_STATIC_SHADOW && shape->shadowEdgeList )
+	edgelist.clear();
+	for (i = 0, pPolys = shape->polys; i < shape->npolys; ++i, ++pPolys)
 	{
-		drawlist = shape->shadowEdgeList;
-		edge_count = shape->nShadowEdges;
-	}
-	else
-	{
-		edgelist.clear();
-		for (i = 0, pPolys = shape->polys; i < shape->npolys; ++i, ++pPolys)
+		Vector3f p[3];
+		for(j = 0; j < 3; j++)
 		{
-			Vector3f p[3];
-			for(j = 0; j < 3; j++)
-			{
-				int current = pPolys->pindex[j];
-				p[j] = Vector3f(pVertices[current].x, scale_y(pVertices[current].y, flag, flag_data), pVertices[current].z);
-			}
+			int current = pPolys->pindex[j];
+			p[j] = Vector3f(pVertices[current].x, scale_y(pVertices[current].y, flag, flag_data), pVertices[current].z);
+		}
 
-			Vector3f normal = crossProduct(p[2] - p[0], p[1] - p[0]);
-			if (normal * *light > 0)
+		Vector3f normal = crossProduct(p[2] - p[0], p[1] - p[0]);
+		if (normal * *light > 0)
+		{
+			for (n = 1; n < pPolys->npnts; n++)
 			{
-				for (n = 1; n < pPolys->npnts; n++)
-				{
-					// link to the previous vertex
-					addToEdgeList(pPolys->pindex[n-1], pPolys->pindex[n], edgelist);
-				}
-				// back to the first
-				addToEdgeList(pPolys->pindex[pPolys->npnts-1], pPolys->pindex[0], edgelist);
+				// link to the previous vertex
+				addToEdgeList(pPolys->pindex[n-1], pPolys->pindex[n], edgelist);
 			}
+			// back to the first
+			addToEdgeList(pPolys->pindex[pPolys->npnts-1], pPolys->pindex[0], edgelist);
 		}
+	}
 
-		// Remove duplicate pairs from the edge list. For example, in the list ((1 2), (2 6), (6 2), (3, 4)), remove (2 6) and (6 2).
-		edgelistFlipped = edgelist;
-		std::for_each(edgelistFlipped.begin(), edgelistFlipped.end(), flipEdge);
-		std::sort(edgelist.begin(), edgelist.end(), edgeLessThan);
-		std::sort(edgelistFlipped.begin(), edgelistFlipped.end(), edgeLessThan);
-		edgelistFiltered.resize(edgelist.size());
-		edgelistFiltered.erase(std::set_difference(edgelist.begin(), edgelist.end(), edgelistFlipped.begin(), edgelistFlipped.end(), edgelistFiltered.begin(), edgeLessThan), edgelistFiltered.end());
+	// Remove duplicate pairs from the edge list. For example, in the list ((1 2), (2 6), (6 2), (3, 4)), remove (2 6) and (6 2).
+	edgelistFlipped = edgelist;
+	std::for_each(edgelistFlipped.begin(), edgelistFlipped.end(), flipEdge);
+	std::sort(edgelist.begin(), edgelist.end(), edgeLessThan);
+	std::sort(edgelistFlipped.begin(), edgelistFlipped.end(), edgeLessThan);
+	edgelistFiltered.resize(edgelist.size());
+	edgelistFiltered.erase(std::set_difference(edgelist.begin(), edgelist.end(), edgelistFlipped.begin(), edgelistFlipped.end(), edgelistFiltered.begin(), edgeLessThan), edgelistFiltered.end());
+	//debug(LOG_WARNING, "we have %i edges", (int)edgelistFiltered.size());
+
+	// extrude the silhouette away from the light
+	volume.resize(edgelistFiltered.size() * 4);
+	for (i = 0; i < edgelistFiltered.size(); i++)
+	{
+		int a = edgelistFiltered[i].from, b = edgelistFiltered[i].to;
 
-		drawlist = &edgelistFiltered[0];
-		edge_count = edgelistFiltered.size();
-		//debug(LOG_WARNING, "we have %i edges", edge_count);
+		volume[i*4 + 0] = Vector3f(pVertices[b].x, scale_y(pVertices[b].y, flag, flag_data), pVertices[b].z);
+		volume[i*4 + 1] = volume[i*4 + 0] + *light;
+		volume[i*4 + 3] = Vector3f(pVertices[a].x, scale_y(pVertices[a].y, flag, flag_data), pVertices[a].z);
+		volume[i*4 + 2] = volume[i*4 + 3] + *light;
+	}
+}
+
+/// Draw the shadow for a shape
+/// The volumes of statically shadowed shapes are cached, since the light only changes relative to them when the sun moves.
+static void pie_DrawShadow(iIMDShape *shape, int flag, int flag_data, Vector3f* light)
+{
+	static std::vector<Vector3f> volume;  // Static, to save allocations.
+	const std::vector<Vector3f> *drawVolume = &volume;
 
-		if(flag & pie_STATIC_SHADOW)
+	if (flag & pie_STATIC_SHADOW)
+	{
+		const float length = sqrtf(*light * *light);
+		shadow_key_t key;
+
+		key.shape = shape;
+		key.flag = flag & (pie_RAISE | pie_HEIGHT_SCALED);
+		key.flag_data = key.flag != 0 ? flag_data : 0;
+		key.light[0] = lroundf(light->x / length * SHADOW_LIGHT_STEPS);
+		key.light[1] = lroundf(light->y / length * SHADOW_LIGHT_STEPS);
+		key.light[2] = lroundf(light->z / length * SHADOW_LIGHT_STEPS);
+		key.light[3] = lroundf(length);
+
+		std::map<shadow_key_t, std::vector<Vector3f> >::iterator cached = shadowCache.find(key);
+		if (cached == shadowCache.end())
+		{
+			if (shadowCache.size() >= SHADOW_CACHE_MAX)
+			{
+				shadowCache.clear();
+			}
+			cached = shadowCache.insert(std::make_pair(key, std::vector<Vector3f>())).first;
+			pie_BuildShadowVolume(shape, key.flag, key.flag_data, light, cached->second);
+			shadowCacheMisses++;
+		}
+		else
 		{
-			// then store it in the imd
-			shape->nShadowEdges = edge_count;
-			shape->shadowEdgeList = (EDGE *)realloc(shape->shadowEdgeList, sizeof(EDGE) * shape->nShadowEdges);
-			std::copy(drawlist, drawlist + edge_count, shape->shadowEdgeList);
+			shadowCacheHits++;
 		}
+		drawVolume = &cached->second;
 	}
-
-	// draw the shadow volume
-	glBegin(GL_QUADS);
-	glNormal3f(0.0, 1.0, 0.0);
-	for(i=0;i<edge_count;i++)
+	else
 	{
-		int a = drawlist[i].from, b = drawlist[i].to;
+		pie_BuildShadowVolume(shape, flag, flag_data, light, volume);
+	}
 
-		glVertex3f(pVertices[b].x, scale_y(pVertices[b].y, flag, flag_data), pVertices[b].z);
-		glVertex3f(pVertices[b].x+light->x, scale_y(pVertices[b].y, flag, flag_data)+light->y, pVertices[b].z+light->z);
-		glVertex3f(pVertices[a].x+light->x, scale_y(pVertices[a].y, flag, flag_data)+light->y, pVertices[a].z+light->z);
-		glVertex3f(pVertices[a].x, scale_y(pVertices[a].y, flag, flag_data), pVertices[a].z);
+	if (drawVolume->empty())
+	{
+		return;
 	}
-	glEnd();
+
+	// draw the shadow volume
+	glVertexPointer(3, GL_FLOAT, sizeof(Vector3f), &(*drawVolume)[0]);
+	glDrawArrays(GL_QUADS, 0, drawVolume->size());
 
 #ifdef SHOW_SHADOW_EDGES
 	glDisable(GL_DEPTH_TEST);
@@ -402,16 +617,10 @@ static void pie_DrawShadow(iIMDShape *shape, int flag, int flag_data, Vector3f*
 
 	glColor4ub(0xFF, 0, 0, 0xFF);
 	glBegin(GL_LINES);
-	for(i = 0; i < edge_count; i++)
+	for (unsigned i = 0; i < drawVolume->size(); i += 4)
 	{
-		int a = drawlist[i].from, b = drawlist[i].to;
-		if(a < 0)
-		{
-			continue;
-		}
-
-		glVertex3f(pVertices[b].x, scale_y(pVertices[b].y, flag, flag_data), pVertices[b].z);
-		glVertex3f(pVertices[a].x, scale_y(pVertices[a].y, flag, flag_data), pVertices[a].z);
+		glVertex3f((*drawVolume)[i].x, (*drawVolume)[i].y, (*drawVolume)[i].z);
+		glVertex3f((*drawVolume)[i + 3].x, (*drawVolume)[i + 3].y, (*drawVolume)[i + 3].z);
 	}
 	glEnd();
 	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
@@ -419,6 +628,31 @@ static void pie_DrawShadow(iIMDShape *shape, int flag, int flag_data, Vector3f*
 #endif
 }
 
+void pie_FreeShadowVolumes(iIMDShape *shape)
+{
+	shadow_key_t key;
+
+	memset(&key, 0, sizeof(key));
+	key.shape = shape;
+	key.flag = INT_MIN;
+	key.flag_data = INT_MIN;
+	std::map<shadow_key_t, std::vector<Vector3f> >::iterator first = shadowCache.lower_bound(key), last = first;
+	while (last != shadowCache.end() && last->first.shape == shape)
+	{
+		++last;
+	}
+	shadowCache.erase(first, last);
+}
+
+void pie_GetResetShadowCacheCounts(unsigned int *pHits, unsigned int *pMisses)
+{
+	*pHits = shadowCacheHits;
+	*pMisses = shadowCacheMisses;
+
+	shadowCacheHits = 0;
+	shadowCacheMisses = 0;
+}
+
 static void inverse_matrix(const float * src, float * dst)
 {
 	const float det = src[0]*src[5]*src[10] + src[4]*src[9]*src[2] + src[8]*src[1]*src[6] - src[2]*src[5]*src[8] - src[6]*src[9]*src[0] - src[10]*src[1]*src[4];
@@ -446,6 +680,8 @@ void pie_CleanUp( void )
 	free( scshapes );
 	tshapes = NULL;
 	scshapes = NULL;
+	bshapes.clear();
+	shadowCache.clear();
 }
 
 void pie_Draw3DShape(iIMDShape *shape, int frame, int team, PIELIGHT colour, int pieFlag, int pieFlagData)
@@ -465,13 +701,14 @@ void pie_Draw3DShape(iIMDShape *shape, int frame, int team, PIELIGHT colour, int
 		frame = team;
 	}
 
-	if (drawing_interface || !shadows)
+	if (drawing_interface || (!shadows && !batching))
 	{
 		pie_Draw3DShape2(shape, frame, colour, teamcolour, pieFlag, pieFlagData);
 	}
 	else
 	{
-		if (pieFlag & (pie_ADDITIVE | pie_TRANSLUCENT))
+		// While batching, blended shapes must wait until the batched shapes behind them have been drawn.
+		if (pieFlag & (pie_ADDITIVE | pie_TRANSLUCENT) || (batching && (pieFlag & pie_ECM)))
 		{
 			if (tshapes_size <= nb_tshapes)
 			{
@@ -489,17 +726,18 @@ void pie_Draw3DShape(iIMDShape *shape, int frame, int team, PIELIGHT colour, int
 					memset( &tshapes[old_size], 0, (tshapes_size-old_size)*sizeof(transluscent_shape_t) );
 				}
 			}
-			glGetFloatv(GL_MODELVIEW_MATRIX, tshapes[nb_tshapes].matrix);
+			tshapes[nb_tshapes].matrix = pie_GetMatrix();
 			tshapes[nb_tshapes].shape = shape;
 			tshapes[nb_tshapes].frame = frame;
 			tshapes[nb_tshapes].colour = colour;
+			tshapes[nb_tshapes].teamcolour = teamcolour;
 			tshapes[nb_tshapes].flag = pieFlag;
 			tshapes[nb_tshapes].flag_data = pieFlagData;
 			nb_tshapes++;
 		}
 		else
 		{
-			if(pieFlag & pie_SHADOW || pieFlag & pie_STATIC_SHADOW)
+			if (shadows && (pieFlag & pie_SHADOW || pieFlag & pie_STATIC_SHADOW))
 			{
 				float distance;
 
@@ -521,23 +759,22 @@ void pie_Draw3DShape(iIMDShape *shape, int frame, int team, PIELIGHT colour, int
 					}
 				}
 
-				glGetFloatv(GL_MODELVIEW_MATRIX, scshapes[nb_scshapes].matrix);
-				distance = scshapes[nb_scshapes].matrix[12] * scshapes[nb_scshapes].matrix[12];
-				distance += scshapes[nb_scshapes].matrix[13] * scshapes[nb_scshapes].matrix[13];
-				distance += scshapes[nb_scshapes].matrix[14] * scshapes[nb_scshapes].matrix[14];
+				scshapes[nb_scshapes].matrix = pie_GetMatrix();
+				distance = scshapes[nb_scshapes].matrix.m[12] * scshapes[nb_scshapes].matrix.m[12];
+				distance += scshapes[nb_scshapes].matrix.m[13] * scshapes[nb_scshapes].matrix.m[13];
+				distance += scshapes[nb_scshapes].matrix.m[14] * scshapes[nb_scshapes].matrix.m[14];
 
 				// if object is too far in the fog don't generate a shadow.
 				if (distance < SHADOW_END_DISTANCE)
 				{
-					float invmat[9], pos_light0[4];
+					float invmat[9];
 
-					inverse_matrix( scshapes[nb_scshapes].matrix, invmat );
+					inverse_matrix( scshapes[nb_scshapes].matrix.m, invmat );
 
 					// Calculate the light position relative to the object
-					glGetLightfv(GL_LIGHT0, GL_POSITION, pos_light0);
-					scshapes[nb_scshapes].light.x = invmat[0] * pos_light0[0] + invmat[3] * pos_light0[1] + invmat[6] * pos_light0[2];
-					scshapes[nb_scshapes].light.y = invmat[1] * pos_light0[0] + invmat[4] * pos_light0[1] + invmat[7] * pos_light0[2];
-					scshapes[nb_scshapes].light.z = invmat[2] * pos_light0[0] + invmat[5] * pos_light0[1] + invmat[8] * pos_light0[2];
+					scshapes[nb_scshapes].light.x = invmat[0] * lightEye.x + invmat[3] * lightEye.y + invmat[6] * lightEye.z;
+					scshapes[nb_scshapes].light.y = invmat[1] * lightEye.x + invmat[4] * lightEye.y + invmat[7] * lightEye.z;
+					scshapes[nb_scshapes].light.z = invmat[2] * lightEye.x + invmat[5] * lightEye.y + invmat[8] * lightEye.z;
 
 					scshapes[nb_scshapes].shape = shape;
 					scshapes[nb_scshapes].flag = pieFlag;
@@ -547,7 +784,14 @@ void pie_Draw3DShape(iIMDShape *shape, int frame, int team, PIELIGHT colour, int
 				}
 			}
 
-			pie_Draw3DShape2(shape, frame, colour, teamcolour, pieFlag, pieFlagData);
+			if (batching && !(pieFlag & pie_BUTTON))
+			{
+				pie_BatchShape(shape, frame, colour, teamcolour, pieFlag, pieFlagData);
+			}
+			else
+			{
+				pie_Draw3DShape2(shape, frame, colour, teamcolour, pieFlag, pieFlagData);
+			}
 		}
 	}
 }
@@ -556,11 +800,19 @@ static void pie_ShadowDrawLoop(void)
 {
 	unsigned int i = 0;
 
+	// The volumes are drawn from client memory
+	glPushClientAttrib(GL_CLIENT_VERTEX_ARRAY_BIT);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glNormal3f(0.0, 1.0, 0.0);
+
 	for (i = 0; i < nb_scshapes; i++)
 	{
-		glLoadMatrixf(scshapes[i].matrix);
+		glLoadMatrixf(scshapes[i].matrix.m);
 		pie_DrawShadow(scshapes[i].shape, scshapes[i].flag, scshapes[i].flag_data, &scshapes[i].light);
 	}
+
+	glPopClientAttrib();
 }
 
 static void pie_DrawShadows(void)
@@ -670,8 +922,8 @@ static void pie_DrawRemainingTransShapes(void)
 	glPushMatrix();
 	for (i = 0; i < nb_tshapes; ++i)
 	{
-		glLoadMatrixf(tshapes[i].matrix);
-		pie_Draw3DShape2(tshapes[i].shape, tshapes[i].frame, tshapes[i].colour, tshapes[i].colour,
+		glLoadMatrixf(tshapes[i].matrix.m);
+		pie_Draw3DShape2(tshapes[i].shape, tshapes[i].frame, tshapes[i].colour, tshapes[i].teamcolour,
 				 tshapes[i].flag, tshapes[i].flag_data);
 	}
 	glPopMatrix();
@@ -681,6 +933,7 @@ static void pie_DrawRemainingTransShapes(void)
 
 void pie_RemainingPasses(void)
 {
+	ASSERT(!batching, "Shape batch not ended");
 	if(shadows)
 	{
 		pie_DrawShadows();
@@ -727,14 +980,16 @@ void pie_DrawImage(const PIEIMAGE *image, const PIERECT *dest, PIELIGHT colour)
 	glEnd();
 }
 
-void pie_GetResetCounts(unsigned int* pPieCount, unsigned int* pPolyCount, unsigned int* pStateCount)
+void pie_GetResetCounts(unsigned int* pPieCount, unsigned int* pPolyCount, unsigned int* pStateCount, unsigned int* pBatchCount)
 {
 	*pPieCount  = pieCount;
 	*pPolyCount = polyCount;
 	*pStateCount = pieStateCount;
+	*pBatchCount = batchCount;
 
 	pieCount = 0;
 	polyCount = 0;
 	pieStateCount = 0;
+	batchCount = 0;
 	return;
 }
@@ -37,35 +37,21 @@
 
 #define MATRIX_MAX 8
 
-/*
- * Matrices are of this form:
- * [ a d g j ]
- * [ b e h k ]
- * [ c f i l ]
- * [ 0 0 0 1 ]
- */
-struct SDMATRIX
-{
-	SDWORD a, b, c,
-	       d, e, f,
-	       g, h, i,
-	       j, k, l;
-};
-static SDMATRIX	aMatrixStack[MATRIX_MAX];
-static SDMATRIX *psMatrix = &aMatrixStack[0];
+static Matrix4f aMatrixStack[MATRIX_MAX];
+static Matrix4f *psMatrix = &aMatrixStack[0];
 
 bool drawing_interface = true;
 
 //*************************************************************************
 
-static const SDMATRIX Identitymatrix = {
-	FP12_MULTIPLIER,                  0,               0,
-	              0,    FP12_MULTIPLIER,               0,
-	              0,                  0, FP12_MULTIPLIER,
-	              0,                  0,               0,
-};
 static SDWORD _MATRIX_INDEX;
 
+/// The matrix stack is computed here, and OpenGL is only ever given the result, so it never has to be read back.
+static inline void pie_MatLoad(void)
+{
+	glLoadMatrixf(psMatrix->m);
+}
+
 //*************************************************************************
 //*** reset transformation matrix stack and make current identity
 //*
@@ -74,11 +60,12 @@ static SDWORD _MATRIX_INDEX;
 static void pie_MatReset(void)
 {
 	psMatrix = &aMatrixStack[0];
+	_MATRIX_INDEX = 0;
 
 	// make 1st matrix identity
-	*psMatrix = Identitymatrix;
+	matrixIdentity(psMatrix);
 
-	glLoadIdentity();
+	pie_MatLoad();
 }
 
 
@@ -94,8 +81,6 @@ void pie_MatBegin(void)
 
 	psMatrix++;
 	aMatrixStack[_MATRIX_INDEX] = aMatrixStack[_MATRIX_INDEX-1];
-
-	glPushMatrix();
 }
 
 
@@ -111,25 +96,14 @@ void pie_MatEnd(void)
 
 	psMatrix--;
 
-	glPopMatrix();
+	pie_MatLoad();
 }
 
 
 void pie_TRANSLATE(int32_t x, int32_t y, int32_t z)
 {
-	/*
-	 * curMatrix = curMatrix . translationMatrix(x, y, z)
-	 *
-	 *                         [ 1 0 0 x ]
-	 *                         [ 0 1 0 y ]
-	 * curMatrix = curMatrix . [ 0 0 1 z ]
-	 *                         [ 0 0 0 1 ]
-	 */
-	psMatrix->j += x * psMatrix->a + y * psMatrix->d + z * psMatrix->g;
-	psMatrix->k += x * psMatrix->b + y * psMatrix->e + z * psMatrix->h;
-	psMatrix->l += x * psMatrix->c + y * psMatrix->f + z * psMatrix->i;
-
-	glTranslatef(x, y, z);
+	matrixTranslate(psMatrix, x, y, z);
+	pie_MatLoad();
 }
 
 //*************************************************************************
@@ -138,31 +112,8 @@ void pie_TRANSLATE(int32_t x, int32_t y, int32_t z)
 //******
 void pie_MatScale(float scale)
 {
-	/*
-	 * s := scale
-	 * curMatrix = curMatrix . scaleMatrix(s, s, s)
-	 *
-	 *                         [ s 0 0 0 ]
-	 *                         [ 0 s 0 0 ]
-	 * curMatrix = curMatrix . [ 0 0 s 0 ]
-	 *                         [ 0 0 0 1 ]
-	 *
-	 * curMatrix = scale * curMatrix
-	 */
-
-	psMatrix->a = psMatrix->a * scale;
-	psMatrix->b = psMatrix->b * scale;
-	psMatrix->c = psMatrix->c * scale;
-
-	psMatrix->d = psMatrix->d * scale;
-	psMatrix->e = psMatrix->e * scale;
-	psMatrix->f = psMatrix->f * scale;
-
-	psMatrix->g = psMatrix->g * scale;
-	psMatrix->h = psMatrix->h * scale;
-	psMatrix->i = psMatrix->i * scale;
-
-	glScalef(scale, scale, scale);
+	matrixScale(psMatrix, scale, scale, scale);
+	pie_MatLoad();
 }
 
 
@@ -173,36 +124,10 @@ void pie_MatScale(float scale)
 
 void pie_MatRotY(uint16_t y)
 {
-	/*
-	 * a := angle
-	 * c := cos(a)
-	 * s := sin(a)
-	 *
-	 * curMatrix = curMatrix . rotationMatrix(a, 0, 1, 0)
-	 *
-	 *                         [  c  0  s  0 ]
-	 *                         [  0  1  0  0 ]
-	 * curMatrix = curMatrix . [ -s  0  c  0 ]
-	 *                         [  0  0  0  1 ]
-	 */
 	if (y != 0)
 	{
-		int t;
-		int64_t cra = iCos(y), sra = iSin(y);
-
-		t = (cra*psMatrix->a - sra*psMatrix->g)>>16;
-		psMatrix->g = (sra*psMatrix->a + cra*psMatrix->g)>>16;
-		psMatrix->a = t;
-
-		t = (cra*psMatrix->b - sra*psMatrix->h)>>16;
-		psMatrix->h = (sra*psMatrix->b + cra*psMatrix->h)>>16;
-		psMatrix->b = t;
-
-		t = (cra*psMatrix->c - sra*psMatrix->i)>>16;
-		psMatrix->i = (sra*psMatrix->c + cra*psMatrix->i)>>16;
-		psMatrix->c = t;
-
-		glRotatef(UNDEG(y), 0.0f, 1.0f, 0.0f);
+		matrixRotY(psMatrix, y);
+		pie_MatLoad();
 	}
 }
 
@@ -214,36 +139,10 @@ void pie_MatRotY(uint16_t y)
 
 void pie_MatRotZ(uint16_t z)
 {
-	/*
-	 * a := angle
-	 * c := cos(a)
-	 * s := sin(a)
-	 *
-	 * curMatrix = curMatrix . rotationMatrix(a, 0, 0, 1)
-	 *
-	 *                         [ c  -s  0  0 ]
-	 *                         [ s   c  0  0 ]
-	 * curMatrix = curMatrix . [ 0   0  1  0 ]
-	 *                         [ 0   0  0  1 ]
-	 */
 	if (z != 0)
 	{
-		int t;
-		int64_t cra = iCos(z), sra = iSin(z);
-
-		t = (cra*psMatrix->a + sra*psMatrix->d)>>16;
-		psMatrix->d = (cra*psMatrix->d - sra*psMatrix->a)>>16;
-		psMatrix->a = t;
-
-		t = (cra*psMatrix->b + sra*psMatrix->e)>>16;
-		psMatrix->e = (cra*psMatrix->e - sra*psMatrix->b)>>16;
-		psMatrix->b = t;
-
-		t = (cra*psMatrix->c + sra*psMatrix->f)>>16;
-		psMatrix->f = (cra*psMatrix->f - sra*psMatrix->c)>>16;
-		psMatrix->c = t;
-
-		glRotatef(UNDEG(z), 0.0f, 0.0f, 1.0f);
+		matrixRotZ(psMatrix, z);
+		pie_MatLoad();
 	}
 }
 
@@ -255,39 +154,18 @@ void pie_MatRotZ(uint16_t z)
 
 void pie_MatRotX(uint16_t x)
 {
-	/*
-	 * a := angle
-	 * c := cos(a)
-	 * s := sin(a)
-	 *
-	 * curMatrix = curMatrix . rotationMatrix(a, 0, 0, 1)
-	 *
-	 *                         [ 1  0   0  0 ]
-	 *                         [ 0  c  -s  0 ]
-	 * curMatrix = curMatrix . [ 0  s   c  0 ]
-	 *                         [ 0  0   0  1 ]
-	 */
-	if (x != 0.f)
+	if (x != 0)
 	{
-		int t;
-		int64_t cra = iCos(x), sra = iSin(x);
-
-		t = (cra*psMatrix->d + sra*psMatrix->g)>>16;
-		psMatrix->g = (cra*psMatrix->g - sra*psMatrix->d)>>16;
-		psMatrix->d = t;
-
-		t = (cra*psMatrix->e + sra*psMatrix->h)>>16;
-		psMatrix->h = (cra*psMatrix->h - sra*psMatrix->e)>>16;
-		psMatrix->e = t;
-
-		t = (cra*psMatrix->f + sra*psMatrix->i)>>16;
-		psMatrix->i = (cra*psMatrix->i - sra*psMatrix->f)>>16;
-		psMatrix->f = t;
-
-		glRotatef(UNDEG(x), 1.0f, 0.0f, 0.0f);
+		matrixRotX(psMatrix, x);
+		pie_MatLoad();
 	}
 }
 
+Matrix4f const &pie_GetMatrix(void)
+{
+	return *psMatrix;
+}
+
 
 /*!
  * 3D vector perspective projection
@@ -301,13 +179,10 @@ int32_t pie_RotateProject(const Vector3i *v3d, Vector2i *v2d)
 	/*
 	 * v = curMatrix . v3d
 	 */
-	Vector3i v(
-		v3d->x * psMatrix->a + v3d->y * psMatrix->d + v3d->z * psMatrix->g + psMatrix->j,
-		v3d->x * psMatrix->b + v3d->y * psMatrix->e + v3d->z * psMatrix->h + psMatrix->k,
-		v3d->x * psMatrix->c + v3d->y * psMatrix->f + v3d->z * psMatrix->i + psMatrix->l
-	);
+	const Vector3f v = matrixTransform(*psMatrix, Vector3f(*v3d));
 
-	const int zz = v.z >> STRETCHED_Z_SHIFT;
+	// Same scale as the fixed point matrices this used to work with
+	const int zz = v.z * (1 << (FP12_SHIFT - STRETCHED_Z_SHIFT));
 
 	if (zz < MIN_STRETCHED_Z)
 	{
@@ -316,8 +191,8 @@ int32_t pie_RotateProject(const Vector3i *v3d, Vector2i *v2d)
 	}
 	else
 	{
-		v2d->x = rendSurface.xcentre + (v.x / zz);
-		v2d->y = rendSurface.ycentre - (v.y / zz);
+		v2d->x = rendSurface.xcentre + (int)(v.x * FP12_MULTIPLIER) / zz;
+		v2d->y = rendSurface.ycentre - (int)(v.y * FP12_MULTIPLIER) / zz;
 	}
 
 	return zz;
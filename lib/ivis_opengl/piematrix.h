@@ -29,6 +29,7 @@
 #define _pieMatrix_h
 
 #include "lib/ivis_opengl/piedef.h"
+#include "lib/framework/matrix.h"
 
 //*************************************************************************
 
@@ -61,6 +62,8 @@ extern void pie_MatRotX(uint16_t x);
 extern void pie_MatRotY(uint16_t y);
 extern void pie_MatRotZ(uint16_t z);
 extern int32_t pie_RotateProject(const Vector3i *src, Vector2i *dest);
+/// The current transformation matrix, which is also OpenGL's modelview matrix while drawing
+Matrix4f const &pie_GetMatrix(void);
 
 //*************************************************************************
 
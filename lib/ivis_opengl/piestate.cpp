@@ -340,6 +340,11 @@ void pie_SetShaderStretchDepth(float stretch)
 	shaderStretch = stretch;
 }
 
+float pie_GetShaderStretchDepth(void)
+{
+	return shaderStretch;
+}
+
 void pie_ActivateFallback(SHADER_MODE, iIMDShape* shape, PIELIGHT teamcolour, PIELIGHT colour)
 {
 	if (shape->tcmaskpage == iV_TEX_INVALID)
@@ -372,7 +377,7 @@ void pie_ActivateFallback(SHADER_MODE, iIMDShape* shape, PIELIGHT teamcolour, PI
 	// TU1
 	glActiveTexture(GL_TEXTURE1);
 	glEnable(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D, _TEX_PAGE[shape->tcmaskpage].id);
+	glBindTexture(GL_TEXTURE_2D, iV_NativeTexID(shape->tcmaskpage));
 	glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE,	GL_COMBINE);
 
 	// TU1 RGB
@@ -455,12 +460,12 @@ void pie_ActivateShader(SHADER_MODE shaderMode, iIMDShape* shape, PIELIGHT teamc
 	if (maskpage != iV_TEX_INVALID)
 	{
 		glActiveTexture(GL_TEXTURE1);
-		glBindTexture(GL_TEXTURE_2D, _TEX_PAGE[maskpage].id);
+		glBindTexture(GL_TEXTURE_2D, iV_NativeTexID(maskpage));
 	}
 	if (normalpage != iV_TEX_INVALID)
 	{
 		glActiveTexture(GL_TEXTURE2);
-		glBindTexture(GL_TEXTURE_2D, _TEX_PAGE[normalpage].id);
+		glBindTexture(GL_TEXTURE_2D, iV_NativeTexID(normalpage));
 	}
 	glActiveTexture(GL_TEXTURE0);
 
@@ -517,6 +522,13 @@ void pie_UpdateFogDistance(float begin, float end)
 {
 	glFogf(GL_FOG_START, begin);
 	glFogf(GL_FOG_END, end);
+	rendStates.fogEnd = end;
+}
+
+/// Distance from the eye beyond which everything is the fog colour, 0 if not set yet
+float pie_GetFogEnd(void)
+{
+	return rendStates.fogEnd;
 }
 
 //
@@ -588,7 +600,7 @@ void pie_SetTexturePage(SDWORD num)
 					glEnable(GL_TEXTURE_2D);
 				}
 				ASSERT_OR_RETURN(, num < iV_TEX_MAX, "Index out of bounds: %d", num);
-				glBindTexture(GL_TEXTURE_2D, _TEX_PAGE[num].id);
+				glBindTexture(GL_TEXTURE_2D, iV_NativeTexID(num));
 		}
 		rendStates.texPage = num;
 	}
@@ -610,40 +622,80 @@ void pie_SetAlphaTest(bool keyingOn)
 	}
 }
 
-void pie_SetRendMode(REND_MODE rendMode)
+static bool surfaceBlending = false;  ///< Drawing into a surface, see pie_SetSurfaceBlending
+
+/// Sets the blend function of rendMode. In a surface, the destination alpha accumulates how much
+/// the drawing covers, and the colour is left premultiplied by it, so that the surface can be
+/// blended onto the screen later with the same result as drawing there directly.
+static void pie_ApplyRendMode(REND_MODE rendMode)
 {
-	if (rendMode != rendStates.rendMode)
+	switch (rendMode)
 	{
-		rendStates.rendMode = rendMode;
-		switch (rendMode)
-		{
-			case REND_OPAQUE:
-				glDisable(GL_BLEND);
-				break;
+		case REND_OPAQUE:
+			glDisable(GL_BLEND);
+			break;
 
-			case REND_ALPHA:
-				glEnable(GL_BLEND);
+		case REND_ALPHA:
+			glEnable(GL_BLEND);
+			if (surfaceBlending)
+			{
+				glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+			}
+			else
+			{
 				glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-				break;
+			}
+			break;
 
-			case REND_ADDITIVE:
-				glEnable(GL_BLEND);
+		case REND_ADDITIVE:
+			glEnable(GL_BLEND);
+			if (surfaceBlending)
+			{
+				glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE, GL_ZERO, GL_ONE);
+			}
+			else
+			{
 				glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-				break;
+			}
+			break;
 
-			case REND_MULTIPLICATIVE:
-				glEnable(GL_BLEND);
+		case REND_MULTIPLICATIVE:
+			glEnable(GL_BLEND);
+			if (surfaceBlending)
+			{
+				glBlendFuncSeparate(GL_ZERO, GL_SRC_COLOR, GL_ZERO, GL_ONE);
+			}
+			else
+			{
 				glBlendFunc(GL_ZERO, GL_SRC_COLOR);
-				break;
+			}
+			break;
 
-			default:
-				ASSERT(false, "Bad render state");
-				break;
-		}
+		default:
+			ASSERT(false, "Bad render state");
+			break;
+	}
+}
+
+void pie_SetRendMode(REND_MODE rendMode)
+{
+	if (rendMode != rendStates.rendMode)
+	{
+		rendStates.rendMode = rendMode;
+		pie_ApplyRendMode(rendMode);
 	}
 	return;
 }
 
+void pie_SetSurfaceBlending(bool enable)
+{
+	if (enable != surfaceBlending)
+	{
+		surfaceBlending = enable;
+		pie_ApplyRendMode(rendStates.rendMode);
+	}
+}
+
 bool _glerrors(const char *function, const char *file, int line)
 {
 	bool ret = false;
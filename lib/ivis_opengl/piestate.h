@@ -45,6 +45,7 @@ struct RENDER_STATE
 					bool				fogEnabled;
 					bool				fog;
 					PIELIGHT			fogColour;
+					float				fogEnd;
 					SDWORD				texPage;
 					REND_MODE			rendMode;
 					bool				keyingOn;
@@ -77,10 +78,13 @@ extern bool pie_GetFogStatus(void);
 extern void pie_SetFogColour(PIELIGHT colour);
 extern PIELIGHT pie_GetFogColour(void) WZ_DECL_PURE;
 extern void pie_UpdateFogDistance(float begin, float end);
+extern float pie_GetFogEnd(void) WZ_DECL_PURE;
 //render states
 extern void pie_SetTexturePage(SDWORD num);
 extern void pie_SetAlphaTest(bool keyingOn);
 extern void pie_SetRendMode(REND_MODE rendMode);
+/// Blend so that what is drawn can be blended onto the screen later, premultiplied by its alpha. Used by pie_BeginSurface.
+void pie_SetSurfaceBlending(bool enable);
 
 // Shaders control center
 extern bool pie_GetShaderAvailability(void);
@@ -92,6 +96,7 @@ void pie_DeactivateFallback(void);
 void pie_ActivateShader(SHADER_MODE shaderMode, iIMDShape* shape, PIELIGHT teamcolour, PIELIGHT colour);
 void pie_ActivateFallback(SHADER_MODE shaderMode, iIMDShape* shape, PIELIGHT teamcolour, PIELIGHT colour);
 void pie_SetShaderStretchDepth(float stretch);
+float pie_GetShaderStretchDepth(void);
 void pie_SetShaderTime(uint32_t shaderTime);
 void pie_SetShaderEcmEffect(bool value);
 
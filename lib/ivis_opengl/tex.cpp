@@ -20,6 +20,7 @@
 
 
 #include "lib/framework/frame.h"
+#include "lib/framework/file.h"
 #include "lib/framework/opengl.h"
 
 #include "lib/ivis_opengl/ivisdef.h"
@@ -30,33 +31,32 @@
 
 #include "screen.h"
 
+#include <physfs.h>
+
+#include <map>
+#include <set>
+#include <string>
+
+#define TEX_PREFETCH_SESSIONS 8  ///< Sessions a page stays in the prefetch list after it was last used
+
 //*************************************************************************
 
 iTexPage _TEX_PAGE[iV_TEX_MAX];
 unsigned int _TEX_INDEX;
 
+static bool lazyTexPages = false;
+static std::map<std::string, int> prefetchTexPages;  ///< Pages to load up front, with the number of sessions since each was used
+static std::set<std::string> usedTexPages;           ///< Pages used this session
+
 static void pie_PrintLoadedTextures(void);
 
 //*************************************************************************
 
 
-/**************************************************************************
-	Add an image buffer given in s as a new texture page in the texture
-	table.  We check first if the given image has already been loaded,
-	as a sanity check (should never happen).  The texture numbers are
-	stored in a special texture table, not in the resource system, for
-	some unknown reason. Start looking for an available slot in the
-	texture table at the given slot number.
-
-	Returns the texture number of the image.
-**************************************************************************/
-int pie_AddTexPage(iV_Image *s, const char* filename, int slot, int maxTextureSize, bool useMipmaping)
+/// Finds a free slot for a new texture page, starting at slot, and gives it the name filename.
+static int pie_ReserveTexPage(const char *filename, int slot)
 {
 	unsigned int i = 0;
-	int width, height;
-	void *bmp;
-	bool scaleDown = false;
-	GLint minfilter;
 
 	/* Have we already loaded this one? Should not happen here. */
 	while (i < _TEX_INDEX)
@@ -78,17 +78,29 @@ int pie_AddTexPage(iV_Image *s, const char* filename, int slot, int maxTextureSi
 	{
 		_TEX_INDEX++; // increase table
 	}
-	ASSERT(i != iV_TEX_MAX, "pie_AddTexPage: too many texture pages");
+	ASSERT_OR_RETURN(-1, i != iV_TEX_MAX, "pie_AddTexPage: too many texture pages");
 
 	debug(LOG_TEXTURE, "pie_AddTexPage: %s page=%d", filename, _TEX_INDEX);
-	assert(s != NULL);
 
 	/* Stick the name into the tex page structures */
 	sstrcpy(_TEX_PAGE[i].name, filename);
+	_TEX_PAGE[i].lazyFile = NULL;
+	_TEX_PAGE[i].used = false;
+
+	return i;
+}
+
+/// Uploads the image s as the texture of page i. Leaves the texture binding as it was.
+static void pie_UploadTexPage(int i, iV_Image *s, int maxTextureSize, bool useMipmaping)
+{
+	int width, height;
+	void *bmp;
+	bool scaleDown = false;
+	GLint minfilter, boundTexture;
 
+	glGetIntegerv(GL_TEXTURE_BINDING_2D, &boundTexture);
 	glGenTextures(1, &_TEX_PAGE[i].id);
-	// FIXME: This function is used instead of glBindTexture, but we're juggling with difficult to trace global state here. Look into pie_SetTexturePage's definition for details.
-	pie_SetTexturePage(i);
+	glBindTexture(GL_TEXTURE_2D, _TEX_PAGE[i].id);
 
 	width = s->width;
 	height = s->height;
@@ -107,7 +119,7 @@ int pie_AddTexPage(iV_Image *s, const char* filename, int slot, int maxTextureSi
 		}
 		if (scaleDown)
 		{
-			debug(LOG_TEXTURE, "scaling down texture %s from %ix%i to %ix%i", filename, s->width, s->height, width, height);
+			debug(LOG_TEXTURE, "scaling down texture %s from %ix%i to %ix%i", _TEX_PAGE[i].name, s->width, s->height, width, height);
 			bmp = malloc(4 * width * height); // FIXME: don't know for sure it is 4 bytes per pixel
 			gluScaleImage(iV_getPixelFormat(s), s->width, s->height, GL_UNSIGNED_BYTE, s->bmp,
 			                                    width,    height,    GL_UNSIGNED_BYTE, bmp);
@@ -127,7 +139,7 @@ int pie_AddTexPage(iV_Image *s, const char* filename, int slot, int maxTextureSi
 	}
 	else
 	{
-		debug(LOG_ERROR, "pie_AddTexPage: non POT texture %s", filename);
+		debug(LOG_ERROR, "pie_AddTexPage: non POT texture %s", _TEX_PAGE[i].name);
 	}
 	
 	// it is uploaded, we do not need it anymore
@@ -160,6 +172,32 @@ int pie_AddTexPage(iV_Image *s, const char* filename, int slot, int maxTextureSi
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
 	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
 
+	glBindTexture(GL_TEXTURE_2D, boundTexture);
+}
+
+/**************************************************************************
+	Add an image buffer given in s as a new texture page in the texture
+	table.  We check first if the given image has already been loaded,
+	as a sanity check (should never happen).  The texture numbers are
+	stored in a special texture table, not in the resource system, for
+	some unknown reason. Start looking for an available slot in the
+	texture table at the given slot number.
+
+	Returns the texture number of the image.
+**************************************************************************/
+int pie_AddTexPage(iV_Image *s, const char* filename, int slot, int maxTextureSize, bool useMipmaping)
+{
+	int i = pie_ReserveTexPage(filename, slot);
+
+	assert(s != NULL);
+	if (i < 0)
+	{
+		iV_unloadImage(s);
+		return -1;
+	}
+
+	pie_UploadTexPage(i, s, maxTextureSize, useMipmaping);
+
 	/* Send back the texpage number so we can store it in the IMD */
 
 	_TEX_INDEX++;
@@ -167,6 +205,157 @@ int pie_AddTexPage(iV_Image *s, const char* filename, int slot, int maxTextureSi
 	return i;
 }
 
+/**************************************************************************
+	Add the image in fileName as the texture page texPage, without
+	loading it. It is decoded and uploaded when the page is first bound,
+	so pages that are never drawn take no memory. Replaces any page that
+	already has the name, like pie_ReplaceTexPage.
+
+	Returns the texture number of the page.
+**************************************************************************/
+int pie_AddLazyTexPage(const char *fileName, const char *texPage, int maxTextureSize, bool useMipmaping)
+{
+	int i;
+
+	for (i = 0; i < iV_TEX_MAX; i++)
+	{
+		if (strncmp(texPage, _TEX_PAGE[i].name, iV_TEXNAME_MAX) == 0)
+		{
+			break;
+		}
+	}
+	if (i < iV_TEX_MAX)
+	{
+		debug(LOG_TEXTURE, "Replacing texture %s at index %d with %s, to load on first use", texPage, i, fileName);
+		glDeleteTextures(1, &_TEX_PAGE[i].id);
+		_TEX_PAGE[i].id = 0;
+		free(_TEX_PAGE[i].lazyFile);
+	}
+	else
+	{
+		i = pie_ReserveTexPage(texPage, 0);
+		if (i < 0)
+		{
+			return -1;
+		}
+	}
+
+	_TEX_PAGE[i].lazyFile = strdup(fileName);
+	_TEX_PAGE[i].maxTextureSize = maxTextureSize;
+	_TEX_PAGE[i].useMipmaping = useMipmaping;
+	_TEX_PAGE[i].used = false;
+
+	return i;
+}
+
+/// Marks the page as used, and uploads it if it was added by pie_AddLazyTexPage. Call through iV_NativeTexID.
+void pie_UseTexPage(int pageNum)
+{
+	iTexPage *page = &_TEX_PAGE[pageNum];
+	char *fileName = page->lazyFile;
+	iV_Image image;
+
+	page->used = true;
+	if (fileName == NULL)
+	{
+		return;
+	}
+	page->lazyFile = NULL;
+
+	debug(LOG_TEXTURE, "Loading texture %s from %s on first use", page->name, fileName);
+	if (!iV_loadImage_PNG(fileName, &image))
+	{
+		debug(LOG_ERROR, "Failed to load %s", fileName);  // The page stays blank.
+		free(fileName);
+		return;
+	}
+	free(fileName);
+
+	pie_UploadTexPage(pageNum, &image, page->maxTextureSize, page->useMipmaping);
+}
+
+/// Sets whether texture pages that are not in the prefetch list are only loaded on first use.
+void pie_SetLazyTexPages(bool lazy)
+{
+	lazyTexPages = lazy;
+}
+
+bool pie_GetLazyTexPages(void)
+{
+	return lazyTexPages;
+}
+
+/// Whether the page should be added with pie_AddLazyTexPage. Safe to call from loader threads.
+bool pie_TexPageIsLazy(const char *texPage)
+{
+	return lazyTexPages && prefetchTexPages.count(texPage) == 0;
+}
+
+/// Reads the pages used in recent sessions, which are loaded up front even when pages are lazy.
+void pie_LoadTexPrefetchList(const char *fileName)
+{
+	char *pFileData, *line, *next;
+	UDWORD fileSize;
+
+	prefetchTexPages.clear();
+	if (!PHYSFS_exists(fileName) || !loadFile(fileName, &pFileData, &fileSize))
+	{
+		return;
+	}
+	for (line = pFileData; line != NULL && *line != '\0'; line = next)
+	{
+		char name[iV_TEXNAME_MAX];
+		int sessions;
+
+		next = strchr(line, '\n');
+		if (next != NULL)
+		{
+			*next++ = '\0';
+		}
+		if (sscanf(line, "%63s %d", name, &sessions) == 2)
+		{
+			prefetchTexPages[name] = sessions;
+		}
+	}
+	free(pFileData);
+	debug(LOG_TEXTURE, "%u texture pages to prefetch", (unsigned)prefetchTexPages.size());
+}
+
+/// Writes the prefetch list, adding the pages used this session and dropping ones unused for TEX_PREFETCH_SESSIONS sessions.
+void pie_SaveTexPrefetchList(const char *fileName)
+{
+	std::map<std::string, int> pages;
+	std::string data;
+	char line[iV_TEXNAME_MAX + 16];
+
+	if (!lazyTexPages)
+	{
+		return;
+	}
+	for (std::map<std::string, int>::const_iterator i = prefetchTexPages.begin(); i != prefetchTexPages.end(); ++i)
+	{
+		if (i->second + 1 < TEX_PREFETCH_SESSIONS)
+		{
+			pages[i->first] = i->second + 1;
+		}
+	}
+	for (std::set<std::string>::const_iterator i = usedTexPages.begin(); i != usedTexPages.end(); ++i)
+	{
+		pages[*i] = 0;
+	}
+	for (std::map<std::string, int>::const_iterator i = pages.begin(); i != pages.end(); ++i)
+	{
+		ssprintf(line, "%s %d\n", i->first.c_str(), i->second);
+		data += line;
+	}
+
+	PHYSFS_mkdir("cache");
+	if (!saveFile(fileName, data.c_str(), data.size()))
+	{
+		debug(LOG_ERROR, "Could not write the texture prefetch list %s", fileName);
+	}
+}
+
 
 void pie_InitSkybox(SDWORD pageNum)
 {
@@ -238,7 +427,7 @@ int iV_GetTexture(const char *filename)
 {
 	unsigned int i = 0;
 	iV_Image sSprite;
-	char path[PATH_MAX];
+	char path[PATH_MAX], name[iV_TEXNAME_MAX];
 
 	/* Have we already loaded this one then? */
 	sstrcpy(path, filename);
@@ -254,14 +443,23 @@ int iV_GetTexture(const char *filename)
 	// Try to load it
 	sstrcpy(path, "texpages/");
 	sstrcat(path, filename);
+	sstrcpy(name, filename);
+	pie_MakeTexPageName(name);
+	if (pie_TexPageIsLazy(name))
+	{
+		if (!PHYSFS_exists(path))
+		{
+			debug(LOG_ERROR, "Failed to find %s", path);
+			return -1;
+		}
+		return pie_AddLazyTexPage(path, name, -1, true);	// FIXME, -1, use getTextureSize()
+	}
 	if (!iV_loadImage_PNG(path, &sSprite))
 	{
 		debug(LOG_ERROR, "Failed to load %s", path);
 		return -1;
 	}
-	sstrcpy(path, filename);
-	pie_MakeTexPageName(path);
-	return pie_AddTexPage(&sSprite, path, 0, -1, true);	// FIXME, -1, use getTextureSize()
+	return pie_AddTexPage(&sSprite, name, 0, -1, true);	// FIXME, -1, use getTextureSize()
 }
 
 
@@ -285,6 +483,8 @@ int pie_ReplaceTexPage(iV_Image *s, const char *texPage, int maxTextureSize, boo
 	glDeleteTextures(1, &_TEX_PAGE[i].id);
 	debug(LOG_TEXTURE, "Reloading texture %s from index %d", texPage, i);
 	_TEX_PAGE[i].name[0] = '\0';
+	free(_TEX_PAGE[i].lazyFile);
+	_TEX_PAGE[i].lazyFile = NULL;
 	pie_AddTexPage(s, texPage, i, maxTextureSize, useMipmaping);
 
 	return i;
@@ -307,6 +507,18 @@ void pie_TexShutDown(void)
 	}
 
 	debug(LOG_TEXTURE, "pie_TexShutDown successful - did free %u texture pages", i);
+
+	// Remember the pages that were drawn, for the prefetch list
+	for (i = 0; i < iV_TEX_MAX; i++)
+	{
+		if (_TEX_PAGE[i].used && _TEX_PAGE[i].name[0] != '\0')
+		{
+			usedTexPages.insert(_TEX_PAGE[i].name);
+		}
+		free(_TEX_PAGE[i].lazyFile);
+		_TEX_PAGE[i].lazyFile = NULL;
+		_TEX_PAGE[i].used = false;
+	}
 }
 
 void pie_TexInit(void)
@@ -315,6 +527,8 @@ void pie_TexInit(void)
 
 	while (i < iV_TEX_MAX) {
 		_TEX_PAGE[i].name[0] = '\0';
+		_TEX_PAGE[i].lazyFile = NULL;
+		_TEX_PAGE[i].used = false;
 		i++;
 	}
 	debug(LOG_TEXTURE, "pie_TexInit successful - initialized %d texture pages\n", i);
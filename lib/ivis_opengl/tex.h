@@ -36,6 +36,10 @@ struct iTexPage
 {
 	char name[iV_TEXNAME_MAX];
 	GLuint id;
+	char *lazyFile;      ///< Image to decode and upload when the page is first used, NULL if uploaded
+	int maxTextureSize;  ///< For uploading lazyFile
+	bool useMipmaping;   ///< For uploading lazyFile
+	bool used;           ///< Has been bound since it was added
 };
 
 //*************************************************************************
@@ -45,13 +49,20 @@ extern iTexPage _TEX_PAGE[iV_TEX_MAX];
 
 //*************************************************************************
 
+extern void pie_UseTexPage(int pageNum);
+
 static inline char * iV_TexName(SDWORD pageNum)
 {
 	return _TEX_PAGE[pageNum].name;
 }
 
+/// The OpenGL texture of a page, uploading it first if it was added lazily.
 static inline GLuint iV_NativeTexID(SDWORD pageNum)
 {
+	if (!_TEX_PAGE[pageNum].used)
+	{
+		pie_UseTexPage(pageNum);
+	}
 	return _TEX_PAGE[pageNum].id;
 }
 
@@ -63,6 +74,12 @@ extern unsigned int iV_getPixelFormat(const iV_Image *image);
 
 extern int pie_ReplaceTexPage(iV_Image *s, const char *texPage, int maxTextureSize, bool useMipmaping);
 extern int pie_AddTexPage(iV_Image *s, const char *filename, int slot, int maxTextureSize, bool useMipmaping);
+extern int pie_AddLazyTexPage(const char *fileName, const char *texPage, int maxTextureSize, bool useMipmaping);
+extern void pie_SetLazyTexPages(bool lazy);
+extern bool pie_GetLazyTexPages(void);
+extern bool pie_TexPageIsLazy(const char *texPage);
+extern void pie_LoadTexPrefetchList(const char *fileName);
+extern void pie_SaveTexPrefetchList(const char *fileName);
 extern void pie_TexInit(void);
 
 extern void pie_InitSkybox(SDWORD pageNum);
@@ -32,6 +32,10 @@
 #include "lib/ivis_opengl/bitimage.h"
 #include "src/multiplay.h"
 
+#include <map>
+#include <string>
+#include <vector>
+
 #define ASCII_SPACE			(32)
 #define ASCII_NEWLINE			('@')
 #define ASCII_COLOURMODE		('#')
@@ -55,6 +59,63 @@ static float font_colour[4] = {1.f, 1.f, 1.f, 1.f};
 static GLint _glcContext = 0;
 static GLint _glcFont_Regular = 0;
 static GLint _glcFont_Bold = 0;
+static GLint _glcFont_Current = 0;   ///< Font selected by iV_SetFont
+
+/* GLC measures a string by laying out each of its glyphs again, and iV_DrawFormattedText measures
+ * every prefix of every word it wraps, every frame. The same strings are measured and wrapped frame
+ * after frame, so the results are kept, per font and size, until the fonts go away.
+ */
+#define TEXT_CACHE_MAX 4096   ///< Entries a cache may hold; it is emptied when full, the next frame fills it again
+
+/// What a measurement depends on apart from the text itself
+struct TEXT_STYLE
+{
+	GLint font;
+	float size;
+
+	bool operator <(TEXT_STYLE const &b) const { return font != b.font ? font < b.font : size < b.size; }
+};
+
+struct TEXT_KEY
+{
+	TEXT_STYLE  style;
+	std::string text;
+
+	bool operator <(TEXT_KEY const &b) const { return style < b.style || (!(b.style < style) && text < b.text); }
+};
+
+/// Measurements of the tallest glyph of a font, used for line spacing
+struct FONT_METRICS
+{
+	int lineSize, aboveBase, belowBase;
+};
+
+/// A line of iV_DrawFormattedText, as wrapped
+struct TEXT_LINE
+{
+	std::string text;
+	UDWORD      xOffset;    ///< From the left of the formatted text, as justified
+};
+
+struct TEXT_LAYOUT_KEY
+{
+	TEXT_KEY key;
+	UDWORD   width, justify;
+	bool     multiPlayer;   ///< Newlines are ignored in multiplayer
+
+	bool operator <(TEXT_LAYOUT_KEY const &b) const
+	{
+		if (width != b.width) return width < b.width;
+		if (justify != b.justify) return justify < b.justify;
+		if (multiPlayer != b.multiPlayer) return multiPlayer < b.multiPlayer;
+		return key < b.key;
+	}
+};
+
+static std::map<TEXT_KEY, unsigned> textWidthCache;
+static std::map<std::pair<TEXT_STYLE, uint32_t>, unsigned> charWidthCache;
+static std::map<TEXT_STYLE, FONT_METRICS> fontMetricsCache;
+static std::map<TEXT_LAYOUT_KEY, std::vector<TEXT_LINE> > textLayoutCache;
 
 /***************************************************************************/
 /*
@@ -209,8 +270,24 @@ void iV_TextInit()
 #endif
 }
 
+static inline TEXT_STYLE currentTextStyle(void)
+{
+	TEXT_STYLE style = {_glcFont_Current, font_size};
+	return style;
+}
+
+static void iV_ClearTextCaches(void)
+{
+	textWidthCache.clear();
+	charWidthCache.clear();
+	fontMetricsCache.clear();
+	textLayoutCache.clear();
+}
+
 void iV_TextShutdown()
 {
+	iV_ClearTextCaches();
+
 	if (_glcFont_Regular)
 	{
 		glcDeleteFont(_glcFont_Regular);
@@ -227,6 +304,7 @@ void iV_TextShutdown()
 	{
 		glcDeleteContext(_glcContext);
 	}
+	_glcFont_Current = 0;
 }
 
 void iV_SetFont(enum iV_fonts FontID)
@@ -235,22 +313,26 @@ void iV_SetFont(enum iV_fonts FontID)
 	{
 		case font_scaled:
 			iV_SetTextSize(12.f * pie_GetVideoBufferHeight() / 480);
+			_glcFont_Current = _glcFont_Regular;
 			glcFont(_glcFont_Regular);
 			break;
 
 		default:
 		case font_regular:
 			iV_SetTextSize(12.f);
+			_glcFont_Current = _glcFont_Regular;
 			glcFont(_glcFont_Regular);
 			break;
 
 		case font_large:
 			iV_SetTextSize(21.f);
+			_glcFont_Current = _glcFont_Bold;
 			glcFont(_glcFont_Bold);
 			break;
 
 		case font_small:
 			iV_SetTextSize(9.f);
+			_glcFont_Current = _glcFont_Regular;
 			glcFont(_glcFont_Regular);
 			break;
 	}
@@ -306,7 +388,7 @@ static inline float getGLCPointToPixel(float point_width)
 	return pixel_width;
 }
 
-unsigned int iV_GetTextWidth(const char* string)
+static unsigned int measureTextWidth(const char* string)
 {
 	float boundingbox[8];
 	float pixel_width, point_width;
@@ -323,6 +405,30 @@ unsigned int iV_GetTextWidth(const char* string)
 	return (unsigned int)pixel_width;
 }
 
+/// Looks up the width of text in the current font and size, measuring it if it's not known yet
+static unsigned int cachedTextWidth(std::string const &text)
+{
+	TEXT_KEY key = {currentTextStyle(), text};
+	std::map<TEXT_KEY, unsigned>::const_iterator i = textWidthCache.find(key);
+	if (i != textWidthCache.end())
+	{
+		return i->second;
+	}
+
+	unsigned width = measureTextWidth(text.c_str());
+	if (textWidthCache.size() >= TEXT_CACHE_MAX)
+	{
+		textWidthCache.clear();
+	}
+	textWidthCache.insert(std::make_pair(key, width));
+	return width;
+}
+
+unsigned int iV_GetTextWidth(const char* string)
+{
+	return cachedTextWidth(string);
+}
+
 unsigned int iV_GetCountedTextWidth(const char* string, size_t string_length)
 {
 	float boundingbox[8];
@@ -357,7 +463,7 @@ unsigned int iV_GetTextHeight(const char* string)
 	return (unsigned int)pixel_height;
 }
 
-unsigned int iV_GetCharWidth(uint32_t charCode)
+static unsigned int measureCharWidth(uint32_t charCode)
 {
 	float boundingbox[8];
 	float pixel_width, point_width;
@@ -373,7 +479,25 @@ unsigned int iV_GetCharWidth(uint32_t charCode)
 	return (unsigned int)pixel_width;
 }
 
-int iV_GetTextLineSize()
+unsigned int iV_GetCharWidth(uint32_t charCode)
+{
+	std::pair<TEXT_STYLE, uint32_t> key(currentTextStyle(), charCode);
+	std::map<std::pair<TEXT_STYLE, uint32_t>, unsigned>::const_iterator i = charWidthCache.find(key);
+	if (i != charWidthCache.end())
+	{
+		return i->second;
+	}
+
+	unsigned width = measureCharWidth(charCode);
+	if (charWidthCache.size() >= TEXT_CACHE_MAX)
+	{
+		charWidthCache.clear();
+	}
+	charWidthCache.insert(std::make_pair(key, width));
+	return width;
+}
+
+static int measureTextLineSize(void)
 {
 	float boundingbox[8];
 	float pixel_height, point_height;
@@ -402,7 +526,7 @@ static float iV_GetMaxCharBaseY(void)
 	return base_line[1];
 }
 
-int iV_GetTextAboveBase(void)
+static int measureTextAboveBase(void)
 {
 	float point_base_y = iV_GetMaxCharBaseY();
 	float point_top_y;
@@ -421,7 +545,7 @@ int iV_GetTextAboveBase(void)
 	return (int)pixel_height;
 }
 
-int iV_GetTextBelowBase(void)
+static int measureTextBelowBase(void)
 {
 	float point_base_y = iV_GetMaxCharBaseY();
 	float point_bottom_y;
@@ -440,6 +564,35 @@ int iV_GetTextBelowBase(void)
 	return (int)pixel_height;
 }
 
+/// The metrics of the tallest glyph of the current font and size, measured once per font and size
+static FONT_METRICS const &currentFontMetrics(void)
+{
+	TEXT_STYLE style = currentTextStyle();
+	std::map<TEXT_STYLE, FONT_METRICS>::const_iterator i = fontMetricsCache.find(style);
+	if (i != fontMetricsCache.end())
+	{
+		return i->second;
+	}
+
+	FONT_METRICS metrics = {measureTextLineSize(), measureTextAboveBase(), measureTextBelowBase()};
+	return fontMetricsCache.insert(std::make_pair(style, metrics)).first->second;
+}
+
+int iV_GetTextLineSize()
+{
+	return currentFontMetrics().lineSize;
+}
+
+int iV_GetTextAboveBase(void)
+{
+	return currentFontMetrics().aboveBase;
+}
+
+int iV_GetTextBelowBase(void)
+{
+	return currentFontMetrics().belowBase;
+}
+
 void iV_SetTextColour(PIELIGHT colour)
 {
 	font_colour[0] = colour.byte.r / 255.0f;
@@ -448,25 +601,61 @@ void iV_SetTextColour(PIELIGHT colour)
 	font_colour[3] = colour.byte.a / 255.0f;
 }
 
-/** Draws formatted text with word wrap, long word splitting, embedded newlines
- *  (uses '@' rather than '\n') and colour toggle mode ('#') which enables or
- *  disables font colouring.
- *
- *  @param String   the string to display.
- *  @param x,y      X and Y coordinates of top left of formatted text.
- *  @param width    the maximum width of the formatted text (beyond which line
- *                  wrapping is used).
- *  @param justify  The alignment style to use, which is one of the following:
- *                  FTEXT_LEFTJUSTIFY, FTEXT_CENTRE or FTEXT_RIGHTJUSTIFY.
- *  @return the Y coordinate for the next text line.
- */
-int iV_DrawFormattedText(const char* String, UDWORD x, UDWORD y, UDWORD Width, UDWORD Justify)
+static GLint textDrawMatrixMode = 0;   ///< Matrix mode to restore in iV_EndTextDraw
+
+/// Sets up the state GLC draws text with, for any number of iV_RenderText calls.
+static void iV_BeginTextDraw(void)
+{
+	pie_SetTexturePage(TEXPAGE_EXTERN);
+
+	glGetIntegerv(GL_MATRIX_MODE, &textDrawMatrixMode);
+	glMatrixMode(GL_TEXTURE);
+	glPushMatrix();
+	glLoadIdentity();
+	glMatrixMode(GL_MODELVIEW);
+
+	glColor4fv(font_colour);
+	glFrontFace(GL_CW);
+}
+
+static void iV_RenderText(const char* string, float XPos, float YPos, float rotation)
+{
+	glPushMatrix();
+
+	if (rotation != 0.f)
+	{
+		rotation = 360.f - rotation;
+	}
+
+	glTranslatef(XPos, YPos, 0.f);
+	glRotatef(180.f, 1.f, 0.f, 0.f);
+	glRotatef(rotation, 0.f, 0.f, 1.f);
+	glScalef(font_size, font_size, 0.f);
+
+	glcRenderString(string);
+
+	glPopMatrix();
+}
+
+static void iV_EndTextDraw(void)
+{
+	glFrontFace(GL_CCW);
+
+	glMatrixMode(GL_TEXTURE);
+	glPopMatrix();
+	glMatrixMode(textDrawMatrixMode);
+
+	// Reset the current model view matrix
+	glLoadIdentity();
+}
+
+/// Splits String into the lines iV_DrawFormattedText draws, in the current font and size.
+static void iV_FormatText(const char* String, UDWORD Width, UDWORD Justify, std::vector<TEXT_LINE> &lines)
 {
 	std::string FString;
 	std::string FWord;
 	int i;
-	int jx = x;		// Default to left justify.
-	int jy = y;
+	UDWORD jx = 0;		// Default to left justify.
 	UDWORD WWidth;
 	int TWidth;
 	const char* curChar = String;
@@ -573,64 +762,73 @@ int iV_DrawFormattedText(const char* String, UDWORD x, UDWORD y, UDWORD Width, U
 		switch (Justify)
 		{
 			case FTEXT_CENTRE:
-				jx = x + (Width - TWidth) / 2;
+				jx = (Width - TWidth) / 2;
 				break;
 
 			case FTEXT_RIGHTJUSTIFY:
-				jx = x + Width - TWidth;
+				jx = Width - TWidth;
 				break;
 
 			case FTEXT_LEFTJUSTIFY:
-				jx = x;
+				jx = 0;
 				break;
 		}
 
-		// draw the text.
-		iV_DrawText(FString.c_str(), jx, jy);
-
-		// and move down a line.
-		jy += iV_GetTextLineSize();
+		TEXT_LINE line = {FString, jx};
+		lines.push_back(line);
 	}
-
-	return jy;
 }
 
-void iV_DrawTextRotated(const char* string, float XPos, float YPos, float rotation)
+/** Draws formatted text with word wrap, long word splitting, embedded newlines
+ *  (uses '@' rather than '\n') and colour toggle mode ('#') which enables or
+ *  disables font colouring.
+ *
+ *  @param String   the string to display.
+ *  @param x,y      X and Y coordinates of top left of formatted text.
+ *  @param width    the maximum width of the formatted text (beyond which line
+ *                  wrapping is used).
+ *  @param justify  The alignment style to use, which is one of the following:
+ *                  FTEXT_LEFTJUSTIFY, FTEXT_CENTRE or FTEXT_RIGHTJUSTIFY.
+ *  @return the Y coordinate for the next text line.
+ */
+int iV_DrawFormattedText(const char* String, UDWORD x, UDWORD y, UDWORD Width, UDWORD Justify)
 {
-	GLint matrix_mode = 0;
-	ASSERT_OR_RETURN( , string, "Couldn't render string!");
-	pie_SetTexturePage(TEXPAGE_EXTERN);
-
-	glGetIntegerv(GL_MATRIX_MODE, &matrix_mode);
-	glMatrixMode(GL_TEXTURE);
-	glPushMatrix();
-	glLoadIdentity();
-	glMatrixMode(GL_MODELVIEW);
-	glPushMatrix();
-
-	if (rotation != 0.f)
+	TEXT_LAYOUT_KEY key = {{currentTextStyle(), String}, Width, Justify, bMultiPlayer};
+	std::map<TEXT_LAYOUT_KEY, std::vector<TEXT_LINE> >::iterator layout = textLayoutCache.find(key);
+	if (layout == textLayoutCache.end())
 	{
-		rotation = 360.f - rotation;
+		if (textLayoutCache.size() >= TEXT_CACHE_MAX)
+		{
+			textLayoutCache.clear();
+		}
+		layout = textLayoutCache.insert(std::make_pair(key, std::vector<TEXT_LINE>())).first;
+		iV_FormatText(String, Width, Justify, layout->second);
 	}
 
-	glTranslatef(XPos, YPos, 0.f);
-	glRotatef(180.f, 1.f, 0.f, 0.f);
-	glRotatef(rotation, 0.f, 0.f, 1.f);
-	glScalef(font_size, font_size, 0.f);
+	const int lineSize = iV_GetTextLineSize();
+	int jy = y;
 
-	glColor4fv(font_colour);
+	iV_BeginTextDraw();
+	for (std::vector<TEXT_LINE>::const_iterator line = layout->second.begin(); line != layout->second.end(); ++line)
+	{
+		int jx = x + line->xOffset;
+		iV_RenderText(line->text.c_str(), jx, jy, 0.f);
 
-	glFrontFace(GL_CW);
-	glcRenderString(string);
-	glFrontFace(GL_CCW);
+		// and move down a line.
+		jy += lineSize;
+	}
+	iV_EndTextDraw();
 
-	glPopMatrix();
-	glMatrixMode(GL_TEXTURE);
-	glPopMatrix();
-	glMatrixMode(matrix_mode);
+	return jy;
+}
 
-	// Reset the current model view matrix
-	glLoadIdentity();
+void iV_DrawTextRotated(const char* string, float XPos, float YPos, float rotation)
+{
+	ASSERT_OR_RETURN( , string, "Couldn't render string!");
+
+	iV_BeginTextDraw();
+	iV_RenderText(string, XPos, YPos, rotation);
+	iV_EndTextDraw();
 }
 
 static void iV_DrawTextRotatedFv(float x, float y, float rotation, const char* format, va_list ap)
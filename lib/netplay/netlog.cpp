@@ -27,15 +27,35 @@
 #include "netlog.h"
 #include "netplay.h"
 
+#include <limits.h>
+
 // ////////////////////////////////////////////////////////////////////////
 // Logging for debug only
 // ////////////////////////////////////////////////////////////////////////
 
 #define NUM_GAME_PACKETS 256
+#define NUM_STATS_PLAYERS (MAX_CONNECTED_PLAYERS + 1)  ///< Last entry is for broadcasts and not yet joined players.
+
+static const unsigned pingHistogramLimits[NUM_PING_BUCKETS] = {25, 50, 100, 200, 400, 800, 1600, UINT_MAX};
 
 static PHYSFS_file	*pFileHandle = NULL;
-static uint32_t		packetcount[2][NUM_GAME_PACKETS];
-static uint32_t		packetsize[2][NUM_GAME_PACKETS];
+static NETTYPESTATS	typeStats[2][NUM_STATS_PLAYERS][NUM_GAME_PACKETS];
+static NETTYPESTATS	typeTotals[2][NUM_GAME_PACKETS];	///< typeStats summed over all players
+static NETTYPESTATS	playerTotals[2][NUM_STATS_PLAYERS];	///< typeStats summed over all message types
+static uint32_t		pingHistogram[MAX_CONNECTED_PLAYERS][NUM_PING_BUCKETS];
+
+static void NETresetStats(void)
+{
+	memset(typeStats, 0, sizeof(typeStats));
+	memset(typeTotals, 0, sizeof(typeTotals));
+	memset(playerTotals, 0, sizeof(playerTotals));
+	memset(pingHistogram, 0, sizeof(pingHistogram));
+}
+
+static void makeLogTimeSuffix(char *buf, size_t bufSize, struct tm const *newtime)
+{
+	snprintf(buf, bufSize, "%04d%02d%02d_%02d%02d%02d", newtime->tm_year + 1900, newtime->tm_mon + 1, newtime->tm_mday, newtime->tm_hour, newtime->tm_min, newtime->tm_sec);
+}
 
 bool NETstartLogging(void)
 {
@@ -43,20 +63,15 @@ bool NETstartLogging(void)
 	struct tm *newtime;
 	char buf[256];
 	static char filename[256] = {'\0'};
-	int i;
+	char timeSuffix[32];
 
-	for (i = 0; i < NUM_GAME_PACKETS; i++)
-	{
-		packetcount[0][i] = 0;
-		packetsize[0][i] = 0;
-		packetcount[1][i] = 0;
-		packetsize[1][i] = 0;
-	}
+	NETresetStats();
 
 	time( &aclock );                 /* Get time in seconds */
 	newtime = localtime( &aclock );  /* Convert time to struct */
 
-	snprintf(filename, sizeof(filename), "logs/netplay-%04d%02d%02d_%02d%02d%02d.log", newtime->tm_year + 1900, newtime->tm_mon + 1, newtime->tm_mday, newtime->tm_hour, newtime->tm_min, newtime->tm_sec);
+	makeLogTimeSuffix(timeSuffix, sizeof(timeSuffix), newtime);
+	snprintf(filename, sizeof(filename), "logs/netplay-%s.log", timeSuffix);
 	pFileHandle = PHYSFS_openWrite( filename ); // open the file
 	if (!pFileHandle)
 	{
@@ -81,16 +96,19 @@ bool NETstopLogging(void)
 		return false;
 	}
 
+	NETdumpStats();
+
 	/* Output stats */
 	for (i = 0; i < NUM_GAME_PACKETS; i++)
 	{
+		NETTYPESTATS sent = NETgetTypeStats(NET_ALL_PLAYERS, false, i), recv = NETgetTypeStats(NET_ALL_PLAYERS, true, i);
 		snprintf(buf, sizeof(buf), "%-24s:\t received %u times, %u bytes; sent %u times, %u bytes\n", messageTypeToString(i),
-			packetcount[1][i], packetsize[1][i], packetcount[0][i], packetsize[0][i]);
+			recv.count, recv.bytes, sent.count, sent.bytes);
 		PHYSFS_write(pFileHandle, buf, strlen(buf), 1);
-		totalBytessent += packetsize[0][i];
-		totalBytesrecv += packetsize[1][i];
-		totalPacketsent += packetcount[0][i];
-		totalPacketrecv += packetcount[1][i];
+		totalBytessent += sent.bytes;
+		totalBytesrecv += recv.bytes;
+		totalPacketsent += sent.count;
+		totalPacketrecv += recv.count;
 	}
 	snprintf(buf, sizeof(buf), "== Total bytes sent %u, Total bytes received %u ==\n", totalBytessent, totalBytesrecv);
 	PHYSFS_write(pFileHandle, buf, strlen(buf), 1);
@@ -144,12 +162,132 @@ bool NETstopLogging(void)
  *  \param type, uint8_t, the packet's type.
  *  \param size, uint32_t, the packet's size
  *  \param received, bool, true if we are receiving a packet, false if we are sending a packet.
+ *  \param player, unsigned, the player the packet is sent to or received from, or anything else for broadcasts and not yet joined players.
+ *  \param usecs, uint32_t, microseconds spent serialising or deserialising the packet.
 */
-void NETlogPacket(uint8_t type, uint32_t size, bool received)
+void NETlogPacket(uint8_t type, uint32_t size, bool received, unsigned player, uint32_t usecs)
 {
 	STATIC_ASSERT((1<<(8*sizeof(type))) == NUM_GAME_PACKETS);  // NUM_GAME_PACKETS must be larger than maximum possible type.
-	packetcount[received][type]++;
-	packetsize[received][type] += size;
+	unsigned statsPlayer = std::min<unsigned>(player, NUM_STATS_PLAYERS - 1);
+	NETTYPESTATS *stats[3] = {&typeStats[received][statsPlayer][type], &typeTotals[received][type], &playerTotals[received][statsPlayer]};
+	for (unsigned i = 0; i < ARRAY_SIZE(stats); ++i)
+	{
+		stats[i]->count++;
+		stats[i]->bytes += size;
+		stats[i]->usecs += usecs;
+	}
+}
+
+void NETlogPing(unsigned player, unsigned pingTime)
+{
+	ASSERT_OR_RETURN(, player < MAX_CONNECTED_PLAYERS, "Bad player %u", player);
+
+	unsigned bucket = 0;
+	while (pingTime >= pingHistogramLimits[bucket])
+	{
+		++bucket;
+	}
+	pingHistogram[player][bucket]++;
+}
+
+NETTYPESTATS NETgetTypeStats(unsigned player, bool received, uint8_t type)
+{
+	if (player == NET_ALL_PLAYERS)
+	{
+		return typeTotals[received][type];
+	}
+	return typeStats[received][std::min<unsigned>(player, NUM_STATS_PLAYERS - 1)][type];
+}
+
+NETTYPESTATS NETgetPlayerStats(unsigned player, bool received)
+{
+	return playerTotals[received][std::min<unsigned>(player, NUM_STATS_PLAYERS - 1)];
+}
+
+uint32_t NETgetPingHistogram(unsigned player, unsigned bucket)
+{
+	ASSERT_OR_RETURN(0, player < MAX_CONNECTED_PLAYERS && bucket < NUM_PING_BUCKETS, "Bad player %u or bucket %u", player, bucket);
+	return pingHistogram[player][bucket];
+}
+
+unsigned NETgetPingHistogramLimit(unsigned bucket)
+{
+	ASSERT_OR_RETURN(0, bucket < NUM_PING_BUCKETS, "Bad bucket %u", bucket);
+	return pingHistogramLimits[bucket];
+}
+
+/// Writes the per-player and per-message type statistics to logs/netstats-*.csv, for loading into a spreadsheet.
+bool NETdumpStats(void)
+{
+	time_t aclock;
+	char filename[256];
+	char timeSuffix[32];
+	char buf[256];
+
+	time(&aclock);
+	makeLogTimeSuffix(timeSuffix, sizeof(timeSuffix), localtime(&aclock));
+	snprintf(filename, sizeof(filename), "logs/netstats-%s.csv", timeSuffix);
+	PHYSFS_file *fileHandle = PHYSFS_openWrite(filename);
+	if (!fileHandle)
+	{
+		debug(LOG_ERROR, "Could not create net statistics %s: %s", filename, PHYSFS_getLastError());
+		return false;
+	}
+
+	snprintf(buf, sizeof(buf), "player,direction,message,count,bytes,usecs\n");
+	PHYSFS_write(fileHandle, buf, strlen(buf), 1);
+	for (unsigned player = 0; player < NUM_STATS_PLAYERS; ++player)
+	{
+		for (unsigned received = 0; received < 2; ++received)
+		{
+			for (unsigned type = 0; type < NUM_GAME_PACKETS; ++type)
+			{
+				NETTYPESTATS const &stats = typeStats[received][player][type];
+				if (stats.count == 0)
+				{
+					continue;
+				}
+				char playerName[8] = "all";
+				if (player < MAX_CONNECTED_PLAYERS)
+				{
+					ssprintf(playerName, "%u", player);
+				}
+				snprintf(buf, sizeof(buf), "%s,%s,%s,%u,%u,%"PRIu64"\n", playerName, received? "received" : "sent", messageTypeToString(type), stats.count, stats.bytes, stats.usecs);
+				PHYSFS_write(fileHandle, buf, strlen(buf), 1);
+			}
+		}
+	}
+
+	snprintf(buf, sizeof(buf), "\nplayer,ping below (ms),count\n");
+	PHYSFS_write(fileHandle, buf, strlen(buf), 1);
+	for (unsigned player = 0; player < MAX_CONNECTED_PLAYERS; ++player)
+	{
+		for (unsigned bucket = 0; bucket < NUM_PING_BUCKETS; ++bucket)
+		{
+			if (pingHistogram[player][bucket] == 0)
+			{
+				continue;
+			}
+			snprintf(buf, sizeof(buf), "%u,%u,%u\n", player, pingHistogramLimits[bucket], pingHistogram[player][bucket]);
+			PHYSFS_write(fileHandle, buf, strlen(buf), 1);
+		}
+	}
+
+	snprintf(buf, sizeof(buf), "\nplayer,send queue (bytes),flush latency (ms)\n");
+	PHYSFS_write(fileHandle, buf, strlen(buf), 1);
+	for (unsigned player = 0; player < MAX_CONNECTED_PLAYERS; ++player)
+	{
+		snprintf(buf, sizeof(buf), "%u,%u,%u\n", player, NETgetSendQueueDepth(player), NETgetFlushLatency(player));
+		PHYSFS_write(fileHandle, buf, strlen(buf), 1);
+	}
+
+	if (!PHYSFS_close(fileHandle))
+	{
+		debug(LOG_ERROR, "Could not close net statistics: %s", PHYSFS_getLastError());
+		return false;
+	}
+	debug(LOG_NET, "Wrote %s", filename);
+	return true;
 }
 
 bool NETlogEntry(const char *str,UDWORD a,UDWORD b)
@@ -27,6 +27,23 @@
 bool NETstartLogging(void);
 bool NETstopLogging(void);
 bool NETlogEntry( const char *str, UDWORD a, UDWORD b );
-void NETlogPacket(uint8_t type, uint32_t size, bool received);
+void NETlogPacket(uint8_t type, uint32_t size, bool received, unsigned player, uint32_t usecs);
+void NETlogPing(unsigned player, unsigned pingTime);  ///< Adds a round trip time measurement to the ping histogram.
+
+#define NUM_PING_BUCKETS 8
+
+/// Totals for messages of a single type.
+struct NETTYPESTATS
+{
+	uint32_t count;  ///< Number of messages.
+	uint32_t bytes;  ///< Total size of the messages, before compression.
+	uint64_t usecs;  ///< Total microseconds spent serialising or deserialising (including processing) the messages.
+};
+
+NETTYPESTATS NETgetTypeStats(unsigned player, bool received, uint8_t type);  ///< Statistics for messages to or from the player, or for all messages if player == NET_ALL_PLAYERS.
+NETTYPESTATS NETgetPlayerStats(unsigned player, bool received);             ///< Statistics for messages of all types to or from the player.
+uint32_t NETgetPingHistogram(unsigned player, unsigned bucket);  ///< Number of pings to the player which were below NETgetPingHistogramLimit(bucket), but not below the previous limit.
+unsigned NETgetPingHistogramLimit(unsigned bucket);              ///< Upper limit of the bucket, in milliseconds.
+bool NETdumpStats(void);                                         ///< Writes all statistics to a file in the logs directory.
 
 #endif // _netlog_h
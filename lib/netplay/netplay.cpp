@@ -154,7 +154,7 @@ unsigned NET_PlayerConnectionStatus[CONNECTIONSTATUS_NORMAL][MAX_PLAYERS];
 **/
 static char const *versionString = "version_getVersionString()";
 static int NETCODE_VERSION_MAJOR = 5;
-static int NETCODE_VERSION_MINOR = 1;
+static int NETCODE_VERSION_MINOR = 2;
 
 // The Lobby Client - declared external in netplay.h
 Lobby::Client lobbyclient;
@@ -935,6 +935,32 @@ UDWORD NETgetPacketsRecvd(void)
 }
 
 
+/// Returns the socket used for sending directly to the player, or NULL if we can't send directly to the player.
+static Socket *NETplayerSocket(unsigned player)
+{
+	if (!NetPlay.bComms || player >= MAX_CONNECTED_PLAYERS)
+	{
+		return NULL;
+	}
+	if (NetPlay.isHost)
+	{
+		return connected_bsocket[player];
+	}
+	return player == NetPlay.hostPlayer? bsocket : NULL;
+}
+
+unsigned NETgetSendQueueDepth(unsigned player)
+{
+	Socket *sock = NETplayerSocket(player);
+	return sock != NULL? socketSendQueueSize(sock) : 0;
+}
+
+unsigned NETgetFlushLatency(unsigned player)
+{
+	Socket *sock = NETplayerSocket(player);
+	return sock != NULL? socketFlushLatency(sock) : 0;
+}
+
 // ////////////////////////////////////////////////////////////////////////
 // Send a message to a player, option to guarantee message
 bool NETsend(uint8_t player, NetMessage const *message)
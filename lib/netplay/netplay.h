@@ -279,6 +279,8 @@ extern UDWORD	NETgetPacketsRecvd(void);			// return packets sent/recv.  call reg
 extern UDWORD	NETgetRecentBytesSent(void);		// more immediate functions.
 extern UDWORD	NETgetRecentPacketsSent(void);
 extern UDWORD	NETgetRecentBytesRecvd(void);
+unsigned NETgetSendQueueDepth(unsigned player);       ///< Bytes sent to the player, which are still waiting to be compressed or written to the socket.
+unsigned NETgetFlushLatency(unsigned player);         ///< Milliseconds between flushing data to the player and the data being completely written to the socket.
 
 extern void NETplayerKicked(UDWORD index);			// Cleanup after player has been kicked
 
@@ -33,6 +33,10 @@
 
 #include <zlib.h>
 
+#if defined(WZ_OS_UNIX)
+# include <sys/time.h>
+#endif
+
 enum
 {
 	SOCK_CONNECTION,
@@ -49,7 +53,7 @@ struct Socket
 	 *
 	 * All non-listening sockets will only use the first socket handle.
 	 */
-	Socket() : ready(false), writeError(false), deleteLater(false), isCompressed(false), readDisconnected(false), zDeflateInSize(0) {}
+	Socket() : ready(false), writeError(false), deleteLater(false), isCompressed(false), readDisconnected(false), zDeflateInSize(0), flushTime(0), flushLatency(0) {}
 	~Socket();
 
 	SOCKET fd[SOCK_COUNT];
@@ -64,8 +68,12 @@ struct Socket
 	z_stream zInflate;
 	unsigned zDeflateInSize;
 	bool zInflateNeedInput;
-	std::vector<uint8_t> zDeflateOutBuf;
+	std::vector<uint8_t> zDeflateInBuf;     ///< Uncompressed data written since the last flush. Only used by the game thread.
+	std::vector<uint8_t> zDeflateOutBuf;    ///< Compressed data. Only used by the socket thread.
 	std::vector<uint8_t> zInflateInBuf;
+
+	unsigned flushTime;                     ///< Time when the oldest data which is still waiting to be written was flushed.
+	unsigned flushLatency;                  ///< Milliseconds it took to completely write the most recently written data.
 };
 
 struct SocketSet
@@ -79,12 +87,25 @@ static WZ_SEMAPHORE *socketThreadSemaphore;
 static WZ_THREAD *socketThread = NULL;
 static bool socketThreadQuit;
 typedef std::map<Socket *, std::vector<uint8_t> > SocketThreadWriteMap;
-static SocketThreadWriteMap socketThreadWrites;
+static SocketThreadWriteMap socketThreadWrites;   ///< Data ready to be written to the sockets.
+static SocketThreadWriteMap socketThreadDeflates; ///< Data flushed from compressed sockets, which the socket thread has yet to compress.
 
 
 static void socketCloseNow(Socket *sock);
 
 
+/// Milliseconds since some arbitrary point in time. Unlike wzGetTicks(), safe to call from the socket thread.
+static unsigned socketTicks()
+{
+#if   defined(WZ_OS_UNIX)
+	struct timeval tv;
+	gettimeofday(&tv, NULL);
+	return tv.tv_sec*1000 + tv.tv_usec/1000;
+#elif defined(WZ_OS_WIN)
+	return GetTickCount();
+#endif
+}
+
 bool socketReadReady(Socket const *sock)
 {
 	return sock->ready;
@@ -355,11 +376,104 @@ static bool connectionIsOpen(Socket* sock)
 	return true;
 }
 
+/// Compresses the data flushed from a compressed socket. Called by the socket thread only.
+static void socketDeflate(Socket *sock, std::vector<uint8_t> const &in, std::vector<uint8_t> &out)
+{
+	sock->zDeflate.next_in = (Bytef *)(in.empty()? NULL : &in[0]);
+	sock->zDeflate.avail_in = in.size();
+
+	// Compress and flush data out of zlib compression state.
+	do
+	{
+		size_t alreadyHave = out.size();
+		out.resize(alreadyHave + in.size() + 1000);  // A bit more than in.size() should be enough to always do everything in one go.
+		sock->zDeflate.next_out = (Bytef *)&out[alreadyHave];
+		sock->zDeflate.avail_out = out.size() - alreadyHave;
+
+		int ret = deflate(&sock->zDeflate, Z_PARTIAL_FLUSH);
+		ASSERT(ret != Z_STREAM_ERROR, "zlib compression failed!");
+
+		// Remove unused part of buffer.
+		out.resize(out.size() - sock->zDeflate.avail_out);
+	} while(sock->zDeflate.avail_out == 0);
+
+	ASSERT(sock->zDeflate.avail_in == 0, "zlib didn't compress everything!");
+
+	// Primitive network logging, uncomment to use.
+	//printf("Size %3zu ->%3zu, buf =", in.size(), out.size());
+	//for (unsigned n = 0; n < std::min<unsigned>(out.size(), 40); ++n) printf(" %02X", out[n]);
+	//printf("\n");
+}
+
+/// Deletes the socket if socketClose was called, and there is nothing left to write. Must hold socketThreadMutex.
+static void socketThreadCloseIfDone(Socket *sock)
+{
+	if (sock->deleteLater && socketThreadWrites.find(sock) == socketThreadWrites.end() && socketThreadDeflates.find(sock) == socketThreadDeflates.end())
+	{
+		socketCloseNow(sock);
+	}
+}
+
+/// Marks the socket as broken, and discards anything left to write to it. Must hold socketThreadMutex.
+static void socketThreadWriteError(Socket *sock)
+{
+	sock->writeError = true;
+	socketThreadWrites.erase(sock);    // Socket broken, don't try writing to it again.
+	socketThreadDeflates.erase(sock);
+	socketThreadCloseIfDone(sock);
+}
+
+/// Compresses everything flushed by the game thread. Must hold socketThreadMutex, which is released while compressing.
+static void socketThreadDeflateAll()
+{
+	// Take the data, but leave the (now empty) entries in socketThreadDeflates, so that socketClose waits for us to finish.
+	SocketThreadWriteMap toDeflate;
+	for (SocketThreadWriteMap::iterator i = socketThreadDeflates.begin(); i != socketThreadDeflates.end(); ++i)
+	{
+		toDeflate[i->first].swap(i->second);
+	}
+
+	// Compress without holding the mutex, so the game thread never waits for zlib.
+	wzMutexUnlock(socketThreadMutex);
+	for (SocketThreadWriteMap::iterator i = toDeflate.begin(); i != toDeflate.end(); ++i)
+	{
+		Socket *sock = i->first;
+		sock->zDeflateOutBuf.clear();
+		socketDeflate(sock, i->second, sock->zDeflateOutBuf);
+	}
+	wzMutexLock(socketThreadMutex);
+
+	for (SocketThreadWriteMap::iterator i = toDeflate.begin(); i != toDeflate.end(); ++i)
+	{
+		Socket *sock = i->first;
+		SocketThreadWriteMap::iterator d = socketThreadDeflates.find(sock);
+		if (d == socketThreadDeflates.end())
+		{
+			continue;  // Got a write error while compressing, so don't bother writing.
+		}
+		if (!sock->zDeflateOutBuf.empty())
+		{
+			std::vector<uint8_t> &writeQueue = socketThreadWrites[sock];
+			writeQueue.insert(writeQueue.end(), sock->zDeflateOutBuf.begin(), sock->zDeflateOutBuf.end());
+		}
+		if (d->second.empty())
+		{
+			socketThreadDeflates.erase(d);  // No more data was flushed while we were compressing.
+		}
+		socketThreadCloseIfDone(sock);
+	}
+}
+
 static int socketThreadFunction(void *)
 {
 	wzMutexLock(socketThreadMutex);
 	while (!socketThreadQuit)
 	{
+		if (!socketThreadDeflates.empty())
+		{
+			socketThreadDeflateAll();
+		}
+
 #if   defined(WZ_OS_UNIX)
 		SOCKET maxfd = INT_MIN;
 #elif defined(WZ_OS_WIN)
@@ -379,9 +493,13 @@ static int socketThreadFunction(void *)
 		struct timeval tv = {0, 50 * 1000};
 
 		// Check if we can write to any sockets.
-		wzMutexUnlock(socketThreadMutex);
-		int ret = select(maxfd + 1, NULL, &fds, NULL, &tv);
-		wzMutexLock(socketThreadMutex);
+		int ret = 0;
+		if (!socketThreadWrites.empty())
+		{
+			wzMutexUnlock(socketThreadMutex);
+			ret = select(maxfd + 1, NULL, &fds, NULL, &tv);
+			wzMutexLock(socketThreadMutex);
+		}
 
 		// We can write to some sockets. (Ignore errors from select, we may have deleted the socket after unlocking the mutex, and before calling select.)
 		if (ret > 0)
@@ -409,10 +527,11 @@ static int socketThreadFunction(void *)
 					if (writeQueue.empty())
 					{
 						socketThreadWrites.erase(w);  // Nothing left to write, delete from pending list.
-						if (sock->deleteLater)
+						if (socketThreadDeflates.find(sock) == socketThreadDeflates.end())
 						{
-							socketCloseNow(sock);
+							sock->flushLatency = socketTicks() - sock->flushTime;  // Everything flushed so far has been written.
 						}
+						socketThreadCloseIfDone(sock);
 					}
 				}
 				else
@@ -426,12 +545,7 @@ static int socketThreadFunction(void *)
 							if (!connectionIsOpen(sock))
 							{
 								debug(LOG_NET, "Socket error");
-								sock->writeError = true;
-								socketThreadWrites.erase(w);  // Socket broken, don't try writing to it again.
-								if (sock->deleteLater)
-								{
-									socketCloseNow(sock);
-								}
+								socketThreadWriteError(sock);
 								break;
 							}
 						case EINTR:
@@ -442,19 +556,14 @@ static int socketThreadFunction(void *)
 							// fall through
 #endif
 						default:
-							sock->writeError = true;
-							socketThreadWrites.erase(w);  // Socket broken, don't try writing to it again.
-							if (sock->deleteLater)
-							{
-								socketCloseNow(sock);
-							}
+							socketThreadWriteError(sock);
 							break;
 					}
 				}
 			}
 		}
 
-		if (socketThreadWrites.empty())
+		if (socketThreadWrites.empty() && socketThreadDeflates.empty())
 		{
 			// Nothing to do, expect to wait.
 			wzMutexUnlock(socketThreadMutex);
@@ -557,6 +666,21 @@ bool socketReadDisconnected(Socket *sock)
 	return sock->readDisconnected;
 }
 
+/// Appends data to one of the socket thread queues, waking the thread if needed. Must hold socketThreadMutex.
+static void socketQueueForThread(SocketThreadWriteMap &queues, Socket *sock, uint8_t const *data, size_t size)
+{
+	if (socketThreadWrites.empty() && socketThreadDeflates.empty())
+	{
+		wzSemaphorePost(socketThreadSemaphore);
+	}
+	if (socketThreadWrites.find(sock) == socketThreadWrites.end() && socketThreadDeflates.find(sock) == socketThreadDeflates.end())
+	{
+		sock->flushTime = socketTicks();  // Nothing was waiting to be written, so start timing.
+	}
+	std::vector<uint8_t> &queue = queues[sock];
+	queue.insert(queue.end(), data, data + size);
+}
+
 /**
  * Similar to write(2) with the exception that this function will block until
  * <em>all</em> data has been written or an error occurs.
@@ -583,34 +707,14 @@ ssize_t writeAll(Socket* sock, const void* buf, size_t size)
 		if (!sock->isCompressed)
 		{
 			wzMutexLock(socketThreadMutex);
-			if (socketThreadWrites.empty())
-			{
-				wzSemaphorePost(socketThreadSemaphore);
-			}
-			std::vector<uint8_t> &writeQueue = socketThreadWrites[sock];
-			writeQueue.insert(writeQueue.end(), static_cast<char const *>(buf), static_cast<char const *>(buf) + size);
+			socketQueueForThread(socketThreadWrites, sock, static_cast<uint8_t const *>(buf), size);
 			wzMutexUnlock(socketThreadMutex);
 		}
 		else
 		{
-			sock->zDeflate.next_in = (Bytef *)buf;
-			sock->zDeflate.avail_in = size;
-			sock->zDeflateInSize += sock->zDeflate.avail_in;
-			do
-			{
-				size_t alreadyHave = sock->zDeflateOutBuf.size();
-				sock->zDeflateOutBuf.resize(alreadyHave + size + 20);  // A bit more than size should be enough to always do everything in one go.
-				sock->zDeflate.next_out = (Bytef *)&sock->zDeflateOutBuf[alreadyHave];
-				sock->zDeflate.avail_out = sock->zDeflateOutBuf.size() - alreadyHave;
-
-				int ret = deflate(&sock->zDeflate, Z_NO_FLUSH);
-				ASSERT(ret != Z_STREAM_ERROR, "zlib compression failed!");
-
-				// Remove unused part of buffer.
-				sock->zDeflateOutBuf.resize(sock->zDeflateOutBuf.size() - sock->zDeflate.avail_out);
-			} while(sock->zDeflate.avail_out == 0);
-
-			ASSERT(sock->zDeflate.avail_in == 0, "zlib didn't compress everything!");
+			// Compressed by the socket thread, when flushed.
+			sock->zDeflateInBuf.insert(sock->zDeflateInBuf.end(), static_cast<uint8_t const *>(buf), static_cast<uint8_t const *>(buf) + size);
+			sock->zDeflateInSize += size;
 		}
 	}
 
@@ -624,43 +728,52 @@ void socketFlush(Socket *sock)
 		return;  // Not compressed, so don't mess with zlib.
 	}
 
-	// Flush data out of zlib compression state.
-	do
+	if (sock->zDeflateInBuf.empty())
 	{
-		size_t alreadyHave = sock->zDeflateOutBuf.size();
-		sock->zDeflateOutBuf.resize(alreadyHave + 1000);  // 100 bytes would probably be enough to flush the rest in one go.
-		sock->zDeflate.next_out = (Bytef *)&sock->zDeflateOutBuf[alreadyHave];
-		sock->zDeflate.avail_out = sock->zDeflateOutBuf.size() - alreadyHave;
+		return;  // No data to flush out.
+	}
 
-		int ret = deflate(&sock->zDeflate, Z_PARTIAL_FLUSH);
-		ASSERT(ret != Z_STREAM_ERROR, "zlib compression failed!");
+	// Hand the data to the socket thread, which compresses and sends it.
+	wzMutexLock(socketThreadMutex);
+	socketQueueForThread(socketThreadDeflates, sock, &sock->zDeflateInBuf[0], sock->zDeflateInBuf.size());
+	wzMutexUnlock(socketThreadMutex);
 
-		// Remove unused part of buffer.
-		sock->zDeflateOutBuf.resize(sock->zDeflateOutBuf.size() - sock->zDeflate.avail_out);
-	} while(sock->zDeflate.avail_out == 0);
+	// Data sent, don't send again.
+	sock->zDeflateInSize = 0;
+	sock->zDeflateInBuf.clear();
+}
+
+size_t socketSendQueueSize(Socket *sock)
+{
+	size_t size = sock->zDeflateInBuf.size();
 
-	if (sock->zDeflateOutBuf.empty())
+	wzMutexLock(socketThreadMutex);
+	SocketThreadWriteMap::const_iterator d = socketThreadDeflates.find(sock);
+	if (d != socketThreadDeflates.end())
 	{
-		return;  // No data to flush out.
+		size += d->second.size();
+	}
+	SocketThreadWriteMap::const_iterator w = socketThreadWrites.find(sock);
+	if (w != socketThreadWrites.end())
+	{
+		size += w->second.size();
 	}
+	wzMutexUnlock(socketThreadMutex);
 
+	return size;
+}
+
+unsigned socketFlushLatency(Socket *sock)
+{
 	wzMutexLock(socketThreadMutex);
-	if (socketThreadWrites.empty())
+	unsigned latency = sock->flushLatency;
+	if (socketThreadWrites.find(sock) != socketThreadWrites.end() || socketThreadDeflates.find(sock) != socketThreadDeflates.end())
 	{
-		wzSemaphorePost(socketThreadSemaphore);
+		latency = std::max(latency, socketTicks() - sock->flushTime);  // Still waiting, so it's taking at least this long.
 	}
-	std::vector<uint8_t> &writeQueue = socketThreadWrites[sock];
-	writeQueue.insert(writeQueue.end(), sock->zDeflateOutBuf.begin(), sock->zDeflateOutBuf.end());
 	wzMutexUnlock(socketThreadMutex);
 
-	// Primitive network logging, uncomment to use.
-	//printf("Size %3u ->%3zu, buf =", sock->zDeflateInSize, sock->zDeflateOutBuf.size());
-	//for (unsigned n = 0; n < std::min<unsigned>(sock->zDeflateOutBuf.size(), 40); ++n) printf(" %02X", sock->zDeflateOutBuf[n]);
-	//printf("\n");
-
-	// Data sent, don't send again.
-	sock->zDeflateInSize = 0;
-	sock->zDeflateOutBuf.clear();
+	return latency;
 }
 
 void socketBeginCompression(Socket *sock)
@@ -988,7 +1101,7 @@ void socketClose(Socket* sock)
 	}
 	wzMutexLock(socketThreadMutex);
 	//Instead of socketThreadWrites.erase(sock);, try sending the data before actually deleting.
-	if (socketThreadWrites.find(sock) != socketThreadWrites.end())
+	if (socketThreadWrites.find(sock) != socketThreadWrites.end() || socketThreadDeflates.find(sock) != socketThreadDeflates.end())
 	{
 		// Wait until the data is written, then delete the socket.
 		sock->deleteLater = true;
@@ -1368,6 +1481,32 @@ char const *getSocketTextAddress(Socket const *sock)
 	return sock->textAddress;
 }
 
+unsigned socketListenPort(Socket const *sock)
+{
+	// Prefer the IPv4 socket, in case the IPv6 one doesn't map IPv4 and got a port of its own.
+	static const unsigned order[] = {SOCK_IPV4_LISTEN, SOCK_IPV6_LISTEN};
+
+	for (unsigned i = 0; i < ARRAY_SIZE(order); ++i)
+	{
+		struct sockaddr_storage addr;
+		socklen_t addr_len = sizeof(addr);
+
+		if (sock->fd[order[i]] == INVALID_SOCKET || getsockname(sock->fd[order[i]], (struct sockaddr*)&addr, &addr_len) == SOCKET_ERROR)
+		{
+			continue;
+		}
+		if (addr.ss_family == AF_INET)
+		{
+			return ntohs(((struct sockaddr_in *)&addr)->sin_port);
+		}
+		if (addr.ss_family == AF_INET6)
+		{
+			return ntohs(((struct sockaddr_in6 *)&addr)->sin6_port);
+		}
+	}
+	return 0;
+}
+
 SocketAddress *resolveHost(const char *host, unsigned int port)
 {
 	struct addrinfo* results;
@@ -1454,6 +1593,7 @@ void SOCKETshutdown()
 		wzMutexLock(socketThreadMutex);
 		socketThreadQuit = true;
 		socketThreadWrites.clear();
+		socketThreadDeflates.clear();
 		wzMutexUnlock(socketThreadMutex);
 		wzSemaphorePost(socketThreadSemaphore);  // Wake up the thread, so it can quit.
 		wzThreadJoin(socketThread);
@@ -102,6 +102,7 @@ size_t socketArrayOpen(Socket **sockets, size_t maxSockets, const SocketAddress
 void socketArrayClose(Socket **sockets, size_t maxSockets);             ///< Closes all Sockets in the array.
 
 char const *getSocketTextAddress(Socket const *sock);                   ///< Gets a string with the socket address.
+unsigned socketListenPort(Socket const *sock);                          ///< Gets the port a listening Socket is bound to, useful after socketListen(0). Returns 0 on error.
 bool socketReadReady(Socket const *sock);                               ///< Returns if checkSockets found data to read from this Socket.
 ssize_t readNoInt(Socket *sock, void *buf, size_t max_size);            ///< Reads up to max_size bytes from the Socket.
 ssize_t readAll(Socket* sock, void *buf, size_t size, unsigned timeout);///< Reads exactly size bytes from the Socket, or blocks until the timeout expires.
@@ -110,7 +111,11 @@ ssize_t writeAll(Socket *sock, const void* buf, size_t size);           ///< Non
 // Sockets, compressed.
 void socketBeginCompression(Socket *sock);                              ///< Makes future data sent compressed, and future data received expected to be compressed.
 bool socketReadDisconnected(Socket *sock);                              ///< If readNoInt returned 0, returns true if this is the result of a disconnect, or false if the input compressed data just hasn't produced any output bytes.
-void socketFlush(Socket *sock);                                         ///< Actually sends the data written with writeAll. Only useful on compressed sockets. Note that flushing too often makes compression less effective.
+void socketFlush(Socket *sock);                                         ///< Actually sends the data written with writeAll. Only useful on compressed sockets. Note that flushing too often makes compression less effective. Compression is done by a separate thread.
+
+// Socket statistics.
+size_t socketSendQueueSize(Socket *sock);                               ///< Returns the number of bytes written to the Socket, which have not yet been sent.
+unsigned socketFlushLatency(Socket *sock);                              ///< Returns how many milliseconds the last flushed data took to be sent, or how long the oldest data has been waiting, if longer.
 
 // Socket sets.
 SocketSet *allocSocketSet(void);                                        ///< Constructs a SocketSet.
@@ -34,6 +34,7 @@
 #endif
 
 #include "../framework/frame.h"
+#include "../framework/wztime.h"
 #include "netplay.h"
 #include "nettypes.h"
 #include "netqueue.h"
@@ -62,6 +63,7 @@ static MessageReader reader;  ///< Used when deserialising a message.
 static NetMessage message;    ///< A message which is being serialised or deserialised.
 static NETQUEUE queueInfo;    ///< Indicates which queue is currently being (de)serialised.
 static PACKETDIR NetDir;      ///< Indicates whether a message is being serialised (PACKET_ENCODE) or deserialised (PACKET_DECODE), or not doing anything (PACKET_INVALID).
+static uint64_t messageStartTime;  ///< When NETbegin{Encode,Decode} was called, for the statistics.
 
 static void NETsetPacketDir(PACKETDIR dir)
 {
@@ -434,6 +436,7 @@ void NETbeginEncode(NETQUEUE queue, uint8_t type)
 	queueInfo = queue;
 	message = type;
 	writer = MessageWriter(message);
+	messageStartTime = wzGetMicroTicks();
 }
 
 void NETbeginDecode(NETQUEUE queue, uint8_t type)
@@ -443,10 +446,22 @@ void NETbeginDecode(NETQUEUE queue, uint8_t type)
 	queueInfo = queue;
 	message = receiveQueue(queueInfo)->getMessage();
 	reader = MessageReader(message);
+	messageStartTime = wzGetMicroTicks();
 
 	assert(type == message.type);
 }
 
+/// Returns which player's statistics messages in the queue count towards.
+/// Game messages are sent to everyone, from our own game queue, so only received ones are booked against a player, the one who sent them.
+static unsigned queueStatsPlayer(NETQUEUE queue, bool received)
+{
+	if (queue.queueType == QUEUE_NET || (queue.queueType == QUEUE_GAME && received))
+	{
+		return queue.index;
+	}
+	return NET_ALL_PLAYERS;
+}
+
 bool NETend()
 {
 	// If we are encoding just return true
@@ -455,7 +470,7 @@ bool NETend()
 		// Push the message onto the list.
 		NetQueue *queue = sendQueue(queueInfo);
 		queue->pushMessage(message);
-		NETlogPacket(message.type, message.data.size(), false);
+		NETlogPacket(message.type, message.data.size(), false, queueStatsPlayer(queueInfo, false), wzGetMicroTicks() - messageStartTime);
 
 		if (queueInfo.queueType == QUEUE_GAME)
 		{
@@ -481,6 +496,7 @@ bool NETend()
 	if (NETgetPacketDir() == PACKET_DECODE)
 	{
 		bool ret = reader.valid();
+		NETlogPacket(message.type, message.data.size(), true, queueStatsPlayer(queueInfo, true), wzGetMicroTicks() - messageStartTime);
 
 		// We have ended the deserialisation, so mark the direction invalid
 		NETsetPacketDir(PACKET_INVALID);
@@ -462,16 +462,13 @@ bool sound_QueueSamplePlaying( void )
 	return false;
 }
 
-/** Decodes an opened OggVorbis file into an OpenAL buffer
- *  \param psTrack pointer to object which will contain the final buffer
+/** Decodes an opened OggVorbis file into PCM data, without touching OpenAL
  *  \param PHYSFS_fileHandle file handle given by PhysicsFS to the opened file
- *  \return on success the psTrack pointer, otherwise it will be free'd and a NULL pointer is returned instead
+ *  \return the decoded data, or NULL on failure
  */
-static inline TRACK* sound_DecodeOggVorbisTrack(TRACK *psTrack, PHYSFS_file* PHYSFS_fileHandle)
+static soundDataBuffer *sound_DecodeOggVorbisTrack(PHYSFS_file *PHYSFS_fileHandle)
 {
 #ifndef WZ_NOSOUND
-	ALenum		format;
-	ALuint		buffer;
 	struct OggVorbisDecoderState *decoder;
 	soundDataBuffer	*soundBuffer;
 
@@ -484,7 +481,6 @@ static inline TRACK* sound_DecodeOggVorbisTrack(TRACK *psTrack, PHYSFS_file* PHY
 	if (decoder == NULL)
 	{
 		debug(LOG_WARNING, "Failed to open audio file for decoding");
-		free(psTrack);
 		return NULL;
 	}
 
@@ -493,7 +489,6 @@ static inline TRACK* sound_DecodeOggVorbisTrack(TRACK *psTrack, PHYSFS_file* PHY
 
 	if (soundBuffer == NULL)
 	{
-		free(psTrack);
 		return NULL;
 	}
 
@@ -505,39 +500,25 @@ static inline TRACK* sound_DecodeOggVorbisTrack(TRACK *psTrack, PHYSFS_file* PHY
 //       builds. (Returning NULL here __will__ result in a program termination.)
 #ifdef DEBUG
 		free(soundBuffer);
-		free(psTrack);
 		return NULL;
 #endif
 	}
 
-	// Determine PCM data format
-	format = (soundBuffer->channelCount == 1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
-
-	// Create an OpenAL buffer and fill it with the decoded data
-	alGenBuffers(1, &buffer);
-	sound_GetError();
-	alBufferData(buffer, format, soundBuffer->data, soundBuffer->size, soundBuffer->frequency);
-	sound_GetError();
-
-	free(soundBuffer);
-
-	// save buffer name in track
-	psTrack->iBufferName = buffer;
+	return soundBuffer;
+#else
+	// Nothing to decode into, but the track still has to exist
+	return (soundDataBuffer *)calloc(1, sizeof(soundDataBuffer));
 #endif
-
-	return psTrack;
 }
 
 //*
 // =======================================================================================================================
 // =======================================================================================================================
 //
-TRACK* sound_LoadTrackFromFile(const char *fileName)
+soundDataBuffer *sound_DecodeTrackFromFile(const char *fileName)
 {
-	TRACK* pTrack;
 	PHYSFS_file* fileHandle;
-	size_t filename_size;
-	char* track_name;
+	soundDataBuffer *soundBuffer;
 
 	// Use PhysicsFS to open the file
 	fileHandle = PHYSFS_openRead(fileName);
@@ -548,6 +529,27 @@ TRACK* sound_LoadTrackFromFile(const char *fileName)
 		return NULL;
 	}
 
+	soundBuffer = sound_DecodeOggVorbisTrack(fileHandle);
+
+	PHYSFS_close(fileHandle);
+	return soundBuffer;
+}
+
+//*
+// =======================================================================================================================
+// =======================================================================================================================
+//
+TRACK *sound_LoadTrackFromDecoded(soundDataBuffer *soundBuffer)
+{
+	TRACK* pTrack;
+	size_t filename_size;
+	char* track_name;
+
+	if (soundBuffer == NULL)
+	{
+		return NULL;
+	}
+
 	if (GetLastResourceFilename() == NULL)
 	{
 		// This is a non fatal error.  We just can't find filename for some reason.
@@ -584,13 +586,37 @@ TRACK* sound_LoadTrackFromFile(const char *fileName)
 	}
 	pTrack->fileName = track_name;
 
-	// Now use sound_ReadTrackFromBuffer to decode the file's contents
-	pTrack = sound_DecodeOggVorbisTrack(pTrack, fileHandle);
+#ifndef WZ_NOSOUND
+	{
+		// Determine PCM data format
+		ALenum format = (soundBuffer->channelCount == 1) ? AL_FORMAT_MONO16 : AL_FORMAT_STEREO16;
+		ALuint buffer;
+
+		// Create an OpenAL buffer and fill it with the decoded data
+		alGenBuffers(1, &buffer);
+		sound_GetError();
+		alBufferData(buffer, format, soundBuffer->data, soundBuffer->size, soundBuffer->frequency);
+		sound_GetError();
+
+		// save buffer name in track
+		pTrack->iBufferName = buffer;
+	}
+#endif
+
+	free(soundBuffer);
 
-	PHYSFS_close(fileHandle);
 	return pTrack;
 }
 
+//*
+// =======================================================================================================================
+// =======================================================================================================================
+//
+TRACK* sound_LoadTrackFromFile(const char *fileName)
+{
+	return sound_LoadTrackFromDecoded(sound_DecodeTrackFromFile(fileName));
+}
+
 void sound_FreeTrack( TRACK *psTrack )
 {
 #ifndef WZ_NOSOUND
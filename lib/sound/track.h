@@ -45,6 +45,7 @@
 
 typedef bool (* AUDIO_CALLBACK)  ( void *psObj );
 struct AUDIO_STREAM;
+struct soundDataBuffer;
 
 /* structs */
 
@@ -91,6 +92,10 @@ bool	sound_Init(void);
 bool	sound_Shutdown(void);
 
 TRACK *	sound_LoadTrackFromFile(const char *fileName);
+/** Decodes a track without touching OpenAL, so it can be done on a loader thread; free the result with free() if unused */
+soundDataBuffer *	sound_DecodeTrackFromFile(const char *fileName);
+/** Uploads a decoded track to OpenAL, named after the last resource file loaded; takes ownership of soundBuffer */
+TRACK *	sound_LoadTrackFromDecoded(soundDataBuffer *soundBuffer);
 unsigned int sound_SetTrackVals(const char* fileName, bool loop, unsigned int volume, unsigned int audibleRadius);
 void	sound_ReleaseTrack( TRACK * psTrack );
 
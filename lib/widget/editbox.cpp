@@ -45,9 +45,6 @@
 /* Whether the cursor blinks or not */
 #define CURSOR_BLINK		1
 
-/* The time the cursor blinks for */
-#define WEDB_BLINKRATE		800
-
 /* Number of characters to jump the edit box text when moving the cursor */
 #define WEDB_CHARJUMP		6
 
@@ -37,6 +37,9 @@
 #define WEDBS_HILITE	0x0010		//
 #define WEDBS_DISABLE   0x0020		// disable button from selection
 
+/* The time the cursor blinks for */
+#define WEDB_BLINKRATE		800
+
 struct W_EDITBOX : public WIDGET
 {
 	W_EDITBOX(W_EDBINIT const *init);
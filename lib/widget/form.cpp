@@ -82,6 +82,8 @@ W_FORM::W_FORM(W_FORMINIT const *init)
 	, startTime(0)                    // This assignment was previously done by a memset.
 	, psLastHiLite(NULL)
 	, psWidgets(NULL)
+	, psSurface(NULL)
+	, surfaceHash(0)
 {
 	if (display == NULL)
 	{
@@ -295,7 +297,7 @@ W_FORM* formCreate(const W_FORMINIT* psInit)
 	/* Check the style bits are OK */
 	if (psInit->style & ~(WFORM_TABBED | WFORM_INVISIBLE | WFORM_CLICKABLE
 	                    | WFORM_NOCLICKMOVE | WFORM_NOPRIMARY | WFORM_SECONDARY
-	                    | WIDG_HIDDEN))
+	                    | WFORM_CACHED | WIDG_HIDDEN))
 	{
 		ASSERT(false, "formCreate: Unknown style bit");
 		return NULL;
@@ -341,6 +343,9 @@ W_FORM* formCreate(const W_FORMINIT* psInit)
 /* Free the memory used by a form */
 void formFree(W_FORM *psWidget)
 {
+	pie_DeleteSurface(psWidget->psSurface);
+	psWidget->psSurface = NULL;
+
 	if (psWidget->style & WFORM_TABBED)
 	{
 		formFreeTabbed((W_TABFORM *)psWidget);
@@ -26,6 +26,8 @@
 
 #include "lib/widget/widget.h"
 
+struct PIE_SURFACE;
+
 
 /* Respond to a mouse click */
 extern void formClicked(W_FORM *psWidget, UDWORD key);
@@ -44,6 +46,8 @@ struct W_FORM : public WIDGET
 	PIELIGHT        aColours[WCOL_MAX];     ///< Colours for the form and its widgets
 	WIDGET *        psLastHiLite;           ///< The last widget to be hilited. This is used to track when the mouse moves off something.
 	WIDGET *        psWidgets;              ///< The widgets on the form
+	PIE_SURFACE *   psSurface;              ///< Image of the form, if WFORM_CACHED
+	uint32_t        surfaceHash;            ///< Hash of what the image was drawn from
 };
 
 /* Information for a minor tab */
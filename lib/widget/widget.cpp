@@ -25,7 +25,12 @@
 #include "lib/framework/string_ext.h"
 #include "lib/framework/frameint.h"
 #include "lib/framework/utf.h"
+#include "lib/framework/wzapp.h"
 #include "lib/ivis_opengl/textdraw.h"
+// FIXME Direct iVis implementation include!
+#include "lib/ivis_opengl/pieblitfunc.h"
+
+#include <QtCore/QHash>
 
 #include "widget.h"
 #include "widgint.h"
@@ -48,12 +53,16 @@ static WIDGET_AUDIOCALLBACK AudioCallback = NULL;
 static SWORD HilightAudioID = -1;
 static SWORD ClickedAudioID = -1;
 
+/* Number of WFORM_CACHED forms drawn from their image, and redrawn, since widgGetResetCachedFormCounts */
+static unsigned int cachedFormsReused = 0, cachedFormsRedrawn = 0;
+
 /* Function prototypes */
 void widgHiLite(WIDGET *psWidget, W_CONTEXT *psContext);
 void widgHiLiteLost(WIDGET *psWidget, W_CONTEXT *psContext);
 static void widgReleased(WIDGET *psWidget, UDWORD key, W_CONTEXT *psContext);
 static void widgRun(WIDGET *psWidget, W_CONTEXT *psContext);
 static void widgDisplayForm(W_FORM *psForm, UDWORD xOffset, UDWORD yOffset);
+static void widgDisplayFormWidgets(W_FORM *psForm, UDWORD xOffset, UDWORD yOffset);
 static void widgRelease(WIDGET *psWidget);
 
 /* Buffer to return strings in */
@@ -1485,8 +1494,203 @@ void widgSetReturn(W_SCREEN* psScreen, WIDGET *psWidget)
 }
 
 
+/* Mix a value into an FNV-1a hash of what widgets are displayed from */
+static uint32_t widgHashValue(uint32_t hash, uint64_t value)
+{
+	for (unsigned i = 0; i < sizeof(value); ++i)
+	{
+		hash = (hash ^ (uint8_t)(value >> 8*i)) * 16777619u;
+	}
+	return hash;
+}
+
+static uint32_t widgHashString(uint32_t hash, const char *string)
+{
+	if (string == NULL)
+	{
+		return widgHashValue(hash, 0);
+	}
+	for (; *string != '\0'; ++string)
+	{
+		hash = (hash ^ (uint8_t)*string) * 16777619u;
+	}
+	return widgHashValue(hash, 1);
+}
+
+/* Hash the fields a widget is displayed from.
+ * The fields the display functions of the library use, and those a user display function is given.
+ */
+static uint32_t widgHashWidget(uint32_t hash, WIDGET *psWidget)
+{
+	hash = widgHashValue(hash, psWidget->id);
+	hash = widgHashValue(hash, psWidget->style);
+	hash = widgHashValue(hash, (uint16_t)psWidget->x | (uint32_t)(uint16_t)psWidget->y << 16 | (uint64_t)psWidget->width << 32 | (uint64_t)psWidget->height << 48);
+	hash = widgHashValue(hash, (uintptr_t)psWidget->display);
+	hash = widgHashValue(hash, (uintptr_t)psWidget->pUserData);
+	hash = widgHashValue(hash, psWidget->UserData);
+	hash = widgHashValue(hash, psWidget == psMouseOverWidget);
+
+	switch (psWidget->type)
+	{
+	case WIDG_FORM:
+	{
+		W_FORM *psForm = (W_FORM *)psWidget;
+		hash = widgHashValue(hash, psForm->disableChildren);
+		hash = widgHashValue(hash, psForm->Ax0 | (uint32_t)psForm->Ay0 << 16 | (uint64_t)psForm->Ax1 << 32 | (uint64_t)psForm->Ay1 << 48);
+		hash = widgHashValue(hash, psForm->animCount | (uint64_t)psForm->startTime << 32);
+		for (unsigned i = 0; i < WCOL_MAX; ++i)
+		{
+			hash = widgHashValue(hash, psForm->aColours[i].rgba);
+		}
+		if (psForm->style & WFORM_TABBED)
+		{
+			W_TABFORM *psTabForm = (W_TABFORM *)psForm;
+			hash = widgHashValue(hash, psTabForm->majorT | (uint32_t)psTabForm->minorT << 16 | (uint64_t)psTabForm->tabHiLite << 32 | (uint64_t)psTabForm->state << 48);
+			hash = widgHashValue(hash, psTabForm->numMajor | (uint64_t)(uint16_t)psTabForm->TabMultiplier << 32);
+		}
+		else if (psForm->style & WFORM_CLICKABLE)
+		{
+			hash = widgHashValue(hash, ((W_CLICKFORM *)psForm)->state);
+		}
+		break;
+	}
+	case WIDG_LABEL:
+		hash = widgHashString(hash, ((W_LABEL *)psWidget)->aText);
+		hash = widgHashValue(hash, ((W_LABEL *)psWidget)->FontID);
+		break;
+	case WIDG_BUTTON:
+		hash = widgHashValue(hash, ((W_BUTTON *)psWidget)->state);
+		hash = widgHashString(hash, ((W_BUTTON *)psWidget)->pText);
+		hash = widgHashValue(hash, ((W_BUTTON *)psWidget)->FontID);
+		break;
+	case WIDG_EDITBOX:
+	{
+		W_EDITBOX *psEdBox = (W_EDITBOX *)psWidget;
+		hash = widgHashValue(hash, psEdBox->state);
+		hash = widgHashValue(hash, qHash(psEdBox->aText));
+		hash = widgHashValue(hash, psEdBox->FontID);
+		hash = widgHashValue(hash, (uint32_t)psEdBox->insPos | (uint64_t)(uint32_t)psEdBox->printStart << 32);
+		if ((psEdBox->state & WEDBS_MASK) != WEDBS_FIXED)
+		{
+			// The cursor blinks
+			hash = widgHashValue(hash, (wzGetTicks() - psEdBox->blinkOffset)/WEDB_BLINKRATE % 2);
+		}
+		break;
+	}
+	case WIDG_BARGRAPH:
+	{
+		W_BARGRAPH *psBGraph = (W_BARGRAPH *)psWidget;
+		hash = widgHashValue(hash, psBGraph->barPos);
+		hash = widgHashValue(hash, psBGraph->majorSize | (uint32_t)psBGraph->minorSize << 16 | (uint64_t)psBGraph->iRange << 32 | (uint64_t)psBGraph->iValue << 48);
+		hash = widgHashValue(hash, psBGraph->iOriginal | (uint64_t)(uint32_t)psBGraph->denominator << 16 | (uint64_t)(uint16_t)psBGraph->precision << 48);
+		hash = widgHashValue(hash, psBGraph->majorCol.rgba | (uint64_t)psBGraph->minorCol.rgba << 32);
+		hash = widgHashValue(hash, psBGraph->textCol.rgba);
+		hash = widgHashValue(hash, qHash(psBGraph->text));
+		break;
+	}
+	case WIDG_SLIDER:
+	{
+		W_SLIDER *psSlider = (W_SLIDER *)psWidget;
+		hash = widgHashValue(hash, psSlider->orientation);
+		hash = widgHashValue(hash, psSlider->numStops | (uint32_t)psSlider->barSize << 16 | (uint64_t)psSlider->pos << 32 | (uint64_t)psSlider->state << 48);
+		break;
+	}
+	default:
+		ASSERT(!"Unknown widget type", "Unknown widget type");
+		break;
+	}
+
+	return hash;
+}
+
+/* Hash what a form and the widgets on it are displayed from, visiting the same widgets as widgDisplayFormWidgets */
+static uint32_t widgHashForm(uint32_t hash, W_FORM *psForm)
+{
+	hash = widgHashWidget(hash, psForm);
+	if (psForm->disableChildren)
+	{
+		return hash;
+	}
+
+	for (WIDGET *psCurr = formGetWidgets(psForm); psCurr; psCurr = psCurr->psNext)
+	{
+		if (psCurr->style & WIDG_HIDDEN)
+		{
+			continue;
+		}
+
+		if (psCurr->type == WIDG_FORM)
+		{
+			hash = widgHashForm(hash, (W_FORM *)psCurr);
+		}
+		else
+		{
+			hash = widgHashWidget(hash, psCurr);
+		}
+	}
+	return hash;
+}
+
+/* Display a WFORM_CACHED form from its image, redrawing the image first if anything on the form has changed.
+ * Returns false if the form has to be drawn directly.
+ */
+static bool widgDisplayCachedForm(W_FORM *psForm, UDWORD xOffset, UDWORD yOffset)
+{
+	const int x0 = xOffset + psForm->x, y0 = yOffset + psForm->y;
+	uint32_t hash = widgHashValue(2166136261u, xOffset | (uint64_t)yOffset << 32);
+	hash = widgHashForm(hash, psForm);
+
+	if (psForm->psSurface == NULL)
+	{
+		psForm->psSurface = pie_CreateSurface(psForm->width, psForm->height);
+		if (psForm->psSurface == NULL)
+		{
+			psForm->style &= ~WFORM_CACHED;  // Not supported, draw it directly from now on.
+			return false;
+		}
+		psForm->surfaceHash = ~hash;
+	}
+
+	if (hash != psForm->surfaceHash)
+	{
+		if (!pie_BeginSurface(psForm->psSurface, x0, y0))
+		{
+			return false;  // Drawn into the image of a form it is on.
+		}
+		widgDisplayFormWidgets(psForm, xOffset, yOffset);
+		pie_EndSurface();
+		psForm->surfaceHash = hash;
+		++cachedFormsRedrawn;
+	}
+	else
+	{
+		++cachedFormsReused;
+	}
+
+	pie_DrawSurface(psForm->psSurface, x0, y0);
+	return true;
+}
+
+void widgGetResetCachedFormCounts(unsigned int *pReused, unsigned int *pRedrawn)
+{
+	*pReused = cachedFormsReused;
+	*pRedrawn = cachedFormsRedrawn;
+	cachedFormsReused = 0;
+	cachedFormsRedrawn = 0;
+}
+
 /* Display the widgets on a form */
 static void widgDisplayForm(W_FORM *psForm, UDWORD xOffset, UDWORD yOffset)
+{
+	if ((psForm->style & WFORM_CACHED) && widgDisplayCachedForm(psForm, xOffset, yOffset))
+	{
+		return;
+	}
+	widgDisplayFormWidgets(psForm, xOffset, yOffset);
+}
+
+/* Display a form and the widgets on it */
+static void widgDisplayFormWidgets(W_FORM *psForm, UDWORD xOffset, UDWORD yOffset)
 {
 	WIDGET	*psCurr = NULL;
 	SDWORD	xOrigin = 0, yOrigin = 0;
@@ -60,6 +60,13 @@
 #define WFORM_NOPRIMARY		0x10
 #define WFORM_SECONDARY		0x20	///< Enable secondary buttons
 
+/**
+ * Keep an image of the form and what is on it, and only redraw it when a widget on it changes.
+ * Only for forms of fixed size that are drawn within their rectangle, and whose display functions
+ * draw the same as long as the widgets' fields (and which widget the mouse is over) stay the same.
+ */
+#define WFORM_CACHED		0x40
+
 /************ Label styles ***************/
 
 #define WLAB_PLAIN		0	///< Plain text only label
@@ -430,6 +437,9 @@ extern UDWORD widgRunScreen(W_SCREEN *psScreen);
  */
 extern void widgDisplayScreen(W_SCREEN *psScreen);
 
+/** Get the number of WFORM_CACHED forms drawn from their images and redrawn since the last call. */
+extern void widgGetResetCachedFormCounts(unsigned int *pReused, unsigned int *pRedrawn);
+
 
 /** Set the current audio callback function and audio id's. */
 extern void WidgSetAudio(WIDGET_AUDIOCALLBACK Callback,SWORD HilightID,SWORD ClickedID);
@@ -24,7 +24,10 @@
  */
 
 #include "lib/framework/frame.h"
+#include "lib/ivis_opengl/piedef.h"
 #include "lib/ivis_opengl/piematrix.h"
+#include "lib/ivis_opengl/piemode.h"
+#include "lib/ivis_opengl/piestate.h"
 
 #include "atmos.h"
 #include "bucket3d.h"
@@ -34,66 +37,68 @@
 #include "map.h"
 #include "miscimd.h"
 
-#include <algorithm>
-
-#define CLIP_LEFT	((SDWORD)0)
-#define CLIP_RIGHT	((SDWORD)pie_GetVideoBufferWidth())
-#define CLIP_TOP	((SDWORD)0)
-#define CLIP_BOTTOM ((SDWORD)pie_GetVideoBufferHeight())
-//scale depth = 1<<FP12_SHIFT>>STRETCHED_Z_SHIFT<<xpshift
-// Gerard - HACK Multiplied by 7 to fix clipping
-// someone needs to take a good look at the radius calculation
-#define SCALE_DEPTH (FP12_MULTIPLIER*7)
+// Components stick out of the shape the bounds are taken from, so be generous
+#define CULL_RADIUS_SCALE 2
 
 struct BUCKET_TAG
 {
-	bool operator <(BUCKET_TAG const &b) const { return actualZ > b.actualZ; }  // Sort in reverse z order.
-
 	RENDER_TYPE     objectType; //type of object held
 	void *          pObject;    //pointer to the object
 	int32_t         actualZ;
 };
 
 static std::vector<BUCKET_TAG> bucketArray;
+static std::vector<BUCKET_TAG> bucketSortBuffer;  ///< Scratch space for bucketSort()
+static unsigned bucketDrawnCount = 0, bucketCulledCount = 0;
 
-static SDWORD bucketCalculateZ(RENDER_TYPE objectType, void* pObject)
+/// Whether a sphere, in view coordinates, is at least partly on screen and in front of the fog.
+/// Uses the projection of pie_RotateProject(), so the edges are where it puts them.
+static bool bucketSphereVisible(Vector3f const &v, float radius)
 {
-	SDWORD				z = 0, radius;
-	Vector2i				pixel;
-	Vector3i				position;
-	UDWORD				droidSize;
+	const float focal = 1 << STRETCHED_Z_SHIFT;  // Distance of the screen from the eye, in pixels
+	const float left = rendSurface.xcentre, right = (float)pie_GetVideoBufferWidth() - rendSurface.xcentre;
+	const float top = rendSurface.ycentre, bottom = (float)pie_GetVideoBufferHeight() - rendSurface.ycentre;
+
+	if (v.z + radius <= 0)
+	{
+		return false;  // Behind the eye
+	}
+	if (pie_GetFogEnabled() && pie_GetFogEnd() > 0 && v.z - radius > pie_GetFogEnd())
+	{
+		return false;  // Completely fogged
+	}
+
+	// Each side of the view frustum is a plane through the eye; compare the distance of the centre from it with the radius.
+	return focal * v.x + left * v.z    >= -radius * sqrtf(focal * focal + left * left)
+	    && right * v.z - focal * v.x   >= -radius * sqrtf(focal * focal + right * right)
+	    && top * v.z - focal * v.y     >= -radius * sqrtf(focal * focal + top * top)
+	    && bottom * v.z + focal * v.y  >= -radius * sqrtf(focal * focal + bottom * bottom);
+}
+
+/// Finds where an object is relative to the camera, and the radius of a sphere around it.
+/// @param zOffset Set to how much closer the object should be sorted than its position.
+/// @return false if the object is never drawn.
+static bool bucketObjectBounds(RENDER_TYPE objectType, void *pObject, Vector3f *view, float *radius, int *zOffset)
+{
+	Vector3i			position;
 	DROID				*psDroid;
-	BODY_STATS			*psBStats;
 	SIMPLE_OBJECT		*psSimpObj;
 	COMPONENT_OBJECT	*psCompObj;
-	const iIMDShape		*pImd;
+	const iIMDShape		*pImd = NULL;
 	Spacetime               spacetime;
 
+	*zOffset = 0;
+
 	switch(objectType)
 	{
 		case RENDER_PARTICLE:
-			position.x = ((ATPART*)pObject)->position.x;
+			position.x = ((ATPART*)pObject)->position.x - player.p.x;
+			position.z = -(((ATPART*)pObject)->position.z - player.p.z);
 			position.y = ((ATPART*)pObject)->position.y;
-			position.z = ((ATPART*)pObject)->position.z;
-
-			position.x = position.x - player.p.x;
-			position.z = -(position.z - player.p.z);
- 			position.y = position.y;
+			pImd = ((ATPART*)pObject)->imd;
 
 			/* 16 below is HACK!!! */
-			z = pie_RotateProject(&position,&pixel) - 16;
-			if (z > 0)
-			{
-				//particle use the image radius
-				radius = ((ATPART*)pObject)->imd->radius;
-				radius *= SCALE_DEPTH;
-				radius /= z;
-				if ((pixel.x + radius < CLIP_LEFT) || (pixel.x - radius > CLIP_RIGHT)
-					|| (pixel.y + radius < CLIP_TOP) || (pixel.y - radius > CLIP_BOTTOM))
-				{
-					z = -1;
-				}
-			}
+			*zOffset = 16;
 			break;
 		case RENDER_PROJECTILE:
 			if(((PROJECTILE*)pObject)->psWStats->weaponSubClass == WSC_FLAME ||
@@ -101,93 +106,38 @@ static SDWORD bucketCalculateZ(RENDER_TYPE objectType, void* pObject)
                 ((PROJECTILE*)pObject)->psWStats->weaponSubClass == WSC_EMP)
 			{
 				/* We don't do projectiles from these guys, cos there's an effect instead */
-				z = -1;
+				return false;
 			}
-			else
-			{
 
-				//the weapon stats holds the reference to which graphic to use
-				pImd = ((PROJECTILE*)pObject)->psWStats->pInFlightGraphic;
-
-				psSimpObj = (SIMPLE_OBJECT*) pObject;
-				position.x = psSimpObj->pos.x - player.p.x;
-				position.z = -(psSimpObj->pos.y - player.p.z);
-
-				position.y = psSimpObj->pos.z;
-
-				z = pie_RotateProject(&position,&pixel);
-
-				if (z > 0)
-				{
-					//particle use the image radius
-					radius = pImd->radius;
-					radius *= SCALE_DEPTH;
-					radius /= z;
-					if ((pixel.x + radius < CLIP_LEFT) || (pixel.x - radius > CLIP_RIGHT)
-						|| (pixel.y + radius < CLIP_TOP) || (pixel.y - radius > CLIP_BOTTOM))
-					{
-						z = -1;
-					}
-				}
-			}
+			//the weapon stats holds the reference to which graphic to use
+			pImd = ((PROJECTILE*)pObject)->psWStats->pInFlightGraphic;
+
+			// Where it is drawn, between the last two ticks
+			spacetime = interpolateObjectSpacetime((SIMPLE_OBJECT *)pObject, graphicsTime);
+			position.x = spacetime.pos.x - player.p.x;
+			position.z = -(spacetime.pos.y - player.p.z);
+			position.y = spacetime.pos.z;
 			break;
 		case RENDER_STRUCTURE://not depth sorted
 			psSimpObj = (SIMPLE_OBJECT*) pObject;
 			position.x = psSimpObj->pos.x - player.p.x;
 			position.z = -(psSimpObj->pos.y - player.p.z);
+			position.y = psSimpObj->pos.z;
+			pImd = ((STRUCTURE*)pObject)->sDisplay.imd;
 
-			//if((objectType == RENDER_STRUCTURE) && (((STRUCTURE*)pObject)->
-			//	pStructureType->type >= REF_DEFENSE) &&
-			//	(((STRUCTURE*)pObject)->pStructureType->type<=REF_TOWER4))
-			if((objectType == RENDER_STRUCTURE) &&
-				((((STRUCTURE*)pObject)->pStructureType->type == REF_DEFENSE) ||
+			if ((((STRUCTURE*)pObject)->pStructureType->type == REF_DEFENSE) ||
 				 (((STRUCTURE*)pObject)->pStructureType->type == REF_WALL) ||
-				 (((STRUCTURE*)pObject)->pStructureType->type == REF_WALLCORNER)))
-			{
-				position.y = psSimpObj->pos.z + 64;
-				radius = ((STRUCTURE*)pObject)->sDisplay.imd->radius;//walls guntowers and tank traps clip tightly
-			}
-			else
-			{
-				position.y = psSimpObj->pos.z;
-				radius = (((STRUCTURE*)pObject)->sDisplay.imd->radius);
-			}
-
-			z = pie_RotateProject(&position,&pixel);
-
-			if (z > 0)
+				 (((STRUCTURE*)pObject)->pStructureType->type == REF_WALLCORNER))
 			{
-				//particle use the image radius
-				radius *= SCALE_DEPTH;
-				radius /= z;
-				if ((pixel.x + radius < CLIP_LEFT) || (pixel.x - radius > CLIP_RIGHT)
-					|| (pixel.y + radius < CLIP_TOP) || (pixel.y - radius > CLIP_BOTTOM))
-				{
-					z = -1;
-				}
+				position.y += 64;
 			}
 			break;
 		case RENDER_FEATURE://not depth sorted
 			psSimpObj = (SIMPLE_OBJECT*) pObject;
 			position.x = psSimpObj->pos.x - player.p.x;
 			position.z = -(psSimpObj->pos.y - player.p.z);
-
 			position.y = psSimpObj->pos.z+2;
-
-			z = pie_RotateProject(&position,&pixel);
-
-			if (z > 0)
-			{
-				//particle use the image radius
-				radius = ((FEATURE*)pObject)->sDisplay.imd->radius;
-				radius *= SCALE_DEPTH;
-				radius /= z;
-				if ((pixel.x + radius < CLIP_LEFT) || (pixel.x - radius > CLIP_RIGHT)
-					|| (pixel.y + radius < CLIP_TOP) || (pixel.y - radius > CLIP_BOTTOM))
-				{
-					z = -1;
-				}
-			}
+			pImd = ((FEATURE*)pObject)->sDisplay.imd;
 			break;
 		case RENDER_ANIMATION://not depth sorted
 			psCompObj = (COMPONENT_OBJECT *) pObject;
@@ -212,40 +162,28 @@ static SDWORD bucketCalculateZ(RENDER_TYPE objectType, void* pObject)
 			pie_MatRotZ(-psCompObj->orientation.y);
 			pie_MatRotX(-psCompObj->orientation.x);
 
-			z = pie_RotateProject(&position,&pixel);
+			*view = matrixTransform(pie_GetMatrix(), Vector3f(position));
+			*radius = -1;  // Not culled
 
 			pie_MatEnd();
 
-			break;
+			return true;
 		case RENDER_DROID:
 		case RENDER_SHADOW:
 			psDroid = (DROID*) pObject;
 
-			psSimpObj = (SIMPLE_OBJECT*) pObject;
-			position.x = psSimpObj->pos.x - player.p.x;
-			position.z = -(psSimpObj->pos.y - player.p.z);
- 			position.y = psSimpObj->pos.z;
+			// Where it is drawn, between the last two ticks
+			spacetime = interpolateObjectSpacetime(psDroid, graphicsTime);
+			position.x = spacetime.pos.x - player.p.x;
+			position.z = -(spacetime.pos.y - player.p.z);
+			position.y = spacetime.pos.z;
 			if(objectType == RENDER_SHADOW)
 			{
 				position.y+=4;
 			}
 
-			psBStats = asBodyStats + psDroid->asBits[COMP_BODY].nStat;
-			droidSize = psBStats->pIMD->radius;
-			z = pie_RotateProject(&position,&pixel) - (droidSize*2);
-
-			if (z > 0)
-			{
-				//particle use the image radius
-				radius = droidSize;
-				radius *= SCALE_DEPTH;
-				radius /= z;
-				if ((pixel.x + radius < CLIP_LEFT) || (pixel.x - radius > CLIP_RIGHT)
-					|| (pixel.y + radius < CLIP_TOP) || (pixel.y - radius > CLIP_BOTTOM))
-				{
-					z = -1;
-				}
-			}
+			pImd = asBodyStats[psDroid->asBits[COMP_BODY].nStat].pIMD;
+			*zOffset = pImd->radius * 2;
 			break;
 		case RENDER_PROXMSG:
 			if (((PROXIMITY_DISPLAY *)pObject)->type == POS_PROXDATA)
@@ -268,77 +206,113 @@ static SDWORD bucketCalculateZ(RENDER_TYPE objectType, void* pObject)
  				position.y = ((BASE_OBJECT *)((PROXIMITY_DISPLAY *)pObject)->
 					psMessage->pViewData)->pos.z;
 			}
-			z = pie_RotateProject(&position,&pixel);
-
-			if (z > 0)
-			{
-				//particle use the image radius
-				pImd = getImdFromIndex(MI_BLIP_ENEMY);//use MI_BLIP_ENEMY as all are same radius
-				radius = pImd->radius;
-				radius *= SCALE_DEPTH;
-				radius /= z;
-				if ((pixel.x + radius < CLIP_LEFT) || (pixel.x - radius > CLIP_RIGHT)
-					|| (pixel.y + radius < CLIP_TOP) || (pixel.y - radius > CLIP_BOTTOM))
-				{
-					z = -1;
-				}
-			}
+			pImd = getImdFromIndex(MI_BLIP_ENEMY);//use MI_BLIP_ENEMY as all are same radius
 			break;
 		case RENDER_EFFECT:
 			position.x = ((EFFECT*)pObject)->position.x - player.p.x;
 			position.z = -(((EFFECT*)pObject)->position.z - player.p.z);
- 			position.y = ((EFFECT*)pObject)->position.y;
+			position.y = ((EFFECT*)pObject)->position.y;
+			pImd = ((EFFECT*)pObject)->imd;
 
 			/* 16 below is HACK!!! */
-			z = pie_RotateProject(&position,&pixel) - 16;
-
-			if (z > 0)
-			{
-				//particle use the image radius
-				pImd = ((EFFECT*)pObject)->imd;
-				if (pImd != NULL)
-				{
-					radius = pImd->radius;
-					radius *= SCALE_DEPTH;
-					radius /= z;
-					if ((pixel.x + radius < CLIP_LEFT) || (pixel.x - radius > CLIP_RIGHT)
-						|| (pixel.y + radius < CLIP_TOP) || (pixel.y - radius > CLIP_BOTTOM))
-					{
-						z = -1;
-					}
-				}
-			}
-
+			*zOffset = 16;
 			break;
-
 		case RENDER_DELIVPOINT:
 			position.x = ((FLAG_POSITION *)pObject)->coords.x - player.p.x;
 			position.z = -(((FLAG_POSITION*)pObject)->
 				coords.y - player.p.z);
- 			position.y = ((FLAG_POSITION*)pObject)->coords.z;
+			position.y = ((FLAG_POSITION*)pObject)->coords.z;
+			pImd = pAssemblyPointIMDs[((FLAG_POSITION*)pObject)->factoryType][((FLAG_POSITION*)pObject)->factoryInc];
+			break;
+		default:
+			return false;
+	}
 
-			z = pie_RotateProject(&position,&pixel);
+	*view = matrixTransform(pie_GetMatrix(), Vector3f(position));
+	*radius = pImd != NULL ? pImd->sradius * CULL_RADIUS_SCALE : -1;
+	return true;
+}
 
-			if (z > 0)
-			{
-				//particle use the image radius
-				radius = pAssemblyPointIMDs[((FLAG_POSITION*)pObject)->factoryType][((FLAG_POSITION*)pObject)->factoryInc]->radius;
-				radius *= SCALE_DEPTH;
-				radius /= z;
-				if ((pixel.x + radius < CLIP_LEFT) || (pixel.x - radius > CLIP_RIGHT)
-					|| (pixel.y + radius < CLIP_TOP) || (pixel.y - radius > CLIP_BOTTOM))
-				{
-					z = -1;
-				}
-			}
+/// Culls the object, and finds the depth to sort it at
+/// @return The depth, or -1 if the object can't be seen.
+static SDWORD bucketCalculateZ(RENDER_TYPE objectType, void* pObject)
+{
+	Vector3f view;
+	float radius;
+	int zOffset;
 
-			break;
+	if (!bucketObjectBounds(objectType, pObject, &view, &radius, &zOffset)
+	    || (radius >= 0 && !bucketSphereVisible(view, radius)))
+	{
+		return -1;
+	}
 
-		default:
-		break;
+	// Same depth units as pie_RotateProject()
+	return view.z * (1 << (FP12_SHIFT - STRETCHED_Z_SHIFT)) - zOffset;
+}
+
+bool bucketObjectInView(RENDER_TYPE objectType, void *pObject)
+{
+	ASSERT(objectType != RENDER_ANIMATION, "Animations change the matrix stack, so can't be tested here");
+	return bucketCalculateZ(objectType, pObject) >= 0;
+}
+
+bool bucketObjectVisible(RENDER_TYPE objectType, void *pObject)
+{
+	if (bucketCalculateZ(objectType, pObject) < 0)
+	{
+		bucketCulledCount++;
+		return false;
 	}
+	bucketDrawnCount++;
+	return true;
+}
 
-	return z;
+void bucketCountObjects(unsigned drawn, unsigned culled)
+{
+	bucketDrawnCount += drawn;
+	bucketCulledCount += culled;
+}
+
+void bucketGetResetCounts(unsigned *pDrawn, unsigned *pCulled)
+{
+	*pDrawn = bucketDrawnCount;
+	*pCulled = bucketCulledCount;
+
+	bucketDrawnCount = 0;
+	bucketCulledCount = 0;
+}
+
+/// Sorts the bucket in reverse z order. A radix sort, since the depths are already integers,
+/// skipping the bytes all depths share, which are most of them.
+static void bucketSort(void)
+{
+	for (unsigned shift = 0; shift < 32; shift += 8)
+	{
+		unsigned count[256] = {0};
+		unsigned start[256];
+		unsigned pos = 0;
+
+		for (std::vector<BUCKET_TAG>::const_iterator tag = bucketArray.begin(); tag != bucketArray.end(); ++tag)
+		{
+			++count[(~(uint32_t)tag->actualZ >> shift) & 0xFF];  // Inverted, for reverse order
+		}
+		if (count[(~(uint32_t)bucketArray[0].actualZ >> shift) & 0xFF] == bucketArray.size())
+		{
+			continue;  // All the same
+		}
+		for (unsigned i = 0; i < 256; ++i)
+		{
+			start[i] = pos;
+			pos += count[i];
+		}
+		bucketSortBuffer.resize(bucketArray.size());
+		for (std::vector<BUCKET_TAG>::const_iterator tag = bucketArray.begin(); tag != bucketArray.end(); ++tag)
+		{
+			bucketSortBuffer[start[(~(uint32_t)tag->actualZ >> shift) & 0xFF]++] = *tag;
+		}
+		bucketArray.swap(bucketSortBuffer);
+	}
 }
 
 /* add an object to the current render list */
@@ -350,6 +324,8 @@ void bucketAddTypeToList(RENDER_TYPE objectType, void* pObject)
 
 	if (z < 0)
 	{
+		bucketCulledCount++;
+
 		/* Object will not be render - has been clipped! */
 		if(objectType == RENDER_DROID || objectType == RENDER_STRUCTURE)
 		{
@@ -359,6 +335,7 @@ void bucketAddTypeToList(RENDER_TYPE objectType, void* pObject)
 		
 		return;
 	}
+	bucketDrawnCount++;
 
 	switch(objectType)
 	{
@@ -421,13 +398,47 @@ void bucketAddTypeToList(RENDER_TYPE objectType, void* pObject)
 }
 
 
+/// Whether the object is drawn as opaque shapes only, so that it can be drawn in a batch
+static bool bucketIsBatched(RENDER_TYPE objectType)
+{
+	switch (objectType)
+	{
+		case RENDER_DROID:
+		case RENDER_STRUCTURE:
+		case RENDER_FEATURE:
+		case RENDER_ANIMATION:
+			return true;
+		default:
+			return false;
+	}
+}
+
 /* render Objects in list */
 void bucketRenderCurrentList(void)
 {
-	std::sort(bucketArray.begin(), bucketArray.end());
+	bool batching = false;
+
+	if (!bucketArray.empty())
+	{
+		bucketSort();
+	}
 
 	for (std::vector<BUCKET_TAG>::const_iterator thisTag = bucketArray.begin(); thisTag != bucketArray.end(); ++thisTag)
 	{
+		// Batch runs of objects, ending the batch before anything that has to be drawn in depth order
+		if (bucketIsBatched(thisTag->objectType) != batching)
+		{
+			batching = !batching;
+			if (batching)
+			{
+				pie_BeginShapeBatch();
+			}
+			else
+			{
+				pie_EndShapeBatch();
+			}
+		}
+
 		switch(thisTag->objectType)
 		{
 			case RENDER_PARTICLE:
@@ -462,6 +473,10 @@ void bucketRenderCurrentList(void)
 				break;
 		}
 	}
+	if (batching)
+	{
+		pie_EndShapeBatch();
+	}
 
 	//reset the bucket array as we go
 	//reset the tag array
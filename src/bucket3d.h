@@ -43,4 +43,18 @@ void bucketAddTypeToList(RENDER_TYPE objectType, void *object);
 /* render Objects in list */
 void bucketRenderCurrentList(void);
 
+/// Whether any of the object can be seen, that is it is not outside the view or beyond the fog.
+/// For objects drawn without the bucket.
+bool bucketObjectVisible(RENDER_TYPE objectType, void *pObject);
+
+/// Like bucketObjectVisible(), but without counting the object. Doesn't change anything, so it may be
+/// called from the job threads while the matrix stays the same, for all objects but animations.
+bool bucketObjectInView(RENDER_TYPE objectType, void *pObject);
+
+/// Adds to the counts of objects tested with bucketObjectInView()
+void bucketCountObjects(unsigned drawn, unsigned culled);
+
+/// Gets the number of objects drawn and culled since the last call
+void bucketGetResetCounts(unsigned *pDrawn, unsigned *pCulled);
+
 #endif // __INCLUDED_SRC_BUCKET3D_H__
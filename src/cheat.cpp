@@ -70,6 +70,8 @@ static CHEAT_ENTRY cheatCodes[] =
 	{"showfps", kf_ToggleFPS},	//displays your average FPS
 	{"showsamples", kf_ToggleSamples}, //displays the # of Sound samples in Queue & List
 	{"showorders", kf_ToggleOrders}, //displays unit order/action state.
+	{"shownetstats", kf_ToggleNetStats}, // displays per player network statistics
+	{"dumpnetstats", kf_DumpNetStats}, // writes network statistics to logs/netstats-*.csv
 	{"showlevelname", kf_ToggleLevelName}, // shows the current level name on screen
 	{"logical", kf_ToggleLogical}, //logical game updates separated from graphics updates.
 	{"pause", kf_TogglePauseMode}, // Pause the game.
@@ -95,6 +97,16 @@ bool attemptCheatCode(const char* cheat_name)
 		kf_ToggleLevelName();
 		return true;
 	}
+	else if (!strcasecmp("shownetstats", cheat_name))
+	{
+		kf_ToggleNetStats();
+		return true;
+	}
+	else if (!strcasecmp("dumpnetstats", cheat_name))
+	{
+		kf_DumpNetStats();
+		return true;
+	}
 
 	if (strcmp(cheat_name, "cheat on") == 0 || strcmp(cheat_name, "debug") == 0)
 	{
@@ -36,6 +36,7 @@
 #include "loadsave.h"
 #include "main.h"
 #include "multiplay.h"
+#include "terrain.h"
 #include "version.h"
 #include "warzoneconfig.h"
 #include "wrappers.h"
@@ -233,6 +234,7 @@ typedef enum
 	CLI_CRASH,
 	CLI_TEXTURECOMPRESSION,
 	CLI_NOTEXTURECOMPRESSION,
+	CLI_BENCHMARKTERRAIN,
 } CLI_OPTIONS;
 
 static const struct poptOption* getOptionsTable(void)
@@ -265,6 +267,7 @@ static const struct poptOption* getOptionsTable(void)
 		{ "host",       '\0', POPT_ARG_NONE,   NULL, CLI_HOSTLAUNCH, N_("go directly to host screen"),        NULL },
 		{ "texturecompression", '\0', POPT_ARG_NONE, NULL, CLI_TEXTURECOMPRESSION, N_("Enable texture compression"), NULL },
 		{ "notexturecompression", '\0', POPT_ARG_NONE, NULL, CLI_NOTEXTURECOMPRESSION, N_("Disable texture compression"), NULL },
+		{ "benchmark-terrain", '\0', POPT_ARG_NONE, NULL, CLI_BENCHMARKTERRAIN, N_("Time building and updating the terrain of each loaded map"), NULL },
 		// Terminating entry
 		{ NULL,         '\0', 0,               NULL, 0,              NULL,                                    NULL },
 	};
@@ -601,6 +604,10 @@ bool ParseCommandLine(int argc, const char** argv)
 			case CLI_NOTEXTURECOMPRESSION:
 				wz_texture_compression = GL_RGBA;
 				break;
+
+			case CLI_BENCHMARKTERRAIN:
+				terrainBenchmark = true;
+				break;
 		};
 	}
 
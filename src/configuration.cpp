@@ -30,6 +30,7 @@
 #include "lib/netplay/netplay.h"
 #include "lib/sound/mixer.h"
 #include "lib/ivis_opengl/screen.h"
+#include "lib/ivis_opengl/tex.h"
 #include "lib/framework/opengl.h"
 
 #include "advvis.h"
@@ -115,6 +116,7 @@ bool loadConfig()
 	radarDrawMode = (RADAR_DRAW_MODE)ini.value("radarTerrainMode", RADAR_MODE_DEFAULT).toInt();
 	radarDrawMode = (RADAR_DRAW_MODE)MIN(NUM_RADAR_MODES - 1, radarDrawMode); // restrict to allowed values
 	if (ini.contains("textureSize")) setTextureSize(ini.value("textureSize").toInt());
+	pie_SetLazyTexPages(ini.value("lazyTextures", false).toBool());
 	NetPlay.isUPNP = ini.value("UPnP", true).toBool();
 	if (ini.contains("FSAA")) war_setFSAA(ini.value("FSAA").toInt());
 	war_setFullscreen(ini.value("fullscreen", true).toBool());
@@ -207,6 +209,7 @@ bool saveConfig()
 	ini.setValue("trapCursor", war_GetTrapCursor());
 	ini.setValue("vsync", war_GetVsync());
 	ini.setValue("textureSize", getTextureSize());
+	ini.setValue("lazyTextures", pie_GetLazyTexPages());
 	ini.setValue("FSAA", war_getFSAA());
 	ini.setValue("UPnP", (SDWORD)NetPlay.isUPNP);
 	ini.setValue("rotateRadar", rotateRadar);
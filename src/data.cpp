@@ -27,6 +27,7 @@
 #include <physfs.h>
 
 #include "lib/framework/frame.h"
+#include "lib/framework/file.h"
 #include "lib/framework/frameresource.h"
 #include "lib/framework/strres.h"
 #include "lib/framework/crc.h"
@@ -698,27 +699,51 @@ static void dataSMSGRelease(void *pData)
 	viewDataShutDown((VIEWDATA *)pData);
 }
 
-/* Load an imd */
-static bool dataIMDBufferLoad(const char *pBuffer, UDWORD size, void **ppData)
+/* Read and parse an imd, on a loader thread */
+static bool dataIMDDecode(const char *fileName, void **ppDecoded)
 {
-	iIMDShape	*psIMD;
-	const char *pBufferPosition = pBuffer;
+	char *pBuffer;
+	UDWORD size;
+	const char *pBufferPosition;
 
-	psIMD = iV_ProcessIMD( &pBufferPosition, pBufferPosition + size );
-	if (psIMD == NULL) {
-		debug( LOG_ERROR, "IMD load failed - %s", GetLastResourceFilename() );
+	if (!loadFile(fileName, &pBuffer, &size))
+	{
+		return false;
+	}
+
+	pBufferPosition = pBuffer;
+	*ppDecoded = iV_DecodeIMD(&pBufferPosition, pBuffer + size, fileName);
+	free(pBuffer);
+	if (*ppDecoded == NULL)
+	{
+		debug(LOG_ERROR, "IMD load failed - %s", fileName);
 		return false;
 	}
 
-	*ppData = psIMD;
 	return true;
 }
 
+/* Load an imd */
+static bool dataIMDLoad(WZ_DECL_UNUSED const char *fileName, void *pDecoded, void **ppData)
+{
+	*ppData = iV_FinishIMD((iIMDDecoded *)pDecoded, GetLastResourceFilename());
+	return *ppData != NULL;
+}
+
+
+/*!
+ * Release a decoded image which was never loaded
+ */
+static void dataImageDecodedRelease(void *pDecoded)
+{
+	iV_unloadImage((iV_Image *)pDecoded);
+	free(pDecoded);
+}
 
 /*!
- * Load an image from file
+ * Decode an image from file, on a loader thread
  */
-static bool dataImageLoad(const char *fileName, void **ppData)
+static bool dataImageDecode(const char *fileName, void **ppDecoded)
 {
 	iV_Image *psSprite = (iV_Image *)malloc(sizeof(iV_Image));
 	if (!psSprite)
@@ -729,14 +754,61 @@ static bool dataImageLoad(const char *fileName, void **ppData)
 	if (!iV_loadImage_PNG(fileName, psSprite))
 	{
 		debug( LOG_ERROR, "IMGPAGE load failed" );
+		free(psSprite);
 		return false;
 	}
 
-	*ppData = psSprite;
+	*ppDecoded = psSprite;
 
 	return true;
 }
 
+/*!
+ * Load a decoded image
+ */
+static bool dataImageLoad(WZ_DECL_UNUSED const char *fileName, void *pDecoded, void **ppData)
+{
+	*ppData = pDecoded;
+
+	return true;
+}
+
+
+/*!
+ * Decode a texture page, on a loader thread, unless it will only be loaded when first used.
+ * Pages loaded on first use are left as an empty image.
+ */
+static bool dataTexPageDecodeOrDefer(const char *fileName, void **ppDecoded, bool tcmask)
+{
+	char texpage[PATH_MAX];
+	const char *baseName = strrchr(fileName, '/');
+
+	// Work out the page name like dataTexPageLoad, without GetLastResourceFilename, which belongs to the main thread
+	sstrcpy(texpage, baseName != NULL ? baseName + 1 : fileName);
+	pie_MakeTexPageName(texpage);
+	if (tcmask)
+	{
+		pie_MakeTexPageTCMaskName(texpage);
+	}
+
+	if (pie_TexPageIsLazy(texpage))
+	{
+		*ppDecoded = calloc(1, sizeof(iV_Image));
+		return *ppDecoded != NULL;
+	}
+	return dataImageDecode(fileName, ppDecoded);
+}
+
+static bool dataTexPageDecode(const char *fileName, void **ppDecoded)
+{
+	return dataTexPageDecodeOrDefer(fileName, ppDecoded, false);
+}
+
+static bool dataTexPageTCMaskDecode(const char *fileName, void **ppDecoded)
+{
+	return dataTexPageDecodeOrDefer(fileName, ppDecoded, true);
+}
+
 
 // Tertiles (terrain tiles) loader.
 static bool dataTERTILESLoad(const char *fileName, void **ppData)
@@ -775,8 +847,8 @@ static void dataIMGRelease(void *pData)
 }
 
 
-/* Load a texturepage into memory */
-static bool dataTexPageLoad(const char *fileName, void **ppData)
+/* Load a decoded texturepage into memory */
+static bool dataTexPageLoad(const char *fileName, void *pDecoded, void **ppData)
 {
 	char texpage[PATH_MAX] = {'\0'};
 
@@ -784,13 +856,20 @@ static bool dataTexPageLoad(const char *fileName, void **ppData)
 	sstrcpy(texpage, GetLastResourceFilename());
 
 	pie_MakeTexPageName(texpage);
-	if (!dataImageLoad(fileName, ppData))
+	*ppData = pDecoded;
+
+	if (((iV_Image *)*ppData)->bmp == NULL)
 	{
-		return false;
+		// not decoded, load it when it is first drawn (also replaces any old page)
+		debug(LOG_TEXTURE, "adding page %s with texture %s, to load on first use", texpage, fileName);
+		if (!resPresent(DT_TEXPAGE, texpage))
+		{
+			SetLastResourceFilename(texpage);
+		}
+		pie_AddLazyTexPage(fileName, texpage, getTextureSize(), true);
 	}
-
 	// see if this texture page has already been loaded
-	if (resPresent(DT_TEXPAGE, texpage))
+	else if (resPresent(DT_TEXPAGE, texpage))
 	{
 		// replace the old texture page with the new one
 		debug(LOG_TEXTURE, "replacing %s with new texture %s", texpage, fileName);
@@ -806,8 +885,8 @@ static bool dataTexPageLoad(const char *fileName, void **ppData)
 	return true;
 }
 
-/* Load a team colour mask texturepage into memory */
-static bool dataTexPageTCMaskLoad(const char *fileName, void **ppData)
+/* Load a decoded team colour mask texturepage into memory */
+static bool dataTexPageTCMaskLoad(const char *fileName, void *pDecoded, void **ppData)
 {
 	char texpage[PATH_MAX] = {'\0'};
 
@@ -816,17 +895,28 @@ static bool dataTexPageTCMaskLoad(const char *fileName, void **ppData)
 
 	// Check if a corresponding texpage exists, exit if no
 	pie_MakeTexPageName(texpage);
-	ASSERT_OR_RETURN(false, resPresent(DT_TEXPAGE, texpage), "Corresponding texpage %s doesn't exists!", texpage);
-
-	pie_MakeTexPageTCMaskName(texpage);
-		
-	if (!dataImageLoad(fileName, ppData))
+	if (!resPresent(DT_TEXPAGE, texpage))
 	{
+		dataImageDecodedRelease(pDecoded);
+		ASSERT(false, "Corresponding texpage %s doesn't exists!", texpage);
 		return false;
 	}
 
+	pie_MakeTexPageTCMaskName(texpage);
+	*ppData = pDecoded;
+
+	if (((iV_Image *)*ppData)->bmp == NULL)
+	{
+		// not decoded, load it when it is first drawn (also replaces any old mask)
+		debug(LOG_TEXTURE, "adding page %s with tcmask %s, to load on first use", texpage, fileName);
+		if (!resPresent(DT_TCMASK, texpage))
+		{
+			SetLastResourceFilename(texpage);
+		}
+		pie_AddLazyTexPage(fileName, texpage, getTextureSize(), false);
+	}
 	// see if this texture page has already been loaded
-	if (resPresent(DT_TCMASK, texpage))
+	else if (resPresent(DT_TCMASK, texpage))
 	{
 		// replace the old texture page with the new one
 		debug(LOG_TEXTURE, "replacing %s with new tcmask %s", texpage, fileName);
@@ -856,18 +946,31 @@ static void dataImageRelease(void *pData)
 }
 
 
-/* Load an audio file */
-static bool dataAudioLoad(const char* fileName, void **ppData)
+/* Decode an audio file, on a loader thread */
+static bool dataAudioDecode(const char* fileName, void **ppDecoded)
 {
 	if ( audio_Disabled() == true )
 	{
-		*ppData = NULL;
+		*ppDecoded = NULL;
 		// No error occurred (sound is just disabled), so we return true
 		return true;
 	}
 
-	// Load the track from a file
-	*ppData = sound_LoadTrackFromFile( fileName );
+	*ppDecoded = sound_DecodeTrackFromFile( fileName );
+
+	return *ppDecoded != NULL;
+}
+
+/* Load a decoded audio file */
+static bool dataAudioLoad(WZ_DECL_UNUSED const char* fileName, void *pDecoded, void **ppData)
+{
+	if ( audio_Disabled() == true )
+	{
+		*ppData = NULL;
+		return true;
+	}
+
+	*ppData = sound_LoadTrackFromDecoded((soundDataBuffer *)pDecoded);
 
 	return *ppData != NULL;
 }
@@ -1132,7 +1235,6 @@ static const RES_TYPE_MIN_BUF BufferResourceTypes[] =
 	{"RSTRRES", bufferRSTRRESLoad, NULL},
 	{"RFUNC", bufferRFUNCLoad, NULL},
 	{"SMSG", bufferSMSGLoad, dataSMSGRelease},
-	{"IMD", dataIMDBufferLoad, (RES_FREE)iV_IMDRelease},
 };
 
 struct RES_TYPE_MIN_FILE
@@ -1144,15 +1246,11 @@ struct RES_TYPE_MIN_FILE
 
 static const RES_TYPE_MIN_FILE FileResourceTypes[] =
 {
-	{"WAV", dataAudioLoad, (RES_FREE)sound_ReleaseTrack},
 	{"AUDIOCFG", dataAudioCfgLoad, NULL},
 	{"ANI", dataAnimLoad, dataAnimRelease},
 	{"ANIMCFG", dataAnimCfgLoad, NULL},
-	{"IMGPAGE", dataImageLoad, dataImageRelease},
 	{"TERTILES", dataTERTILESLoad, dataTERTILESRelease},
 	{"IMG", dataIMGLoad, dataIMGRelease},
-	{DT_TEXPAGE, dataTexPageLoad, dataImageRelease},
-	{DT_TCMASK, dataTexPageTCMaskLoad, dataImageRelease},
 	{"SCRIPT", dataScriptLoad, dataScriptRelease},
 	{"SCRIPTVAL", dataScriptLoadVals, NULL},
 	{"STR_RES", dataStrResLoad, dataStrResRelease},
@@ -1160,6 +1258,24 @@ static const RES_TYPE_MIN_FILE FileResourceTypes[] =
 	{"JAVASCRIPT", jsLoad, NULL},
 };
 
+struct RES_TYPE_MIN_DECODE
+{
+	const char *aType;                      ///< points to the string defining the type (e.g. SCRIPT) - NULL indicates end of list
+	RES_FILEDECODE decode;                  ///< routine to read and decode the file on a loader thread
+	RES_DECODEDLOAD decodedLoad;            ///< routine to process the decoded data for this type
+	RES_FREE decodedRelease;                ///< routine to release decoded data that was never processed
+	RES_FREE release;                       ///< routine to release the data (NULL indicates none)
+};
+
+static const RES_TYPE_MIN_DECODE DecodeResourceTypes[] =
+{
+	{"IMD", dataIMDDecode, dataIMDLoad, (RES_FREE)iV_FreeDecodedIMD, (RES_FREE)iV_IMDRelease},
+	{"WAV", dataAudioDecode, dataAudioLoad, free, (RES_FREE)sound_ReleaseTrack},
+	{"IMGPAGE", dataImageDecode, dataImageLoad, dataImageDecodedRelease, dataImageRelease},
+	{DT_TEXPAGE, dataTexPageDecode, dataTexPageLoad, dataImageDecodedRelease, dataImageRelease},
+	{DT_TCMASK, dataTexPageTCMaskDecode, dataTexPageTCMaskLoad, dataImageDecodedRelease, dataImageRelease},
+};
+
 /* Pass all the data loading functions to the framework library */
 bool dataInitLoadFuncs(void)
 {
@@ -1198,5 +1314,20 @@ bool dataInitLoadFuncs(void)
 		}
 	}
 
+	// iterate through decode load functions
+	{
+		const RES_TYPE_MIN_DECODE *CurrentType;
+		// Points just past the last item in the list
+		const RES_TYPE_MIN_DECODE * const EndType = &DecodeResourceTypes[sizeof(DecodeResourceTypes) / sizeof(RES_TYPE_MIN_DECODE)];
+
+		for (CurrentType = DecodeResourceTypes; CurrentType != EndType; ++CurrentType)
+		{
+			if (!resAddDecodeLoad(CurrentType->aType, CurrentType->decode, CurrentType->decodedLoad, CurrentType->decodedRelease, CurrentType->release))
+			{
+				return false; // error whilst adding a decode load
+			}
+		}
+	}
+
 	return true;
 }
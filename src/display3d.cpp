@@ -28,6 +28,7 @@
 #include "lib/framework/opengl.h"
 #include "lib/framework/math_ext.h"
 #include "lib/framework/stdio_ext.h"
+#include "lib/framework/wzjobs.h"
 
 /* Includes direct access to render library */
 #include "lib/ivis_opengl/pieblitfunc.h"
@@ -128,6 +129,7 @@ static void	drawDroidSensorLock(DROID *psDroid);
 static void	calcAverageTerrainHeight(iView *player);
 bool	doWeDrawProximitys(void);
 static PIELIGHT getBlueprintColour(STRUCT_STATES state);
+static void displayNetStats(void);
 
 static void NetworkDisplayPlainForm(WIDGET *psWidget, UDWORD xOffset, UDWORD yOffset, WZ_DECL_UNUSED PIELIGHT *pColours);
 static void NetworkDisplayImage(WIDGET *psWidget, UDWORD xOffset, UDWORD yOffset, WZ_DECL_UNUSED PIELIGHT *pColours);
@@ -212,6 +214,10 @@ bool showFPS = false;       //
  * default OFF, turn ON via console command 'showsamples'
  */
 bool showSAMPLES = false;
+/** Show per player network statistics
+ * default OFF, turn ON via console command 'shownetstats'
+ */
+bool showNETSTATS = false;
 /**  Show the current selected units order / action
  *  default OFF, turn ON via console command 'showorders'
  */
@@ -643,6 +649,51 @@ static void setupConnectionStatusForm(void)
 	}
 }
 
+/// Shows the network statistics of each connected player, and which message types use the most bandwidth.
+static void displayNetStats()
+{
+	char buf[255];
+	unsigned height = iV_GetTextLineSize();
+	unsigned y = height + 20;
+
+	for (unsigned player = 0; player < MAX_CONNECTED_PLAYERS; ++player)
+	{
+		if (!NetPlay.players[player].allocated || player == selectedPlayer)
+		{
+			continue;
+		}
+		uint32_t sent = NETgetPlayerStats(player, false).bytes, received = NETgetPlayerStats(player, true).bytes;
+		ssprintf(buf, "%u %.12s: ping %ums, queue %ub, flush %ums, sent %ukB, received %ukB", player, getPlayerName(player), ingame.PingTimes[player],
+		         NETgetSendQueueDepth(player), NETgetFlushLatency(player), sent/1024, received/1024);
+		iV_DrawText(buf, 10, y);
+		y += height;
+	}
+
+	// Find the message types using the most bandwidth.
+	unsigned topTypes[3] = {0, 0, 0};
+	uint32_t topBytes[3] = {0, 0, 0};
+	for (unsigned type = 0; type < 256; ++type)
+	{
+		unsigned t = type;
+		uint32_t bytes = NETgetTypeStats(NET_ALL_PLAYERS, false, t).bytes + NETgetTypeStats(NET_ALL_PLAYERS, true, t).bytes;
+		for (unsigned n = 0; n < ARRAY_SIZE(topTypes); ++n)
+		{
+			if (bytes > topBytes[n])
+			{
+				std::swap(bytes, topBytes[n]);
+				std::swap(t, topTypes[n]);
+			}
+		}
+	}
+	for (unsigned n = 0; n < ARRAY_SIZE(topTypes) && topBytes[n] != 0; ++n)
+	{
+		NETTYPESTATS stats = NETgetTypeStats(NET_ALL_PLAYERS, false, topTypes[n]);
+		ssprintf(buf, "%s: %ukB, %u sent, %uus", messageTypeToString(topTypes[n]), topBytes[n]/1024, stats.count, unsigned(stats.usecs));
+		iV_DrawText(buf, 10, y);
+		y += height;
+	}
+}
+
 /// Render the 3D world
 void draw3DScene( void )
 {
@@ -745,6 +796,10 @@ void draw3DScene( void )
 		iV_DrawText(Lbuf, pie_GetVideoBufferWidth() - width, height + 48);
 		iV_DrawText(Abuf, pie_GetVideoBufferWidth() - width, height + 59);
 	}
+	if (showNETSTATS)
+	{
+		displayNetStats();
+	}
 	if (showFPS)
 	{
 		unsigned int width, height;
@@ -914,11 +969,37 @@ static void calcAverageTerrainHeight(iView *player)
 	}
 }
 
+/// Projects the corners of one row of the visible tiles, and updates their colours. Run on the job threads.
+static void projectTileRow(void *, unsigned idx)
+{
+	const int i = idx - visibleTiles.y/2;
+
+	/* Go through the x's */
+	for (int j = -visibleTiles.x/2, jdx = 0; j <= visibleTiles.x/2; j++, ++jdx)
+	{
+		Vector2i screen(0, 0);
+		Position pos;
+
+		pos.x = world_coord(j);
+		pos.z = -world_coord(i);
+		pos.y = 0;
+
+		if (tileOnMap(playerXTile + j, playerZTile + i))
+		{
+			MAPTILE *psTile = mapTile(playerXTile + j, playerZTile + i);
+
+			pos.y = map_TileHeight(playerXTile + j, playerZTile + i);
+			setTileColour(playerXTile + j, playerZTile + i, pal_SetBrightness(psTile->level));
+		}
+		tileScreenInfo[idx][jdx].z = pie_RotateProject(&pos, &screen);
+		tileScreenInfo[idx][jdx].x = screen.x;
+		tileScreenInfo[idx][jdx].y = screen.y;
+	}
+}
+
 /// Draw the terrain and all droids, missiles and other objects on it
 static void drawTiles(iView *player)
 {
-	int i, j;
-	int idx, jdx;
 	Vector3f theSun;
 
 	/* ---------------------------------------------------------------- */
@@ -956,30 +1037,7 @@ static void drawTiles(iView *player)
 	pie_BeginLighting(&theSun, getDrawShadows());
 
 	// update the fog of war... FIXME: Remove this
-	for (i = -visibleTiles.y/2, idx=0; i <= visibleTiles.y/2; i++,++idx)
-	{
-		/* Go through the x's */
-		for (j = -visibleTiles.x/2, jdx=0; j <= visibleTiles.x/2; j++,++jdx)
-		{
-			Vector2i screen(0, 0);
-			Position pos;
-
-			pos.x = world_coord(j);
-			pos.z = -world_coord(i);
-			pos.y = 0;
-
-			if (tileOnMap(playerXTile + j, playerZTile + i))
-			{
-				MAPTILE *psTile = mapTile(playerXTile + j, playerZTile + i);
-
-				pos.y = map_TileHeight(playerXTile + j, playerZTile + i);
-				setTileColour(playerXTile + j, playerZTile + i, pal_SetBrightness(psTile->level));
-			}
-			tileScreenInfo[idx][jdx].z = pie_RotateProject(&pos, &screen);
-			tileScreenInfo[idx][jdx].x = screen.x;
-			tileScreenInfo[idx][jdx].y = screen.y;
-		}
-	}
+	wzParallelFor(visibleTiles.y/2*2 + 1, projectTileRow, NULL);
 
 	/* This is done here as effects can light the terrain - pause mode problems though */
 	processEffects();
@@ -1011,8 +1069,10 @@ static void drawTiles(iView *player)
 	/* Now display all the static objects                               */
 	/* ---------------------------------------------------------------- */
 	displayStaticObjects(); // bucket render implemented
+	pie_BeginShapeBatch();
 	displayFeatures(); // bucket render implemented
 	displayDynamicObjects(); //bucket render implemented
+	pie_EndShapeBatch();
 	if(doWeDrawProximitys())
 	{
 		displayProximityMsgs(); // bucket render implemented
@@ -1102,6 +1162,10 @@ bool init3DView(void)
 	{
 		return false;
 	}
+	if (terrainBenchmark && !benchmarkTerrain())
+	{
+		return false;
+	}
 
 	return true;
 }
@@ -1394,25 +1458,38 @@ void	renderAnimComponent( const COMPONENT_OBJECT *psObj )
 	}
 }
 
+/// Objects that passed clipXY(), and whether each of them is in view, tested on the job threads
+static std::vector<void *> candidateObjects;
+static std::vector<uint8_t> candidateInView;  ///< Not vector<bool>, so that each thread only writes its own bytes
+
+static void testCandidateInView(void *data, unsigned i)
+{
+	candidateInView[i] = bucketObjectInView(*(RENDER_TYPE *)data, candidateObjects[i]);
+}
+
+/// Finds which of candidateObjects are in view, sharing the work between the job threads
+static void testCandidatesInView(RENDER_TYPE type)
+{
+	candidateInView.resize(candidateObjects.size());
+	wzParallelFor(candidateObjects.size(), testCandidateInView, &type);
+}
+
 /// Draw the buildings
 void displayStaticObjects( void )
 {
 	STRUCTURE	*psStructure;
 	UDWORD		clan;
-	UDWORD		test = 0;
 	ANIM_OBJECT	*psAnimObj;
-
-	// to solve the flickering edges of baseplates
-	pie_SetDepthOffset(-1.0f);
+	unsigned	drawn = 0, culled = 0;
 
 	/* Go through all the players */
+	candidateObjects.clear();
 	for (clan = 0; clan < MAX_PLAYERS; clan++)
 	{
 		/* Now go all buildings for that player */
 		for(psStructure = apsStructLists[clan]; psStructure != NULL;
 			psStructure = psStructure->psNext)
 		{
-			test++;
 			/* Worth rendering the structure? */
 			if(clipXY(psStructure->pos.x,psStructure->pos.y))
 			{
@@ -1422,47 +1499,68 @@ void displayStaticObjects( void )
 				{
 					psStructure->psCurAnim = animObj_Add( psStructure, ID_ANIM_DERIK, 0, 0 );
 				}
+				candidateObjects.push_back(psStructure);
+			}
+		}
+	}
+	testCandidatesInView(RENDER_STRUCTURE);
 
-				if ( psStructure->psCurAnim == NULL ||
-						psStructure->psCurAnim->bVisible == false ||
-						(psAnimObj = animObj_Find( psStructure,
-						psStructure->psCurAnim->uwID )) == NULL )
+	// to solve the flickering edges of baseplates
+	pie_SetDepthOffset(-1.0f);
+	pie_BeginShapeBatch();
+
+	for (unsigned i = 0; i < candidateObjects.size(); ++i)
+	{
+		psStructure = (STRUCTURE *)candidateObjects[i];
+
+		if ( psStructure->psCurAnim == NULL ||
+				psStructure->psCurAnim->bVisible == false ||
+				(psAnimObj = animObj_Find( psStructure,
+				psStructure->psCurAnim->uwID )) == NULL )
+		{
+			if (candidateInView[i])
+			{
+				drawn++;
+				renderStructure(psStructure);
+			}
+			else
+			{
+				culled++;
+			}
+		}
+		else
+		{
+			if ( psStructure->visible[selectedPlayer] )
+			{
+				//check not a resource extractors
+				if (psStructure->pStructureType->type !=
+					REF_RESOURCE_EXTRACTOR)
 				{
-					renderStructure(psStructure);
+					displayAnimation( psAnimObj, false );
 				}
-				else
+				//check that a power gen exists before animationg res extrac
+				//else if (getPowerGenExists(psStructure->player))
+				/*check the building is active*/
+				else if (psStructure->pFunctionality->resourceExtractor.active)
 				{
-					if ( psStructure->visible[selectedPlayer] )
+					displayAnimation( psAnimObj, false );
+					if(selectedPlayer == psStructure->player)
 					{
-						//check not a resource extractors
-						if (psStructure->pStructureType->type !=
-							REF_RESOURCE_EXTRACTOR)
-						{
-							displayAnimation( psAnimObj, false );
-						}
-						//check that a power gen exists before animationg res extrac
-						//else if (getPowerGenExists(psStructure->player))
-						/*check the building is active*/
-						else if (psStructure->pFunctionality->resourceExtractor.active)
-						{
-							displayAnimation( psAnimObj, false );
-							if(selectedPlayer == psStructure->player)
-							{
-								audio_PlayObjStaticTrack(psStructure, ID_SOUND_OIL_PUMP_2);
-							}
-						}
-						else
-						{
-							/* hold anim on first frame */
-							displayAnimation( psAnimObj, true );
-							audio_StopObjTrack(psStructure, ID_SOUND_OIL_PUMP_2);
-						}
-
+						audio_PlayObjStaticTrack(psStructure, ID_SOUND_OIL_PUMP_2);
 					}
 				}
+				else
+				{
+					/* hold anim on first frame */
+					displayAnimation( psAnimObj, true );
+					audio_StopObjTrack(psStructure, ID_SOUND_OIL_PUMP_2);
+				}
+
 			}
 		}
 	}
+	bucketCountObjects(drawn, culled);
+	pie_EndShapeBatch();  // Before the depth offset goes
 	pie_SetDepthOffset(0.0f);
 }
 
@@ -1669,20 +1767,37 @@ void displayFeatures( void )
 {
 	FEATURE	*psFeature;
 	UDWORD		clan;
+	unsigned	drawn = 0, culled = 0;
 
 		/* player can only be 0 for the features */
 		clan = 0;
 
 		/* Go through all the features */
+		candidateObjects.clear();
 		for(psFeature = apsFeatureLists[clan]; psFeature != NULL;
 			psFeature = psFeature->psNext)
 		{
 			/* Is the feature worth rendering? */
-			if(clipXY(psFeature->pos.x,psFeature->pos.y))
+			if (clipXY(psFeature->pos.x, psFeature->pos.y))
 			{
-				renderFeature(psFeature);
+				candidateObjects.push_back(psFeature);
 			}
 		}
+		testCandidatesInView(RENDER_FEATURE);
+
+		for (unsigned i = 0; i < candidateObjects.size(); ++i)
+		{
+			if (candidateInView[i])
+			{
+				drawn++;
+				renderFeature((FEATURE *)candidateObjects[i]);
+			}
+			else
+			{
+				culled++;
+			}
+		}
+		bucketCountObjects(drawn, culled);
 }
 
 /// Draw the Proximity messages for the *SELECTED PLAYER ONLY*
@@ -1771,43 +1886,58 @@ void displayDynamicObjects( void )
 	DROID		*psDroid;
 	ANIM_OBJECT	*psAnimObj;
 	UDWORD		clan;
+	unsigned	drawn = 0, culled = 0;
 
 	/* Need to go through all the droid lists */
+	candidateObjects.clear();
 	for(clan = 0; clan < MAX_PLAYERS; clan++)
 	{
 		for(psDroid = apsDroidLists[clan]; psDroid != NULL;
 			psDroid = psDroid->psNext)
 		{
 			/* Find out whether the droid is worth rendering */
-				if(clipXY(psDroid->pos.x,psDroid->pos.y))
-				{
-					/* No point in adding it if you can't see it? */
-					if(psDroid->visible[selectedPlayer] || demoGetStatus())
-					{
-						psDroid->sDisplay.frameNumber = currentGameFrame;
+			/* No point in adding it if you can't see it? */
+			if (clipXY(psDroid->pos.x, psDroid->pos.y) && (psDroid->visible[selectedPlayer] || demoGetStatus()))
+			{
+				candidateObjects.push_back(psDroid);
+			}
+		}
+	}
+	testCandidatesInView(RENDER_DROID);
 
-						// NOTE! : anything that has multiple (anim) frames *must* use the bucket to render
-						// In this case, AFAICT only DROID_CYBORG_SUPER had the issue.  (Same issue as oil pump anim)
-						if (psDroid->droidType != DROID_CYBORG_SUPER)
-						{
-							renderDroid(psDroid);
-						}
-						else
-						{
-							bucketAddTypeToList(RENDER_DROID, psDroid);
-						}
-						/* draw anim if visible */
-						if ( psDroid->psCurAnim != NULL &&
-							psDroid->psCurAnim->bVisible == true &&
-							(psAnimObj = animObj_Find( psDroid,
-							psDroid->psCurAnim->uwID )) != NULL )
-						{
-							displayAnimation( psAnimObj, false );
-						}
-					}
-				} // end clipDroid
-		} // end for
-	} // end for clan
+	for (unsigned i = 0; i < candidateObjects.size(); ++i)
+	{
+		psDroid = (DROID *)candidateObjects[i];
+
+		// NOTE! : anything that has multiple (anim) frames *must* use the bucket to render
+		// In this case, AFAICT only DROID_CYBORG_SUPER had the issue.  (Same issue as oil pump anim)
+		if (psDroid->droidType == DROID_CYBORG_SUPER)
+		{
+			psDroid->sDisplay.frameNumber = currentGameFrame;
+			bucketAddTypeToList(RENDER_DROID, psDroid);  // Culled and counted by the bucket
+		}
+		else if (candidateInView[i])
+		{
+			psDroid->sDisplay.frameNumber = currentGameFrame;
+			drawn++;
+			renderDroid(psDroid);
+		}
+		else
+		{
+			culled++;
+			continue;  // Wholly off screen, so its animation is too
+		}
+
+		/* draw anim if visible */
+		if ( psDroid->psCurAnim != NULL &&
+			psDroid->psCurAnim->bVisible == true &&
+			(psAnimObj = animObj_Find( psDroid,
+			psDroid->psCurAnim->uwID )) != NULL )
+		{
+			displayAnimation( psAnimObj, false );
+		}
+	}
+	bucketCountObjects(drawn, culled);
 } // end Fn
 
 /// Sets the player's position and view angle - defaults player rotations as well
@@ -2618,23 +2748,24 @@ static bool	renderWallSection(STRUCTURE *psStructure)
 void renderShadow( DROID *psDroid, iIMDShape *psShadowIMD )
 {
 	Vector3i dv;
+	Spacetime st = interpolateObjectSpacetime(psDroid, graphicsTime);  // Follow the droid as drawn
 
-	dv.x = psDroid->pos.x - player.p.x;
+	dv.x = st.pos.x - player.p.x;
 	if(psDroid->droidType == DROID_TRANSPORTER)
 	{
 		dv.x -= bobTransporterHeight()/2;
 	}
-	dv.z = -(psDroid->pos.y - player.p.z);
-	dv.y = map_Height(psDroid->pos.x, psDroid->pos.y);
+	dv.z = -(st.pos.y - player.p.z);
+	dv.y = map_Height(st.pos.x, st.pos.y);
 
 	/* Push the indentity matrix */
 	pie_MatBegin();
 
 	pie_TRANSLATE(dv.x,dv.y,dv.z);
 
-	pie_MatRotY(-psDroid->rot.direction);
-	pie_MatRotX(psDroid->rot.pitch);
-	pie_MatRotZ(psDroid->rot.roll);
+	pie_MatRotY(-st.rot.direction);
+	pie_MatRotX(st.rot.pitch);
+	pie_MatRotZ(st.rot.roll);
 
 	pie_Draw3DShape(psShadowIMD, 0, 0, WZCOL_WHITE, pie_TRANSLUCENT, 128);
 
@@ -4230,9 +4361,10 @@ static void addConstructionLine(DROID *psDroid, STRUCTURE *psStructure)
 	PIELIGHT colour;
 
 	null.x = null.y = null.z = 0;
-	each.x = psDroid->pos.x;
-	each.z = psDroid->pos.y;
-	each.y = psDroid->pos.z + 24;
+	Spacetime st = interpolateObjectSpacetime(psDroid, graphicsTime);  // From the droid as drawn
+	each.x = st.pos.x;
+	each.z = st.pos.y;
+	each.y = st.pos.z + 24;
 
 	vec.x = each.x - player.p.x;
 	vec.z = -(each.z - player.p.z);
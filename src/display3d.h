@@ -50,6 +50,7 @@ enum ENERGY_BAR
 
 extern bool showFPS;
 extern bool showSAMPLES;
+extern bool showNETSTATS;
 extern bool showORDERS;
 extern bool showLevelName;
 
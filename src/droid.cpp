@@ -95,6 +95,7 @@ extern DROID_TEMPLATE	sDefaultDesignTemplate;
 // Template storage
 DROID_TEMPLATE		*apsDroidTemplates[MAX_PLAYERS];
 DROID_TEMPLATE		*apsStaticTemplates;	// for AIs and scripts
+static std::vector<DROID_TEMPLATE *> staticTemplateIndex;	///< apsStaticTemplates by their STATS_INDEX_TEMPLATE index
 
 // store the experience of recently recycled droids
 UWORD	aDroidExperience[MAX_PLAYERS][MAX_RECYCLED_DROIDS];
@@ -1556,6 +1557,21 @@ DROID_TEMPLATE::DROID_TEMPLATE(LineView line)
 	std::fill_n(asWeaps, DROID_MAXWEAPS, 0);
 }
 
+/// Add the head of apsStaticTemplates to the name index. Later templates come first in the list, so they replace earlier ones.
+static void indexStaticTemplate(DROID_TEMPLATE *psTempl)
+{
+	char const *rName = psTempl->pName ? psTempl->pName : psTempl->aName;
+	int index = statsIndexFind(STATS_INDEX_TEMPLATE, rName);
+
+	if (index >= 0)
+	{
+		staticTemplateIndex[index] = psTempl;
+		return;
+	}
+	statsIndexAdd(STATS_INDEX_TEMPLATE, rName, staticTemplateIndex.size());
+	staticTemplateIndex.push_back(psTempl);
+}
+
 /* load the Droid stats for the components from the Access database */
 bool loadDroidTemplates(const char *pDroidData, UDWORD bufferSize)
 {
@@ -1624,6 +1640,7 @@ bool loadDroidTemplates(const char *pDroidData, UDWORD bufferSize)
 			// Add all templates to static template list
 			design.prefab = true;  // prefabricated templates referenced from VLOs
 			addTemplateToList(&design, &apsStaticTemplates);
+			indexStaticTemplate(apsStaticTemplates);
 		}
 
 		debug(LOG_NEVER, "(default) Droid template found, aName: %s, MP ID: %d, ref: %u, pname: %s, prefab: %s, type:%d (loading)",
@@ -1861,6 +1878,8 @@ bool droidTemplateShutDown(void)
 		delete pTemplate;
 	}
 	apsStaticTemplates = NULL;
+	staticTemplateIndex.clear();
+	statsIndexClear(STATS_INDEX_TEMPLATE);
 	free(sDefaultDesignTemplate.pName);
 	sDefaultDesignTemplate.pName = NULL;
 
@@ -2910,14 +2929,15 @@ DROID_TEMPLATE *GetAIDroidTemplate(const char *aName)
 DROID_TEMPLATE * getTemplateFromUniqueName(const char *pName, unsigned int player)
 {
 	DROID_TEMPLATE *psCurr;
-	DROID_TEMPLATE *list = apsStaticTemplates;	// assume AI
 
-	if (isHumanPlayer(player))
+	if (!isHumanPlayer(player))
 	{
-		list = apsDroidTemplates[player];	// was human
+		// AI, so the template is a static one
+		int index = statsIndexFind(STATS_INDEX_TEMPLATE, pName);
+		return index >= 0 ? staticTemplateIndex[index] : NULL;
 	}
-	
-	for (psCurr = list; psCurr != NULL; psCurr = psCurr->psNext)
+
+	for (psCurr = apsDroidTemplates[player]; psCurr != NULL; psCurr = psCurr->psNext)
 	{
 		if (strcmp(psCurr->pName, pName) == 0)
 		{
@@ -2936,19 +2956,9 @@ DROID_TEMPLATE * getTemplateFromUniqueName(const char *pName, unsigned int playe
  */
 DROID_TEMPLATE *getTemplateFromTranslatedNameNoPlayer(char const *pName)
 {
-	const char *rName;
-	DROID_TEMPLATE *psCurr;
-
-	for (psCurr = apsStaticTemplates; psCurr != NULL; psCurr = psCurr->psNext)
-	{
-		rName = psCurr->pName ? psCurr->pName : psCurr->aName;
-		if (strcmp(rName, pName) == 0)
-		{
-			return psCurr;
-		}
-	}
+	int index = statsIndexFind(STATS_INDEX_TEMPLATE, pName);
 
-	return NULL;
+	return index >= 0 ? staticTemplateIndex[index] : NULL;
 }
 
 /*getTemplatefFromMultiPlayerID gets template for unique ID  searching all lists */
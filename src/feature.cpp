@@ -127,6 +127,7 @@ bool loadFeatureStats(const char *pFeatureData, UDWORD bufferSize)
 
 	asFeatureStats = new FEATURE_STATS[table.size()];
 	numFeatureStats = table.size();
+	statsIndexClear(STATS_INDEX_FEATURE);
 
 	for (unsigned i = 0; i < table.size(); ++i)
 	{
@@ -136,6 +137,7 @@ bool loadFeatureStats(const char *pFeatureData, UDWORD bufferSize)
 			debug(LOG_ERROR, "%s", table.getError().toUtf8().constData());
 			return false;
 		}
+		statsIndexAdd(STATS_INDEX_FEATURE, asFeatureStats[i].pName, i);
 
 		//and the oil resource - assumes only one!
 		if (asFeatureStats[i].subType == FEAT_OIL_RESOURCE)
@@ -157,6 +159,7 @@ void featureStatsShutDown(void)
 	delete[] asFeatureStats;
 	asFeatureStats = NULL;
 	numFeatureStats = 0;
+	statsIndexClear(STATS_INDEX_FEATURE);
 }
 
 /** Deals with damage to a feature
@@ -544,18 +547,7 @@ bool destroyFeature(FEATURE *psDel)
 
 SDWORD getFeatureStatFromName( const char *pName )
 {
-	unsigned int inc;
-	FEATURE_STATS *psStat;
-
-	for (inc = 0; inc < numFeatureStats; inc++)
-	{
-		psStat = &asFeatureStats[inc];
-		if (!strcmp(psStat->pName, pName))
-		{
-			return inc;
-		}
-	}
-	return -1;
+	return statsIndexFind(STATS_INDEX_FEATURE, pName);
 }
 
 Vector2i getFeatureStatsSize(FEATURE_STATS const *pFeatureType)
@@ -1546,7 +1546,7 @@ void addBottomForm(void)
 
 	sFormInit.formID = FRONTEND_BACKDROP;
 	sFormInit.id = FRONTEND_BOTFORM;
-	sFormInit.style = WFORM_PLAIN;
+	sFormInit.style = WFORM_PLAIN | WFORM_CACHED;
 	sFormInit.x = FRONTEND_BOTFORMX;
 	sFormInit.y = FRONTEND_BOTFORMY;
 	sFormInit.width = FRONTEND_BOTFORMW;
@@ -1481,6 +1481,7 @@ bool FunctionShutDown(void)
 		asFunctions++;
 	}
 	free(pStartList);
+	statsIndexClear(STATS_INDEX_FUNCTION);
 
 	return true;
 }
@@ -1551,5 +1552,11 @@ bool loadFunctionStats(const char *pFunctionData, UDWORD bufferSize)
 	//set the function list pointer to the start
 	asFunctions = pStartList;
 
+	statsIndexClear(STATS_INDEX_FUNCTION);
+	for (i = 0; i < numFunctions; i++)
+	{
+		statsIndexAdd(STATS_INDEX_FUNCTION, asFunctions[i]->pName, i);
+	}
+
 	return true;
 }
@@ -28,6 +28,7 @@
 #include "lib/framework/endian_hack.h"
 #include "lib/framework/wzconfig.h"
 #include "lib/framework/file.h"
+#include "lib/framework/wztime.h"
 #include "lib/framework/frameint.h"
 #include "lib/framework/physfs_ext.h"
 #include "lib/framework/strres.h"
@@ -1492,6 +1493,8 @@ so can be called in levLoadData when starting a game from a load save game*/
 // -----------------------------------------------------------------------------------------
 bool loadGameInit(const char* fileName)
 {
+	saveFileDeferWait();  // Make sure we aren't still writing the savegame.
+
 	if (!gameLoad(fileName))
 	{
 		debug(LOG_ERROR, "Corrupted / unsupported savegame file %s, Unable to load!", fileName);
@@ -1571,6 +1574,8 @@ bool loadGame(const char *pGameToLoad, bool keepObjects, bool freeMem, bool User
 	/* Stop the game clock */
 	gameTimeStop();
 
+	saveFileDeferWait();  // Make sure we aren't still writing the savegame.
+
 	if ((gameType == GTYPE_SAVE_START) ||
 		(gameType == GTYPE_SAVE_MIDMISSION))
 	{
@@ -2662,7 +2667,7 @@ bool saveGame(char *aFileName, GAME_TYPE saveType)
 	}
 
 	CurrentFileName[fileExtension] = '\0';
-	strcat(CurrentFileName, "limbo.bjo");
+	strcat(CurrentFileName, "limbo.ini");
 	/*Write the swapped droid lists to the file*/
 	if (!writeDroidFile(CurrentFileName, apsLimboDroids))
 	{
@@ -2757,6 +2762,20 @@ static bool writeMapFile(const char* fileName)
 	return status;
 }
 
+// -----------------------------------------------------------------------------------------
+bool saveGameInBackground(char *aFileName, GAME_TYPE saveType)
+{
+	uint64_t startTime = wzGetMicroTicks();
+
+	saveFileDeferBegin();
+	bool ret = saveGame(aFileName, saveType);
+	debug(LOG_SAVE, "Took snapshot of %s in %u ms", aFileName, (unsigned)((wzGetMicroTicks() - startTime)/1000));
+	// Write the files anyway, if saveGame failed, since it would have written as much as it could.
+	saveFileDeferEnd(true);
+
+	return ret;
+}
+
 // -----------------------------------------------------------------------------------------
 static bool gameLoad(const char* fileName)
 {
@@ -3605,14 +3624,12 @@ bool gameLoadV(PHYSFS_file* fileHandle, unsigned int version)
 
 // -----------------------------------------------------------------------------------------
 /*
-Writes the game specifics to a file
+Writes the header and the game specifics to the game file
 */
-static bool writeGameFile(const char* fileName, SDWORD saveType)
+static bool writeGameFileData(const char* fileName, const SAVE_GAME* saveGame)
 {
 	GAME_SAVEHEADER fileHeader;
-	SAVE_GAME       saveGame;
 	bool            status;
-	unsigned int    i, j;
 
 	PHYSFS_file* fileHandle = openSaveFile(fileName);
 	if (!fileHandle)
@@ -3637,6 +3654,47 @@ static bool writeGameFile(const char* fileName, SDWORD saveType)
 		return false;
 	}
 
+	status = serializeSaveGameData(fileHandle, saveGame);
+
+	// Close the file
+	PHYSFS_close(fileHandle);
+
+	// Return our success status with writing out the file!
+	return status;
+}
+
+/// The game file of a savegame written in the background, see writeDeferredGameFile
+struct DEFERRED_GAME_FILE
+{
+	char      fileName[PATH_MAX];
+	SAVE_GAME saveGame;
+};
+
+/// Writes the game file after the rest of the savegame, so that an interrupted save doesn't leave a game file that refers to missing or old files
+static bool writeDeferredGameFile(void *data, bool ok)
+{
+	DEFERRED_GAME_FILE *psGameFile = (DEFERRED_GAME_FILE *)data;
+
+	if (ok)
+	{
+		ok = writeGameFileData(psGameFile->fileName, &psGameFile->saveGame);
+	}
+	else
+	{
+		debug(LOG_ERROR, "Not writing %s, since the rest of the savegame could not be written", psGameFile->fileName);
+	}
+	delete psGameFile;
+	return ok;
+}
+
+/*
+Writes the game specifics to a file
+*/
+static bool writeGameFile(const char* fileName, SDWORD saveType)
+{
+	SAVE_GAME       saveGame;
+	unsigned int    i, j;
+
 	ASSERT( saveType == GTYPE_SAVE_START ||
 			saveType == GTYPE_SAVE_MIDMISSION,
 			"writeGameFile: invalid save type" );
@@ -3790,13 +3848,17 @@ static bool writeGameFile(const char* fileName, SDWORD saveType)
 	//version 38
 	sstrcpy(saveGame.modList, getModList());
 
-	status = serializeSaveGameData(fileHandle, &saveGame);
+	if (saveFileDeferring())
+	{
+		DEFERRED_GAME_FILE *psGameFile = new DEFERRED_GAME_FILE;
 
-	// Close the file
-	PHYSFS_close(fileHandle);
+		sstrcpy(psGameFile->fileName, fileName);
+		psGameFile->saveGame = saveGame;
+		saveFileDeferLast(writeDeferredGameFile, psGameFile);
+		return true;
+	}
 
-	// Return our success status with writing out the file!
-	return status;
+	return writeGameFileData(fileName, &saveGame);
 }
 
 // -----------------------------------------------------------------------------------------
@@ -4455,7 +4517,8 @@ bool loadSaveStructure(char *pFileData, UDWORD filesize)
 	SAVE_STRUCTURE_V2		*psSaveStructure, sSaveStructure;
 	STRUCTURE			*psStructure;
 	STRUCTURE_STATS			*psStats = NULL;
-	UDWORD				count, statInc;
+	UDWORD				count;
+	int					statInc;
 	int32_t				found;
 	UDWORD				NumberOfSkippedStructures=0;
 	UDWORD				burnTime;
@@ -4529,19 +4592,9 @@ bool loadSaveStructure(char *pFileData, UDWORD filesize)
 			NumberOfSkippedStructures++;
 		}
 		//get the stats for this structure
-		found = false;
-
-		for (statInc = 0; statInc < numStructureStats; statInc++)
-		{
-			psStats = asStructureStats + statInc;
-			//loop until find the same name
-
-			if (!strcmp(psStats->pName, psSaveStructure->name))
-			{
-				found = true;
-				break;
-			}
-		}
+		statInc = getStructStatFromName(psSaveStructure->name);
+		found = statInc != -1;
+		psStats = found ? asStructureStats + statInc : NULL;
 		//if haven't found the structure - ignore this record!
 		if (!found)
 		{
@@ -4614,12 +4667,11 @@ bool loadSaveStructure(char *pFileData, UDWORD filesize)
 //return id of a research topic based on the name
 static UDWORD getResearchIdFromName(const char *pName)
 {
-	for (int inc = 0; inc < asResearch.size(); inc++)
+	int inc = statsIndexFind(STATS_INDEX_RESEARCH, pName);
+
+	if (inc >= 0)
 	{
-		if (!strcmp(asResearch[inc].pName, pName))
-		{
-			return inc;
-		}
+		return inc;
 	}
 	debug(LOG_ERROR, "Unknown research - %s", pName);
 	return NULL_ID;
@@ -4659,17 +4711,9 @@ static bool loadSaveStructure2(const char *pFileName, STRUCTURE **ppList)
 		QString name = ini.value("name").toString();
 
 		//get the stats for this structure
-		found = false;
-		for (statInc = 0; statInc < numStructureStats; statInc++)
-		{
-			psStats = asStructureStats + statInc;
-			//loop until find the same name
-			if (name.compare(psStats->pName) == 0)
-			{
-				found = true;
-				break;
-			}
-		}
+		statInc = getStructStatFromName(name.toUtf8().constData());
+		found = statInc != -1;
+		psStats = found ? asStructureStats + statInc : NULL;
 		//if haven't found the structure - ignore this record!
 		ASSERT(found, "This structure no longer exists - %s", name.toUtf8().constData());
 		if (!found)
@@ -5130,7 +5174,8 @@ bool loadSaveFeature(char *pFileData, UDWORD filesize)
 	FEATURE_SAVEHEADER		*psHeader;
 	SAVE_FEATURE_V14			*psSaveFeature;
 	FEATURE					*pFeature;
-	UDWORD					count, i, statInc;
+	UDWORD					count, i;
+	int						statInc;
 	FEATURE_STATS			*psStats = NULL;
 	bool					found;
 	UDWORD					sizeOfSaveFeature;
@@ -5191,18 +5236,9 @@ bool loadSaveFeature(char *pFileData, UDWORD filesize)
 		endian_udword(&psSaveFeature->burnDamage);
 
 		//get the stats for this feature
-		found = false;
-
-		for (statInc = 0; statInc < numFeatureStats; statInc++)
-		{
-			psStats = asFeatureStats + statInc;
-			//loop until find the same name
-			if (!strcmp(psStats->pName, psSaveFeature->name))
-			{
-				found = true;
-				break;
-			}
-		}
+		statInc = getFeatureStatFromName(psSaveFeature->name);
+		found = statInc != -1;
+		psStats = found ? asFeatureStats + statInc : NULL;
 		//if haven't found the feature - ignore this record!
 		if (!found)
 		{
@@ -5264,15 +5300,11 @@ bool loadSaveFeature2(const char *pFileName)
 		FEATURE_STATS *psStats = NULL;
 
 		//get the stats for this feature
-		for (statInc = 0; statInc < numFeatureStats; statInc++)
+		statInc = getFeatureStatFromName(name.toUtf8().constData());
+		if (statInc != -1)
 		{
 			psStats = asFeatureStats + statInc;
-			//loop until find the same name
-			if (!strcmp(psStats->pName, name.toUtf8().constData()))
-			{
-				found = true;
-				break;
-			}
+			found = true;
 		}
 		//if haven't found the feature - ignore this record!
 		if (!found)
@@ -5691,17 +5723,9 @@ static bool loadSaveStructTypeList(const char *pFileName)
 
 			ASSERT_OR_RETURN(false, state == UNAVAILABLE || state == AVAILABLE || state == FOUND || state == REDUNDANT,
 					 "Bad state %d for %s", state, name.toUtf8().constData());
-			for (statInc = 0; statInc < numStructureStats; statInc++) // loop until find the same name
-			{
-				STRUCTURE_STATS *psStats = asStructureStats + statInc;
-
-				if (name.compare(psStats->pName) == 0)
-				{
-					apStructTypeLists[player][statInc] = state;
-					break;
-				}
-			}
-			ASSERT_OR_RETURN(false, statInc != numStructureStats, "Did not find structure %s", name.toUtf8().constData());
+			statInc = getStructStatFromName(name.toUtf8().constData());
+			ASSERT_OR_RETURN(false, statInc != -1, "Did not find structure %s", name.toUtf8().constData());
+			apStructTypeLists[player][statInc] = state;
 		}
 		ini.endGroup();
 	}
@@ -5751,18 +5775,8 @@ bool loadSaveResearch(const char *pFileName)
 		bool found = false;
 		char name[MAX_SAVE_NAME_SIZE];
 		sstrcpy(name, ini.value("name").toString().toUtf8().constData());
-		int statInc;
-		for (statInc = 0; statInc < asResearch.size(); statInc++)
-		{
-			RESEARCH *psStats = &asResearch[statInc];
-			//loop until find the same name
-			if (!strcmp(psStats->pName, name))
-
-			{
-				found = true;
-				break;
-			}
-		}
+		int statInc = statsIndexFind(STATS_INDEX_RESEARCH, name);
+		found = statInc != -1;
 		if (!found)
 		{
 			//ignore this record
@@ -6076,16 +6090,9 @@ bool loadSaveStructLimits(const char *pFileName)
 			int limit = ini.value(name, 0).toInt();
 			int statInc;
 
-			for (statInc = 0; statInc < numStructureStats; statInc++)
-			{
-				STRUCTURE_STATS *psStats = asStructureStats + statInc;
-				if (name.compare(psStats->pName) == 0)
-				{
-					asStructLimits[player][statInc].limit = limit != 255? limit : LOTS_OF;
-					break;
-				}
-			}
-			ASSERT_OR_RETURN(false, statInc != numStructureStats, "Did not find structure %s", name.toUtf8().constData());
+			statInc = getStructStatFromName(name.toUtf8().constData());
+			ASSERT_OR_RETURN(false, statInc != -1, "Did not find structure %s", name.toUtf8().constData());
+			asStructLimits[player][statInc].limit = limit != 255? limit : LOTS_OF;
 		}
 		ini.endGroup();
 	}
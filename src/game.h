@@ -121,6 +121,8 @@ extern bool loadScriptState(char *pFileName);
 extern bool loadTerrainTypeMap(const char *pFileData, UDWORD filesize);
 
 extern bool saveGame(char *aFileName, GAME_TYPE saveType);
+/// Like saveGame, but only takes a snapshot of the game state in memory, and writes the files in the background.
+extern bool saveGameInBackground(char *aFileName, GAME_TYPE saveType);
 
 // Get the campaign number for loadGameInit game
 extern UDWORD getCampaign(const char* fileName);
@@ -99,7 +99,7 @@ static bool addQuitOptions(void)
 	// add form
 	sFormInit.formID	= 0;
 	sFormInit.id		= INTINGAMEOP;
-	sFormInit.style		= WFORM_PLAIN;
+	sFormInit.style		= WFORM_PLAIN | WFORM_CACHED;
 	sFormInit.width		= INTINGAMEOP3_W;
 	sFormInit.height	= INTINGAMEOP3_H;;
 	sFormInit.x		= (SWORD)INTINGAMEOP3_X;
@@ -153,7 +153,7 @@ static bool addSlideOptions(void)
 	// add form
 	sFormInit.formID	= 0;
 	sFormInit.id		= INTINGAMEOP;
-	sFormInit.style		= WFORM_PLAIN;
+	sFormInit.style		= WFORM_PLAIN | WFORM_CACHED;
 	sFormInit.x		= (SWORD)INTINGAMEOP2_X;
 	sFormInit.y		= (SWORD)INTINGAMEOP2_Y;
 	sFormInit.width		= INTINGAMEOP2_W;
@@ -233,7 +233,7 @@ static bool _intAddInGameOptions(void)
 	// add form
 	sFormInit.formID	= 0;
 	sFormInit.id		= INTINGAMEOP;
-	sFormInit.style		= WFORM_PLAIN;
+	sFormInit.style		= WFORM_PLAIN | WFORM_CACHED;
 	sFormInit.x			= (SWORD)INTINGAMEOP_X;
 	sFormInit.y			= (SWORD)INTINGAMEOP_Y;
 	sFormInit.height	= INTINGAMEOP_H;
@@ -95,10 +95,12 @@
 #include "terrain.h"
 #include "ingameop.h"
 #include "qtscript.h"
+#include "lib/framework/wzprofile.h"
 
 static void	initMiscVars(void);
 
 static const char UserMusicPath[] = "music";
+static const char TexPrefetchList[] = "cache/texpages.txt";  ///< Texture pages used in recent sessions, see pie_LoadTexPrefetchList
 
 // FIXME Totally inappropriate place for this.
 char fileLoadBuffer[FILE_LOAD_BUFFER_SIZE];
@@ -479,6 +481,8 @@ bool buildMapList(void)
 //
 bool systemInitialise(void)
 {
+	WzProfilePhase profile("systemInitialise");
+
 	if (!widgInitialise())
 	{
 		return false;
@@ -487,16 +491,25 @@ bool systemInitialise(void)
 	buildMapList();
 
 	// Initialize render engine
-	if (!pie_Initialise())
+	wzProfileBegin("pie_Initialise");
+	bool renderer = pie_Initialise();
+	wzProfileEnd();
+	if (!renderer)
 	{
 		debug(LOG_ERROR, "Unable to initialise renderer");
 		return false;
 	}
+	if (pie_GetLazyTexPages())
+	{
+		pie_LoadTexPrefetchList(TexPrefetchList);
+	}
 
+	wzProfileBegin("audio_Init");
 	if (!audio_Init(droidAudioTrackStopped, war_getSoundEnabled()))
 	{
 		debug(LOG_SOUND, "Continuing without audio");
 	}
+	wzProfileEnd();
 	if (war_getSoundEnabled() && war_GetMusicEnabled())
 	{
 		cdAudio_Open(UserMusicPath);
@@ -517,12 +530,16 @@ bool systemInitialise(void)
 	}
 
 	// Initialize the iVis text rendering module
+	wzProfileBegin("iV_TextInit");
 	iV_TextInit();
+	wzProfileEnd();
 
 	iV_Reset();								// Reset the IV library.
 	initLoadingScreen(true);
 
+	wzProfileBegin("readAIs");
 	readAIs();
+	wzProfileEnd();
 
 	return true;
 }
@@ -566,6 +583,7 @@ void systemShutdown(void)
 
 	debug(LOG_MAIN, "shutting down graphics subsystem");
 	iV_ShutDown();
+	pie_SaveTexPrefetchList(TexPrefetchList);
 	levShutDown();
 	widgShutDown();
 	fpathShutdown();
@@ -752,6 +770,8 @@ bool frontendShutdown(void)
 
 bool stageOneInitialise(void)
 {
+	WzProfilePhase profile("stageOneInitialise");
+
 	debug(LOG_WZ, "== stageOneInitalise ==");
 
 	// Initialise all globals and statics everwhere.
@@ -930,6 +950,7 @@ bool stageOneShutDown(void)
 
 bool stageTwoInitialise(void)
 {
+	WzProfilePhase profile("stageTwoInitialise");
 	int i;
 
 	debug(LOG_WZ, "== stageTwoInitalise ==");
@@ -1061,6 +1082,7 @@ bool stageTwoShutDown(void)
 
 bool stageThreeInitialise(void)
 {
+	WzProfilePhase profile("stageThreeInitialise");
 	STRUCTURE *psStr;
 	UDWORD i;
 	DROID		*psDroid;
@@ -530,6 +530,21 @@ void kf_ToggleSamples(void) //Displays number of sound sample in the sound queue
 	CONPRINTF(ConsoleString, (ConsoleString, "Sound Samples displayed is %s", showSAMPLES ? "Enabled" : "Disabled"));
 }
 
+void kf_ToggleNetStats(void) // Displays per player network statistics.
+{
+	showNETSTATS = !showNETSTATS;
+
+	CONPRINTF(ConsoleString, (ConsoleString, "Network statistics display is %s", showNETSTATS ? "Enabled" : "Disabled"));
+}
+
+void kf_DumpNetStats(void) // Writes the network statistics to the logs directory.
+{
+	if (NETdumpStats())
+	{
+		CONPRINTF(ConsoleString, (ConsoleString, "Network statistics written to the logs directory"));
+	}
+}
+
 void kf_ToggleOrders(void)	// Displays orders & action of currently selected unit.
 {
 		// Toggle the boolean value of showORDERS
@@ -545,8 +560,12 @@ void kf_ToggleLevelName(void) // toggles level name
 /* Writes out the frame rate */
 void	kf_FrameRate( void )
 {
-	CONPRINTF(ConsoleString,(ConsoleString, "FPS %d; PIEs %d; polys %d; States %d",
-	          frameRate(), loopPieCount, loopPolyCount, loopStateChanges));
+	CONPRINTF(ConsoleString,(ConsoleString, "FPS %d; PIEs %d; batches %d; polys %d; States %d",
+	          frameRate(), loopPieCount, loopBatchCount, loopPolyCount, loopStateChanges));
+	CONPRINTF(ConsoleString,(ConsoleString, "Objects drawn %d; culled %d", loopObjectsDrawn, loopObjectsCulled));
+	CONPRINTF(ConsoleString,(ConsoleString, "Terrain draws %d; sectors updated %d in %d us", loopTerrainDrawCalls, loopTerrainSectorsUpdated, loopTerrainUpdateTime));
+	CONPRINTF(ConsoleString,(ConsoleString, "Shadow volumes reused %d; built %d", loopShadowCacheHits, loopShadowCacheMisses));
+	CONPRINTF(ConsoleString,(ConsoleString, "Cached forms reused %d; redrawn %d", loopCachedFormsReused, loopCachedFormsRedrawn));
 	if (runningMultiplayer())
 	{
 			CONPRINTF(ConsoleString,(ConsoleString,
@@ -31,6 +31,8 @@ extern void	kf_BuildInfo( void );
 extern void	kf_ToggleFPS(void);			//FPS counter NOT same as kf_Framerate! -Q
 extern void	kf_ToggleSamples(void);		// Displays # of sound samples in Queue/list.
 extern void kf_ToggleOrders(void);		//displays unit's Order/action state.
+extern void kf_ToggleNetStats(void);		// Displays per player network statistics.
+extern void kf_DumpNetStats(void);		// Writes the network statistics to a file.
 extern void kf_ToggleLevelName(void);
 extern void	kf_FrameRate( void );
 extern void	kf_ShowNumObjects( void );
@@ -45,9 +45,12 @@
 #include "lib/script/script.h"
 #include "scripttabs.h"
 #include "research.h"
+#include "droid.h"
+#include "objmem.h"
 #include "lib/framework/lexer_input.h"
 #include "effects.h"
 #include "main.h"
+#include "lib/framework/wzprofile.h"
 
 extern int lev_get_lineno(void);
 extern char* lev_get_text(void);
@@ -594,6 +597,7 @@ char *getLevelName( void )
 // load up the data for a level
 bool levLoadData(const char* name, char *pSaveName, GAME_TYPE saveType)
 {
+	WzProfilePhase profile("levLoadData", "levelload");  // Written to logs/levelload-<time>.csv
 	LEVEL_DATASET	*psNewLevel, *psBaseData, *psChangeLevel;
 	SDWORD			i;
 	bool            bCamChangeSaveGame;
@@ -1004,16 +1008,46 @@ bool levLoadData(const char* name, char *pSaveName, GAME_TYPE saveType)
 	return true;
 }
 
+/// Count the droids in the limbo lists, for levTestLoad
+static unsigned levTestCountLimboDroids(void)
+{
+	unsigned count = 0;
+	int player;
+	DROID *psDroid;
+
+	for (player = 0; player < MAX_PLAYERS; player++)
+	{
+		for (psDroid = apsLimboDroids[player]; psDroid != NULL; psDroid = psDroid->psNext)
+		{
+			count++;
+		}
+	}
+	return count;
+}
+
 static void levTestLoad(const char* level)
 {
 	static char savegameName[80];
 	bool retval;
+	DROID *psDroid;
+	unsigned limboDroids;
 
 	retval = levLoadData(level, NULL, GTYPE_SCENARIO_START);
 	ASSERT(retval, "levLoadData failed selftest");
 	ASSERT(checkResearchStats(), "checkResearchStats failed selftest");
 	ASSERT(checkStructureStats(), "checkStructureStats failed selftest");
 	fprintf(stdout, "\t\tLoaded: %s\n", level);
+
+	// Put a droid in limbo, like at the end of a campaign mission, so we can check that the savegame keeps it
+	psDroid = apsDroidLists[selectedPlayer];
+	if (psDroid != NULL && droidRemove(psDroid, apsDroidLists))
+	{
+		psDroid->pos.x = INVALID_XY;
+		psDroid->pos.y = INVALID_XY;
+		addDroid(psDroid, apsLimboDroids);
+	}
+	limboDroids = levTestCountLimboDroids();
+
 	strcpy(savegameName, "selftest/");
 	PHYSFS_mkdir(savegameName);
 	strcat(savegameName, level);
@@ -1023,9 +1057,19 @@ static void levTestLoad(const char* level)
 	strcpy(savegameName, "selftest/");	// we need to recreate string, because saveGame clobbered it
 	strcat(savegameName, level);
 	strcat(savegameName, ".gam");
+	freeAllLimboDroids();	// not released with the level
 	retval = levReleaseAll();
 	assert(retval == true);
 	fprintf(stdout, "\t\tSaved: %s\n", savegameName);
+
+	// Load the savegame back, and check the limbo droids came back with it
+	retval = loadGameInit(savegameName);
+	ASSERT(retval, "loadGameInit failed selftest");
+	ASSERT(levTestCountLimboDroids() == limboDroids, "Saved %u limbo droids, but loaded %u", limboDroids, levTestCountLimboDroids());
+	freeAllLimboDroids();
+	retval = levReleaseAll();
+	assert(retval == true);
+	fprintf(stdout, "\t\tReloaded: %s\n", savegameName);
 }
 
 void levTest(void)
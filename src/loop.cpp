@@ -56,6 +56,7 @@
 #include "power.h"
 #include "message.h"
 #include "bucket3d.h"
+#include "terrain.h"
 #include "display3d.h"
 #include "warzoneconfig.h"
 
@@ -101,6 +102,16 @@ static void fireWaitingCallbacks(void);
 unsigned int loopPieCount;
 unsigned int loopPolyCount;
 unsigned int loopStateChanges;
+unsigned int loopBatchCount;
+unsigned int loopObjectsDrawn;
+unsigned int loopObjectsCulled;
+unsigned int loopTerrainDrawCalls;
+unsigned int loopTerrainSectorsUpdated;
+unsigned int loopTerrainUpdateTime;
+unsigned int loopShadowCacheHits;
+unsigned int loopShadowCacheMisses;
+unsigned int loopCachedFormsReused;
+unsigned int loopCachedFormsRedrawn;
 
 /*
  * local variables
@@ -350,7 +361,11 @@ static GAMECODE renderLoop()
 		pie_SetFogStatus(true);
 	}
 
-	pie_GetResetCounts(&loopPieCount, &loopPolyCount, &loopStateChanges);
+	pie_GetResetCounts(&loopPieCount, &loopPolyCount, &loopStateChanges, &loopBatchCount);
+	bucketGetResetCounts(&loopObjectsDrawn, &loopObjectsCulled);
+	terrainGetResetCounts(&loopTerrainDrawCalls, &loopTerrainSectorsUpdated, &loopTerrainUpdateTime);
+	pie_GetResetShadowCacheCounts(&loopShadowCacheHits, &loopShadowCacheMisses);
+	widgGetResetCachedFormCounts(&loopCachedFormsReused, &loopCachedFormsRedrawn);
 
 	if ((fogStatus & FOG_BACKGROUND) && (loopMissionState == LMS_SAVECONTINUE))
 	{
@@ -55,6 +55,16 @@ extern SDWORD	nextMissionType;
 extern unsigned int loopPieCount;
 extern unsigned int loopPolyCount;
 extern unsigned int loopStateChanges;
+extern unsigned int loopBatchCount;
+extern unsigned int loopObjectsDrawn;
+extern unsigned int loopObjectsCulled;
+extern unsigned int loopTerrainDrawCalls;
+extern unsigned int loopTerrainSectorsUpdated;
+extern unsigned int loopTerrainUpdateTime;
+extern unsigned int loopShadowCacheHits;
+extern unsigned int loopShadowCacheMisses;
+extern unsigned int loopCachedFormsReused;
+extern unsigned int loopCachedFormsRedrawn;
 
 extern GAMECODE gameLoop(void);
 extern void videoLoop(void);
@@ -78,6 +78,7 @@
 #include "map.h"
 #include "parsetest.h"
 #include "keybind.h"
+#include "lib/framework/wzprofile.h"
 #include <time.h>
 
 /* Always use fallbacks on Windows */
@@ -1266,10 +1267,13 @@ int main(int argc, char *argv[])
 	addDumpInfo(buf);
 
 	debug(LOG_MAIN, "Final initialization");
+	wzProfileBegin("startup", "startup");  // Written to logs/startup-<time>.csv
+	wzProfileBegin("frameInitialise");
 	if (!frameInitialise())
 	{
 		return EXIT_FAILURE;
 	}
+	wzProfileEnd();
 	war_SetWidth(pie_GetVideoBufferWidth());
 	war_SetHeight(pie_GetVideoBufferHeight());
 
@@ -1286,6 +1290,7 @@ int main(int argc, char *argv[])
 	{
 		return EXIT_FAILURE;
 	}
+	wzProfileEnd();
 
 	//set all the pause states to false
 	setAllPauseStates(false);
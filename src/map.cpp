@@ -24,8 +24,12 @@
  *
  */
 #include <time.h>
+#include <algorithm>
+#include <utility>
+#include <vector>
 
 #include "lib/framework/frame.h"
+#include "lib/framework/crc.h"
 #include "lib/framework/endian_hack.h"
 #include "lib/framework/file.h"
 #include "lib/framework/physfs_ext.h"
@@ -51,6 +55,7 @@
 #include "levels.h"
 #include "scriptfuncs.h"
 #include "lib/framework/wzapp.h"
+#include "lib/framework/wzprofile.h"
 
 #define GAME_TICKS_FOR_DANGER (GAME_TICKS_PER_SEC * 2)
 
@@ -137,6 +142,7 @@ static char *Tile_names = NULL;
 #define ROCKIE 3
 
 static int *map;			// 3D array pointer that holds the texturetype
+static int numMapGround;		// number of tiles in map
 static int *mapDecals;		// array that tells us what tile is a decal
 #define MAX_TERRAIN_TILES 100		// max that we support (for now)
 
@@ -497,6 +503,7 @@ static void SetGroundForTile(const char *filename, const char *nametype)
 	pFileData = strchr(pFileData,'\n') + 1;
 
 	map = (int *)malloc(sizeof(int) * numlines * 2 * 2 );	// this is a 3D array map[numlines][2][2]
+	numMapGround = numlines;
 
 	for (i=0; i < numlines; i++)
 	{
@@ -566,28 +573,13 @@ static void rotFlip(int tile, int *i, int *j)
 }
 
 /// Tries to figure out what ground type a grid point is from the surrounding tiles
-static int determineGroundType(int x, int y, const char *tileset)
+/// cliff is the cliff ground type of the tileset
+static int determineGroundType(int x, int y, int cliff)
 {
 	int ground[2][2];
 	int votes[2][2];
 	int i,j, tile;
 	int a,b, best;
-	bool arizona, rockies, urban;
-	arizona = rockies = urban = false;
-	if (strcmp(tileset, "texpages/tertilesc1hw") == 0)
-	{
-		arizona = true;
-	} else if (strcmp(tileset, "texpages/tertilesc2hw") == 0)
-	{
-		urban = true;
-	} else if (strcmp(tileset, "texpages/tertilesc3hw") == 0)
-	{
-		rockies = true;
-	} else
-	{
-		debug(LOG_ERROR, "unknown tileset");
-		return 0;
-	}
 
 	if (x < 0 || y < 0 || x >= mapWidth || y >= mapHeight)
 	{
@@ -615,21 +607,8 @@ static int determineGroundType(int x, int y, const char *tileset)
 			votes[i][j] = 0;
 
 			// cliffs are so small they won't show up otherwise
-			if (urban)
-			{
-				if (ground[i][j] == getTextureType("u_cliff"))
-					return ground[i][j];
-			}
-			else if (arizona)
-			{
-				if (ground[i][j] == getTextureType("a_cliff"))
-					return ground[i][j];
-			}
-			else if (rockies)
-			{
-				if (ground[i][j] == getTextureType("r_cliff"))
-					return ground[i][j];
-			}
+			if (ground[i][j] == cliff)
+				return ground[i][j];
 		}
 	}
 
@@ -730,6 +709,25 @@ static bool hasDecals(int i, int j)
 static bool mapSetGroundTypes(void)
 {
 	int i,j;
+	int cliff = -1;
+
+	// look the cliffs up once, rather than for every tile
+	if (strcmp(tileset, "texpages/tertilesc1hw") == 0)
+	{
+		cliff = getTextureType("a_cliff");
+	}
+	else if (strcmp(tileset, "texpages/tertilesc2hw") == 0)
+	{
+		cliff = getTextureType("u_cliff");
+	}
+	else if (strcmp(tileset, "texpages/tertilesc3hw") == 0)
+	{
+		cliff = getTextureType("r_cliff");
+	}
+	else
+	{
+		debug(LOG_ERROR, "unknown tileset");
+	}
 
 	for (i=0;i<mapWidth;i++)
 	{
@@ -737,7 +735,7 @@ static bool mapSetGroundTypes(void)
 		{
 			MAPTILE *psTile = mapTile(i, j);
 
-			psTile->ground = determineGroundType(i,j,tileset);
+			psTile->ground = cliff != -1 ? determineGroundType(i, j, cliff) : 0;
 
 			if (hasDecals(i,j))
 			{
@@ -752,15 +750,180 @@ static bool mapSetGroundTypes(void)
 	return true;
 }
 
+#define MAP_CACHE_DIR		"cache/maps"
+#define MAP_CACHE_MAGIC		0x575a4d43	// "WZMC"
+#define MAP_CACHE_VERSION	1
+#define MAP_CACHE_MAX_FILES	16	// Each map, tileset and mod combination gets its own file, keep those of the most recently loaded
+
+/// What mapLoad works out for a tile from the map data and the tileset
+struct MAP_CACHE_TILE
+{
+	int32_t		height;
+	int32_t		waterLevel;
+	uint16_t	limitedContinent;
+	uint16_t	hoverContinent;
+	uint8_t		ground;
+	uint8_t		decal;
+	uint16_t	pad;
+};
+
+struct MAP_CACHE_HEADER
+{
+	uint32_t	magic;
+	uint32_t	version;
+	uint32_t	key;
+	uint32_t	width;
+	uint32_t	height;
+};
+
+/// Key of the map cache, covering everything the cached values are worked out from
+static uint32_t mapCacheKey(const uint8_t *pTileData, size_t size)
+{
+	uint32_t crc = crcSum(0, pTileData, size);
+
+	crc = crcSum(crc, &mapWidth, sizeof(mapWidth));
+	crc = crcSum(crc, &mapHeight, sizeof(mapHeight));
+	crc = crcSum(crc, tileset, strlen(tileset));
+	crc = crcSum(crc, Tile_names, numTile_names * MAX_STR_LENGTH);
+	crc = crcSum(crc, map, numMapGround * 2 * 2 * sizeof(*map));
+	crc = crcSum(crc, mapDecals, MAX_TERRAIN_TILES * sizeof(*mapDecals));
+	crc = crcSum(crc, &waterGroundType, sizeof(waterGroundType));
+	crc = crcSum(crc, terrainTypes, sizeof(terrainTypes));
+	return crc;
+}
+
+/// Fill in the ground types, decals, heights and continents of the map from its cache, if it has an up to date one
+static bool mapCacheLoad(uint32_t key)
+{
+	char			aFileName[PATH_MAX];
+	char			*pFileData = NULL;
+	UDWORD			fileSize = 0;
+	MAP_CACHE_HEADER	header;
+	const unsigned		numTiles = mapWidth * mapHeight;
+
+	ssprintf(aFileName, MAP_CACHE_DIR "/%08x.bin", key);
+	if (!PHYSFS_exists(aFileName) || !loadFile(aFileName, &pFileData, &fileSize))
+	{
+		return false;
+	}
+	if (fileSize != sizeof(header) + numTiles * sizeof(MAP_CACHE_TILE))
+	{
+		debug(LOG_MAP, "Ignoring %s, which has the wrong size", aFileName);
+		free(pFileData);
+		return false;
+	}
+	memcpy(&header, pFileData, sizeof(header));
+	if (header.magic != MAP_CACHE_MAGIC || header.version != MAP_CACHE_VERSION || header.key != key
+	    || header.width != mapWidth || header.height != mapHeight)
+	{
+		debug(LOG_MAP, "Ignoring %s, which is for another map", aFileName);
+		free(pFileData);
+		return false;
+	}
+
+	const MAP_CACHE_TILE *psCached = (const MAP_CACHE_TILE *)(pFileData + sizeof(header));
+	for (unsigned i = 0; i < numTiles; i++)
+	{
+		MAPTILE *psTile = &psMapTiles[i];
+
+		psTile->height = psCached[i].height;
+		psTile->waterLevel = psCached[i].waterLevel;
+		psTile->limitedContinent = psCached[i].limitedContinent;
+		psTile->hoverContinent = psCached[i].hoverContinent;
+		psTile->ground = psCached[i].ground;
+		if (psCached[i].decal)
+		{
+			SET_TILE_DECAL(psTile);
+		}
+		else
+		{
+			CLEAR_TILE_DECAL(psTile);
+		}
+	}
+	free(pFileData);
+	debug(LOG_MAP, "Loaded ground types and continents from %s", aFileName);
+	return true;
+}
+
+/// Delete the oldest cache files, until at most MAP_CACHE_MAX_FILES are left
+static void mapCachePrune(void)
+{
+	std::vector<std::pair<PHYSFS_sint64, std::string> > cacheFiles;
+	char **files = PHYSFS_enumerateFiles(MAP_CACHE_DIR);
+	char **i;
+
+	for (i = files; *i != NULL; ++i)
+	{
+		std::string fileName = std::string(MAP_CACHE_DIR "/") + *i;
+
+		if (strstr(*i, ".bin") != NULL)
+		{
+			cacheFiles.push_back(std::make_pair(PHYSFS_getLastModTime(fileName.c_str()), fileName));
+		}
+	}
+	PHYSFS_freeList(files);
+
+	if (cacheFiles.size() <= MAP_CACHE_MAX_FILES)
+	{
+		return;
+	}
+	std::sort(cacheFiles.begin(), cacheFiles.end());
+	for (unsigned j = 0; j < cacheFiles.size() - MAP_CACHE_MAX_FILES; j++)
+	{
+		debug(LOG_MAP, "Deleting old map cache %s", cacheFiles[j].second.c_str());
+		if (!PHYSFS_delete(cacheFiles[j].second.c_str()))
+		{
+			debug(LOG_WARNING, "Could not delete %s: %s", cacheFiles[j].second.c_str(), PHYSFS_getLastError());
+		}
+	}
+}
+
+/// Write what mapLoad worked out for each tile, so that the next load of the same map can skip it
+static void mapCacheSave(uint32_t key)
+{
+	char			aFileName[PATH_MAX];
+	const unsigned		numTiles = mapWidth * mapHeight;
+	MAP_CACHE_HEADER	header = {MAP_CACHE_MAGIC, MAP_CACHE_VERSION, key, (uint32_t)mapWidth, (uint32_t)mapHeight};
+	std::vector<char>	buffer(sizeof(header) + numTiles * sizeof(MAP_CACHE_TILE));
+	MAP_CACHE_TILE		*psCached = (MAP_CACHE_TILE *)&buffer[sizeof(header)];
+
+	memcpy(&buffer[0], &header, sizeof(header));
+	for (unsigned i = 0; i < numTiles; i++)
+	{
+		const MAPTILE *psTile = &psMapTiles[i];
+
+		psCached[i].height = psTile->height;
+		psCached[i].waterLevel = psTile->waterLevel;
+		psCached[i].limitedContinent = psTile->limitedContinent;
+		psCached[i].hoverContinent = psTile->hoverContinent;
+		psCached[i].ground = psTile->ground;
+		psCached[i].decal = TILE_HAS_DECAL(psTile) != 0;
+		psCached[i].pad = 0;
+	}
+
+	ssprintf(aFileName, MAP_CACHE_DIR "/%08x.bin", key);
+	PHYSFS_mkdir(MAP_CACHE_DIR);
+	if (!saveFile(aFileName, &buffer[0], buffer.size()))
+	{
+		debug(LOG_WARNING, "Could not save %s", aFileName);
+		return;
+	}
+	mapCachePrune();
+}
+
 /* Initialise the map structure */
 bool mapLoad(char *filename, bool preview)
 {
+	WzProfilePhase profile("mapLoad");
 	UDWORD		numGw, width, height;
 	char		aFileType[4];
 	UDWORD		version;
 	UDWORD		i, j, x, y;
 	PHYSFS_file	*fp = PHYSFS_openRead(filename);
 	MersenneTwister mt(12345);  // 12345 = random seed.
+	uint8_t		*pTileData = NULL;
+	uint32_t	cacheKey = 0;
+	bool		cached = false;
 
 	if (!fp)
 	{
@@ -824,20 +987,20 @@ bool mapLoad(char *filename, bool preview)
 	
 	//load in the map data itself
 	
-	/* Load in the map data */
+	/* Load in the map data, read in one go, as 16 bit texture and 8 bit height for each tile */
+	pTileData = (uint8_t *)malloc(mapWidth * mapHeight * SAVE_TILE_SIZE);
+	ASSERT(pTileData != NULL, "Out of memory");
+	if (PHYSFS_read(fp, pTileData, SAVE_TILE_SIZE, mapWidth * mapHeight) != mapWidth * mapHeight)
+	{
+		debug(LOG_ERROR, "%s: Error during savegame load", filename);
+		goto failure;
+	}
 	for (i = 0; i < mapWidth * mapHeight; i++)
 	{
-		UWORD	texture;
-		UBYTE	height;
-
-		if (!PHYSFS_readULE16(fp, &texture) || !PHYSFS_readULE8(fp, &height))
-		{
-			debug(LOG_ERROR, "%s: Error during savegame load", filename);
-			goto failure;
-		}
+		const uint8_t *pTile = &pTileData[i * SAVE_TILE_SIZE];
 
-		psMapTiles[i].texture = texture;
-		psMapTiles[i].height = height*ELEVATION_SCALE;
+		psMapTiles[i].texture = pTile[0] | pTile[1] << 8;
+		psMapTiles[i].height = pTile[2]*ELEVATION_SCALE;
 
 		// Visibility stuff
 		memset(psMapTiles[i].watchers, 0, sizeof(psMapTiles[i].watchers));
@@ -875,14 +1038,18 @@ bool mapLoad(char *filename, bool preview)
 		}
 	}
 	
-	if (!mapSetGroundTypes())
+	// The ground types, river bed and continents only depend on the map data and the tileset, so may be cached
+	cacheKey = mapCacheKey(pTileData, mapWidth * mapHeight * SAVE_TILE_SIZE);
+	cached = mapCacheLoad(cacheKey);
+
+	if (!cached && !mapSetGroundTypes())
 	{
 		goto failure;
 	}
 
 	// reset the random water bottom heights
 	// set the river bed
-	for (i = 0; i < mapWidth; i++)
+	for (i = 0; i < mapWidth && !cached; i++)
 	{
 		for (j = 0; j < mapHeight; j++)
 		{
@@ -941,12 +1108,18 @@ bool mapLoad(char *filename, bool preview)
 	}
 
 	/* Set continents. This should ideally be done in advance by the map editor. */
-	mapFloodFillContinents();
+	if (!cached)
+	{
+		mapFloodFillContinents();
+		mapCacheSave(cacheKey);
+	}
 ok:
+	free(pTileData);
 	PHYSFS_close(fp);
 	return true;
 	
 failure:
+	free(pTileData);
 	PHYSFS_close(fp);
 	return false;
 }
@@ -1434,49 +1607,29 @@ UDWORD GetHeightOfMap(void)
 /* This will save out the visibility data */
 bool writeVisibilityData(const char* fileName)
 {
-	unsigned int i;
-	VIS_SAVEHEADER fileHeader;
-
-	PHYSFS_file* fileHandle = openSaveFile(fileName);
-	if (!fileHandle)
-	{
-		return false;
-	}
-
-	fileHeader.aFileType[0] = 'v';
-	fileHeader.aFileType[1] = 'i';
-	fileHeader.aFileType[2] = 's';
-	fileHeader.aFileType[3] = 'd';
-
-	fileHeader.version = CURRENT_VERSION_NUM;
+	std::vector<char> buffer;
+	int planes = (game.maxPlayers + 7)/8;
 
-	// Write out the current file header
-	if (PHYSFS_write(fileHandle, fileHeader.aFileType, sizeof(fileHeader.aFileType), 1) != 1
-	 || !PHYSFS_writeUBE32(fileHandle, fileHeader.version))
+	// Build the whole file in memory, and write it in one go.
+	buffer.reserve(8 + planes*mapWidth*mapHeight);
+	buffer.push_back('v');
+	buffer.push_back('i');
+	buffer.push_back('s');
+	buffer.push_back('d');
+	for (int shift = 24; shift >= 0; shift -= 8)
 	{
-		debug(LOG_ERROR, "writeVisibilityData: could not write header to %s; PHYSFS error: %s", fileName, PHYSFS_getLastError());
-		PHYSFS_close(fileHandle);
-		return false;
+		buffer.push_back(CURRENT_VERSION_NUM >> shift);
 	}
 
-	int planes = (game.maxPlayers + 7)/8;
-
 	for (unsigned plane = 0; plane < planes; ++plane)
 	{
-		for (i = 0; i < mapWidth * mapHeight; ++i)
+		for (unsigned i = 0; i < mapWidth * mapHeight; ++i)
 		{
-			if (!PHYSFS_writeUBE8(fileHandle, psMapTiles[i].tileExploredBits >> (plane*8)))
-			{
-				debug(LOG_ERROR, "writeVisibilityData: could not write to %s; PHYSFS error: %s", fileName, PHYSFS_getLastError());
-				PHYSFS_close(fileHandle);
-				return false;
-			}
+			buffer.push_back(psMapTiles[i].tileExploredBits >> (plane*8));
 		}
 	}
 
-	// Everything is just fine!
-	PHYSFS_close(fileHandle);
-	return true;
+	return saveFile(fileName, &buffer[0], buffer.size());
 }
 
 // -----------------------------------------------------------------------------------
@@ -504,17 +504,34 @@ static void NETQueuedDroidInfo(QueuedDroidInfo *info)
 // Actually send the droid info.
 void sendQueuedDroidInfo()
 {
+	if (queuedOrders.empty())
+	{
+		return;  // Nothing to send.
+	}
+
 	// Sort queued orders, to group the same order to multiple droids.
 	std::sort(queuedOrders.begin(), queuedOrders.end());
 
-	std::vector<QueuedDroidInfo>::iterator eqBegin, eqEnd;
-	for (eqBegin = queuedOrders.begin(); eqBegin != queuedOrders.end(); eqBegin = eqEnd)
+	// Find the ranges of orders which differ only by the droid ID.
+	std::vector<std::vector<QueuedDroidInfo>::iterator> groupBegins;
+	for (std::vector<QueuedDroidInfo>::iterator i = queuedOrders.begin(); i != queuedOrders.end(); ++i)
 	{
-		// Find end of range of orders which differ only by the droid ID.
-		for (eqEnd = eqBegin + 1; eqEnd != queuedOrders.end() && eqEnd->orderCompare(*eqBegin) == 0; ++eqEnd)
-		{}
+		if (groupBegins.empty() || i->orderCompare(*groupBegins.back()) != 0)
+		{
+			groupBegins.push_back(i);
+		}
+	}
+	groupBegins.push_back(queuedOrders.end());
+
+	// Send all the groups in a single message, so a mass order only costs one message header, however many different orders it contains.
+	NETbeginEncode(NETgameQueue(selectedPlayer), GAME_DROIDINFO);
+		uint32_t numGroups = groupBegins.size() - 1;
+		NETuint32_t(&numGroups);
+		for (unsigned group = 0; group < numGroups; ++group)
+		{
+			std::vector<QueuedDroidInfo>::iterator eqBegin = groupBegins[group], eqEnd = groupBegins[group + 1];
 
-		NETbeginEncode(NETgameQueue(selectedPlayer), GAME_DROIDINFO);
+			// The shared order and target are sent once per group.
 			NETQueuedDroidInfo(&*eqBegin);
 
 			uint32_t num = eqEnd - eqBegin;
@@ -531,8 +548,8 @@ void sendQueuedDroidInfo()
 
 				prevDroidId = droidId;
 			}
-		NETend();
-	}
+		}
+	NETend();
 
 	// Sent the orders. Don't send them again.
 	queuedOrders.clear();
@@ -612,97 +629,109 @@ void sendDroidInfo(DROID *psDroid, DROID_ORDER order, uint32_t x, uint32_t y, co
 
 // ////////////////////////////////////////////////////////////////////////////
 // receive droid information form other players.
-bool recvDroidInfo(NETQUEUE queue)
+/// Decodes one group of droids which were given the same order, and gives them the order. Must be called between NETbeginDecode and NETend.
+static void recvQueuedDroidInfoGroup(NETQUEUE queue)
 {
-	NETbeginDecode(queue, GAME_DROIDINFO);
-	{
-		QueuedDroidInfo info;
-		memset(&info, 0x00, sizeof(info));
-		NETQueuedDroidInfo(&info);
+	QueuedDroidInfo info;
+	memset(&info, 0x00, sizeof(info));
+	NETQueuedDroidInfo(&info);
 
-		STRUCTURE_STATS *psStats = NULL;
-		if (info.subType == LocOrder && (info.order == DORDER_BUILD || info.order == DORDER_LINEBUILD))
+	STRUCTURE_STATS *psStats = NULL;
+	if (info.subType == LocOrder && (info.order == DORDER_BUILD || info.order == DORDER_LINEBUILD))
+	{
+		// Find structure target
+		for (unsigned typeIndex = 0; typeIndex < numStructureStats; typeIndex++)
 		{
-			// Find structure target
-			for (unsigned typeIndex = 0; typeIndex < numStructureStats; typeIndex++)
+			if (asStructureStats[typeIndex].ref == info.structRef)
 			{
-				if (asStructureStats[typeIndex].ref == info.structRef)
-				{
-					psStats = asStructureStats + typeIndex;
-					break;
-				}
+				psStats = asStructureStats + typeIndex;
+				break;
 			}
 		}
+	}
 
-		switch (info.subType)
-		{
-			case ObjOrder:       syncDebug("Order=%s,%d(%d)", getDroidOrderName(info.order), info.destId, info.destType); break;
-			case LocOrder:       syncDebug("Order=%s,(%d,%d)", getDroidOrderName(info.order), info.x, info.y); break;
-			case SecondaryOrder: syncDebug("SecondaryOrder=%d,%08X", (int)info.secOrder, (int)info.secState); break;
-		}
+	switch (info.subType)
+	{
+		case ObjOrder:       syncDebug("Order=%s,%d(%d)", getDroidOrderName(info.order), info.destId, info.destType); break;
+		case LocOrder:       syncDebug("Order=%s,(%d,%d)", getDroidOrderName(info.order), info.x, info.y); break;
+		case SecondaryOrder: syncDebug("SecondaryOrder=%d,%08X", (int)info.secOrder, (int)info.secState); break;
+	}
 
-		DROID_ORDER_DATA sOrder = infoToOrderData(info, psStats);
+	DROID_ORDER_DATA sOrder = infoToOrderData(info, psStats);
+
+	uint32_t num = 0;
+	NETuint32_t(&num);
 
-		uint32_t num = 0;
-		NETuint32_t(&num);
+	for (unsigned n = 0; n < num; ++n)
+	{
+		// Get the next droid ID which is being given this order.
+		uint32_t deltaDroidId = 0;
+		NETuint32_t(&deltaDroidId);
+		info.droidId += deltaDroidId;
 
-		for (unsigned n = 0; n < num; ++n)
+		DROID *psDroid = IdToDroid(info.droidId, info.player);
+		if (!psDroid)
 		{
-			// Get the next droid ID which is being given this order.
-			uint32_t deltaDroidId = 0;
-			NETuint32_t(&deltaDroidId);
-			info.droidId += deltaDroidId;
+			debug(LOG_NEVER, "Packet from %d refers to non-existent droid %u, [%s : p%d]",
+			      queue.index, info.droidId, isHumanPlayer(info.player) ? "Human" : "AI", info.player);
+			syncDebug("Droid %d missing", info.droidId);
+			continue;  // Can't find the droid, so skip this droid.
+		}
 
-			DROID *psDroid = IdToDroid(info.droidId, info.player);
-			if (!psDroid)
-			{
-				debug(LOG_NEVER, "Packet from %d refers to non-existent droid %u, [%s : p%d]",
-				      queue.index, info.droidId, isHumanPlayer(info.player) ? "Human" : "AI", info.player);
-				syncDebug("Droid %d missing", info.droidId);
-				continue;  // Can't find the droid, so skip this droid.
-			}
+		CHECK_DROID(psDroid);
 
-			CHECK_DROID(psDroid);
+		syncDebugDroid(psDroid, '<');
 
-			syncDebugDroid(psDroid, '<');
+		switch (info.subType)
+		{
+			case ObjOrder:
+			case LocOrder:
+				/*
+				* If the current order not is a command order and we are not a
+				* commander yet are in the commander group remove us from it.
+				*/
+				if (hasCommander(psDroid))
+				{
+					psDroid->psGroup->remove(psDroid);
+				}
 
-			switch (info.subType)
-			{
-				case ObjOrder:
-				case LocOrder:
-					/*
-					* If the current order not is a command order and we are not a
-					* commander yet are in the commander group remove us from it.
-					*/
-					if (hasCommander(psDroid))
+				if (sOrder.psObj != TargetMissing)  // Only do order if the target didn't die.
+				{
+					if (!info.add)
 					{
-						psDroid->psGroup->remove(psDroid);
+						orderDroidListEraseRange(psDroid, 0, psDroid->listSize + 1);  // Clear all non-pending orders, plus the first pending order (which is probably the order we just received).
+						orderDroidBase(psDroid, &sOrder);  // Execute the order immediately (even if in the middle of another order.
 					}
-
-					if (sOrder.psObj != TargetMissing)  // Only do order if the target didn't die.
+					else
 					{
-						if (!info.add)
-						{
-							orderDroidListEraseRange(psDroid, 0, psDroid->listSize + 1);  // Clear all non-pending orders, plus the first pending order (which is probably the order we just received).
-							orderDroidBase(psDroid, &sOrder);  // Execute the order immediately (even if in the middle of another order.
-						}
-						else
-						{
-							orderDroidAdd(psDroid, &sOrder);   // Add the order to the (non-pending) list. Will probably overwrite the corresponding pending order, assuming all pending orders were written to the list.
-						}
+						orderDroidAdd(psDroid, &sOrder);   // Add the order to the (non-pending) list. Will probably overwrite the corresponding pending order, assuming all pending orders were written to the list.
 					}
-					break;
-				case SecondaryOrder:
-					// Set the droids secondary order
-					turnOffMultiMsg(true);
-					secondarySetState(psDroid, info.secOrder, info.secState);
-					turnOffMultiMsg(false);
-					break;
-			}
+				}
+				break;
+			case SecondaryOrder:
+				// Set the droids secondary order
+				turnOffMultiMsg(true);
+				secondarySetState(psDroid, info.secOrder, info.secState);
+				turnOffMultiMsg(false);
+				break;
+		}
+
+		syncDebugDroid(psDroid, '>');
+
+		CHECK_DROID(psDroid);
+	}
+}
 
-			syncDebugDroid(psDroid, '>');
+bool recvDroidInfo(NETQUEUE queue)
+{
+	NETbeginDecode(queue, GAME_DROIDINFO);
+	{
+		uint32_t numGroups = 0;
+		NETuint32_t(&numGroups);
 
-			CHECK_DROID(psDroid);
+		for (unsigned group = 0; group < numGroups; ++group)
+		{
+			recvQueuedDroidInfoGroup(queue);
 		}
 	}
 	NETend();
@@ -915,6 +915,7 @@ bool recvPing(NETQUEUE queue)
 	{
 		// Work out how long it took them to respond
 		ingame.PingTimes[sender] = (realTime - PingSend[sender]) / 2;
+		NETlogPing(sender, realTime - PingSend[sender]);
 
 		// Note that we have received it
 		PingSend[sender] = 0;
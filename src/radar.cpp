@@ -18,6 +18,8 @@
 	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
 */
 #include <string.h>
+#include <algorithm>
+#include <vector>
 
 #include "lib/framework/frame.h"
 #include "lib/framework/fixedpoint.h"
@@ -55,7 +57,24 @@ bool rotateRadar; ///< Rotate the radar?
 
 static PIELIGHT		colRadarAlly, colRadarMe, colRadarEnemy;
 static PIELIGHT		tileColours[MAX_TILES];
-static UDWORD		*radarBuffer = NULL;
+static UDWORD		*radarBuffer = NULL;	///< What the radar shows, the tiles with the objects on top
+
+/* The radar texture is only updated where the picture changed. The tile colours are only worked out
+ * again for tiles whose colour inputs changed, and the objects are kept apart, to be taken off and
+ * put back each refresh without touching the tiles. */
+struct RADAR_PIXEL
+{
+	size_t	pos;		///< In radarBuffer
+	UDWORD	colour;
+};
+
+static std::vector<UDWORD>	radarTiles;		///< Colours of the tiles alone
+static std::vector<uint64_t>	radarTileKeys;		///< What each tile colour was worked out from, see radarTileKey()
+static bool			radarTilesValid = false;	///< Whether radarTileKeys can be trusted
+static std::vector<RADAR_PIXEL>	radarObjectPixels;	///< Pixels with an object on, in the order drawn
+static std::vector<bool>	radarDirtyRows;		///< Rows of radarBuffer that differ from the radar texture
+static bool			radarTextureValid = false;	///< Whether the radar texture has the current size and filter
+static bool			radarTextureFilter = false;
 
 PIELIGHT clanColours[]=
 {	// see frontend2.png for team color order.
@@ -106,6 +125,7 @@ static int frameSkip = 0;
 
 static void DrawRadarTiles(void);
 static void DrawRadarObjects(void);
+static void UploadRadar(bool filter);
 static void DrawRadarExtras(float radarX, float radarY, float pixSizeH, float pixSizeV);
 static void DrawNorth(void);
 
@@ -147,6 +167,7 @@ bool InitRadar(void)
 		RadarZoom = DEFAULT_RADARZOOM * 2;
 	}
 	pie_InitRadar();
+	radarTextureValid = false;
 
 	return true;
 }
@@ -168,6 +189,12 @@ bool resizeRadar(void)
 		return false;
 	}
 	memset(radarBuffer, 0, radarBufferSize);
+	radarTiles.assign(radarTexWidth * radarTexHeight, 0);
+	radarTileKeys.assign(radarTexWidth * radarTexHeight, 0);
+	radarTilesValid = false;
+	radarObjectPixels.clear();
+	radarDirtyRows.assign(radarTexHeight, false);
+	radarTextureValid = false;
         if (rotateRadar)
 	{
 		RadarZoomMultiplier = (float)MAX(RADWIDTH, RADHEIGHT) / (float)MAX(radarTexWidth, radarTexHeight);
@@ -188,6 +215,11 @@ bool ShutdownRadar(void)
 
 	free(radarBuffer);
 	radarBuffer = NULL;
+	radarTiles.clear();
+	radarTileKeys.clear();
+	radarObjectPixels.clear();
+	radarDirtyRows.clear();
+	radarTextureValid = false;
 
 	return true;
 }
@@ -294,7 +326,7 @@ void drawRadar(void)
 		}
 		DrawRadarTiles();
 		DrawRadarObjects();
-		pie_DownLoadRadar(radarBuffer, radarTexWidth, radarTexHeight, filter);
+		UploadRadar(filter);
 		frameSkip = RADAR_FRAME_SKIP;
 	}
 	frameSkip--;
@@ -418,31 +450,80 @@ static PIELIGHT appliedRadarColour(RADAR_DRAW_MODE radarDrawMode, MAPTILE *WTile
 	return WScr;
 }
 
-/** Draw the map tiles on the radar. */
+/** Everything appliedRadarColour() works out the colour of a tile from. */
+static uint64_t radarTileKey(MAPTILE *psTile)
+{
+	return psTile->texture
+	     | psTile->illumination << 16
+	     | (TEST_TILE_VISIBLE(selectedPlayer, psTile) != 0) << 24
+	     | hasSensorOnTile(psTile, selectedPlayer) << 25
+	     | getRevealStatus() << 26
+	     | radarDrawMode << 27
+	     | (uint64_t)(uint32_t)psTile->height << 32;
+}
+
+/** Draw the map tiles on the radar, those that changed since the last time. */
 static void DrawRadarTiles(void)
 {
 	SDWORD	x, y;
 
-	for (x = scrollMinX; x < scrollMaxX; x++)
+	for (y = scrollMinY; y < scrollMaxY; y++)
 	{
-		for (y = scrollMinY; y < scrollMaxY; y++)
+		for (x = scrollMinX; x < scrollMaxX; x++)
 		{
 			MAPTILE	*psTile = mapTile(x, y);
 			size_t pos = radarTexWidth * (y - scrollMinY) + (x - scrollMinX);
+			uint64_t key = radarTileKey(psTile);
 
 			ASSERT(pos * sizeof(*radarBuffer) < radarBufferSize, "Buffer overrun");
-			radarBuffer[pos] = appliedRadarColour(radarDrawMode, psTile).rgba;
+			if (radarTilesValid && radarTileKeys[pos] == key)
+			{
+				continue;
+			}
+			radarTileKeys[pos] = key;
+			radarTiles[pos] = appliedRadarColour(radarDrawMode, psTile).rgba;
+			radarBuffer[pos] = radarTiles[pos];
+			radarDirtyRows[y - scrollMinY] = true;
 		}
 	}
+	radarTilesValid = true;
 }
 
-/** Draw the droids and structure positions on the radar. */
+static bool radarPixelBefore(RADAR_PIXEL const &a, RADAR_PIXEL const &b)
+{
+	return a.pos < b.pos;
+}
+
+/** Put an object on the radar. */
+static void radarPlot(int x, int y, PIELIGHT colour)
+{
+	RADAR_PIXEL pixel;
+
+	pixel.pos = (x - scrollMinX) + (y - scrollMinY) * radarTexWidth;
+	pixel.colour = colour.rgba;
+	ASSERT_OR_RETURN(, pixel.pos * sizeof(*radarBuffer) < radarBufferSize, "Buffer overrun");
+	radarBuffer[pixel.pos] = pixel.colour;
+	radarObjectPixels.push_back(pixel);
+}
+
+/** Draw the droids and structure positions on the radar, in place of the ones drawn last time. */
 static void DrawRadarObjects(void)
 {
 	UBYTE				clan;
 	PIELIGHT			playerCol;
 	PIELIGHT			flashCol;
-	int				x, y;
+	std::vector<RADAR_PIXEL>	oldPixels;
+
+	/* Take the objects drawn last time off, remembering what was shown */
+	oldPixels.swap(radarObjectPixels);
+	for (std::vector<RADAR_PIXEL>::iterator pixel = oldPixels.begin(); pixel != oldPixels.end(); ++pixel)
+	{
+		pixel->colour = radarBuffer[pixel->pos];
+	}
+	for (std::vector<RADAR_PIXEL>::const_iterator pixel = oldPixels.begin(); pixel != oldPixels.end(); ++pixel)
+	{
+		radarBuffer[pixel->pos] = radarTiles[pixel->pos];
+	}
 
    	/* Show droids on map - go through all players */
    	for(clan = 0; clan < MAX_PLAYERS; clan++)
@@ -485,72 +566,115 @@ static void DrawRadarObjects(void)
 			{
 				int	x = psDroid->pos.x / TILE_UNITS;
    				int	y = psDroid->pos.y / TILE_UNITS;
-				size_t	pos = (x - scrollMinX) + (y - scrollMinY) * radarTexWidth;
 
-				ASSERT(pos * sizeof(*radarBuffer) < radarBufferSize, "Buffer overrun");
 				if (clan == selectedPlayer && gameTime-psDroid->timeLastHit < HIT_NOTIFICATION)
 				{
-					radarBuffer[pos] = flashCol.rgba;
+					radarPlot(x, y, flashCol);
 				}
 				else
 				{
-					radarBuffer[pos] = playerCol.rgba;
+					radarPlot(x, y, playerCol);
 				}
 			}
    		}
    	}
 
-   	/* Do the same for structures */
-	for (x = scrollMinX; x < scrollMaxX; x++)
+	/* Do the same for structures, on all the tiles they cover */
+	for (clan = 0; clan < MAX_PLAYERS; clan++)
 	{
-		for (y = scrollMinY; y < scrollMaxY; y++)
-		{
-			MAPTILE		*psTile = mapTile(x, y);
-			STRUCTURE	*psStruct;
-			size_t		pos = (x - scrollMinX) + (y - scrollMinY) * radarTexWidth;
+		STRUCTURE	*psStruct;
 
-			ASSERT(pos * sizeof(*radarBuffer) < radarBufferSize, "Buffer overrun");
-			if (!TileHasStructure(psTile))
+		//see if have to draw enemy/ally color
+		if (bEnemyAllyRadarColor)
+		{
+			if (clan == selectedPlayer)
 			{
-				continue;
+				playerCol = colRadarMe;
 			}
-			psStruct = (STRUCTURE *)psTile->psObject;
-			clan = psStruct->player;
-
-			//see if have to draw enemy/ally color
-			if (bEnemyAllyRadarColor)
+			else
 			{
-				if (clan == selectedPlayer)
-				{
-					playerCol = colRadarMe;
-				}
-				else
-				{
-					playerCol = (aiCheckAlliances(selectedPlayer, clan) ? colRadarAlly: colRadarEnemy);
-				}
-			} 
-			else 
+				playerCol = (aiCheckAlliances(selectedPlayer, clan) ? colRadarAlly: colRadarEnemy);
+			}
+		}
+		else
+		{
+			//original 8-color mode
+			playerCol = clanColours[getPlayerColour(clan)];
+		}
+		flashCol = flashColours[getPlayerColour(clan)];
+
+		for (psStruct = apsStructLists[clan]; psStruct != NULL; psStruct = psStruct->psNext)
+		{
+			if (!psStruct->visible[selectedPlayer]
+			    && !(bMultiPlayer && game.alliance == ALLIANCES_TEAMS
+			         && aiCheckAlliances(selectedPlayer, psStruct->player)))
 			{
-				//original 8-color mode
-				playerCol = clanColours[getPlayerColour(clan)];
+				continue;
 			}
-			flashCol = flashColours[getPlayerColour(clan)];
 
-			if (psStruct->visible[selectedPlayer]
-			    || (bMultiPlayer && game.alliance == ALLIANCES_TEAMS
-			        && aiCheckAlliances(selectedPlayer, psStruct->player)))
+			Vector2i size = getStructureSize(psStruct);
+			Vector2i map = map_coord(removeZ(psStruct->pos)) - size/2;
+			PIELIGHT col = clan == selectedPlayer && gameTime - psStruct->timeLastHit < HIT_NOTIFICATION ? flashCol : playerCol;
+			int x, y;
+
+			for (y = MAX(map.y, scrollMinY); y < MIN(map.y + size.y, scrollMaxY); y++)
 			{
-				if (clan == selectedPlayer && gameTime - psStruct->timeLastHit < HIT_NOTIFICATION)
+				for (x = MAX(map.x, scrollMinX); x < MIN(map.x + size.x, scrollMaxX); x++)
 				{
-					radarBuffer[pos] = flashCol.rgba;
-				}
-				else
-				{
-					radarBuffer[pos] = playerCol.rgba;
+					radarPlot(x, y, col);
 				}
 			}
-   		}
-   	}
+		}
+	}
+
+	/* Mark the rows where what is shown changed: where objects were taken off and not put back the
+	 * same, and where objects now cover a tile they didn't cover before. Tiles that changed colour
+	 * are marked already. */
+	std::sort(oldPixels.begin(), oldPixels.end(), radarPixelBefore);
+	for (std::vector<RADAR_PIXEL>::const_iterator pixel = oldPixels.begin(); pixel != oldPixels.end(); ++pixel)
+	{
+		if (radarBuffer[pixel->pos] != pixel->colour)
+		{
+			radarDirtyRows[pixel->pos / radarTexWidth] = true;
+		}
+	}
+	for (std::vector<RADAR_PIXEL>::const_iterator pixel = radarObjectPixels.begin(); pixel != radarObjectPixels.end(); ++pixel)
+	{
+		if (!std::binary_search(oldPixels.begin(), oldPixels.end(), *pixel, radarPixelBefore)
+		    && radarBuffer[pixel->pos] != radarTiles[pixel->pos])
+		{
+			radarDirtyRows[pixel->pos / radarTexWidth] = true;
+		}
+	}
+}
+
+/** Send the rows of the radar that changed to the radar texture. */
+static void UploadRadar(bool filter)
+{
+	int	first, last;
+
+	if (!radarTextureValid || filter != radarTextureFilter)
+	{
+		pie_DownLoadRadar(radarBuffer, radarTexWidth, radarTexHeight, filter);
+		radarTextureValid = true;
+		radarTextureFilter = filter;
+		radarDirtyRows.assign(radarTexHeight, false);
+		return;
+	}
+
+	for (first = 0; first < radarTexHeight; first = last)
+	{
+		if (!radarDirtyRows[first])
+		{
+			last = first + 1;
+			continue;
+		}
+		for (last = first; last < radarTexHeight && radarDirtyRows[last]; last++)
+		{
+			radarDirtyRows[last] = false;
+		}
+		pie_UpdateRadar(radarBuffer, radarTexWidth, first, last - first);
+	}
 }
 
 /** Rotate an array of 2d vectors about a given angle, also translates them after rotating. */
@@ -698,4 +822,5 @@ void radarColour(UDWORD tileNumber, uint8_t r, uint8_t g, uint8_t b)
 	tileColours[tileNumber].byte.g = g;
 	tileColours[tileNumber].byte.b = b;
 	tileColours[tileNumber].byte.a = 255;
+	radarTilesValid = false;
 }
@@ -70,7 +70,7 @@ static UWORD setIconID(char *pIconName, char *pName);
 static COMPONENT_STATS * getComponentDetails(char *pName, char *pCompName);
 static void replaceComponent(COMPONENT_STATS *pNewComponent, COMPONENT_STATS *pOldComponent,
 					  UBYTE player);
-static bool checkResearchName(RESEARCH *psRes, UDWORD numStats);
+static bool checkResearchName(RESEARCH *psRes);
 
 static const char *getResearchName(RESEARCH *pResearch)
 {
@@ -95,6 +95,7 @@ bool researchInitVars(void)
 	psCBLastResStructure = NULL;
 	CBResFacilityOwner = -1;
 	asResearch.clear();
+	statsIndexClear(STATS_INDEX_RESEARCH);
 
 	for (int i = 0; i < MAX_PLAYERS; i++)
 	{
@@ -147,7 +148,7 @@ bool loadResearch(const char *pResearchData, UDWORD bufferSize)
 		ASSERT_OR_RETURN(false, research.pName != NULL, "Failed allocating research name");
 
 		//check the name hasn't been used already
-		ASSERT_OR_RETURN(false, checkResearchName(&research, i), "Research name %s used already", research.pName);
+		ASSERT_OR_RETURN(false, checkResearchName(&research), "Research name %s used already", research.pName);
 
 		pResearchData += (strlen(ResearchName)+1);
 		research.ref = REF_RESEARCH_START + i;
@@ -293,6 +294,7 @@ bool loadResearch(const char *pResearchData, UDWORD bufferSize)
 		//increment the pointer to the start of the next record
 		pResearchData = strchr(pResearchData,'\n') + 1;
 		asResearch.push_back(research);
+		statsIndexAdd(STATS_INDEX_RESEARCH, research.pName, i);
 	}
 
 	return true;
@@ -307,34 +309,19 @@ bool loadResearchPR(const char *pPRData, UDWORD bufferSize)
 
 	for (int i = 0; i < NumToAlloc; i++)
 	{
-		bool recFound = false;
-
 		//read the data into the storage - the data is delimited using commas
 		ResearchName[0] = '\0';
 		PRName[0] = '\0';
 		sscanf(pPRData,"%255[^,'\r\n],%255[^,'\r\n],%*d", ResearchName, PRName);
 
-		//loop through each Research to compare the name
-		for (int incR = 0; incR < asResearch.size(); incR++)
-		{
-			if (!(strcmp(ResearchName, asResearch[incR].pName)))
-			{
-				//Research found
-				for (int incPR = 0; incPR < asResearch.size(); incPR++)
-				{
-					if (!(strcmp(PRName, asResearch[incPR].pName)))
-					{
-						//PRresearch found alloc this to the current Research
-						asResearch[incR].pPRList.push_back(incPR);
-						recFound = true;
-						break;
-					}
-				}
-				ASSERT_OR_RETURN(false, recFound, "Unable to find Pre-requisite %s for research %s", PRName, ResearchName);
-				break;
-			}
-		}
-		ASSERT_OR_RETURN(false, recFound, "Unable to find Research %s", ResearchName);
+		int incR = statsIndexFind(STATS_INDEX_RESEARCH, ResearchName);
+		ASSERT_OR_RETURN(false, incR >= 0, "Unable to find Research %s", ResearchName);
+		int incPR = statsIndexFind(STATS_INDEX_RESEARCH, PRName);
+		ASSERT_OR_RETURN(false, incPR >= 0, "Unable to find Pre-requisite %s for research %s", PRName, ResearchName);
+
+		//PRresearch found alloc this to the current Research
+		asResearch[incR].pPRList.push_back(incPR);
+
 		// increment the pointer to the start of the next record
 		pPRData = strchr(pPRData,'\n') + 1;
 	}
@@ -439,69 +426,48 @@ bool loadResearchStructures(const char *pStructData, UDWORD bufferSize,UDWORD li
 	const unsigned int NumToAlloc = numCR(pStructData, bufferSize);
 	unsigned int i = 0;
 	char				ResearchName[MAX_STR_LENGTH], StructureName[MAX_STR_LENGTH];
-	UWORD				incR, incS;
-	STRUCTURE_STATS		*pStructure = asStructureStats;
-	bool				recFound;
+	int					incR, incS;
 
 	for (i = 0; i < NumToAlloc; i++)
 	{
-		recFound = false;
-
 		//read the data into the storage - the data is delimited using comma's
 		ResearchName[0] = '\0';
 		StructureName[0] = '\0';
 		sscanf(pStructData,"%255[^,'\r\n],%255[^,'\r\n],%*d,%*d", ResearchName, StructureName);
 
-		//loop through each Research to compare the name
-		for (incR = 0; incR < asResearch.size(); incR++)
-		{
-			if (!(strcmp(ResearchName, asResearch[incR].pName)))
-			{
-				//Research found
-				for (incS = 0; incS < numStructureStats; incS++)
-				{
-					if (!(strcmp(StructureName, pStructure[incS].pName)))
-					{
-						//Structure found - alloc this to the current Research
-						switch (listNumber)
-						{
-							case REQ_LIST:
-								asResearch[incR].pStructList.push_back(incS);
-								break;
-							case RED_LIST:
-								asResearch[incR].pRedStructs.push_back(incS);
-								break;
-							case RES_LIST:
-								asResearch[incR].pStructureResults.push_back(incS);
-								break;
-							default:
-								/* NO DEFAULT CASE? Alex.... Here ya go - just for you...*/
-								debug( LOG_FATAL, "Unknown research list" );
-								abort();
-								return false;
-						}
-						recFound = true;
-						break;
-					}
-				}
-				//if Structure not found - error
-				if (!recFound)
-				{
-					debug(LOG_FATAL, "Unable to find Structure %s for research %s", StructureName, ResearchName);
-					return false;
-				}
-				else
-				{
-					break;
-				}
-			}
-		}
+		incR = statsIndexFind(STATS_INDEX_RESEARCH, ResearchName);
 		//if Research not found - error
-		if (!recFound)
+		if (incR < 0)
 		{
 			debug(LOG_FATAL, "Unable to allocate all Research Structures for %s", ResearchName);
 			return false;
 		}
+		incS = getStructStatFromName(StructureName);
+		//if Structure not found - error
+		if (incS < 0)
+		{
+			debug(LOG_FATAL, "Unable to find Structure %s for research %s", StructureName, ResearchName);
+			return false;
+		}
+
+		//Structure found - alloc this to the current Research
+		switch (listNumber)
+		{
+			case REQ_LIST:
+				asResearch[incR].pStructList.push_back(incS);
+				break;
+			case RED_LIST:
+				asResearch[incR].pRedStructs.push_back(incS);
+				break;
+			case RES_LIST:
+				asResearch[incR].pStructureResults.push_back(incS);
+				break;
+			default:
+				/* NO DEFAULT CASE? Alex.... Here ya go - just for you...*/
+				debug( LOG_FATAL, "Unknown research list" );
+				abort();
+				return false;
+		}
 		//increment the pointer to the start of the next record
 		pStructData = strchr(pStructData,'\n') + 1;
 	}
@@ -515,54 +481,34 @@ bool loadResearchFunctions(const char *pFunctionData, UDWORD bufferSize)
 	const unsigned int NumToAlloc = numCR(pFunctionData, bufferSize);
 	unsigned int i = 0;
 	char				ResearchName[MAX_STR_LENGTH], FunctionName[MAX_STR_LENGTH];
-	UDWORD				incR, incF;
-	FUNCTION			**pFunction = asFunctions;
-	bool				recFound;
+	int					incR, incF;
 
 	for (i=0; i < NumToAlloc; i++)
 	{
-		recFound = false;
 		//read the data into the storage - the data is delimited using comma's
 		ResearchName[0] = '\0';
 		FunctionName[0] = '\0';
 		sscanf(pFunctionData,"%255[^,'\r\n],%255[^,'\r\n],%*d", ResearchName, FunctionName);
 
-		//loop through each Research to compare the name
-		for (incR=0; incR < asResearch.size(); incR++)
-		{
-			if (!(strcmp(ResearchName, asResearch[incR].pName)))
-			{
-				//Research found
-				for (incF=0; incF < numFunctions; incF++)
-				{
-					if (!(strcmp(FunctionName, (*pFunction[incF]).pName)))
-					{
-						// Function found alloc this to the current Research
-						asResearch[incR].pFunctionList.push_back(pFunction[incF]);
-						recFound = true;
-						break;
-					}
-				}
-				//if Function not found - error
-				if (!recFound)
-				{
-					debug( LOG_ERROR, "Unable to find Function %s for research %s", FunctionName, ResearchName );
-					abort();
-					return false;
-				}
-				else
-				{
-					break;
-				}
-			}
-		}
+		incR = statsIndexFind(STATS_INDEX_RESEARCH, ResearchName);
 		//if Research not found - error
-		if (!recFound)
+		if (incR < 0)
 		{
 			debug( LOG_ERROR, "Unable to allocate all research Functions for %s", ResearchName );
 			abort();
 			return false;
 		}
+		incF = statsIndexFind(STATS_INDEX_FUNCTION, FunctionName);
+		//if Function not found - error
+		if (incF < 0)
+		{
+			debug( LOG_ERROR, "Unable to find Function %s for research %s", FunctionName, ResearchName );
+			abort();
+			return false;
+		}
+
+		// Function found alloc this to the current Research
+		asResearch[incR].pFunctionList.push_back(asFunctions[incF]);
 
 		//increment the pointer to the start of the next record
 		pFunctionData = strchr(pFunctionData,'\n') + 1;
@@ -1204,6 +1150,7 @@ bool ResearchShutDown(void)
 void ResearchRelease(void)
 {
 	asResearch.clear();
+	statsIndexClear(STATS_INDEX_RESEARCH);
 	for (int i = 0; i < MAX_PLAYERS; i++)
 	{
 		asPlayerResList[i].clear();
@@ -1600,97 +1547,59 @@ SDWORD	mapIconToRID(UDWORD iconID)
 /* returns a pointer to a component based on the name - used to load in the research */
 COMPONENT_STATS * getComponentDetails(char *pName, char *pCompName)
 {
-	UDWORD stat, size, quantity, inc;
-	COMPONENT_STATS		*pArtefact;
+	UDWORD stat = componentType(pName);
+	int inc;
 
-	stat = componentType(pName);
-	//get the stat list
+	if (stat == COMP_UNKNOWN || stat >= COMP_NUMCOMPONENTS)
+	{
+		//COMP_UNKNOWN should be an error
+		debug( LOG_ERROR, "Unknown artefact type  - %s", pName );
+		abort();
+		return NULL;
+	}
+
+	inc = getCompFromName(stat, pCompName);
+	if (inc < 0)
+	{
+		debug( LOG_ERROR, "Cannot find component %s", pCompName );
+		abort();
+		return NULL;
+	}
+
+	//get the stat from its list
 	switch (stat)
 	{
 		case COMP_BODY:
-		{
-			pArtefact = (COMPONENT_STATS*)asBodyStats;
-			size = sizeof(BODY_STATS);
-			quantity = numBodyStats;
-			break;
-		}
+			return &asBodyStats[inc];
 		case COMP_BRAIN:
-		{
-			pArtefact = (COMPONENT_STATS*)asBrainStats;
-			size = sizeof(BRAIN_STATS);
-			quantity = numBrainStats;
-			break;
-		}
+			return &asBrainStats[inc];
 		case COMP_PROPULSION:
-		{
-			pArtefact = (COMPONENT_STATS*)asPropulsionStats;
-			size = sizeof(PROPULSION_STATS);
-			quantity = numPropulsionStats;
-			break;
-		}
+			return &asPropulsionStats[inc];
 		case COMP_REPAIRUNIT:
-		{
-			pArtefact = (COMPONENT_STATS*)asRepairStats;
-			size = sizeof(REPAIR_STATS);
-			quantity = numRepairStats;
-			break;
-		}
+			return &asRepairStats[inc];
 		case COMP_ECM:
-		{
-			pArtefact = (COMPONENT_STATS*)asECMStats;
-			size = sizeof(ECM_STATS);
-			quantity = numECMStats;
-			break;
-		}
+			return &asECMStats[inc];
 		case COMP_SENSOR:
-		{
-			pArtefact = (COMPONENT_STATS*)asSensorStats;
-			size = sizeof(SENSOR_STATS);
-			quantity = numSensorStats;
-			break;
-		}
+			return &asSensorStats[inc];
 		case COMP_WEAPON:
-		{
-			pArtefact = (COMPONENT_STATS*)asWeaponStats;
-			size = sizeof(WEAPON_STATS);
-			quantity = numWeaponStats;
-			break;
-		}
+			return &asWeaponStats[inc];
 		case COMP_CONSTRUCT:
-		{
-			pArtefact = (COMPONENT_STATS*)asConstructStats;
-			size = sizeof(CONSTRUCT_STATS);
-			quantity = numConstructStats;
-			break;
-		}
-		default:
-		{
-			//COMP_UNKNOWN should be an error
-			debug( LOG_ERROR, "Unknown artefact type  - %s", pName );
-			abort();
-			return false;
-		}
-	}
-
-	for (inc = 0; inc < quantity; inc++)
-	{
-		if (!strcmp(pArtefact->pName, pCompName))
-		{
-			return pArtefact;
-		}
-		pArtefact = (COMPONENT_STATS*)((char*)pArtefact + size);
+			return &asConstructStats[inc];
 	}
-
-	debug( LOG_ERROR, "Cannot find component %s", pCompName );
-	abort();
 	return NULL;
 }
 
 //return a pointer to a research topic based on the name
 RESEARCH *getResearch(const char *pName)
 {
-	unsigned int inc = 0;
+	int inc = statsIndexFind(STATS_INDEX_RESEARCH, pName);
+
+	if (inc >= 0)
+	{
+		return &asResearch[inc];
+	}
 
+	// Names are matched ignoring case, which the index does not do
 	for (inc = 0; inc < asResearch.size(); inc++)
 	{
 		if (!strcasecmp(asResearch[inc].pName, pName))
@@ -1773,20 +1682,13 @@ static void replaceComponent(COMPONENT_STATS *pNewComponent, COMPONENT_STATS *pO
 
 /*Looks through all the currently allocated stats to check the name is not
 a duplicate*/
-static bool checkResearchName(RESEARCH *psResearch, UDWORD numStats)
+static bool checkResearchName(RESEARCH *psResearch)
 {
-	UDWORD inc;
-	char *pName=psResearch->pName;
-
-	for (inc = 0; inc < numStats; inc++)
+	if (statsIndexFind(STATS_INDEX_RESEARCH, psResearch->pName) >= 0)
 	{
-
-		if (!strcmp(asResearch[inc].pName, pName))
-		{
-			//oops! found the name
-			ASSERT( false, "Research name has already been used - %s", pName );
-			return false;
-		}
+		//oops! found the name
+		ASSERT( false, "Research name has already been used - %s", psResearch->pName );
+		return false;
 	}
 	return true;
 }
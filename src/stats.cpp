@@ -373,15 +373,129 @@ unsigned LineView::eu(unsigned int index, std::vector<std::pair<char const *, un
 }
 
 
+/*******************************************************************************
+*		Name index
+*******************************************************************************/
+
+struct StatsIndexEntry
+{
+	std::string name;
+	UDWORD      hash;
+	int         list;   ///< COMPONENT_TYPE or STATS_INDEX_LIST of the stat, -1 if the slot is free
+	int         index;  ///< Index of the stat in its list
+};
+
+static std::vector<StatsIndexEntry> statsIndex;  ///< Open addressing with linear probing, size is a power of two
+static unsigned statsIndexCount = 0;
+static unsigned statsIndexShift = 32;            ///< 32 - log2(statsIndex.size())
+
+static inline unsigned statsIndexSlot(UDWORD hash, int list)
+{
+	// Fibonacci hashing of the name hash mixed with the list, so equal names in different lists land apart
+	return (uint32_t)((hash + list * 0x61c88647u) * 2654435769u) >> statsIndexShift;
+}
+
+static StatsIndexEntry *statsIndexLookup(int list, const char *pName, UDWORD hash)
+{
+	unsigned mask = statsIndex.size() - 1;
+
+	for (unsigned i = statsIndexSlot(hash, list); statsIndex[i].list != -1; i = (i + 1) & mask)
+	{
+		StatsIndexEntry &entry = statsIndex[i];
+		if (entry.hash == hash && entry.list == list && entry.name == pName)
+		{
+			return &entry;
+		}
+	}
+	return NULL;
+}
+
+static void statsIndexInsert(StatsIndexEntry const &entry)
+{
+	unsigned mask = statsIndex.size() - 1;
+	unsigned i;
+
+	for (i = statsIndexSlot(entry.hash, entry.list); statsIndex[i].list != -1; i = (i + 1) & mask) {}
+	statsIndex[i] = entry;
+	++statsIndexCount;
+}
+
+/// Rehash into a table of newSize slots, dropping the entries of dropList
+static void statsIndexRehash(unsigned newSize, int dropList)
+{
+	std::vector<StatsIndexEntry> old(newSize);
+
+	for (unsigned i = 0; i < newSize; ++i)
+	{
+		old[i].list = -1;
+	}
+	statsIndex.swap(old);
+	statsIndexCount = 0;
+	for (statsIndexShift = 32; (1u << (32 - statsIndexShift)) < newSize; --statsIndexShift) {}
+	for (unsigned i = 0; i < old.size(); ++i)
+	{
+		if (old[i].list != -1 && old[i].list != dropList)
+		{
+			statsIndexInsert(old[i]);
+		}
+	}
+}
+
+/* Add a stat name to the name index. If the list already has a stat of that name, the first one is kept. */
+void statsIndexAdd(int list, const char *pName, int index)
+{
+	if (pName == NULL || *pName == '\0')
+	{
+		return;
+	}
+	if ((statsIndexCount + 1) * 2 > statsIndex.size())
+	{
+		statsIndexRehash(std::max<unsigned>(statsIndex.size() * 2, 512), -1);
+	}
+
+	StatsIndexEntry entry;
+	entry.name = pName;
+	entry.hash = HashString(pName);
+	entry.list = list;
+	entry.index = index;
+	if (statsIndexLookup(list, pName, entry.hash) == NULL)
+	{
+		statsIndexInsert(entry);
+	}
+}
+
+/* Find the index of the stat with the given name in the list, or -1 if there is none */
+int statsIndexFind(int list, const char *pName)
+{
+	if (statsIndexCount == 0 || pName == NULL || *pName == '\0')
+	{
+		return -1;
+	}
+
+	StatsIndexEntry *psEntry = statsIndexLookup(list, pName, HashString(pName));
+	return psEntry != NULL ? psEntry->index : -1;
+}
+
+/* Remove all the names of a list from the index, before it is freed or reloaded */
+void statsIndexClear(int list)
+{
+	if (statsIndexCount != 0)
+	{
+		statsIndexRehash(statsIndex.size(), list);
+	}
+}
+
+
 /*******************************************************************************
 *		Generic stats macros/functions
 *******************************************************************************/
 
 /* Macro to allocate memory for a set of stats */
-#define ALLOC_STATS(numEntries, list, listSize, type) \
+#define ALLOC_STATS(numEntries, list, listSize, type, compType) \
 	ASSERT( (numEntries) < REF_RANGE, \
 	"allocStats: number of stats entries too large for " #type );\
 	if ((list))	free((list));	\
+	statsIndexClear(compType); \
 	(list) = (type *)malloc(sizeof(type) * (numEntries)); \
 	if ((list) == NULL) \
 	{ \
@@ -394,8 +508,9 @@ unsigned LineView::eu(unsigned int index, std::vector<std::pair<char const *, un
 
 
 /*Macro to Deallocate stats*/
-#define STATS_DEALLOC(list, listSize, type) \
+#define STATS_DEALLOC(list, listSize, type, compType) \
 	statsDealloc((COMPONENT_STATS*)(list), (listSize), sizeof(type)); \
+	statsIndexClear(compType); \
 	(list) = NULL 
 
 
@@ -459,20 +574,21 @@ static void deallocBodyStats(void)
 	}
 	free(asBodyStats);
 	asBodyStats = NULL;
+	statsIndexClear(COMP_BODY);
 }
 
 /*Deallocate all the stats assigned from input data*/
 bool statsShutDown(void)
 {
-	STATS_DEALLOC(asWeaponStats, numWeaponStats, WEAPON_STATS);
+	STATS_DEALLOC(asWeaponStats, numWeaponStats, WEAPON_STATS, COMP_WEAPON);
 	//STATS_DEALLOC(asBodyStats, numBodyStats, BODY_STATS);
 	deallocBodyStats();
-	STATS_DEALLOC(asBrainStats, numBrainStats, BRAIN_STATS);
-	STATS_DEALLOC(asPropulsionStats, numPropulsionStats, PROPULSION_STATS);
-	STATS_DEALLOC(asSensorStats, numSensorStats, SENSOR_STATS);
-	STATS_DEALLOC(asECMStats, numECMStats, ECM_STATS);
-	STATS_DEALLOC(asRepairStats, numRepairStats, REPAIR_STATS);
-	STATS_DEALLOC(asConstructStats, numConstructStats, CONSTRUCT_STATS);
+	STATS_DEALLOC(asBrainStats, numBrainStats, BRAIN_STATS, COMP_BRAIN);
+	STATS_DEALLOC(asPropulsionStats, numPropulsionStats, PROPULSION_STATS, COMP_PROPULSION);
+	STATS_DEALLOC(asSensorStats, numSensorStats, SENSOR_STATS, COMP_SENSOR);
+	STATS_DEALLOC(asECMStats, numECMStats, ECM_STATS, COMP_ECM);
+	STATS_DEALLOC(asRepairStats, numRepairStats, REPAIR_STATS, COMP_REPAIRUNIT);
+	STATS_DEALLOC(asConstructStats, numConstructStats, CONSTRUCT_STATS, COMP_CONSTRUCT);
 	deallocPropulsionTypes();
 	deallocTerrainTable();
 	deallocSpecialAbility();
@@ -484,10 +600,11 @@ bool statsShutDown(void)
  * The macro uses the ref number in the stats structure to
  * index the correct array entry
  */
-#define SET_STATS(stats, list, index, type, refStart) \
+#define SET_STATS(stats, list, index, type, refStart, compType) \
 	ASSERT( ((stats)->ref >= (refStart)) && ((stats)->ref < (refStart) + REF_RANGE), \
 		"setStats: Invalid " #type " ref number" ); \
-	memcpy((list) + (index), (stats), sizeof(type))
+	memcpy((list) + (index), (stats), sizeof(type)); \
+	statsIndexAdd((compType), (stats)->pName, (index))
 
 
 /* Return the number of newlines in a file buffer */
@@ -513,44 +630,44 @@ UDWORD numCR(const char *pFileBuffer, UDWORD fileSize)
 /* Allocate Weapon stats */
 bool statsAllocWeapons(UDWORD	numStats)
 {
-	ALLOC_STATS(numStats, asWeaponStats, numWeaponStats, WEAPON_STATS);
+	ALLOC_STATS(numStats, asWeaponStats, numWeaponStats, WEAPON_STATS, COMP_WEAPON);
 }
 /* Allocate Body Stats */
 bool statsAllocBody(UDWORD	numStats)
 {
-	ALLOC_STATS(numStats, asBodyStats, numBodyStats, BODY_STATS);
+	ALLOC_STATS(numStats, asBodyStats, numBodyStats, BODY_STATS, COMP_BODY);
 }
 /* Allocate Brain Stats */
 bool statsAllocBrain(UDWORD	numStats)
 {
-	ALLOC_STATS(numStats, asBrainStats, numBrainStats, BRAIN_STATS);
+	ALLOC_STATS(numStats, asBrainStats, numBrainStats, BRAIN_STATS, COMP_BRAIN);
 }
 /* Allocate Propulsion Stats */
 bool statsAllocPropulsion(UDWORD	numStats)
 {
-	ALLOC_STATS(numStats, asPropulsionStats, numPropulsionStats, PROPULSION_STATS);
+	ALLOC_STATS(numStats, asPropulsionStats, numPropulsionStats, PROPULSION_STATS, COMP_PROPULSION);
 }
 /* Allocate Sensor Stats */
 bool statsAllocSensor(UDWORD	numStats)
 {
-	ALLOC_STATS(numStats, asSensorStats, numSensorStats, SENSOR_STATS);
+	ALLOC_STATS(numStats, asSensorStats, numSensorStats, SENSOR_STATS, COMP_SENSOR);
 }
 /* Allocate Ecm Stats */
 bool statsAllocECM(UDWORD	numStats)
 {
-	ALLOC_STATS(numStats, asECMStats, numECMStats, ECM_STATS);
+	ALLOC_STATS(numStats, asECMStats, numECMStats, ECM_STATS, COMP_ECM);
 }
 
 /* Allocate Repair Stats */
 bool statsAllocRepair(UDWORD	numStats)
 {
-	ALLOC_STATS(numStats, asRepairStats, numRepairStats, REPAIR_STATS);
+	ALLOC_STATS(numStats, asRepairStats, numRepairStats, REPAIR_STATS, COMP_REPAIRUNIT);
 }
 
 /* Allocate Construct Stats */
 bool statsAllocConstruct(UDWORD	numStats)
 {
-	ALLOC_STATS(numStats, asConstructStats, numConstructStats, CONSTRUCT_STATS);
+	ALLOC_STATS(numStats, asConstructStats, numConstructStats, CONSTRUCT_STATS, COMP_CONSTRUCT);
 }
 
 const char *getStatName(const void * Stat)
@@ -2331,43 +2448,43 @@ bool loadPropulsionSounds(const char *pPropSoundData, UDWORD bufferSize)
 /* Set the stats for a particular weapon type */
 void statsSetWeapon(WEAPON_STATS	*psStats, UDWORD index)
 {
-	SET_STATS(psStats, asWeaponStats, index, WEAPON_STATS, REF_WEAPON_START);
+	SET_STATS(psStats, asWeaponStats, index, WEAPON_STATS, REF_WEAPON_START, COMP_WEAPON);
 }
 /* Set the stats for a particular body type */
 void statsSetBody(BODY_STATS	*psStats, UDWORD index)
 {
-	SET_STATS(psStats, asBodyStats, index, BODY_STATS, REF_BODY_START);
+	SET_STATS(psStats, asBodyStats, index, BODY_STATS, REF_BODY_START, COMP_BODY);
 }
 /* Set the stats for a particular brain type */
 void statsSetBrain(BRAIN_STATS	*psStats, UDWORD index)
 {
-	SET_STATS(psStats, asBrainStats, index, BRAIN_STATS, REF_BRAIN_START);
+	SET_STATS(psStats, asBrainStats, index, BRAIN_STATS, REF_BRAIN_START, COMP_BRAIN);
 }
 /* Set the stats for a particular power type */
 void statsSetPropulsion(PROPULSION_STATS	*psStats, UDWORD index)
 {
 	SET_STATS(psStats, asPropulsionStats, index, PROPULSION_STATS,
-		REF_PROPULSION_START);
+		REF_PROPULSION_START, COMP_PROPULSION);
 }
 /* Set the stats for a particular sensor type */
 void statsSetSensor(SENSOR_STATS	*psStats, UDWORD index)
 {
-	SET_STATS(psStats, asSensorStats, index, SENSOR_STATS, REF_SENSOR_START);
+	SET_STATS(psStats, asSensorStats, index, SENSOR_STATS, REF_SENSOR_START, COMP_SENSOR);
 }
 /* Set the stats for a particular ecm type */
 void statsSetECM(ECM_STATS	*psStats, UDWORD index)
 {
-	SET_STATS(psStats, asECMStats, index, ECM_STATS, REF_ECM_START);
+	SET_STATS(psStats, asECMStats, index, ECM_STATS, REF_ECM_START, COMP_ECM);
 }
 /* Set the stats for a particular repair type */
 void statsSetRepair(REPAIR_STATS	*psStats, UDWORD index)
 {
-	SET_STATS(psStats, asRepairStats, index, REPAIR_STATS, REF_REPAIR_START);
+	SET_STATS(psStats, asRepairStats, index, REPAIR_STATS, REF_REPAIR_START, COMP_REPAIRUNIT);
 }
 /* Set the stats for a particular construct type */
 void statsSetConstruct(CONSTRUCT_STATS	*psStats, UDWORD index)
 {
-	SET_STATS(psStats, asConstructStats, index, CONSTRUCT_STATS, REF_CONSTRUCT_START);
+	SET_STATS(psStats, asConstructStats, index, CONSTRUCT_STATS, REF_CONSTRUCT_START, COMP_CONSTRUCT);
 }
 
 /*******************************************************************************
@@ -2741,80 +2858,14 @@ SDWORD	getCompFromResName(UDWORD compType, const char *pName)
 	return getCompFromName(compType, pName);
 }
 
-static void getStatsDetails(UDWORD compType, BASE_STATS **ppsStats, UDWORD *pnumStats, UDWORD *pstatSize)
-{
-
-	switch (compType)
-	{
-	case COMP_BODY:
-		*ppsStats = (BASE_STATS*)asBodyStats;
-		*pnumStats = numBodyStats;
-		*pstatSize = sizeof(BODY_STATS);
-		break;
-	case COMP_BRAIN:
-		*ppsStats = (BASE_STATS*)asBrainStats;
-		*pnumStats = numBrainStats;
-		*pstatSize = sizeof(BRAIN_STATS);
-		break;
-	case COMP_PROPULSION:
-		*ppsStats = (BASE_STATS*)asPropulsionStats;
-		*pnumStats = numPropulsionStats;
-		*pstatSize = sizeof(PROPULSION_STATS);
-		break;
-	case COMP_REPAIRUNIT:
-		*ppsStats = (BASE_STATS*)asRepairStats;
-		*pnumStats = numRepairStats;
-		*pstatSize = sizeof(REPAIR_STATS);
-		break;
-	case COMP_ECM:
-		*ppsStats = (BASE_STATS*)asECMStats;
-		*pnumStats = numECMStats;
-		*pstatSize = sizeof(ECM_STATS);
-		break;
-	case COMP_SENSOR:
-		*ppsStats = (BASE_STATS*)asSensorStats;
-		*pnumStats = numSensorStats;
-		*pstatSize = sizeof(SENSOR_STATS);
-		break;
-	case COMP_CONSTRUCT:
-		*ppsStats = (BASE_STATS*)asConstructStats;
-		*pnumStats = numConstructStats;
-		*pstatSize = sizeof(CONSTRUCT_STATS);
-		break;
-	case COMP_WEAPON:
-		*ppsStats = (BASE_STATS*)asWeaponStats;
-		*pnumStats = numWeaponStats;
-		*pstatSize = sizeof(WEAPON_STATS);
-		break;
-	default:
-		//COMP_UNKNOWN should be an error
-		debug( LOG_FATAL, "Invalid component type - game.c" );
-		abort();
-	}
-}
-
 
 //get the component Inc for a stat based on the name and type
 //returns -1 if record not found
 SDWORD getCompFromName(UDWORD compType, const char *pName)
 {
-	BASE_STATS	*psStats = NULL;
-	UDWORD		numStats = 0, count, statSize = 0;
-
-	getStatsDetails(compType, &psStats,&numStats,&statSize);
-
-	//find the stat with the same name
-	for(count = 0; count < numStats; count++)
-	{
-		if (!strcmp(pName, psStats->pName))
-		{
-			return count;
-		}
-		psStats = (BASE_STATS*)((char*)psStats + statSize);
-	}
+	ASSERT_OR_RETURN(-1, compType > COMP_UNKNOWN && compType < COMP_NUMCOMPONENTS, "Invalid component type %u", compType);
 
-	//return -1 if record not found or an invalid component type is passed in
-	return -1;
+	return statsIndexFind(compType, pName);
 }
 
 /*return the name to display for the interface - valid for OBJECTS and STATS*/
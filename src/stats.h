@@ -268,6 +268,10 @@ extern UDWORD componentType(const char* pType);
 extern SDWORD getCompFromName(UDWORD compType, const char *pName);
 //get the component Inc for a stat based on the Resource name held in Names.txt
 extern SDWORD getCompFromResName(UDWORD compType, const char *pName);
+/* Name index for looking up stats by name, list is a COMPONENT_TYPE or STATS_INDEX_LIST */
+extern void statsIndexAdd(int list, const char *pName, int index);
+extern int statsIndexFind(int list, const char *pName);
+extern void statsIndexClear(int list);
 /*returns the weapon sub class based on the string name passed in */
 extern bool getWeaponSubClass(const char* subClass, WEAPON_SUBCLASS* wclass);
 /*either gets the name associated with the resource (if one) or allocates space and copies pName*/
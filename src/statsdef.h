@@ -207,6 +207,16 @@ enum COMPONENT_TYPE
 	COMP_NUMCOMPONENTS,			/** The number of enumerators in this enum.	 */
 };
 
+/** Lists of stats with a name index, after the ones of the COMPONENT_TYPEs. */
+enum STATS_INDEX_LIST
+{
+	STATS_INDEX_STRUCTURE = COMP_NUMCOMPONENTS,	///< asStructureStats
+	STATS_INDEX_FEATURE,				///< asFeatureStats
+	STATS_INDEX_RESEARCH,				///< asResearch
+	STATS_INDEX_FUNCTION,				///< asFunctions
+	STATS_INDEX_TEMPLATE,				///< apsStaticTemplates, by their position in the static template index
+};
+
 /**
  * LOC used for holding locations for Sensors and ECM's
  */
@@ -478,6 +478,7 @@ bool loadStructureStats(const char *pStructData, UDWORD bufferSize)
 
 	asStructureStats = new STRUCTURE_STATS[table.size()];
 	numStructureStats = table.size();
+	statsIndexClear(STATS_INDEX_STRUCTURE);
 
 	for (unsigned i = 0; i < table.size(); ++i)
 	{
@@ -489,6 +490,7 @@ bool loadStructureStats(const char *pStructData, UDWORD bufferSize)
 			debug(LOG_ERROR, "%s", table.getError().toUtf8().constData());
 			return false;
 		}
+		statsIndexAdd(STATS_INDEX_STRUCTURE, asStructureStats[i].pName, i);
 
 		initModuleStats(i, asStructureStats[i].type);  // This function looks like a hack. But slightly less hacky than before.
 	}
@@ -698,6 +700,7 @@ bool structureStatsShutDown(void)
 	delete[] asStructureStats;
 	asStructureStats = NULL;
 	numStructureStats = 0;
+	statsIndexClear(STATS_INDEX_STRUCTURE);
 
 	//free up the structLimits structure
 	for (inc = 0; inc < MAX_PLAYERS ; inc++)
@@ -4882,18 +4885,7 @@ bool destroyStruct(STRUCTURE *psDel)
 return the first one it finds!! */
 int32_t getStructStatFromName(char const *pName)
 {
-	UDWORD				inc;
-	STRUCTURE_STATS		*psStat;
-
-	for (inc = 0; inc < numStructureStats; inc++)
-	{
-		psStat = &asStructureStats[inc];
-		if (!strcmp(psStat->pName, pName))
-		{
-			return inc;
-		}
-	}
-	return -1;
+	return statsIndexFind(STATS_INDEX_STRUCTURE, pName);
 }
 
 
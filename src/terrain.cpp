@@ -47,6 +47,10 @@
 #include "display3d.h"
 #include "hci.h"
 #include "loop.h"
+#include "lib/framework/wzprofile.h"
+#include "lib/framework/wztime.h"
+
+#include <vector>
 
 /**
  * A sector contains all information to draw a square piece of the map.
@@ -120,6 +124,18 @@ static int xSectors, ySectors;
 /// Did we initialise the terrain renderer yet?
 static bool terrainInitalised = false;
 
+/// Scratch space for updateSectorsGeometry(), kept so that updates don't allocate
+static std::vector<RenderVertex> updateGeometry, updateWater;
+static std::vector<DecalVertex> updateDecals;
+
+/// Counts for terrainGetResetCounts()
+static unsigned terrainDrawCalls = 0, terrainSectorsUpdated = 0, terrainUpdateTime = 0;
+
+/// Set by --benchmark-terrain, see benchmarkTerrain()
+bool terrainBenchmark = false;
+/// How often benchmarkTerrain() repeats each measurement
+static const int TERRAIN_BENCHMARK_RUNS = 10;
+
 #ifdef DEBUG
 /// Check for OpenGL errors 
 #define glError() { \
@@ -155,6 +171,7 @@ static void finishDrawRangeElements(void)
 							dreCount,
 							GL_UNSIGNED_INT,
 							BUFFER_OFFSET(sizeof(GLuint)*dreOffset));
+		terrainDrawCalls++;
 	}
 	drawRangeElementsStarted = false;
 }
@@ -595,52 +612,53 @@ static void setSectorDecals(int x, int y,
 }
 
 /**
- * Update the sector for when the terrain is changed.
+ * Update a run of consecutive sectors for when the terrain is changed.
+ * Their parts of each VBO follow each other, so each VBO gets a single update for the whole run.
  */
-static void updateSectorGeometry(int x, int y)
+static void updateSectorsGeometry(int first, int count)
 {
-	RenderVertex *geometry;
-	RenderVertex *water;
-	DecalVertex *decaldata;
+	const uint64_t startTime = wzGetMicroTicks();
+	const Sector &firstSector = sectors[first], &lastSector = sectors[first + count - 1];
+	const int geometryTotal = lastSector.geometryOffset + lastSector.geometrySize - firstSector.geometryOffset;
+	const int waterTotal    = lastSector.waterOffset    + lastSector.waterSize    - firstSector.waterOffset;
+	const int decalTotal    = lastSector.decalOffset    + lastSector.decalSize    - firstSector.decalOffset;
 	int geometrySize = 0;
 	int waterSize = 0;
 	int decalSize = 0;
-	
-	geometry  = (RenderVertex *)malloc(sizeof(RenderVertex)*sectors[x*ySectors + y].geometrySize);
-	water     = (RenderVertex *)malloc(sizeof(RenderVertex)*sectors[x*ySectors + y].waterSize);
+	int i;
 
-	setSectorGeometry(x, y, geometry, water, &geometrySize, &waterSize);
-	ASSERT(geometrySize == sectors[x*ySectors + y].geometrySize, "something went seriously wrong updating the terrain");
-	ASSERT(waterSize    == sectors[x*ySectors + y].waterSize   , "something went seriously wrong updating the terrain");
-	
-	glBindBuffer(GL_ARRAY_BUFFER, geometryVBO); glError();
-	glBufferSubData(GL_ARRAY_BUFFER, sizeof(RenderVertex)*sectors[x*ySectors + y].geometryOffset,
-	                                 sizeof(RenderVertex)*sectors[x*ySectors + y].geometrySize, geometry); glError();
-	glBindBuffer(GL_ARRAY_BUFFER, waterVBO); glError();
-	glBufferSubData(GL_ARRAY_BUFFER, sizeof(RenderVertex)*sectors[x*ySectors + y].waterOffset,
-	                                 sizeof(RenderVertex)*sectors[x*ySectors + y].waterSize, water); glError();
+	updateGeometry.resize(geometryTotal);
+	updateWater.resize(waterTotal);
+	updateDecals.resize(count*sectorSize*sectorSize*12);  // The most a sector can have, in case they changed
 
-	free(geometry);
-	free(water);
-
-	if (sectors[x*ySectors + y].decalSize <= 0)
+	for (i = first; i < first + count; i++)
 	{
-		// Nothing to do here, and glBufferSubData(GL_ARRAY_BUFFER, 0, 0, *) crashes in my graphics driver. Probably shouldn't crash...
-		return;
+		setSectorGeometry(i / ySectors, i % ySectors, &updateGeometry[0], &updateWater[0], &geometrySize, &waterSize);
+		setSectorDecals(i / ySectors, i % ySectors, &updateDecals[0], &decalSize);
 	}
+	ASSERT(geometrySize == geometryTotal, "something went seriously wrong updating the terrain");
+	ASSERT(waterSize    == waterTotal   , "something went seriously wrong updating the terrain");
 
-	decaldata = (DecalVertex *)malloc(sizeof(DecalVertex)*sectors[x*ySectors + y].decalSize);
-	setSectorDecals(x, y, decaldata, &decalSize);
-	ASSERT(decalSize == sectors[x*ySectors + y].decalSize   , "the amount of decals has changed");
-	
-	glBindBuffer(GL_ARRAY_BUFFER, decalVBO); glError();
-	glBufferSubData(GL_ARRAY_BUFFER, sizeof(DecalVertex)*sectors[x*ySectors + y].decalOffset,
-	                                 sizeof(DecalVertex)*sectors[x*ySectors + y].decalSize, decaldata); glError();
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ARRAY_BUFFER, geometryVBO); glError();
+	glBufferSubData(GL_ARRAY_BUFFER, sizeof(RenderVertex)*firstSector.geometryOffset,
+	                                 sizeof(RenderVertex)*geometryTotal, &updateGeometry[0]); glError();
+	glBindBuffer(GL_ARRAY_BUFFER, waterVBO); glError();
+	glBufferSubData(GL_ARRAY_BUFFER, sizeof(RenderVertex)*firstSector.waterOffset,
+	                                 sizeof(RenderVertex)*waterTotal, &updateWater[0]); glError();
 
-	free (decaldata);
+	// glBufferSubData(GL_ARRAY_BUFFER, 0, 0, *) crashes in my graphics driver, so only update when there are decals. Probably shouldn't crash...
+	ASSERT(decalSize == decalTotal, "the amount of decals has changed");
+	if (decalTotal > 0 && decalSize == decalTotal)
+	{
+		glBindBuffer(GL_ARRAY_BUFFER, decalVBO); glError();
+		glBufferSubData(GL_ARRAY_BUFFER, sizeof(DecalVertex)*firstSector.decalOffset,
+		                                 sizeof(DecalVertex)*decalTotal, &updateDecals[0]); glError();
+	}
 
 	glBindBuffer(GL_ARRAY_BUFFER, 0);  // HACK Must unbind GL_ARRAY_BUFFER (don't know if it has to be unbound everywhere), otherwise text rendering may mysteriously crash.
+
+	terrainSectorsUpdated += count;
+	terrainUpdateTime += wzGetMicroTicks() - startTime;
 }
 
 /**
@@ -693,6 +711,8 @@ void markTileDirty(int i, int j)
  */
 bool initTerrain(void)
 {
+	WzProfilePhase profile("initTerrain");
+	const uint64_t startTime = wzGetMicroTicks();
 	int i, j, x, y, a, b, absX, absY;
 	PIELIGHT colour[2][2], centerColour;
 	int layer = 0;
@@ -1010,7 +1030,7 @@ bool initTerrain(void)
 	debug(LOG_TERRAIN, "%i decals found", decalSize/12);
 	glGenBuffers(1, &decalVBO); glError();
 	glBindBuffer(GL_ARRAY_BUFFER, decalVBO); glError();
-	glBufferData(GL_ARRAY_BUFFER, sizeof(DecalVertex)*decalSize, decaldata, GL_STATIC_DRAW); glError();
+	glBufferData(GL_ARRAY_BUFFER, sizeof(DecalVertex)*decalSize, decaldata, GL_DYNAMIC_DRAW); glError();
 	free(decaldata);
 	glBindBuffer(GL_ARRAY_BUFFER, 0);
 	
@@ -1045,6 +1065,7 @@ bool initTerrain(void)
 	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB8, lightmapWidth, lightmapHeight, 0, GL_RGB, GL_UNSIGNED_BYTE, lightmapPixmap);
 
 	terrainInitalised = true;
+	debug(LOG_TERRAIN, "built %i sectors of %ix%i tiles in %u us", xSectors*ySectors, sectorSize, sectorSize, (unsigned)(wzGetMicroTicks() - startTime));
 
 	glBindBuffer(GL_ARRAY_BUFFER, 0);  // HACK Must unbind GL_ARRAY_BUFFER (in this function, at least), otherwise text rendering may mysteriously crash.
 
@@ -1076,6 +1097,11 @@ void shutdownTerrain(void)
 	free(sectors);
 	sectors = NULL;
 
+	// Give back the scratch space
+	std::vector<RenderVertex>().swap(updateGeometry);
+	std::vector<RenderVertex>().swap(updateWater);
+	std::vector<DecalVertex>().swap(updateDecals);
+
 	glDeleteTextures(1, &lightmap_tex_num);
 	free(lightmapPixmap);
 	lightmapPixmap = NULL;
@@ -1083,6 +1109,45 @@ void shutdownTerrain(void)
 	terrainInitalised = false;
 }
 
+/**
+ * Time building the terrain of the loaded map, and updating its sectors one by one as when a single tile changes.
+ * Prints the averages over TERRAIN_BENCHMARK_RUNS runs, so that the same map can be compared between builds.
+ */
+bool benchmarkTerrain(void)
+{
+	uint64_t initTime = 0;
+	unsigned drawCalls, sectorsUpdated, updateTime;
+	int run, i;
+
+	for (run = 0; run < TERRAIN_BENCHMARK_RUNS; run++)
+	{
+		uint64_t startTime;
+
+		shutdownTerrain();
+		startTime = wzGetMicroTicks();
+		if (!initTerrain())
+		{
+			return false;
+		}
+		initTime += wzGetMicroTicks() - startTime;
+	}
+
+	terrainGetResetCounts(&drawCalls, &sectorsUpdated, &updateTime);
+	for (run = 0; run < TERRAIN_BENCHMARK_RUNS; run++)
+	{
+		for (i = 0; i < xSectors*ySectors; i++)
+		{
+			updateSectorsGeometry(i, 1);
+		}
+	}
+	terrainGetResetCounts(&drawCalls, &sectorsUpdated, &updateTime);
+
+	fprintf(stdout, "Terrain benchmark, %ix%i tiles in %i sectors of %ix%i, %i runs:\n", mapWidth, mapHeight, xSectors*ySectors, sectorSize, sectorSize, TERRAIN_BENCHMARK_RUNS);
+	fprintf(stdout, "  initTerrain:   %u us\n", (unsigned)(initTime / TERRAIN_BENCHMARK_RUNS));
+	fprintf(stdout, "  sector update: %.2f us per sector\n", sectorsUpdated > 0 ? (double)updateTime / sectorsUpdated : 0.0);
+	return true;
+}
+
 /**
  * Update the lightmap and draw the terrain and decals.
  * This function first draws the terrain in black, and then uses additive blending to put the terrain layers
@@ -1094,7 +1159,8 @@ void drawTerrain(void)
 	int texPage;
 	int layer;
 	int offset, size;
-	float xPos, yPos, distance;
+	int dirtyStart = -1;
+	const int64_t maxDistance = (int64_t)world_coord(terrainDistance) * world_coord(terrainDistance);
 	const GLfloat paramsX[4] = {1.0f/world_coord(mapWidth)*((float)mapWidth/lightmapWidth), 0, 0, 0};
 	const GLfloat paramsY[4] = {0, 0, -1.0f/world_coord(mapHeight)*((float)mapHeight/lightmapHeight), 0};
 
@@ -1162,30 +1228,35 @@ void drawTerrain(void)
 	}
 
 	///////////////////////////////////
-	// terrain culling
+	// terrain culling, and updating the visible sectors that changed, in runs of consecutive sectors
 	for (x = 0; x < xSectors; x++)
 	{
 		for (y = 0; y < ySectors; y++)
 		{
-			xPos = world_coord(x*sectorSize+sectorSize/2);
-			yPos = world_coord(y*sectorSize+sectorSize/2);
-			distance = pow(player.p.x - xPos, 2) + pow(player.p.z - yPos, 2);
+			const int64_t xDist = player.p.x - world_coord(x*sectorSize+sectorSize/2);
+			const int64_t yDist = player.p.z - world_coord(y*sectorSize+sectorSize/2);
+			Sector *psSector = &sectors[x*ySectors + y];
 
-			if (distance > pow((double)world_coord(terrainDistance), 2))
-			{
-				sectors[x*ySectors + y].draw = false;
-			}
-			else
+			psSector->draw = xDist*xDist + yDist*yDist <= maxDistance;
+			if (psSector->draw && psSector->dirty)
 			{
-				sectors[x*ySectors + y].draw = true;
-				if (sectors[x*ySectors + y].dirty)
+				psSector->dirty = false;
+				if (dirtyStart < 0)
 				{
-					updateSectorGeometry(x,y);
-					sectors[x*ySectors + y].dirty = false;
+					dirtyStart = x*ySectors + y;
 				}
 			}
+			else if (dirtyStart >= 0)
+			{
+				updateSectorsGeometry(dirtyStart, x*ySectors + y - dirtyStart);
+				dirtyStart = -1;
+			}
 		}
 	}
+	if (dirtyStart >= 0)
+	{
+		updateSectorsGeometry(dirtyStart, xSectors*ySectors - dirtyStart);
+	}
 
 	// enable texture coord generation
 	glEnable(GL_TEXTURE_GEN_S); glError();
@@ -1238,7 +1309,7 @@ void drawTerrain(void)
 	{
 		for (y = 0; y < ySectors; y++)
 		{
-			if (sectors[x*ySectors + y].draw)
+			if (sectors[x*ySectors + y].draw && sectors[x*ySectors + y].geometryIndexSize > 0)
 			{
 				addDrawRangeElements(GL_TRIANGLES,
 				                     sectors[x*ySectors + y].geometryOffset,
@@ -1300,6 +1371,17 @@ void drawTerrain(void)
 	{
 		const GLfloat paramsX[4] = {0, 0, -1.0f/world_coord(psGroundTypes[layer].textureSize), 0};
 		const GLfloat paramsY[4] = {1.0f/world_coord(psGroundTypes[layer].textureSize), 0, 0, 0};
+		bool layerVisible = false;
+
+		// Skip the layer, and its texture change, if no sector in view has any of it
+		for (i = 0; i < xSectors*ySectors && !layerVisible; i++)
+		{
+			layerVisible = sectors[i].draw && sectors[i].textureIndexSize[layer] > 0;
+		}
+		if (!layerVisible)
+		{
+			continue;
+		}
 
 		// load the texture
 		texPage = iV_GetTexture(psGroundTypes[layer].textureName);
@@ -1318,7 +1400,8 @@ void drawTerrain(void)
 		{
 			for (y = 0; y < ySectors; y++)
 			{
-				if (sectors[x*ySectors + y].draw)
+				// Sectors without this layer are skipped, so they don't stop the ones around them being drawn together
+				if (sectors[x*ySectors + y].draw && sectors[x*ySectors + y].textureIndexSize[layer] > 0)
 				{
 					addDrawRangeElements(GL_TRIANGLES,
 										 sectors[x*ySectors + y].geometryOffset,
@@ -1375,6 +1458,7 @@ void drawTerrain(void)
 			if (size > 0)
 			{
 				glDrawArrays(GL_TRIANGLES, offset, size); glError();
+				terrainDrawCalls++;
 			}
 			size = 0;
 			if (y < ySectors && sectors[x*ySectors + y].draw)
@@ -1522,3 +1606,14 @@ void drawWater(void)
 
 	//glBindBuffer(GL_ARRAY_BUFFER, 0);  // HACK Must unbind GL_ARRAY_BUFFER (don't know if it has to be unbound everywhere), otherwise text rendering may mysteriously crash.
 }
+
+void terrainGetResetCounts(unsigned *pDrawCalls, unsigned *pSectorsUpdated, unsigned *pUpdateTime)
+{
+	*pDrawCalls = terrainDrawCalls;
+	*pSectorsUpdated = terrainSectorsUpdated;
+	*pUpdateTime = terrainUpdateTime;
+
+	terrainDrawCalls = 0;
+	terrainSectorsUpdated = 0;
+	terrainUpdateTime = 0;
+}
@@ -25,6 +25,10 @@
 
 bool initTerrain(void);
 void shutdownTerrain(void);
+bool benchmarkTerrain(void);
+
+/// Whether to run benchmarkTerrain() after the terrain of a map is built
+extern bool terrainBenchmark;
 
 void drawTerrain(void);
 void drawWater(void);
@@ -34,4 +38,7 @@ void setTileColour(int x, int y, PIELIGHT colour);
 
 void markTileDirty(int i, int j);
 
+/// Gets the number of terrain draw calls, the number of sectors updated and the microseconds spent updating them since the last call
+void terrainGetResetCounts(unsigned *pDrawCalls, unsigned *pSectorsUpdated, unsigned *pUpdateTime);
+
 #endif
@@ -42,6 +42,7 @@
 #include "texture.h"
 #include "radar.h"
 #include "map.h"
+#include "lib/framework/wzprofile.h"
 
 
 #define MIPMAP_LEVELS		4
@@ -122,6 +123,7 @@ static int newPage(const char *name, int level, int width, int height, int count
 
 bool texLoad(const char *fileName)
 {
+	WzProfilePhase profile("texLoad");
 	char fullPath[PATH_MAX], partialPath[PATH_MAX], *buffer;
 	unsigned int i, j, k, size;
 	int texPage;
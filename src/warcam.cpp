@@ -540,8 +540,10 @@ static uint16_t getAverageTrackAngle(unsigned groupNumber, bool bCheckOnScreen)
 		{
 			if (bCheckOnScreen ? droidOnScreen(psDroid, pie_GetVideoBufferWidth() / 6) : true)
 			{
-				xTotal += iSin(psDroid->rot.direction);
-				yTotal += iCos(psDroid->rot.direction);
+				uint16_t direction = interpolateObjectSpacetime(psDroid, graphicsTime).rot.direction;
+
+				xTotal += iSin(direction);
+				yTotal += iCos(direction);
 			}
 		}
 	}
@@ -563,10 +565,12 @@ static void getTrackingConcerns(SDWORD *x, SDWORD *y, SDWORD *z, UDWORD groupNum
 		{
 			if (!bOnScreen || droidOnScreen(psDroid, pie_GetVideoBufferWidth() / 4))
 			{
+				Position pos = interpolateObjectSpacetime(psDroid, graphicsTime).pos;  // Where it is drawn
+
 				count++;
-				xTotals += psDroid->pos.x;
-				yTotals += psDroid->pos.z;	// note the flip
-				zTotals += psDroid->pos.y;
+				xTotals += pos.x;
+				yTotals += pos.z;	// note the flip
+				zTotals += pos.y;
 			}
 		}
 	}
@@ -622,7 +626,8 @@ in the case of location and degrees of arc in the case of rotation.
 
 static void updateCameraAcceleration(UBYTE update)
 {
-	Vector3i concern = swapYZ(trackingCamera.target->pos);
+	// Follow the target as it is drawn, so the camera moves smoothly between game ticks
+	Vector3i concern = swapYZ(interpolateObjectSpacetime(trackingCamera.target, graphicsTime).pos);
 	Vector2i behind(0, 0); /* Irrelevant for normal radar tracking */
 	bool bFlying = false;
 
@@ -764,8 +769,10 @@ static void updateCameraRotationAcceleration( UBYTE update )
 			int droidHeight, difHeight, droidMapHeight;
 
 			bGotFlying = true;
-			droidHeight = psDroid->pos.z;
-			droidMapHeight = map_Height(psDroid->pos.x, psDroid->pos.y);
+			Position pos = interpolateObjectSpacetime(psDroid, graphicsTime).pos;
+
+			droidHeight = pos.z;
+			droidMapHeight = map_Height(pos.x, pos.y);
 			difHeight = abs(droidHeight - droidMapHeight);
 			if(difHeight < MIN_TRACK_HEIGHT)
 			{
@@ -785,7 +792,7 @@ static void updateCameraRotationAcceleration( UBYTE update )
 		}
 		else
 		{
-			yConcern = trackingCamera.target->rot.direction;
+			yConcern = interpolateObjectSpacetime(trackingCamera.target, graphicsTime).rot.direction;
 		}
 		yConcern += DEG(180);
 
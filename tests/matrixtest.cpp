@@ -0,0 +1,217 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2011  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/**
+ * @file matrixtest.cpp
+ *
+ * Tests the CPU matrix functions the renderer uses for its matrix stack, against matrices built
+ * element by element and multiplied out, then times the transform of a typical model, as done for
+ * every droid component and structure drawn. Needs no OpenGL.
+ *
+ * Usage: matrixtest [iterations]
+ */
+
+#include "lib/framework/frame.h"
+#include "lib/framework/matrix.h"
+
+#include <stdarg.h>
+#include <time.h>
+#include <algorithm>
+
+#define EPSILON 1e-3f
+
+static bool failed = false;
+
+/***************************************************************************/
+/*  Minimal framework support, so that the matrix code can be used alone.  */
+/***************************************************************************/
+
+bool assertEnabled = true;
+bool enabled_debug[LOG_LAST];
+char last_called_script_event[MAX_EVENT_NAME_LEN];
+
+void _debug(code_part part, const char *function, const char *str, ...)
+{
+	va_list ap;
+
+	va_start(ap, str);
+	fprintf(stderr, "matrixtest: %s: ", function);
+	vfprintf(stderr, str, ap);
+	fprintf(stderr, "\n");
+	va_end(ap);
+
+	if (part == LOG_ERROR)
+	{
+		failed = true;
+	}
+}
+
+/***************************************************************************/
+
+/// Builds a matrix from its rows, as it would be written down
+static Matrix4f rows(float r0c0, float r0c1, float r0c2, float r0c3,
+                     float r1c0, float r1c1, float r1c2, float r1c3,
+                     float r2c0, float r2c1, float r2c2, float r2c3)
+{
+	Matrix4f mat = {{r0c0, r1c0, r2c0, 0.f,  r0c1, r1c1, r2c1, 0.f,  r0c2, r1c2, r2c2, 0.f,  r0c3, r1c3, r2c3, 1.f}};
+	return mat;
+}
+
+static void checkMatrix(const char *test, Matrix4f const &got, Matrix4f const &expected)
+{
+	for (int i = 0; i < 16; ++i)
+	{
+		if (fabsf(got.m[i] - expected.m[i]) > EPSILON)
+		{
+			debug(LOG_ERROR, "%s: element %d (row %d, column %d) is %f, expected %f", test, i, i % 4, i / 4, got.m[i], expected.m[i]);
+			return;
+		}
+	}
+}
+
+static void checkVector(const char *test, Vector3f const &got, Vector3f const &expected)
+{
+	if (fabsf(got.x - expected.x) > EPSILON || fabsf(got.y - expected.y) > EPSILON || fabsf(got.z - expected.z) > EPSILON)
+	{
+		debug(LOG_ERROR, "%s: got (%f, %f, %f), expected (%f, %f, %f)", test, got.x, got.y, got.z, expected.x, expected.y, expected.z);
+	}
+}
+
+static void testBasics(void)
+{
+	Matrix4f identity, mat;
+
+	matrixIdentity(&identity);
+	checkMatrix("identity", identity, rows(1, 0, 0, 0,  0, 1, 0, 0,  0, 0, 1, 0));
+
+	mat = identity;
+	matrixTranslate(&mat, 10, -20, 30);
+	checkMatrix("translate", mat, rows(1, 0, 0, 10,  0, 1, 0, -20,  0, 0, 1, 30));
+	checkVector("translate point", matrixTransform(mat, Vector3f(1, 2, 3)), Vector3f(11, -18, 33));
+	checkVector("translate direction", matrixTransformDirection(mat, Vector3f(1, 2, 3)), Vector3f(1, 2, 3));
+
+	mat = identity;
+	matrixScale(&mat, 2, 3, 4);
+	checkMatrix("scale", mat, rows(2, 0, 0, 0,  0, 3, 0, 0,  0, 0, 4, 0));
+
+	// A quarter turn in the 0..64k angles
+	mat = identity;
+	matrixRotX(&mat, 16384);
+	checkVector("rotate x", matrixTransform(mat, Vector3f(1, 2, 3)), Vector3f(1, -3, 2));
+	mat = identity;
+	matrixRotY(&mat, 16384);
+	checkVector("rotate y", matrixTransform(mat, Vector3f(1, 2, 3)), Vector3f(3, 2, -1));
+	mat = identity;
+	matrixRotZ(&mat, 16384);
+	checkVector("rotate z", matrixTransform(mat, Vector3f(1, 2, 3)), Vector3f(-2, 1, 3));
+}
+
+/// Each operation must give the same result as multiplying by the matrix it stands for, like OpenGL does
+static void testComposition(void)
+{
+	const uint16_t angles[] = {0, 1000, 16384, 30000, 45000, 65535};
+	Matrix4f mat, expected;
+
+	matrixIdentity(&mat);
+	matrixIdentity(&expected);
+	for (unsigned i = 0; i < ARRAY_SIZE(angles); ++i)
+	{
+		const float a = angles[i] * MATRIX_ANGLE_TO_RAD, c = cosf(a), s = sinf(a);
+		const float tx = 100.f * i, ty = -50.f, tz = 7.f * i * i;
+		const float scale = 0.5f + 0.25f * i;
+
+		matrixTranslate(&mat, tx, ty, tz);
+		expected = matrixMultiply(expected, rows(1, 0, 0, tx,  0, 1, 0, ty,  0, 0, 1, tz));
+		checkMatrix("composed translate", mat, expected);
+
+		matrixRotY(&mat, angles[i]);
+		expected = matrixMultiply(expected, rows(c, 0, s, 0,  0, 1, 0, 0,  -s, 0, c, 0));
+		checkMatrix("composed rotate y", mat, expected);
+
+		matrixRotX(&mat, angles[i]);
+		expected = matrixMultiply(expected, rows(1, 0, 0, 0,  0, c, -s, 0,  0, s, c, 0));
+		checkMatrix("composed rotate x", mat, expected);
+
+		matrixRotZ(&mat, angles[i]);
+		expected = matrixMultiply(expected, rows(c, -s, 0, 0,  s, c, 0, 0,  0, 0, 1, 0));
+		checkMatrix("composed rotate z", mat, expected);
+
+		matrixScale(&mat, scale, scale, scale);
+		expected = matrixMultiply(expected, rows(scale, 0, 0, 0,  0, scale, 0, 0,  0, 0, scale, 0));
+		checkMatrix("composed scale", mat, expected);
+
+		// Undo the scale, so the numbers stay within what the epsilon can compare
+		matrixScale(&mat, 1 / scale, 1 / scale, 1 / scale);
+		expected = matrixMultiply(expected, rows(1 / scale, 0, 0, 0,  0, 1 / scale, 0, 0,  0, 0, 1 / scale, 0));
+	}
+
+	// A full turn in four steps comes back to where it started
+	matrixIdentity(&mat);
+	for (int i = 0; i < 4; ++i)
+	{
+		matrixRotY(&mat, 16384);
+	}
+	matrixIdentity(&expected);
+	checkMatrix("full turn", mat, expected);
+}
+
+/// Times the transforms done to draw a droid component: push, translate, three rotations, scale, then project a point.
+static void benchmark(unsigned iterations)
+{
+	Matrix4f stack[2];
+	Vector3f sum(0, 0, 0);
+
+	matrixIdentity(&stack[0]);
+	matrixRotX(&stack[0], 60000);
+	matrixTranslate(&stack[0], -4000, -1500, 3000);
+
+	clock_t start = clock();
+	for (unsigned i = 0; i < iterations; ++i)
+	{
+		stack[1] = stack[0];
+		matrixTranslate(&stack[1], i & 1023, 200, i & 511);
+		matrixRotY(&stack[1], i * 7);
+		matrixRotX(&stack[1], i * 3);
+		matrixRotZ(&stack[1], i * 5);
+		matrixScale(&stack[1], 1.5f, 1.5f, 1.5f);
+		sum = sum + matrixTransform(stack[1], Vector3f(10, 20, 30));
+	}
+	double seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+	// Print the sum, so the loop can't be optimised away.
+	printf("%u transforms in %.3f s: %.1f ns each (checksum %g)\n", iterations, seconds, seconds * 1e9 / std::max(iterations, 1u), sum.x + sum.y + sum.z);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned iterations = argc > 1 ? atoi(argv[1]) : 1000000;
+
+	enabled_debug[LOG_ERROR] = true;
+
+	testBasics();
+	testComposition();
+	if (failed)
+	{
+		fprintf(stderr, "%s: FAILED\n", argv[0]);
+		return 1;
+	}
+	printf("Matrix tests passed\n");
+
+	benchmark(iterations);
+	return 0;
+}
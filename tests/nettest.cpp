@@ -0,0 +1,524 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2011  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/**
+ * @file nettest.cpp
+ *
+ * Loopback netplay load test. Runs a host and several clients in one process, talking over
+ * real compressed sockets on 127.0.0.1. Each client sends a scripted set of droid orders every
+ * tick, the host relays them to everyone, and a client only advances to the next tick once it has
+ * the orders of all players, like the game does. Reports join times, order latency, tick rate,
+ * throughput and the rate of ticks on which some client applied different orders than the host,
+ * and fails if there were any.
+ *
+ * Usage: nettest [clients [ticks [orders per tick]]]
+ * Listens on a free port, unless one is set with the NETTEST_PORT environment variable.
+ */
+
+#include "lib/framework/frame.h"
+#include "lib/framework/wzapp.h"
+#include "lib/framework/wztime.h"
+#include "lib/framework/crc.h"
+#include "lib/netplay/netsocket.h"
+#include "lib/netplay/netqueue.h"
+
+#include <stdarg.h>
+#include <vector>
+#include <algorithm>
+
+#ifdef BACKEND_QT
+# include <QtCore/QThread>
+# include <QtCore/QMutex>
+# include <QtCore/QSemaphore>
+#else
+# include <SDL.h>
+# include <SDL_thread.h>
+#endif
+
+#define NETTEST_MAX_CLIENTS     16
+#define NETTEST_TIMEOUT         10000   ///< Milliseconds without progress before giving up.
+
+enum
+{
+	NETTEST_ORDERS = 1,                     ///< Client -> host -> all clients: uint32 tick, uint32 player, uint64 sent time, uint32 count, count*4 uint32 orders.
+};
+
+struct TestClient
+{
+	Socket *        socket;                 ///< Client end of the connection.
+	Socket *        hostSocket;             ///< Host end of the connection.
+	NetQueuePair *  queues;                 ///< Framing for data received by the client.
+	NetQueuePair *  hostQueues;             ///< Framing for data received by the host from this client.
+	unsigned        player;
+	uint64_t        joinTime;               ///< Microseconds from connecting until the player index arrived.
+	unsigned        tick;                   ///< Tick we are collecting orders for.
+	bool            sentTick;               ///< Whether we already sent our orders for tick.
+	std::vector<NetMessage> tickOrders;     ///< Orders received for tick.
+	uint32_t        crc;                    ///< Checksum of all orders applied.
+	std::vector<uint32_t> tickCrcs;         ///< Checksum of the orders applied on each tick.
+	uint64_t        latencySum;             ///< Microseconds our own orders took to come back from the host.
+	uint64_t        latencyMax;
+	unsigned        latencyCount;
+};
+
+static TestClient clients[NETTEST_MAX_CLIENTS];
+static unsigned numClients = 8;
+static unsigned numTicks = 500;
+static unsigned ordersPerTick = 10;
+static uint64_t bytesSent = 0;
+static size_t maxSendQueue = 0;
+static bool failed = false;
+
+/***************************************************************************/
+/*  Minimal framework support, so that the socket code can be used alone.  */
+/***************************************************************************/
+
+bool assertEnabled = true;
+bool enabled_debug[LOG_LAST];
+char last_called_script_event[MAX_EVENT_NAME_LEN];
+
+void _debug(code_part part, const char *function, const char *str, ...)
+{
+	va_list ap;
+
+	va_start(ap, str);
+	fprintf(stderr, "nettest: %s: ", function);
+	vfprintf(stderr, str, ap);
+	fprintf(stderr, "\n");
+	va_end(ap);
+
+	if (part == LOG_ERROR)
+	{
+		failed = true;
+	}
+}
+
+int wzGetTicks()
+{
+	return wzGetMicroTicks() / 1000;
+}
+
+#ifdef BACKEND_QT
+struct _wzThread : public QThread
+{
+	_wzThread(int (*threadFunc_)(void *), void *data_) : threadFunc(threadFunc_), data(data_) {}
+	void run()
+	{
+		ret = (*threadFunc)(data);
+	}
+	int (*threadFunc)(void *);
+	void *data;
+	int ret;
+};
+
+struct _wzMutex : public QMutex
+{
+};
+
+struct _wzSemaphore : public QSemaphore
+{
+	_wzSemaphore(int startValue = 0) : QSemaphore(startValue) {}
+};
+
+WZ_THREAD *wzThreadCreate(int (*threadFunc)(void *), void *data) { return new WZ_THREAD(threadFunc, data); }
+int wzThreadJoin(WZ_THREAD *thread) { thread->wait(); int ret = thread->ret; delete thread; return ret; }
+void wzThreadStart(WZ_THREAD *thread) { thread->start(); }
+void wzYieldCurrentThread() { QThread::yieldCurrentThread(); }
+WZ_MUTEX *wzMutexCreate() { return new WZ_MUTEX; }
+void wzMutexDestroy(WZ_MUTEX *mutex) { delete mutex; }
+void wzMutexLock(WZ_MUTEX *mutex) { mutex->lock(); }
+void wzMutexUnlock(WZ_MUTEX *mutex) { mutex->unlock(); }
+WZ_SEMAPHORE *wzSemaphoreCreate(int startValue) { return new WZ_SEMAPHORE(startValue); }
+void wzSemaphoreDestroy(WZ_SEMAPHORE *semaphore) { delete semaphore; }
+void wzSemaphoreWait(WZ_SEMAPHORE *semaphore) { semaphore->acquire(); }
+void wzSemaphorePost(WZ_SEMAPHORE *semaphore) { semaphore->release(); }
+#else
+WZ_THREAD *wzThreadCreate(int (*threadFunc)(void *), void *data) { return SDL_CreateThread(threadFunc, data); }
+int wzThreadJoin(WZ_THREAD *thread) { int result; SDL_WaitThread(thread, &result); return result; }
+void wzThreadStart(WZ_THREAD *) {}
+void wzYieldCurrentThread() { SDL_Delay(1); }
+WZ_MUTEX *wzMutexCreate() { return SDL_CreateMutex(); }
+void wzMutexDestroy(WZ_MUTEX *mutex) { SDL_DestroyMutex(mutex); }
+void wzMutexLock(WZ_MUTEX *mutex) { SDL_LockMutex(mutex); }
+void wzMutexUnlock(WZ_MUTEX *mutex) { SDL_UnlockMutex(mutex); }
+WZ_SEMAPHORE *wzSemaphoreCreate(int startValue) { return SDL_CreateSemaphore(startValue); }
+void wzSemaphoreDestroy(WZ_SEMAPHORE *semaphore) { SDL_DestroySemaphore(semaphore); }
+void wzSemaphoreWait(WZ_SEMAPHORE *semaphore) { SDL_SemWait(semaphore); }
+void wzSemaphorePost(WZ_SEMAPHORE *semaphore) { SDL_SemPost(semaphore); }
+#endif
+
+/***************************************************************************/
+/*  Messages                                                               */
+/***************************************************************************/
+
+static void putUint32(NetMessage &message, uint32_t v)
+{
+	for (int i = 24; i >= 0; i -= 8)
+	{
+		message.data.push_back(v >> i);
+	}
+}
+
+static uint32_t getUint32(const NetMessage &message, size_t &pos)
+{
+	uint32_t v = 0;
+	for (unsigned i = 0; i < 4; ++i, ++pos)
+	{
+		v = v << 8 | (pos < message.data.size() ? message.data[pos] : 0);
+	}
+	return v;
+}
+
+static void sendMessage(Socket *sock, const NetMessage &message)
+{
+	uint8_t *rawData = message.rawDataDup();
+	ssize_t rawLen = message.rawLen();
+	if (writeAll(sock, rawData, rawLen) != rawLen)
+	{
+		debug(LOG_ERROR, "Failed to write %u bytes: %s", (unsigned)rawLen, strSockError(getSockErr()));
+	}
+	delete[] rawData;
+	bytesSent += rawLen;
+}
+
+/// Scripted orders, the same on every run.
+static NetMessage makeOrders(unsigned player, unsigned tick)
+{
+	NetMessage message(NETTEST_ORDERS);
+	uint32_t seed = player * 7919 + tick * 104729 + 1;
+	uint64_t now = wzGetMicroTicks();
+
+	putUint32(message, tick);
+	putUint32(message, player);
+	putUint32(message, now >> 32);
+	putUint32(message, now);
+	putUint32(message, ordersPerTick);
+	for (unsigned i = 0; i < ordersPerTick; ++i)
+	{
+		seed = seed * 1103515245 + 12345;
+		putUint32(message, player * 1000 + (seed >> 16) % 100);  // Droid id.
+		putUint32(message, (seed >> 8) % 40);                    // Order.
+		seed = seed * 1103515245 + 12345;
+		putUint32(message, (seed >> 8) % (64 * 128));            // x.
+		putUint32(message, (seed >> 12) % (64 * 128));           // y.
+	}
+	return message;
+}
+
+static bool ordersPlayerLess(const NetMessage &a, const NetMessage &b)
+{
+	size_t posA = 4, posB = 4;
+	return getUint32(a, posA) < getUint32(b, posB);
+}
+
+/// Applies all orders of a tick in player order, and moves on to the next tick.
+static void clientApplyTick(TestClient *client)
+{
+	uint32_t tickCrc = 0;
+
+	std::sort(client->tickOrders.begin(), client->tickOrders.end(), ordersPlayerLess);
+	for (std::vector<NetMessage>::const_iterator i = client->tickOrders.begin(); i != client->tickOrders.end(); ++i)
+	{
+		// Skip the timestamp, which isn't part of the game state.
+		tickCrc = crcSum(tickCrc, &i->data[0], 8);
+		tickCrc = crcSum(tickCrc, &i->data[16], i->data.size() - 16);
+	}
+	client->crc = crcSum(client->crc, &tickCrc, sizeof(tickCrc));
+	client->tickCrcs.push_back(tickCrc);
+	client->tickOrders.clear();
+	++client->tick;
+	client->sentTick = false;
+}
+
+static void clientHandleMessage(TestClient *client, const NetMessage &message)
+{
+	size_t pos = 0;
+	uint32_t tick = getUint32(message, pos);
+	uint32_t player = getUint32(message, pos);
+	uint64_t sentTime = (uint64_t)getUint32(message, pos) << 32;
+	sentTime |= getUint32(message, pos);
+
+	if (message.type != NETTEST_ORDERS || tick != client->tick || player >= numClients)
+	{
+		debug(LOG_ERROR, "Client %u: got message type %u for tick %u from player %u, while waiting for tick %u.", client->player, message.type, tick, player, client->tick);
+		return;
+	}
+	if (player == client->player)
+	{
+		uint64_t latency = wzGetMicroTicks() - sentTime;
+		client->latencySum += latency;
+		client->latencyMax = std::max(client->latencyMax, latency);
+		++client->latencyCount;
+	}
+	client->tickOrders.push_back(message);
+	if (client->tickOrders.size() == numClients)
+	{
+		clientApplyTick(client);
+	}
+}
+
+/// Reads whatever is available on sock into queues. Returns false if the connection broke.
+static bool readMessages(Socket *sock, NetQueuePair *queues)
+{
+	uint8_t buffer[16384];
+
+	if (!socketReadReady(sock))
+	{
+		return true;
+	}
+	ssize_t size = readNoInt(sock, buffer, sizeof(buffer));
+	if (size == SOCKET_ERROR || (size == 0 && socketReadDisconnected(sock)))
+	{
+		return false;
+	}
+	queues->receive.writeRawData(buffer, size);
+	return true;
+}
+
+/***************************************************************************/
+/*  Test                                                                   */
+/***************************************************************************/
+
+/// Connects all clients, one at a time, like players joining a game.
+static bool joinClients(Socket *listenSocket, SocketAddress *hostAddress, SocketSet *set)
+{
+	for (unsigned i = 0; i < numClients; ++i)
+	{
+		TestClient *client = &clients[i];
+		uint64_t startTime = wzGetMicroTicks();
+		uint8_t index[4];
+
+		client->player = i;
+		client->socket = socketOpenAny(hostAddress, 1500);
+		// The listening socket doesn't block, so poll it like the lobby does.
+		while (client->socket != NULL && (client->hostSocket = socketAccept(listenSocket)) == NULL && wzGetMicroTicks() - startTime < 1500000)
+		{
+			wzYieldCurrentThread();
+		}
+		if (client->hostSocket == NULL)
+		{
+			debug(LOG_ERROR, "Client %u failed to connect: %s", i, strSockError(getSockErr()));
+			return false;
+		}
+
+		// Host sends the player index uncompressed, as the game does with the version check.
+		index[0] = i >> 24; index[1] = i >> 16; index[2] = i >> 8; index[3] = i;
+		writeAll(client->hostSocket, index, sizeof(index));
+		socketBeginCompression(client->hostSocket);
+		if (readAll(client->socket, index, sizeof(index), 1500) != sizeof(index) || (unsigned)(index[0] << 24 | index[1] << 16 | index[2] << 8 | index[3]) != i)
+		{
+			debug(LOG_ERROR, "Client %u didn't get its player index.", i);
+			return false;
+		}
+		socketBeginCompression(client->socket);
+		client->joinTime = wzGetMicroTicks() - startTime;
+
+		client->queues = new NetQueuePair;
+		client->hostQueues = new NetQueuePair;
+		SocketSet_AddSocket(set, client->socket);
+		SocketSet_AddSocket(set, client->hostSocket);
+	}
+	return true;
+}
+
+/// Runs the game until all clients have done all ticks. The host relays everything it gets to everyone, in the order received.
+static bool runTicks(SocketSet *set, TestClient *host)
+{
+	int lastProgress = wzGetTicks();
+	unsigned lastTicks = 0;
+
+	host->crc = 0;
+	host->tick = 0;
+	host->player = numClients;
+	while (!failed)
+	{
+		unsigned ticksDone = 0;
+
+		for (unsigned i = 0; i < numClients; ++i)
+		{
+			TestClient *client = &clients[i];
+			if (client->tick < numTicks && !client->sentTick)
+			{
+				sendMessage(client->socket, makeOrders(client->player, client->tick));
+				socketFlush(client->socket);
+				client->sentTick = true;
+			}
+			ticksDone += client->tick;
+		}
+		if (ticksDone == numClients * numTicks)
+		{
+			break;
+		}
+		if (ticksDone != lastTicks)
+		{
+			lastTicks = ticksDone;
+			lastProgress = wzGetTicks();
+		}
+		else if (wzGetTicks() - lastProgress > NETTEST_TIMEOUT)
+		{
+			debug(LOG_ERROR, "No progress for %u ms, stuck at %u of %u client ticks.", NETTEST_TIMEOUT, ticksDone, numClients * numTicks);
+			return false;
+		}
+
+		if (checkSockets(set, 1) <= 0)
+		{
+			continue;
+		}
+
+		// Host side.
+		bool relayed = false;
+		for (unsigned i = 0; i < numClients; ++i)
+		{
+			NetQueue &queue = clients[i].hostQueues->receive;
+			if (!readMessages(clients[i].hostSocket, clients[i].hostQueues))
+			{
+				debug(LOG_ERROR, "Host lost connection to client %u.", i);
+				return false;
+			}
+			for (; queue.haveMessage(); queue.popMessage())
+			{
+				for (unsigned j = 0; j < numClients; ++j)
+				{
+					sendMessage(clients[j].hostSocket, queue.getMessage());
+				}
+				clientHandleMessage(host, queue.getMessage());
+				relayed = true;
+			}
+		}
+		if (relayed)
+		{
+			for (unsigned j = 0; j < numClients; ++j)
+			{
+				socketFlush(clients[j].hostSocket);
+				maxSendQueue = std::max(maxSendQueue, socketSendQueueSize(clients[j].hostSocket));
+			}
+		}
+
+		// Client side.
+		for (unsigned i = 0; i < numClients; ++i)
+		{
+			NetQueue &queue = clients[i].queues->receive;
+			if (!readMessages(clients[i].socket, clients[i].queues))
+			{
+				debug(LOG_ERROR, "Client %u lost connection to host.", i);
+				return false;
+			}
+			for (; queue.haveMessage(); queue.popMessage())
+			{
+				clientHandleMessage(&clients[i], queue.getMessage());
+			}
+		}
+	}
+	return !failed;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned port = getenv("NETTEST_PORT") != NULL ? atoi(getenv("NETTEST_PORT")) : 0;  // 0 picks a free port, so parallel runs don't clash.
+	uint64_t joinSum = 0, joinMax = 0, latencySum = 0, latencyMax = 0;
+	unsigned latencyCount = 0, desyncTicks = 0;
+	TestClient host;
+	bool ok;
+
+	enabled_debug[LOG_ERROR] = true;
+	enabled_debug[LOG_INFO] = true;
+	numClients = std::min<unsigned>(argc > 1 ? atoi(argv[1]) : numClients, NETTEST_MAX_CLIENTS);
+	numTicks = argc > 2 ? atoi(argv[2]) : numTicks;
+	ordersPerTick = argc > 3 ? atoi(argv[3]) : ordersPerTick;
+	if (numClients == 0)
+	{
+		fprintf(stderr, "Usage: %s [clients [ticks [orders per tick]]]\n", argv[0]);
+		return -1;
+	}
+
+	SOCKETinit();
+	Socket *listenSocket = socketListen(port);
+	port = listenSocket != NULL ? socketListenPort(listenSocket) : 0;
+	SocketAddress *hostAddress = port != 0 ? resolveHost("127.0.0.1", port) : NULL;
+	SocketSet *set = allocSocketSet();
+	if (listenSocket == NULL || hostAddress == NULL)
+	{
+		fprintf(stderr, "%s: Failed to listen on port %u\n", argv[0], port);
+		return -1;
+	}
+
+	printf("Testing %u clients, %u ticks, %u orders per tick, port %u\n", numClients, numTicks, ordersPerTick, port);
+	ok = joinClients(listenSocket, hostAddress, set);
+	uint64_t startTime = wzGetMicroTicks();
+	ok = ok && runTicks(set, &host);
+	uint64_t elapsed = std::max<uint64_t>(wzGetMicroTicks() - startTime, 1);
+
+	for (unsigned i = 0; ok && i < numClients; ++i)
+	{
+		TestClient *client = &clients[i];
+		joinSum += client->joinTime;
+		joinMax = std::max(joinMax, client->joinTime);
+		latencySum += client->latencySum;
+		latencyMax = std::max(latencyMax, client->latencyMax);
+		latencyCount += client->latencyCount;
+		if (client->crc != host.crc)
+		{
+			fprintf(stderr, "%s: Desync: client %u has checksum %08X, host has %08X\n", argv[0], i, client->crc, host.crc);
+		}
+	}
+	for (unsigned tick = 0; ok && tick < numTicks; ++tick)
+	{
+		for (unsigned i = 0; i < numClients; ++i)
+		{
+			if (tick >= host.tickCrcs.size() || clients[i].tickCrcs[tick] != host.tickCrcs[tick])
+			{
+				++desyncTicks;
+				break;
+			}
+		}
+	}
+	if (ok)
+	{
+		printf("Join time:   avg %.2f ms, max %.2f ms\n", joinSum / 1000. / numClients, joinMax / 1000.);
+		printf("Latency:     avg %.2f ms, max %.2f ms\n", latencySum / 1000. / std::max(latencyCount, 1u), latencyMax / 1000.);
+		printf("Tick rate:   %.1f ticks/s\n", numTicks * 1000000. / elapsed);
+		printf("Throughput:  %.1f KiB/s (uncompressed), max send queue %u bytes\n", bytesSent * 1000000. / 1024. / elapsed, (unsigned)maxSendQueue);
+		printf("Desyncs:     %u of %u ticks (%.2f%%)\n", desyncTicks, numTicks, desyncTicks * 100. / std::max(numTicks, 1u));
+		printf("Checksum:    %08X\n", host.crc);
+		if (desyncTicks != 0)
+		{
+			fprintf(stderr, "%s: FAILED, clients desynced\n", argv[0]);
+			ok = false;
+		}
+	}
+
+	for (unsigned i = 0; i < numClients; ++i)
+	{
+		if (clients[i].socket != NULL)
+		{
+			socketClose(clients[i].socket);
+		}
+		if (clients[i].hostSocket != NULL)
+		{
+			socketClose(clients[i].hostSocket);
+		}
+		delete clients[i].queues;
+		delete clients[i].hostQueues;
+	}
+	deleteSocketSet(set);
+	deleteSocketAddress(hostAddress);
+	socketClose(listenSocket);
+	SOCKETshutdown();
+
+	return ok ? 0 : -1;
+}
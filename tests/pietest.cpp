@@ -0,0 +1,364 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2011  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+/**
+ * @file pietest.cpp
+ *
+ * Tests that a model compiled by pie2bin loads into exactly the same shape as the PIE file it was
+ * compiled from. Each model is loaded as text, compiled, loaded again from the compiled data, and
+ * the two shapes are compared bit for bit. The number of animation frames the texture coordinates
+ * of each polygon are expanded to is checked too, against what the PIE loader does. Done for a
+ * built-in model with animated polygons of different frame counts, and for every model in
+ * modellist.txt.
+ */
+
+#include "lib/framework/frame.h"
+#include "lib/ivis_opengl/imd.h"
+#include "lib/ivis_opengl/piedef.h"
+#include "lib/ivis_opengl/piebinary.h"
+#include "lib/ivis_opengl/tex.h"
+#include "tools/pie/piecompile.h"
+
+#include <physfs.h>
+#include <stdarg.h>
+#include <string>
+#include <vector>
+
+static bool failed = false;
+static const char *currentModel = "";
+
+/// Two levels. In the first, the animated polygons have 4 and 8 frames, and the textured ones around them
+/// get the frame count of the last animated polygon before them. The second level starts again from 1 frame.
+static const char builtinModel[] =
+	"PIE 3\n"
+	"TYPE 200\n"
+	"TEXTURE 0 page-7-barbarians-arizona.png 256 256\n"
+	"LEVELS 2\n"
+	"LEVEL 1\n"
+	"POINTS 4\n"
+	"\t0 0 0\n"
+	"\t10 0 0\n"
+	"\t10 10 0\n"
+	"\t0 10 5\n"
+	"POLYGONS 5\n"
+	"\t200 3 0 1 2 0.1 0.1 0.2 0.1 0.2 0.2\n"
+	"\t4200 3 0 2 3 4 1 16 16 0.5 0.5 0.5625 0.5 0.5625 0.5625\n"
+	"\t200 3 1 2 3 0.3 0.3 0.4 0.3 0.4 0.4\n"
+	"\t4200 3 1 3 0 8 2 32 16 0 0 0.125 0 0.125 0.0625\n"
+	"\t200 3 2 3 0 0.6 0.6 0.7 0.6 0.7 0.7\n"
+	"CONNECTORS 1\n"
+	"\t1 2 3\n"
+	"LEVEL 2\n"
+	"MATERIALS 0.5 0.5 0.5 1 1 1 0 0 0 20\n"
+	"POINTS 3\n"
+	"\t0 0 0\n"
+	"\t5 0 0\n"
+	"\t5 5 0\n"
+	"POLYGONS 2\n"
+	"\t200 3 0 1 2 0.1 0.1 0.2 0.1 0.2 0.2\n"
+	"\t4200 3 2 1 0 2 1 16 16 0.25 0.25 0.3125 0.25 0.3125 0.3125\n";
+
+/***************************************************************************/
+/*  Minimal framework support, so that the model loader can be used alone. */
+/***************************************************************************/
+
+bool assertEnabled = true;
+bool enabled_debug[LOG_LAST];
+char last_called_script_event[MAX_EVENT_NAME_LEN];
+
+void _debug(code_part part, const char *function, const char *str, ...)
+{
+	va_list ap;
+
+	va_start(ap, str);
+	fprintf(stderr, "pietest: %s: %s: ", currentModel, function);
+	vfprintf(stderr, str, ap);
+	fprintf(stderr, "\n");
+	va_end(ap);
+
+	if (part == LOG_ERROR)
+	{
+		failed = true;
+	}
+}
+
+const char *GetLastResourceFilename(void)
+{
+	return currentModel;
+}
+
+// Only used to finish loading a model, or to free its shadows, which this test doesn't do.
+int iV_GetTexture(const char *) { return iV_TEX_INVALID; }
+void pie_MakeTexPageTCMaskName(char *) {}
+void pie_FreeShadowVolumes(iIMDShape *) {}
+
+/***************************************************************************/
+
+static void fail(const char *format, ...)
+{
+	va_list ap;
+
+	va_start(ap, format);
+	fprintf(stderr, "pietest: %s: ", currentModel);
+	vfprintf(stderr, format, ap);
+	fprintf(stderr, "\n");
+	va_end(ap);
+	failed = true;
+}
+
+/// Works out, from the PIE text, how many frames the texture coordinates of each polygon of each level are expanded to.
+/// Like the PIE loader, a textured polygon gets the frame count of the last animated polygon of its level up to and including itself.
+static std::vector<std::vector<unsigned> > pieFrameCounts(const char *data)
+{
+	std::vector<std::vector<unsigned> > levels;
+	const char *line = data;
+
+	for (; *line != '\0'; line = strchr(line, '\n') != NULL ? strchr(line, '\n') + 1 : line + strlen(line))
+	{
+		const char *word = line + strspn(line, " \t");  // Not sscanf's " ", which would skip empty lines too
+		unsigned npolys;
+
+		if (sscanf(word, "LEVEL %u", &npolys) == 1)
+		{
+			levels.push_back(std::vector<unsigned>());
+		}
+		if (sscanf(word, "POLYGONS %u", &npolys) != 1 || levels.empty())
+		{
+			continue;
+		}
+		unsigned numFrames = 0;
+		for (unsigned i = 0; i < npolys && (line = strchr(line, '\n')) != NULL; ++i)
+		{
+			unsigned flags, npnts, frames;
+			int index[3], cnt;
+
+			++line;
+			if (sscanf(line, "%x %u %d %d %d%n", &flags, &npnts, &index[0], &index[1], &index[2], &cnt) != 5)
+			{
+				fail("Can't read polygon %u", i);
+				return levels;
+			}
+			if ((flags & iV_IMD_TEXANIM) && sscanf(line + cnt, "%u", &frames) == 1)
+			{
+				numFrames = frames;
+			}
+			levels.back().push_back(flags & iV_IMD_TEX ? MAX(1, numFrames) : 0);
+		}
+	}
+	return levels;
+}
+
+/// Reads the frame counts of the textured polygons of each level of a compiled model, 0 for untextured ones.
+static std::vector<std::vector<unsigned> > compiledFrameCounts(std::string const &compiled)
+{
+	std::vector<std::vector<unsigned> > levels;
+	size_t pos = sizeof(PIEB_HEADER);
+	PIEB_HEADER header;
+
+	memcpy(&header, compiled.data(), sizeof(header));
+	for (unsigned level = 0; level < PHYSFS_swapULE32(header.nlevels) && pos + sizeof(PIEB_LEVEL) <= compiled.size(); ++level)
+	{
+		PIEB_LEVEL h;
+
+		memcpy(&h, compiled.data() + pos, sizeof(h));
+		pos += sizeof(h) + PHYSFS_swapULE32(h.npoints) * sizeof(PIEB_POINT);
+		levels.push_back(std::vector<unsigned>());
+		for (unsigned i = 0; i < PHYSFS_swapULE32(h.npolys) && pos + sizeof(PIEB_POLY) <= compiled.size(); ++i, pos += sizeof(PIEB_POLY))
+		{
+			PIEB_POLY poly;
+
+			memcpy(&poly, compiled.data() + pos, sizeof(poly));
+			levels.back().push_back(PHYSFS_swapULE32(poly.flags) & iV_IMD_TEX ? MAX(1, PHYSFS_swapULE32(poly.numFrames)) : 0);
+		}
+		pos += PHYSFS_swapULE32(h.ntexcoords) * sizeof(PIEB_TEXCOORD) + PHYSFS_swapULE32(h.nconnectors) * sizeof(PIEB_CONNECTOR);
+	}
+	return levels;
+}
+
+#define COMPARE(what, a, b) if ((a) != (b)) { fail("Level %u: %s differs, %d from text, %d compiled", level, what, (int)(a), (int)(b)); return; }
+#define COMPARE_BITS(what, a, b, size) if (memcmp((a), (b), (size)) != 0) { fail("Level %u: %s differs", level, what); return; }
+
+static void compareShapes(iIMDShape const *text, iIMDShape const *compiled, std::vector<std::vector<unsigned> > const &frameCounts)
+{
+	for (unsigned level = 0; text != NULL || compiled != NULL; ++level, text = text->next, compiled = compiled->next)
+	{
+		if (text == NULL || compiled == NULL)
+		{
+			fail("Level %u is only in the %s shape", level, text != NULL ? "text" : "compiled");
+			return;
+		}
+		COMPARE("flags", text->flags, compiled->flags);
+		COMPARE("sradius", text->sradius, compiled->sradius);
+		COMPARE("radius", text->radius, compiled->radius);
+		COMPARE_BITS("min", &text->min, &compiled->min, sizeof(text->min));
+		COMPARE_BITS("max", &text->max, &compiled->max, sizeof(text->max));
+		COMPARE_BITS("ocen", &text->ocen, &compiled->ocen, sizeof(text->ocen));
+		COMPARE("numFrames", text->numFrames, compiled->numFrames);
+		COMPARE("animInterval", text->animInterval, compiled->animInterval);
+		COMPARE_BITS("material", text->material, compiled->material, sizeof(text->material));
+		COMPARE_BITS("shininess", &text->shininess, &compiled->shininess, sizeof(text->shininess));
+		COMPARE("npoints", text->npoints, compiled->npoints);
+		COMPARE_BITS("points", text->points, compiled->points, text->npoints * sizeof(*text->points));
+		COMPARE("nconnectors", text->nconnectors, compiled->nconnectors);
+		COMPARE_BITS("connectors", text->connectors, compiled->connectors, text->nconnectors * sizeof(*text->connectors));
+		COMPARE("npolys", text->npolys, compiled->npolys);
+		if (level >= frameCounts.size() || frameCounts[level].size() != text->npolys)
+		{
+			fail("Level %u: couldn't work out the animation frames of the polygons from the text", level);
+			return;
+		}
+		for (unsigned i = 0; i < text->npolys; ++i)
+		{
+			iIMDPoly const *a = &text->polys[i], *b = &compiled->polys[i];
+
+			COMPARE("polygon flags", a->flags, b->flags);
+			COMPARE("polygon size", a->npnts, b->npnts);
+			COMPARE_BITS("polygon points", a->pindex, b->pindex, sizeof(a->pindex));
+			COMPARE_BITS("polygon normal", &a->normal, &b->normal, sizeof(a->normal));
+			COMPARE_BITS("polygon animation", &a->texAnim, &b->texAnim, sizeof(a->texAnim));
+			COMPARE("polygon textured", a->texCoord != NULL, b->texCoord != NULL);
+			if (a->texCoord != NULL)
+			{
+				COMPARE_BITS("polygon texture coordinates", a->texCoord, b->texCoord, frameCounts[level][i] * a->npnts * sizeof(*a->texCoord));
+			}
+		}
+	}
+}
+
+static iIMDDecoded *decode(const char *data, size_t size)
+{
+	return iV_DecodeIMD(&data, data + size, currentModel);
+}
+
+/// Loads the model as text, compiles it, loads the result, and compares the two.
+static void testModel(const char *name, const char *data, size_t size)
+{
+	std::string compiled;
+	iIMDDecoded *psText, *psCompiled;
+	bool wasFailed = failed;
+
+	currentModel = name;
+	failed = false;
+
+	psText = decode(data, size);
+	if (psText == NULL)
+	{
+		fprintf(stderr, "pietest: %s: Doesn't load as text, skipped\n", name);
+		failed = wasFailed;
+		return;
+	}
+
+	// pieCompile reads a file, so give it one
+	FILE *fp = tmpfile();
+	if (fp == NULL || fwrite(data, size, 1, fp) != 1 || fseek(fp, 0, SEEK_SET) != 0)
+	{
+		fail("Can't write temporary file");
+	}
+	else if (!pieCompile(name, fp, &compiled))
+	{
+		fail("Doesn't compile");
+	}
+	else if ((psCompiled = decode(compiled.data(), compiled.size())) == NULL)
+	{
+		fail("Compiled model doesn't load");
+	}
+	else
+	{
+		if (psText->flags != psCompiled->flags)
+		{
+			fail("Model flags differ");
+		}
+		if ((psText->texfile == NULL) != (psCompiled->texfile == NULL) || (psText->texfile != NULL && strcmp(psText->texfile, psCompiled->texfile) != 0)
+		    || (psText->normalfile == NULL) != (psCompiled->normalfile == NULL) || (psText->normalfile != NULL && strcmp(psText->normalfile, psCompiled->normalfile) != 0))
+		{
+			fail("Texture pages differ");
+		}
+		std::vector<std::vector<unsigned> > frameCounts = pieFrameCounts(data);
+
+		// Expanding to a different number of frames gives the same first frames, so check the number itself
+		if (compiledFrameCounts(compiled) != frameCounts)
+		{
+			fail("Texture coordinates are expanded to different numbers of animation frames");
+		}
+		else
+		{
+			compareShapes(psText->shape, psCompiled->shape, frameCounts);
+		}
+		iV_FreeDecodedIMD(psCompiled);
+	}
+	if (fp != NULL)
+	{
+		fclose(fp);
+	}
+	iV_FreeDecodedIMD(psText);
+
+	failed = failed || wasFailed;
+}
+
+int main(int argc, char **argv)
+{
+	char datapath[PATH_MAX];
+	unsigned count = 0;
+
+	enabled_debug[LOG_ERROR] = true;
+
+	testModel("built-in test model", builtinModel, strlen(builtinModel));
+
+	FILE *list = fopen("modellist.txt", "r");
+	if (list == NULL)
+	{
+		fprintf(stderr, "%s: Failed to open list file\n", argv[0]);
+		return -1;
+	}
+	sstrcpy(datapath, getenv("srcdir") != NULL ? getenv("srcdir") : ".");
+	sstrcat(datapath, "/../data/");
+	char filename[PATH_MAX];
+	while (fscanf(list, "%s\n", filename) == 1)
+	{
+		std::vector<char> data;
+		char buffer[4096];
+		size_t size;
+
+		std::string fullpath = std::string(datapath) + filename;
+		FILE *fp = fopen(fullpath.c_str(), "rb");
+		if (fp == NULL)
+		{
+			fprintf(stderr, "%s: Failed to open %s\n", argv[0], fullpath.c_str());
+			failed = true;
+			continue;
+		}
+		while ((size = fread(buffer, 1, sizeof(buffer), fp)) > 0)
+		{
+			data.insert(data.end(), buffer, buffer + size);
+		}
+		fclose(fp);
+		size = data.size();
+		data.push_back('\0');  // The PIE parser relies on it
+		testModel(filename, &data[0], size);
+		++count;
+	}
+	fclose(list);
+
+	if (failed)
+	{
+		fprintf(stderr, "%s: FAILED\n", argv[0]);
+		return 1;
+	}
+	printf("%u models load the same compiled\n", count + 1);
+	return 0;
+}
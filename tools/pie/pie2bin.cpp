@@ -0,0 +1,63 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2011  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+// Compiles a PIE model into the binary format of lib/ivis_opengl/piebinary.h, which the game
+// loads without parsing. The compiled file can replace the PIE file under the same name.
+//
+// Usage: pie2bin input.pie output.pie
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string>
+
+#include "piecompile.h"
+
+int main(int argc, char **argv)
+{
+	std::string out;
+	FILE *fp;
+
+	if (argc != 3)
+	{
+		fprintf(stderr, "Usage: %s input.pie output.pie\nCompiles a PIE model into the binary format the game loads without parsing.\n", argv[0]);
+		return EXIT_FAILURE;
+	}
+
+	fp = fopen(argv[1], "r");
+	if (fp == NULL)
+	{
+		perror(argv[1]);
+		return EXIT_FAILURE;
+	}
+	bool ok = pieCompile(argv[1], fp, &out);
+	fclose(fp);
+	if (!ok)
+	{
+		return EXIT_FAILURE;
+	}
+
+	fp = fopen(argv[2], "wb");
+	if (fp == NULL || fwrite(out.data(), out.size(), 1, fp) != 1 || fclose(fp) != 0)
+	{
+		perror(argv[2]);
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
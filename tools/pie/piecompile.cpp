@@ -0,0 +1,374 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2011  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+// Compiles PIE models into the binary format of lib/ivis_opengl/piebinary.h, see piecompile.h.
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include "lib/ivis_opengl/piebinary.h"
+#include "piecompile.h"
+
+// From lib/ivis_opengl/imd.h and pietypes.h
+#define PIE_VER              2
+#define PIE_FLOAT_VER        3
+#define iV_IMD_TEX           0x00000200
+#define iV_IMD_TEXANIM       0x00004000
+#define OLD_TEXTURE_SIZE_FIX 256.0f
+
+enum { LIGHT_EMISSIVE, LIGHT_AMBIENT, LIGHT_DIFFUSE, LIGHT_SPECULAR };
+
+struct LEVEL
+{
+	PIEB_LEVEL header;
+	std::vector<PIEB_POINT> points;
+	std::vector<PIEB_POLY> polys;
+	std::vector<PIEB_TEXCOORD> texcoords;
+	std::vector<PIEB_CONNECTOR> connectors;
+};
+
+static const char *input;
+
+/// Reads the next whitespace separated word, returns false at the end of the file
+static bool readWord(FILE *fp, char *word, size_t size)
+{
+	char format[16];
+
+	snprintf(format, sizeof(format), "%%%us", (unsigned)size - 1);
+	return fscanf(fp, format, word) == 1;
+}
+
+static bool fail(const char *message)
+{
+	fprintf(stderr, "%s: %s\n", input, message);
+	return false;
+}
+
+/// Same as pie_SurfaceNormal3fv
+static void surfaceNormal(const PIEB_POINT &p1, const PIEB_POINT &p2, const PIEB_POINT &p3, float *normal)
+{
+	float a[3] = {p3.x - p1.x, p3.y - p1.y, p3.z - p1.z};
+	float b[3] = {p2.x - p1.x, p2.y - p1.y, p2.z - p1.z};
+	float c[3] = {a[1]*b[2] - a[2]*b[1], a[2]*b[0] - a[0]*b[2], a[0]*b[1] - a[1]*b[0]};
+	float sq = c[0]*c[0] + c[1]*c[1] + c[2]*c[2];
+
+	for (int i = 0; i < 3; i++)
+	{
+		normal[i] = sq == 0.0f ? 0.0f : c[i] / sqrtf(sq);
+	}
+}
+
+/// Reads a level, after its LEVEL directive. Stops after the directive that follows it, which is returned in word.
+static bool readLevel(FILE *fp, int pieVersion, LEVEL *level, char *word, size_t size)
+{
+	PIEB_LEVEL *h = &level->header;
+	unsigned i, j, count;
+
+	memset(h, 0, sizeof(*h));
+	for (i = 0; i < PIEB_LIGHTS; i++)
+	{
+		for (j = 0; j < 4; j++)
+		{
+			h->material[i][j] = i == LIGHT_EMISSIVE ? 0.0f : 1.0f;
+		}
+	}
+	h->shininess = 10;
+
+	if (!readWord(fp, word, size))
+	{
+		return fail("Bad directive following LEVEL");
+	}
+	if (strcmp(word, "MATERIALS") == 0)
+	{
+		for (i = LIGHT_AMBIENT; i <= LIGHT_SPECULAR; i++)
+		{
+			if (fscanf(fp, "%f %f %f", &h->material[i][0], &h->material[i][1], &h->material[i][2]) != 3)
+			{
+				return fail("Bad MATERIALS directive");
+			}
+		}
+		if (fscanf(fp, "%f", &h->shininess) != 1 || !readWord(fp, word, size))
+		{
+			return fail("Bad MATERIALS directive");
+		}
+	}
+
+	if (strcmp(word, "POINTS") != 0 || fscanf(fp, "%u", &count) != 1)
+	{
+		return fail("Expecting POINTS directive");
+	}
+	level->points.resize(count);
+	for (i = 0; i < count; i++)
+	{
+		PIEB_POINT &p = level->points[i];
+		if (fscanf(fp, "%f %f %f", &p.x, &p.y, &p.z) != 3)
+		{
+			return fail("Bad point");
+		}
+	}
+
+	if (!readWord(fp, word, size) || strcmp(word, "POLYGONS") != 0 || fscanf(fp, "%u", &count) != 1)
+	{
+		return fail("Expecting POLYGONS directive");
+	}
+	level->polys.resize(count);
+	for (i = 0; i < count; i++)
+	{
+		PIEB_POLY &poly = level->polys[i];
+		unsigned npnts;
+
+		memset(&poly, 0, sizeof(poly));
+		if (fscanf(fp, "%x %u", &poly.flags, &npnts) != 2 || npnts != 3)
+		{
+			return fail("Bad polygon, only triangles are supported");
+		}
+		if (fscanf(fp, "%d %d %d", &poly.pindex[0], &poly.pindex[1], &poly.pindex[2]) != 3)
+		{
+			return fail("Bad polygon points");
+		}
+		for (j = 0; j < 3; j++)
+		{
+			if (poly.pindex[j] < 0 || (unsigned)poly.pindex[j] >= level->points.size())
+			{
+				return fail("Polygon point out of range");
+			}
+		}
+		surfaceNormal(level->points[poly.pindex[0]], level->points[poly.pindex[1]], level->points[poly.pindex[2]], poly.normal);
+
+		if (poly.flags & iV_IMD_TEXANIM)
+		{
+			int nFrames, pbRate, tWidth, tHeight;
+
+			if (fscanf(fp, "%d %d %d %d", &nFrames, &pbRate, &tWidth, &tHeight) != 4)
+			{
+				return fail("Bad texture animation");
+			}
+			h->numFrames = nFrames;
+			h->animInterval = pbRate;
+			poly.texAnim[0] = tWidth / OLD_TEXTURE_SIZE_FIX;
+			poly.texAnim[1] = tHeight / OLD_TEXTURE_SIZE_FIX;
+		}
+
+		if (poly.flags & iV_IMD_TEX)
+		{
+			// The game's parser expands the texture coordinates to the frame count of the last animated polygon so far
+			poly.numFrames = h->numFrames;
+			poly.firstTexCoord = level->texcoords.size();
+			for (j = 0; j < 3; j++)
+			{
+				PIEB_TEXCOORD uv;
+
+				if (fscanf(fp, "%f %f", &uv.u, &uv.v) != 2)
+				{
+					return fail("Bad texture coordinates");
+				}
+				if (pieVersion != PIE_FLOAT_VER)
+				{
+					uv.u /= OLD_TEXTURE_SIZE_FIX;
+					uv.v /= OLD_TEXTURE_SIZE_FIX;
+				}
+				level->texcoords.push_back(uv);
+			}
+		}
+		else if (poly.flags & iV_IMD_TEXANIM)
+		{
+			return fail("Polygons with texture animation must have textures");
+		}
+	}
+
+	// Optional connectors, followed by the next level or the end of the file
+	word[0] = '\0';
+	if (readWord(fp, word, size) && strcmp(word, "CONNECTORS") == 0)
+	{
+		if (fscanf(fp, "%u", &count) != 1)
+		{
+			return fail("Bad CONNECTORS directive");
+		}
+		level->connectors.resize(count);
+		for (i = 0; i < count; i++)
+		{
+			float x, y, z;
+
+			// Truncated, like the "%d%*[.0-9]" of the game's parser
+			if (fscanf(fp, "%f %f %f", &x, &y, &z) != 3)
+			{
+				return fail("Bad connector");
+			}
+			level->connectors[i].x = (int32_t)x;
+			level->connectors[i].y = (int32_t)y;
+			level->connectors[i].z = (int32_t)z;
+		}
+		word[0] = '\0';
+		readWord(fp, word, size);
+	}
+
+	h->npoints = level->points.size();
+	h->npolys = level->polys.size();
+	h->ntexcoords = level->texcoords.size();
+	h->nconnectors = level->connectors.size();
+	return true;
+}
+
+/// Reads a texture file name as the game does: up to the first '.', which must be followed by png
+static bool readTextureName(FILE *fp, char *name)
+{
+	char word[256], *dot;
+
+	if (!readWord(fp, word, sizeof(word)) || (dot = strchr(word, '.')) == NULL || strncmp(dot, ".png", 4) != 0)
+	{
+		return fail("Only png textures are supported");
+	}
+	*dot = '\0';
+	if (strlen(word) + strlen(".png") >= PIEB_NAME_MAX)
+	{
+		return fail("Texture name too long");
+	}
+	strcpy(name, word);
+	strcat(name, ".png");
+	return true;
+}
+
+static bool readPie(FILE *fp, PIEB_HEADER *header, std::vector<LEVEL> *levels)
+{
+	char word[256];
+	int pieVersion, n;
+	unsigned nlevels;
+
+	memset(header, 0, sizeof(*header));
+	memcpy(header->magic, PIEB_MAGIC, sizeof(header->magic));
+	header->version = PIEB_VERSION;
+
+	if (fscanf(fp, "%255s %d", word, &pieVersion) != 2 || strcmp(word, "PIE") != 0)
+	{
+		return fail("Not a PIE file");
+	}
+	if (pieVersion != PIE_VER && pieVersion != PIE_FLOAT_VER)
+	{
+		return fail("PIE version not supported");
+	}
+	if (fscanf(fp, "%255s %x", word, &header->flags) != 2)
+	{
+		return fail("Bad flags");
+	}
+
+	if (fscanf(fp, "%255s %d", word, &n) != 2)
+	{
+		return fail("Expecting TEXTURE or LEVELS");
+	}
+	if (strcmp(word, "TEXTURE") == 0)
+	{
+		int width, height;
+
+		if (!readTextureName(fp, header->texfile) || fscanf(fp, "%d %d %255s %d", &width, &height, word, &n) != 4)
+		{
+			return fail("Bad TEXTURE directive");
+		}
+	}
+	if (strcmp(word, "NORMALMAP") == 0)
+	{
+		if (!readTextureName(fp, header->normalfile) || fscanf(fp, "%255s %d", word, &n) != 2)
+		{
+			return fail("Bad NORMALMAP directive");
+		}
+	}
+	if (strcmp(word, "LEVELS") != 0 || n <= 0)
+	{
+		return fail("Expecting LEVELS directive");
+	}
+	nlevels = n;
+
+	if (!readWord(fp, word, sizeof(word)) || strcmp(word, "LEVEL") != 0 || fscanf(fp, "%d", &n) != 1)
+	{
+		return fail("Expecting LEVEL directive");
+	}
+	while (levels->size() < nlevels)
+	{
+		levels->push_back(LEVEL());
+		if (!readLevel(fp, pieVersion, &levels->back(), word, sizeof(word)))
+		{
+			return false;
+		}
+		if (strcmp(word, "LEVEL") != 0)
+		{
+			break;
+		}
+		if (fscanf(fp, "%d", &n) != 1)
+		{
+			return fail("Bad LEVEL directive");
+		}
+	}
+	header->nlevels = levels->size();
+	return true;
+}
+
+/// Appends 32-bit words in little-endian order
+template <typename T>
+static void writeWords(std::string &out, const std::vector<T> &data)
+{
+	if (!data.empty())
+	{
+		writeWords(out, &data[0], data.size() * sizeof(T));
+	}
+}
+
+static void writeWords(std::string &out, const void *data, size_t size)
+{
+	const unsigned char *bytes = (const unsigned char *)data;
+
+	for (size_t i = 0; i < size; i += 4)
+	{
+		uint32_t word;
+		memcpy(&word, bytes + i, 4);
+		for (int b = 0; b < 4; b++)
+		{
+			out += (char)((word >> (8 * b)) & 0xff);
+		}
+	}
+}
+
+bool pieCompile(const char *name, FILE *fp, std::string *out)
+{
+	PIEB_HEADER header;
+	std::vector<LEVEL> levels;
+
+	input = name;
+	if (!readPie(fp, &header, &levels))
+	{
+		return false;
+	}
+
+	out->clear();
+	out->append(header.magic, sizeof(header.magic));
+	writeWords(*out, &header.version, sizeof(header.version) + sizeof(header.flags) + sizeof(header.nlevels));
+	out->append(header.texfile, sizeof(header.texfile));
+	out->append(header.normalfile, sizeof(header.normalfile));
+	for (std::vector<LEVEL>::const_iterator level = levels.begin(); level != levels.end(); ++level)
+	{
+		writeWords(*out, &level->header, sizeof(level->header));
+		writeWords(*out, level->points);
+		writeWords(*out, level->polys);
+		writeWords(*out, level->texcoords);
+		writeWords(*out, level->connectors);
+	}
+	return true;
+}
@@ -0,0 +1,32 @@
+/*
+	This file is part of Warzone 2100.
+	Copyright (C) 2011  Warzone 2100 Project
+
+	Warzone 2100 is free software; you can redistribute it and/or modify
+	it under the terms of the GNU General Public License as published by
+	the Free Software Foundation; either version 2 of the License, or
+	(at your option) any later version.
+
+	Warzone 2100 is distributed in the hope that it will be useful,
+	but WITHOUT ANY WARRANTY; without even the implied warranty of
+	MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+	GNU General Public License for more details.
+
+	You should have received a copy of the GNU General Public License
+	along with Warzone 2100; if not, write to the Free Software
+	Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+*/
+
+// Compiles PIE models into the binary format of lib/ivis_opengl/piebinary.h, which the game
+// loads without parsing. Used by pie2bin, and by tests/pietest to check the result loads the same.
+
+#ifndef __INCLUDED_TOOLS_PIE_PIECOMPILE_H__
+#define __INCLUDED_TOOLS_PIE_PIECOMPILE_H__
+
+#include <stdio.h>
+#include <string>
+
+/// Compiles the PIE model read from fp into out. Prints what is wrong to stderr, using name, and returns false if it can't.
+bool pieCompile(const char *name, FILE *fp, std::string *out);
+
+#endif // __INCLUDED_TOOLS_PIE_PIECOMPILE_H__